@@ -349,6 +349,62 @@ int Compression::decompress_dynamic(Vector<uint8_t> *p_dst_vect, int p_max_dst_s
 	}
 }
 
+Compression::ZstdCompressionDictionary::ZstdCompressionDictionary(const uint8_t *p_dictionary, int p_dictionary_size) {
+	cdict = ZSTD_createCDict(p_dictionary, p_dictionary_size, zstd_level);
+	ERR_FAIL_NULL(cdict);
+}
+
+Compression::ZstdCompressionDictionary::~ZstdCompressionDictionary() {
+	ZSTD_freeCDict(cdict);
+}
+
+Compression::ZstdDecompressionDictionary::ZstdDecompressionDictionary(const uint8_t *p_dictionary, int p_dictionary_size) {
+	ddict = ZSTD_createDDict(p_dictionary, p_dictionary_size);
+	ERR_FAIL_NULL(ddict);
+}
+
+Compression::ZstdDecompressionDictionary::~ZstdDecompressionDictionary() {
+	ZSTD_freeDDict(ddict);
+}
+
+Compression::ZstdContext::~ZstdContext() {
+	ZSTD_freeCCtx(cctx);
+	ZSTD_freeDCtx(dctx);
+}
+
+int Compression::compress_zstd(ZstdContext &r_context, uint8_t *p_dst, const uint8_t *p_src, int p_src_size, const ZstdCompressionDictionary *p_dictionary) {
+	if (!r_context.cctx) {
+		r_context.cctx = ZSTD_createCCtx();
+		ERR_FAIL_NULL_V(r_context.cctx, -1);
+	}
+	const int max_dst_size = get_max_compressed_buffer_size(p_src_size, MODE_ZSTD);
+	size_t ret;
+	if (p_dictionary) {
+		ERR_FAIL_NULL_V(p_dictionary->cdict, -1);
+		ret = ZSTD_compress_usingCDict(r_context.cctx, p_dst, max_dst_size, p_src, p_src_size, p_dictionary->cdict);
+	} else {
+		ret = ZSTD_compressCCtx(r_context.cctx, p_dst, max_dst_size, p_src, p_src_size, zstd_level);
+	}
+	ERR_FAIL_COND_V(ZSTD_isError(ret), -1);
+	return ret;
+}
+
+int Compression::decompress_zstd(ZstdContext &r_context, uint8_t *p_dst, int p_dst_max_size, const uint8_t *p_src, int p_src_size, const ZstdDecompressionDictionary *p_dictionary) {
+	if (!r_context.dctx) {
+		r_context.dctx = ZSTD_createDCtx();
+		ERR_FAIL_NULL_V(r_context.dctx, -1);
+	}
+	size_t ret;
+	if (p_dictionary) {
+		ERR_FAIL_NULL_V(p_dictionary->ddict, -1);
+		ret = ZSTD_decompress_usingDDict(r_context.dctx, p_dst, p_dst_max_size, p_src, p_src_size, p_dictionary->ddict);
+	} else {
+		ret = ZSTD_decompressDCtx(r_context.dctx, p_dst, p_dst_max_size, p_src, p_src_size);
+	}
+	ERR_FAIL_COND_V(ZSTD_isError(ret), -1);
+	return ret;
+}
+
 int Compression::zlib_level = Z_DEFAULT_COMPRESSION;
 int Compression::gzip_level = Z_DEFAULT_COMPRESSION;
 int Compression::zstd_level = 3;
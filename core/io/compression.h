@@ -34,6 +34,11 @@
 #include "core/templates/vector.h"
 #include "core/typedefs.h"
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
 class Compression {
 public:
 	static int zlib_level;
@@ -55,6 +60,48 @@ public:
 	static int get_max_compressed_buffer_size(int p_src_size, Mode p_mode = MODE_ZSTD);
 	static int decompress(uint8_t *p_dst, int p_dst_max_size, const uint8_t *p_src, int p_src_size, Mode p_mode = MODE_ZSTD);
 	static int decompress_dynamic(Vector<uint8_t> *p_dst_vect, int p_max_dst_size, const uint8_t *p_src, int p_src_size, Mode p_mode);
+
+	// Zstandard for many small inputs, optionally sharing a dictionary. Any data can be used as a
+	// dictionary: zstd treats it as if it came right before the input. A dictionary is digested
+	// once, when created, and can then be used from several threads. A context keeps its memory
+	// between calls, but can only be used by one thread at a time. None of them can be copied, as
+	// they own what zstd allocated.
+	class ZstdCompressionDictionary {
+		friend class Compression;
+		ZSTD_CDict_s *cdict = nullptr;
+
+	public:
+		ZstdCompressionDictionary(const uint8_t *p_dictionary, int p_dictionary_size);
+		ZstdCompressionDictionary(const ZstdCompressionDictionary &) = delete;
+		void operator=(const ZstdCompressionDictionary &) = delete;
+		~ZstdCompressionDictionary();
+	};
+
+	class ZstdDecompressionDictionary {
+		friend class Compression;
+		ZSTD_DDict_s *ddict = nullptr;
+
+	public:
+		ZstdDecompressionDictionary(const uint8_t *p_dictionary, int p_dictionary_size);
+		ZstdDecompressionDictionary(const ZstdDecompressionDictionary &) = delete;
+		void operator=(const ZstdDecompressionDictionary &) = delete;
+		~ZstdDecompressionDictionary();
+	};
+
+	class ZstdContext {
+		friend class Compression;
+		ZSTD_CCtx_s *cctx = nullptr;
+		ZSTD_DCtx_s *dctx = nullptr;
+
+	public:
+		ZstdContext() {}
+		ZstdContext(const ZstdContext &) = delete;
+		void operator=(const ZstdContext &) = delete;
+		~ZstdContext();
+	};
+
+	static int compress_zstd(ZstdContext &r_context, uint8_t *p_dst, const uint8_t *p_src, int p_src_size, const ZstdCompressionDictionary *p_dictionary = nullptr);
+	static int decompress_zstd(ZstdContext &r_context, uint8_t *p_dst, int p_dst_max_size, const uint8_t *p_src, int p_src_size, const ZstdDecompressionDictionary *p_dictionary = nullptr);
 };
 
 #endif // COMPRESSION_H
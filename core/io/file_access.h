@@ -84,6 +84,15 @@ public:
 		COMPRESSION_BROTLI = Compression::MODE_BROTLI,
 	};
 
+	// Hints for how a memory-mapped range will be read (see advise()).
+	enum MapAdvice {
+		MAP_ADVICE_NORMAL,
+		MAP_ADVICE_SEQUENTIAL,
+		MAP_ADVICE_RANDOM,
+		MAP_ADVICE_WILL_NEED,
+		MAP_ADVICE_DONT_NEED,
+	};
+
 	typedef void (*FileCloseFailNotify)(const String &);
 
 	typedef Ref<FileAccess> (*CreateFunc)();
@@ -104,6 +113,7 @@ protected:
 	AccessType get_access_type() const;
 	virtual String fix_path(const String &p_path) const;
 	virtual Error open_internal(const String &p_path, int p_mode_flags) = 0; ///< open a file
+	virtual Error open_mapped_internal(const String &p_path) { return open_internal(p_path, READ); } ///< open a file for reading, memory-mapped if supported
 	virtual uint64_t _get_modified_time(const String &p_file) = 0;
 	virtual void _set_access_type(AccessType p_access);
 
@@ -178,6 +188,25 @@ public:
 	Variant get_var(bool p_allow_objects = false) const;
 
 	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const = 0; ///< get an array of bytes, needs to be overwritten by children.
+
+	// Memory-mapped files (see open_mapped()). The mapping covers the whole file, is read-only and
+	// stays valid as long as this FileAccess exists. Files that aren't mapped return nullptr.
+	virtual const uint8_t *get_mapped_data() const { return nullptr; }
+	// Returns the next p_length bytes without copying them and moves past them. Returns nullptr
+	// without moving if the file isn't mapped or fewer than p_length bytes are left.
+	virtual const uint8_t *get_buffer_span(uint64_t p_length) const { return nullptr; }
+	// Tells the OS how a mapped range will be read. p_length 0 means until the end of the file.
+	virtual void advise(MapAdvice p_advice, uint64_t p_from = 0, uint64_t p_length = 0) const {}
+	// Keeps the mapping until the process exits, even once this FileAccess is gone, so spans into
+	// it can be kept. Returns false if the file isn't mapped.
+	virtual bool pin_mapping() { return false; }
+	virtual bool is_mapping_pinned() const { return false; }
+	// Like get_buffer_span(), but only for pinned mappings. The span is only writable where
+	// make_mapping_writable() was called.
+	virtual uint8_t *get_pinned_span(uint64_t p_length) const { return nullptr; }
+	// Makes the pages holding the range of a pinned mapping copy-on-write writable, so writes never
+	// reach the file.
+	virtual bool make_mapping_writable(uint64_t p_from, uint64_t p_length) const { return false; }
 	Vector<uint8_t> get_buffer(int64_t p_length) const;
 	virtual String get_line() const;
 	virtual String get_token() const;
@@ -229,6 +258,7 @@ public:
 	static Ref<FileAccess> create(AccessType p_access); /// Create a file access (for the current platform) this is the only portable way of accessing files.
 	static Ref<FileAccess> create_for_path(const String &p_path);
 	static Ref<FileAccess> open(const String &p_path, int p_mode_flags, Error *r_error = nullptr); /// Create a file access (for the current platform) this is the only portable way of accessing files.
+	static Ref<FileAccess> open_mapped(const String &p_path, Error *r_error = nullptr); /// Open for reading, memory-mapped where the platform supports it. Falls back to a regular read-only file.
 	static Ref<FileAccess> create_temp(int p_mode_flags, const String &p_prefix = "", const String &p_extension = "", bool p_keep = false, Error *r_error = nullptr);
 
 	static Ref<FileAccess> open_encrypted(const String &p_path, ModeFlags p_mode_flags, const Vector<uint8_t> &p_key, const Vector<uint8_t> &p_iv = Vector<uint8_t>());
@@ -45,7 +45,7 @@ Error PackedData::add_pack(const String &p_path, bool p_replace_files, uint64_t
 	return ERR_FILE_UNRECOGNIZED;
 }
 
-void PackedData::add_path(const String &p_pkg_path, const String &p_path, uint64_t p_ofs, uint64_t p_size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, bool p_encrypted) {
+void PackedData::add_path(const String &p_pkg_path, const String &p_path, uint64_t p_ofs, uint64_t p_size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, bool p_encrypted, bool p_compressed) {
 	String simplified_path = p_path.simplify_path().trim_prefix("res://");
 	PathMD5 pmd5(simplified_path.md5_buffer());
 
@@ -53,6 +53,7 @@ void PackedData::add_path(const String &p_pkg_path, const String &p_path, uint64
 
 	PackedFile pf;
 	pf.encrypted = p_encrypted;
+	pf.compressed = p_compressed;
 	pf.pack = p_pkg_path;
 	pf.offset = p_ofs;
 	pf.size = p_size;
@@ -188,10 +189,11 @@ PackedData::~PackedData() {
 //////////////////////////////////////////////////////////////////
 
 bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
-	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
+	Ref<FileAccess> f = FileAccess::open_mapped(p_path);
 	if (f.is_null()) {
 		return false;
 	}
+	const Ref<FileAccess> pack = f;
 
 	bool pck_header_found = false;
 
@@ -263,7 +265,7 @@ bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files,
 	uint32_t ver_minor = f->get_32();
 	f->get_32(); // patch number, not used for validation.
 
-	ERR_FAIL_COND_V_MSG(version != PACK_FORMAT_VERSION, false, vformat("Pack version unsupported: %d.", version));
+	ERR_FAIL_COND_V_MSG(version < PACK_FORMAT_VERSION_MIN || version > PACK_FORMAT_VERSION, false, vformat("Pack version unsupported: %d.", version));
 	ERR_FAIL_COND_V_MSG(ver_major > VERSION_MAJOR || (ver_major == VERSION_MAJOR && ver_minor > VERSION_MINOR), false, vformat("Pack created with a newer version of the engine: %d.%d.", ver_major, ver_minor));
 
 	uint32_t pack_flags = f->get_32();
@@ -318,15 +320,65 @@ bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files,
 		if (flags & PACK_FILE_REMOVAL) { // The file was removed.
 			PackedData::get_singleton()->remove_path(path);
 		} else {
-			PackedData::get_singleton()->add_path(p_path, path, file_base + ofs + p_offset, size, md5, this, p_replace_files, (flags & PACK_FILE_ENCRYPTED));
+			PackedData::get_singleton()->add_path(p_path, path, file_base + ofs + p_offset, size, md5, this, p_replace_files, (flags & PACK_FILE_ENCRYPTED), (flags & PACK_FILE_COMPRESSED));
 		}
 	}
 
+	if (pack->get_mapped_data()) {
+		// Packed files are spread all over the pack; don't let reading one prefetch its neighbors.
+		pack->advise(FileAccess::MAP_ADVICE_RANDOM);
+		// Views into the pack (see ResourceLoaderBinary) may outlive PackedData, which is deleted
+		// before the resources and strings holding them are.
+		pack->pin_mapping();
+		MutexLock lock(mapped_packs_mutex);
+		mapped_packs[p_path] = pack;
+	}
+
 	return true;
 }
 
 Ref<FileAccess> PackedSourcePCK::get_file(const String &p_path, PackedData::PackedFile *p_file) {
-	return memnew(FileAccessPack(p_path, *p_file));
+	Ref<FileAccess> mapped_pack;
+	if (!p_file->encrypted) {
+		MutexLock lock(mapped_packs_mutex);
+		const Ref<FileAccess> *pack = mapped_packs.getptr(p_file->pack);
+		if (pack) {
+			mapped_pack = *pack;
+		}
+	}
+	Ref<FileAccess> file = memnew(FileAccessPack(p_path, *p_file, mapped_pack));
+	if (!p_file->compressed) {
+		return file;
+	}
+
+	Ref<FileAccessPackCompressed> compressed;
+	compressed.instantiate();
+	Error err = compressed->open_and_parse(file);
+	ERR_FAIL_COND_V_MSG(err != OK, Ref<FileAccess>(), vformat("Can't open compressed pack-referenced file '%s'.", p_path));
+	if (compressed->get_dictionary_size() > 0) {
+		ERR_FAIL_COND_V_MSG(compressed->get_dictionary_distance() > p_file->offset, Ref<FileAccess>(), vformat("Compressed pack-referenced file '%s' is corrupt.", p_path));
+		Vector<uint8_t> dictionary = _get_dictionary(p_file->pack, p_file->offset - compressed->get_dictionary_distance(), compressed->get_dictionary_size());
+		ERR_FAIL_COND_V_MSG(dictionary.is_empty(), Ref<FileAccess>(), vformat("Can't read the compression dictionary of pack-referenced file '%s'.", p_path));
+		compressed->set_dictionary(dictionary);
+	}
+	return compressed;
+}
+
+Vector<uint8_t> PackedSourcePCK::_get_dictionary(const String &p_pack, uint64_t p_offset, uint32_t p_size) {
+	const String key = p_pack + ":" + itos(p_offset);
+	MutexLock lock(dictionaries_mutex);
+	const Vector<uint8_t> *cached = dictionaries.getptr(key);
+	if (cached) {
+		return *cached;
+	}
+
+	Ref<FileAccess> pack = FileAccess::open(p_pack, FileAccess::READ);
+	ERR_FAIL_COND_V(pack.is_null(), Vector<uint8_t>());
+	ERR_FAIL_COND_V(p_offset > pack->get_length() || p_size > pack->get_length() - p_offset, Vector<uint8_t>());
+	pack->seek(p_offset);
+	Vector<uint8_t> dictionary = pack->get_buffer(p_size);
+	dictionaries[key] = dictionary;
+	return dictionary;
 }
 
 //////////////////////////////////////////////////////////////////
@@ -391,7 +443,9 @@ void FileAccessPack::seek(uint64_t p_position) {
 		eof = false;
 	}
 
-	f->seek(off + p_position);
+	if (!mapped) {
+		f->seek(off + p_position);
+	}
 	pos = p_position;
 }
 
@@ -425,21 +479,61 @@ uint64_t FileAccessPack::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
 		to_read = (int64_t)pf.size - (int64_t)pos;
 	}
 
+	const uint64_t read_pos = pos;
 	pos += to_read;
 
 	if (to_read <= 0) {
 		return 0;
 	}
-	f->get_buffer(p_dst, to_read);
+	if (mapped) {
+		memcpy(p_dst, mapped + read_pos, to_read);
+	} else {
+		f->get_buffer(p_dst, to_read);
+	}
 
 	return to_read;
 }
 
+const uint8_t *FileAccessPack::get_buffer_span(uint64_t p_length) const {
+	if (!mapped || pos > pf.size || p_length > pf.size - pos) {
+		return nullptr;
+	}
+	const uint8_t *span = mapped + pos;
+	pos += p_length;
+	return span;
+}
+
+uint8_t *FileAccessPack::get_pinned_span(uint64_t p_length) const {
+	if (!pinned) {
+		return nullptr;
+	}
+	return const_cast<uint8_t *>(get_buffer_span(p_length));
+}
+
+bool FileAccessPack::make_mapping_writable(uint64_t p_from, uint64_t p_length) const {
+	if (!pinned || p_from > pf.size || p_length > pf.size - p_from) {
+		return false;
+	}
+	return f->make_mapping_writable(off + p_from, p_length);
+}
+
+void FileAccessPack::advise(MapAdvice p_advice, uint64_t p_from, uint64_t p_length) const {
+	if (!mapped || p_from >= pf.size) {
+		return;
+	}
+	if (p_length == 0 || p_length > pf.size - p_from) {
+		p_length = pf.size - p_from;
+	}
+	f->advise(p_advice, off + p_from, p_length);
+}
+
 void FileAccessPack::set_big_endian(bool p_big_endian) {
 	ERR_FAIL_COND_MSG(f.is_null(), "File must be opened before use.");
 
 	FileAccess::set_big_endian(p_big_endian);
-	f->set_big_endian(p_big_endian);
+	if (!mapped) {
+		f->set_big_endian(p_big_endian); // The mapped pack is shared and never read through.
+	}
 }
 
 Error FileAccessPack::get_error() const {
@@ -463,11 +557,26 @@ bool FileAccessPack::file_exists(const String &p_name) {
 
 void FileAccessPack::close() {
 	f = Ref<FileAccess>();
+	mapped = nullptr;
+	pinned = false;
 }
 
-FileAccessPack::FileAccessPack(const String &p_path, const PackedData::PackedFile &p_file) :
-		pf(p_file),
-		f(FileAccess::open(pf.pack, FileAccess::READ)) {
+FileAccessPack::FileAccessPack(const String &p_path, const PackedData::PackedFile &p_file, const Ref<FileAccess> &p_mapped_pack) :
+		pf(p_file) {
+	pos = 0;
+	eof = false;
+
+	if (p_mapped_pack.is_valid() && !pf.encrypted && pf.offset <= p_mapped_pack->get_length() && pf.size <= p_mapped_pack->get_length() - pf.offset) {
+		f = p_mapped_pack;
+		off = pf.offset;
+		mapped = f->get_mapped_data() + off;
+		pinned = f->is_mapping_pinned();
+		// Small files are usually read whole right away, so start paging them in.
+		f->advise(pf.size <= MAP_WILL_NEED_MAX_SIZE ? MAP_ADVICE_WILL_NEED : MAP_ADVICE_SEQUENTIAL, off, pf.size);
+		return;
+	}
+
+	f = FileAccess::open(pf.pack, FileAccess::READ);
 	ERR_FAIL_COND_MSG(f.is_null(), vformat("Can't open pack-referenced file '%s'.", String(pf.pack)));
 
 	f->seek(pf.offset);
@@ -489,8 +598,219 @@ FileAccessPack::FileAccessPack(const String &p_path, const PackedData::PackedFil
 		f = fae;
 		off = 0;
 	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// COMPRESSED FILE ACCESS
+//////////////////////////////////////////////////////////////////////////////////
+
+Error FileAccessPackCompressed::open_and_parse(const Ref<FileAccess> &p_base) {
+	_close();
+	ERR_FAIL_COND_V(p_base.is_null(), ERR_INVALID_PARAMETER);
+
+	p_base->seek(0);
+	ERR_FAIL_COND_V(p_base->get_32() != PACK_COMPRESSED_MAGIC, ERR_FILE_UNRECOGNIZED);
+	mode = (Compression::Mode)p_base->get_32();
+	block_size = p_base->get_32();
+	const uint32_t block_count = p_base->get_32();
+	length = p_base->get_64();
+	dictionary_distance = p_base->get_64();
+	dictionary_size = p_base->get_32();
+	p_base->get_32(); // Reserved.
+
+	ERR_FAIL_COND_V(block_size == 0 || block_size > MAX_BLOCK_SIZE, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V(block_count != (length + block_size - 1) / block_size, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V(dictionary_size > 0 && mode != Compression::MODE_ZSTD, ERR_FILE_CORRUPT);
+
+	const uint64_t max_block_stored_size = MAX(block_size, (uint32_t)Compression::get_max_compressed_buffer_size(block_size, mode));
+	block_offsets.resize(block_count + 1);
+	uint64_t offset = PACK_COMPRESSED_HEADER_SIZE + uint64_t(block_count) * 4;
+	for (uint32_t i = 0; i < block_count; i++) {
+		block_offsets[i] = offset;
+		const uint32_t stored_size = p_base->get_32();
+		ERR_FAIL_COND_V(stored_size > max_block_stored_size, ERR_FILE_CORRUPT);
+		offset += stored_size;
+	}
+	block_offsets[block_count] = offset;
+	ERR_FAIL_COND_V(p_base->eof_reached() || offset > p_base->get_length(), ERR_FILE_CORRUPT);
+
+	f = p_base;
+	mapped = f->get_mapped_data();
+	for (Block &block : blocks) {
+		block.owner = this;
+	}
 	pos = 0;
 	eof = false;
+	last_block = -1;
+	return OK;
+}
+
+void FileAccessPackCompressed::set_dictionary(const Vector<uint8_t> &p_dictionary) {
+	ERR_FAIL_COND(uint32_t(p_dictionary.size()) != dictionary_size);
+	ERR_FAIL_COND(dictionary);
+	dictionary = memnew(Compression::ZstdDecompressionDictionary(p_dictionary.ptr(), p_dictionary.size()));
+}
+
+void FileAccessPackCompressed::_decompress_block(void *p_block) {
+	Block *block = (Block *)p_block;
+	const FileAccessPackCompressed *owner = block->owner;
+
+	if (block->src_size == block->size) {
+		memcpy(block->data.ptrw(), block->src, block->size);
+		block->failed = false;
+		return;
+	}
+	int ret;
+	if (owner->mode == Compression::MODE_ZSTD) {
+		ret = Compression::decompress_zstd(block->context, block->data.ptrw(), block->size, block->src, block->src_size, owner->dictionary);
+	} else {
+		ret = Compression::decompress(block->data.ptrw(), block->size, block->src, block->src_size, owner->mode);
+	}
+	block->failed = ret != int(block->size);
+}
+
+void FileAccessPackCompressed::_load_block(Block &r_block, int64_t p_index) const {
+	_wait_block(r_block);
+
+	r_block.index = p_index;
+	r_block.size = MIN(uint64_t(block_size), length - uint64_t(p_index) * block_size);
+	r_block.src_size = block_offsets[p_index + 1] - block_offsets[p_index];
+	if (r_block.data.size() < block_size) {
+		r_block.data.resize(block_size);
+	}
+	if (mapped) {
+		r_block.src = mapped + block_offsets[p_index];
+	} else {
+		// Only the calling thread reads from f.
+		if (uint32_t(r_block.comp.size()) < r_block.src_size) {
+			r_block.comp.resize(r_block.src_size);
+		}
+		f->seek(block_offsets[p_index]);
+		f->get_buffer(r_block.comp.ptrw(), r_block.src_size);
+		r_block.src = r_block.comp.ptr();
+	}
+}
+
+void FileAccessPackCompressed::_wait_block(Block &r_block) const {
+	if (r_block.task != WorkerThreadPool::INVALID_TASK_ID) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(r_block.task);
+		r_block.task = WorkerThreadPool::INVALID_TASK_ID;
+	}
+}
+
+const FileAccessPackCompressed::Block *FileAccessPackCompressed::_get_block(int64_t p_index) const {
+	ERR_FAIL_COND_V_MSG(dictionary_size > 0 && !dictionary, nullptr, "Compression dictionary not set.");
+
+	Block *found = nullptr;
+	for (Block &block : blocks) {
+		if (block.index == p_index) {
+			_wait_block(block);
+			found = &block;
+			break;
+		}
+	}
+
+	// Blocks outside [p_index, p_index + READ_AHEAD_BLOCKS] aren't needed anymore.
+	const uint32_t block_count = block_offsets.size() - 1;
+	auto is_stale = [&](const Block &p_block) {
+		return &p_block != found && (p_block.index < p_index || p_block.index > p_index + READ_AHEAD_BLOCKS);
+	};
+
+	if (!found) {
+		for (Block &block : blocks) {
+			if (is_stale(block)) {
+				found = &block;
+				break;
+			}
+		}
+		_load_block(*found, p_index);
+		_decompress_block(found);
+	}
+
+	// Decompress the next blocks in the background while this one is read, if reading forward.
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	if (p_index == last_block + 1 && pool && pool->get_thread_count() > 0) {
+		for (int64_t next = p_index + 1; next <= p_index + READ_AHEAD_BLOCKS && next < block_count; next++) {
+			bool queued = false;
+			Block *free_block = nullptr;
+			for (Block &block : blocks) {
+				if (block.index == next) {
+					queued = true;
+					break;
+				}
+				if (!free_block && is_stale(block)) {
+					free_block = &block;
+				}
+			}
+			if (queued || !free_block) {
+				continue;
+			}
+			_load_block(*free_block, next);
+			free_block->task = pool->add_native_task(&FileAccessPackCompressed::_decompress_block, free_block, true, "Decompress packed file block");
+		}
+	}
+	last_block = p_index;
+
+	return found;
+}
+
+void FileAccessPackCompressed::seek(uint64_t p_position) {
+	ERR_FAIL_COND_MSG(f.is_null(), "File must be opened before use.");
+
+	if (p_position > length) {
+		p_position = length;
+	}
+	pos = p_position;
+	eof = false;
+}
+
+void FileAccessPackCompressed::seek_end(int64_t p_position) {
+	seek(length + p_position);
+}
+
+uint64_t FileAccessPackCompressed::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
+	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+	ERR_FAIL_COND_V_MSG(f.is_null(), -1, "File must be opened before use.");
+
+	uint64_t read = 0;
+	while (read < p_length) {
+		if (pos >= length) {
+			eof = true;
+			break;
+		}
+		const Block *block = _get_block(pos / block_size);
+		if (!block || block->failed) {
+			eof = true;
+			ERR_FAIL_V_MSG(read, "Compressed packed file is corrupt.");
+		}
+		const uint64_t block_pos = pos % block_size;
+		const uint64_t to_copy = MIN(p_length - read, block->size - block_pos);
+		memcpy(p_dst + read, block->data.ptr() + block_pos, to_copy);
+		read += to_copy;
+		pos += to_copy;
+	}
+	return read;
+}
+
+void FileAccessPackCompressed::flush() {
+	ERR_FAIL();
+}
+
+bool FileAccessPackCompressed::store_buffer(const uint8_t *p_src, uint64_t p_length) {
+	ERR_FAIL_V(false);
+}
+
+void FileAccessPackCompressed::_close() {
+	for (Block &block : blocks) {
+		_wait_block(block);
+		block.index = -1;
+	}
+	f.unref();
+	mapped = nullptr;
+	if (dictionary) {
+		memdelete(dictionary);
+		dictionary = nullptr;
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////
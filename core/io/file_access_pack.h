@@ -31,16 +31,26 @@
 #ifndef FILE_ACCESS_PACK_H
 #define FILE_ACCESS_PACK_H
 
+#include "core/io/compression.h"
 #include "core/io/dir_access.h"
 #include "core/io/file_access.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/os/mutex.h"
 #include "core/string/print_string.h"
 #include "core/templates/hash_set.h"
 #include "core/templates/list.h"
+#include "core/templates/local_vector.h"
 
 // Godot's packed file magic header ("GDPC" in ASCII).
 #define PACK_HEADER_MAGIC 0x43504447
 // The current packed file format version number.
-#define PACK_FORMAT_VERSION 2
+#define PACK_FORMAT_VERSION 3
+// The oldest packed file format version that can still be read. Version 3 added compressed files,
+// packs without any are still written as version 2.
+#define PACK_FORMAT_VERSION_MIN 2
+// Start of a compressed packed file ("GPCZ" in ASCII), see FileAccessPackCompressed.
+#define PACK_COMPRESSED_MAGIC 0x5a435047
+#define PACK_COMPRESSED_HEADER_SIZE 40
 
 enum PackFlags {
 	PACK_DIR_ENCRYPTED = 1 << 0,
@@ -50,6 +60,7 @@ enum PackFlags {
 enum PackFileFlags {
 	PACK_FILE_ENCRYPTED = 1 << 0,
 	PACK_FILE_REMOVAL = 1 << 1,
+	PACK_FILE_COMPRESSED = 1 << 2,
 };
 
 class PackSource;
@@ -67,6 +78,7 @@ public:
 		uint8_t md5[16];
 		PackSource *src = nullptr;
 		bool encrypted;
+		bool compressed = false; // Size is the stored size, see FileAccessPackCompressed.
 	};
 
 private:
@@ -111,7 +123,7 @@ private:
 
 public:
 	void add_pack_source(PackSource *p_source);
-	void add_path(const String &p_pkg_path, const String &p_path, uint64_t p_ofs, uint64_t p_size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, bool p_encrypted = false); // for PackSource
+	void add_path(const String &p_pkg_path, const String &p_path, uint64_t p_ofs, uint64_t p_size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, bool p_encrypted = false, bool p_compressed = false); // for PackSource
 	void remove_path(const String &p_path);
 	uint8_t *get_file_hash(const String &p_path);
 	HashSet<String> get_file_paths() const;
@@ -142,6 +154,18 @@ public:
 };
 
 class PackedSourcePCK : public PackSource {
+	// Packs stay mapped once opened, so packed files read straight from the page cache and
+	// share one file descriptor instead of opening the pack again each. The mappings are pinned,
+	// so views into them stay valid until exit, even after PackedData is gone.
+	HashMap<String, Ref<FileAccess>> mapped_packs;
+	Mutex mapped_packs_mutex;
+
+	// Compression dictionaries shared by compressed files, by pack and offset.
+	HashMap<String, Vector<uint8_t>> dictionaries;
+	Mutex dictionaries_mutex;
+
+	Vector<uint8_t> _get_dictionary(const String &p_pack, uint64_t p_offset, uint32_t p_size);
+
 public:
 	virtual bool try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) override;
 	virtual Ref<FileAccess> get_file(const String &p_path, PackedData::PackedFile *p_file) override;
@@ -156,13 +180,17 @@ public:
 };
 
 class FileAccessPack : public FileAccess {
+	static const uint64_t MAP_WILL_NEED_MAX_SIZE = 8 * 1024 * 1024;
+
 	PackedData::PackedFile pf;
 
 	mutable uint64_t pos;
 	mutable bool eof;
 	uint64_t off;
 
-	Ref<FileAccess> f;
+	Ref<FileAccess> f; // Either a file of its own, or the shared mapped pack (not seeked).
+	const uint8_t *mapped = nullptr; // Start of this file in the mapped pack.
+	bool pinned = false; // The mapped pack is pinned, so spans into it may outlive this file.
 	virtual Error open_internal(const String &p_path, int p_mode_flags) override;
 	virtual uint64_t _get_modified_time(const String &p_file) override { return 0; }
 	virtual BitField<FileAccess::UnixPermissionFlags> _get_unix_permissions(const String &p_file) override { return 0; }
@@ -185,6 +213,13 @@ public:
 
 	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
 
+	virtual const uint8_t *get_mapped_data() const override { return mapped; }
+	virtual const uint8_t *get_buffer_span(uint64_t p_length) const override;
+	virtual void advise(MapAdvice p_advice, uint64_t p_from = 0, uint64_t p_length = 0) const override;
+	virtual bool is_mapping_pinned() const override { return pinned; }
+	virtual uint8_t *get_pinned_span(uint64_t p_length) const override;
+	virtual bool make_mapping_writable(uint64_t p_from, uint64_t p_length) const override;
+
 	virtual void set_big_endian(bool p_big_endian) override;
 
 	virtual Error get_error() const override;
@@ -197,7 +232,94 @@ public:
 
 	virtual void close() override;
 
-	FileAccessPack(const String &p_path, const PackedData::PackedFile &p_file);
+	FileAccessPack(const String &p_path, const PackedData::PackedFile &p_file, const Ref<FileAccess> &p_mapped_pack = Ref<FileAccess>());
+};
+
+// A compressed packed file (PACK_FILE_COMPRESSED). The contents are split into blocks that are
+// compressed on their own and listed in an index, so seeking only decompresses the block it
+// lands in. While reading forward, the next blocks are decompressed on the WorkerThreadPool.
+// Layout, after PACK_COMPRESSED_MAGIC: compression mode, block size, block count, size (64-bit),
+// distance back from this file to its dictionary (64-bit, zstd only), dictionary size, reserved,
+// then the compressed size of each block and the blocks. Blocks that don't shrink are stored as is.
+class FileAccessPackCompressed : public FileAccess {
+	static const uint32_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+	static const uint32_t READ_AHEAD_BLOCKS = 3;
+
+	struct Block {
+		const FileAccessPackCompressed *owner = nullptr;
+		int64_t index = -1;
+		const uint8_t *src = nullptr; // In the mapped pack, or comp.
+		uint32_t src_size = 0;
+		uint32_t size = 0;
+		Vector<uint8_t> comp;
+		Vector<uint8_t> data;
+		WorkerThreadPool::TaskID task = WorkerThreadPool::INVALID_TASK_ID;
+		bool failed = false;
+		Compression::ZstdContext context; // Kept, as the block is reused for the whole file.
+	};
+
+	Ref<FileAccess> f; // The stored file.
+	const uint8_t *mapped = nullptr;
+	Compression::Mode mode = Compression::MODE_ZSTD;
+	uint32_t block_size = 0;
+	uint64_t length = 0;
+	LocalVector<uint64_t> block_offsets; // One past the last block, too.
+	uint64_t dictionary_distance = 0;
+	uint32_t dictionary_size = 0;
+	Compression::ZstdDecompressionDictionary *dictionary = nullptr; // Shared by the blocks.
+
+	mutable Block blocks[READ_AHEAD_BLOCKS + 1];
+	mutable int64_t last_block = -1;
+	mutable uint64_t pos = 0;
+	mutable bool eof = false;
+
+	static void _decompress_block(void *p_block);
+	void _load_block(Block &r_block, int64_t p_index) const;
+	void _wait_block(Block &r_block) const;
+	const Block *_get_block(int64_t p_index) const;
+	void _close();
+
+	virtual Error open_internal(const String &p_path, int p_mode_flags) override { return ERR_UNAVAILABLE; }
+	virtual uint64_t _get_modified_time(const String &p_file) override { return 0; }
+	virtual BitField<FileAccess::UnixPermissionFlags> _get_unix_permissions(const String &p_file) override { return 0; }
+	virtual Error _set_unix_permissions(const String &p_file, BitField<FileAccess::UnixPermissionFlags> p_permissions) override { return FAILED; }
+
+	virtual bool _get_hidden_attribute(const String &p_file) override { return false; }
+	virtual Error _set_hidden_attribute(const String &p_file, bool p_hidden) override { return ERR_UNAVAILABLE; }
+	virtual bool _get_read_only_attribute(const String &p_file) override { return false; }
+	virtual Error _set_read_only_attribute(const String &p_file, bool p_ro) override { return ERR_UNAVAILABLE; }
+
+public:
+	// p_base reads the stored file (a FileAccessPack). Files with a dictionary can only be read
+	// once it's been set.
+	Error open_and_parse(const Ref<FileAccess> &p_base);
+	uint64_t get_dictionary_distance() const { return dictionary_distance; }
+	uint32_t get_dictionary_size() const { return dictionary_size; }
+	void set_dictionary(const Vector<uint8_t> &p_dictionary);
+
+	virtual bool is_open() const override { return f.is_valid(); }
+
+	virtual void seek(uint64_t p_position) override;
+	virtual void seek_end(int64_t p_position = 0) override;
+	virtual uint64_t get_position() const override { return pos; }
+	virtual uint64_t get_length() const override { return length; }
+
+	virtual bool eof_reached() const override { return eof; }
+
+	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
+
+	virtual Error get_error() const override { return eof ? ERR_FILE_EOF : OK; }
+
+	virtual Error resize(int64_t p_length) override { return ERR_UNAVAILABLE; }
+	virtual void flush() override;
+	virtual bool store_buffer(const uint8_t *p_src, uint64_t p_length) override;
+
+	virtual bool file_exists(const String &p_name) override { return false; }
+
+	virtual void close() override { _close(); }
+
+	FileAccessPackCompressed() {}
+	virtual ~FileAccessPackCompressed() { _close(); }
 };
 
 Ref<FileAccess> PackedData::try_open_path(const String &p_path) {
@@ -34,6 +34,8 @@
 #include "core/io/file_access.h"
 #include "core/io/file_access_encrypted.h"
 #include "core/io/file_access_pack.h" // PACK_HEADER_MAGIC, PACK_FORMAT_VERSION
+#include "core/io/marshalls.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/version.h"
 
 static int _get_pad(int p_alignment, int p_n) {
@@ -51,6 +53,10 @@ void PCKPacker::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("add_file", "target_path", "source_path", "encrypt"), &PCKPacker::add_file, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("add_file_removal", "target_path"), &PCKPacker::add_file_removal);
 	ClassDB::bind_method(D_METHOD("flush", "verbose"), &PCKPacker::flush, DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("set_compression_enabled", "enabled"), &PCKPacker::set_compression_enabled);
+	ClassDB::bind_method(D_METHOD("is_compression_enabled"), &PCKPacker::is_compression_enabled);
+	ClassDB::bind_method(D_METHOD("set_compression_dictionaries_enabled", "enabled"), &PCKPacker::set_compression_dictionaries_enabled);
+	ClassDB::bind_method(D_METHOD("is_compression_dictionaries_enabled"), &PCKPacker::is_compression_dictionaries_enabled);
 }
 
 Error PCKPacker::pck_start(const String &p_pck_path, int p_alignment, const String &p_key, bool p_encrypt_directory) {
@@ -90,7 +96,7 @@ Error PCKPacker::pck_start(const String &p_pck_path, int p_alignment, const Stri
 	alignment = p_alignment;
 
 	file->store_32(PACK_HEADER_MAGIC);
-	file->store_32(PACK_FORMAT_VERSION);
+	file->store_32(PACK_FORMAT_VERSION_MIN); // Raised by flush() if there are compressed files.
 	file->store_32(VERSION_MAJOR);
 	file->store_32(VERSION_MINOR);
 	file->store_32(VERSION_PATCH);
@@ -102,7 +108,6 @@ Error PCKPacker::pck_start(const String &p_pck_path, int p_alignment, const Stri
 	file->store_32(pack_flags); // flags
 
 	files.clear();
-	ofs = 0;
 
 	return OK;
 }
@@ -114,7 +119,6 @@ Error PCKPacker::add_file_removal(const String &p_target_path) {
 	// Simplify path here and on every 'files' access so that paths that have extra '/'
 	// symbols or 'res://' in them still match the MD5 hash for the saved path.
 	pf.path = p_target_path.simplify_path().trim_prefix("res://");
-	pf.ofs = ofs;
 	pf.size = 0;
 	pf.removal = true;
 
@@ -139,7 +143,6 @@ Error PCKPacker::add_file(const String &p_target_path, const String &p_source_pa
 	// symbols or 'res://' in them still match the MD5 hash for the saved path.
 	pf.path = p_target_path.simplify_path().trim_prefix("res://");
 	pf.src_path = p_source_path;
-	pf.ofs = ofs;
 	pf.size = f->get_length();
 
 	Vector<uint8_t> data = FileAccess::get_file_as_bytes(p_source_path);
@@ -153,27 +156,185 @@ Error PCKPacker::add_file(const String &p_target_path, const String &p_source_pa
 	}
 	pf.encrypted = p_encrypt;
 
-	uint64_t _size = pf.size;
-	if (p_encrypt) { // Add encryption overhead.
-		if (_size % 16) { // Pad to encryption block size.
-			_size += 16 - (_size % 16);
+	files.push_back(pf);
+
+	return OK;
+}
+
+Vector<uint8_t> PCKPacker::_compress(Compression::ZstdContext &r_context, const Vector<uint8_t> &p_data, const Compression::ZstdCompressionDictionary *p_dictionary, uint32_t p_dictionary_size) {
+	const uint64_t size = p_data.size();
+	const uint32_t block_count = (size + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE;
+
+	Vector<uint8_t> stored;
+	stored.resize(PACK_COMPRESSED_HEADER_SIZE + block_count * 4);
+	uint8_t *header = stored.ptrw();
+	encode_uint32(PACK_COMPRESSED_MAGIC, header);
+	encode_uint32(Compression::MODE_ZSTD, header + 4);
+	encode_uint32(COMPRESSION_BLOCK_SIZE, header + 8);
+	encode_uint32(block_count, header + 12);
+	encode_uint64(size, header + 16);
+	encode_uint64(0, header + 24); // Distance to the dictionary, set once the offsets are known.
+	encode_uint32(p_dictionary_size, header + 32);
+	encode_uint32(0, header + 36); // Reserved.
+
+	Vector<uint8_t> block;
+	block.resize(Compression::get_max_compressed_buffer_size(COMPRESSION_BLOCK_SIZE, Compression::MODE_ZSTD));
+	for (uint32_t i = 0; i < block_count; i++) {
+		const uint8_t *src = p_data.ptr() + uint64_t(i) * COMPRESSION_BLOCK_SIZE;
+		const int src_size = MIN(uint64_t(COMPRESSION_BLOCK_SIZE), size - uint64_t(i) * COMPRESSION_BLOCK_SIZE);
+		int block_size = Compression::compress_zstd(r_context, block.ptrw(), src, src_size, p_dictionary);
+		const uint8_t *block_src = block.ptr();
+		if (block_size <= 0 || block_size >= src_size) {
+			// Doesn't shrink, store it as is.
+			block_size = src_size;
+			block_src = src;
 		}
-		_size += 16; // hash
-		_size += 8; // data size
-		_size += 16; // iv
+
+		const int64_t block_ofs = stored.size();
+		stored.resize(block_ofs + block_size);
+		encode_uint32(block_size, stored.ptrw() + PACK_COMPRESSED_HEADER_SIZE + i * 4);
+		memcpy(stored.ptrw() + block_ofs, block_src, block_size);
 	}
 
-	int pad = _get_pad(alignment, ofs + _size);
-	ofs = ofs + _size + pad;
+	return stored;
+}
 
-	files.push_back(pf);
+Vector<uint8_t> PCKPacker::_build_dictionary(const Vector<File *> &p_files) {
+	// zstd can use any data as a dictionary. Files of the same type mostly share their beginning
+	// (headers, class and property names), so an equal share of the start of each one is used.
+	const uint32_t share = DICTIONARY_MAX_SIZE / p_files.size();
 
-	return OK;
+	Vector<uint8_t> dictionary;
+	for (const File *pf : p_files) {
+		Ref<FileAccess> src = FileAccess::open(pf->src_path, FileAccess::READ);
+		if (src.is_null()) {
+			continue;
+		}
+		dictionary.append_array(src->get_buffer(MIN(uint64_t(share), pf->size)));
+	}
+	return dictionary;
+}
+
+void PCKPacker::_compress_files(Vector<Vector<uint8_t>> &r_dictionaries) {
+	Vector<File *> candidates;
+	HashMap<String, Vector<File *>> groups;
+	File *w = files.ptrw();
+	for (int i = 0; i < files.size(); i++) {
+		if (w[i].removal || w[i].encrypted || w[i].size == 0) {
+			continue;
+		}
+		candidates.push_back(&w[i]);
+		groups[w[i].path.get_extension().to_lower()].push_back(&w[i]);
+	}
+
+	Vector<Vector<uint8_t>> dictionaries;
+	if (compression_dictionaries_enabled) {
+		for (const KeyValue<String, Vector<File *>> &E : groups) {
+			if (E.value.size() < DICTIONARY_MIN_FILES) {
+				continue;
+			}
+			for (File *pf : E.value) {
+				pf->dictionary = dictionaries.size();
+			}
+			dictionaries.push_back(_build_dictionary(E.value));
+		}
+	}
+
+	// Digested once, then shared by all threads.
+	LocalVector<Compression::ZstdCompressionDictionary *> digested_dictionaries;
+	for (const Vector<uint8_t> &dictionary : dictionaries) {
+		digested_dictionaries.push_back(memnew(Compression::ZstdCompressionDictionary(dictionary.ptr(), dictionary.size())));
+	}
+
+	WorkerThreadPool::get_singleton()->parallel_for(
+			candidates.size(), [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+				Compression::ZstdContext context;
+				for (uint32_t i = p_from; i < p_to; i++) {
+					File *pf = candidates[i];
+					const Vector<uint8_t> data = FileAccess::get_file_as_bytes(pf->src_path);
+					Vector<uint8_t> stored = _compress(context, data, nullptr, 0);
+					if (pf->dictionary >= 0) {
+						// Keep whichever is smaller; the dictionary is only written once.
+						Vector<uint8_t> with_dictionary = _compress(context, data, digested_dictionaries[pf->dictionary], dictionaries[pf->dictionary].size());
+						if (with_dictionary.size() < stored.size()) {
+							stored = with_dictionary;
+						} else {
+							pf->dictionary = -1;
+						}
+					}
+					if (stored.size() < data.size()) {
+						pf->compressed = true;
+						pf->stored = stored;
+					} else {
+						pf->dictionary = -1;
+					}
+				}
+			},
+			1, "PCKPacker compression");
+
+	for (Compression::ZstdCompressionDictionary *dictionary : digested_dictionaries) {
+		memdelete(dictionary);
+	}
+
+	// Only keep dictionaries that are used.
+	Vector<int> remap;
+	remap.resize(dictionaries.size());
+	remap.fill(-1);
+	for (File *pf : candidates) {
+		if (pf->dictionary >= 0) {
+			if (remap[pf->dictionary] < 0) {
+				remap.write[pf->dictionary] = r_dictionaries.size();
+				r_dictionaries.push_back(dictionaries[pf->dictionary]);
+			}
+			pf->dictionary = remap[pf->dictionary];
+		}
+	}
 }
 
 Error PCKPacker::flush(bool p_verbose) {
 	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_INVALID_PARAMETER, "File must be opened before use.");
 
+	// Compress first, so the stored sizes, and with them the offsets, are known for the directory.
+	Vector<Vector<uint8_t>> dictionaries;
+	if (compression_enabled) {
+		_compress_files(dictionaries);
+	}
+
+	// Dictionaries come first in the file data.
+	uint64_t ofs = 0;
+	Vector<uint64_t> dictionary_offsets;
+	for (const Vector<uint8_t> &dictionary : dictionaries) {
+		dictionary_offsets.push_back(ofs);
+		ofs += dictionary.size();
+		ofs += _get_pad(alignment, ofs);
+	}
+
+	bool has_compressed = false;
+	File *w = files.ptrw();
+	for (int i = 0; i < files.size(); i++) {
+		w[i].ofs = ofs;
+		if (w[i].removal) {
+			continue;
+		}
+		has_compressed = has_compressed || w[i].compressed;
+
+		uint64_t _size = w[i].compressed ? w[i].stored.size() : w[i].size;
+		if (w[i].encrypted) { // Add encryption overhead.
+			if (_size % 16) { // Pad to encryption block size.
+				_size += 16 - (_size % 16);
+			}
+			_size += 16; // hash
+			_size += 8; // data size
+			_size += 16; // iv
+		}
+		if (w[i].dictionary >= 0) {
+			encode_uint64(w[i].ofs - dictionary_offsets[w[i].dictionary], w[i].stored.ptrw() + 24); // See _compress().
+		}
+
+		int pad = _get_pad(alignment, ofs + _size);
+		ofs = ofs + _size + pad;
+	}
+
 	int64_t file_base_ofs = file->get_position();
 	file->store_64(0); // files base
 
@@ -209,7 +370,7 @@ Error PCKPacker::flush(bool p_verbose) {
 		}
 
 		fhead->store_64(files[i].ofs);
-		fhead->store_64(files[i].size); // pay attention here, this is where file is
+		fhead->store_64(files[i].compressed ? files[i].stored.size() : files[i].size); // pay attention here, this is where file is
 		fhead->store_buffer(files[i].md5.ptr(), 16); //also save md5 for file
 
 		uint32_t flags = 0;
@@ -219,6 +380,9 @@ Error PCKPacker::flush(bool p_verbose) {
 		if (files[i].removal) {
 			flags |= PACK_FILE_REMOVAL;
 		}
+		if (files[i].compressed) {
+			flags |= PACK_FILE_COMPRESSED;
+		}
 		fhead->store_32(flags);
 	}
 
@@ -235,8 +399,20 @@ Error PCKPacker::flush(bool p_verbose) {
 	uint64_t file_base = file->get_position();
 	file->seek(file_base_ofs);
 	file->store_64(file_base); // update files base
+	if (has_compressed) {
+		file->seek(4); // Right after the magic, see pck_start().
+		file->store_32(PACK_FORMAT_VERSION);
+	}
 	file->seek(file_base);
 
+	for (const Vector<uint8_t> &dictionary : dictionaries) {
+		file->store_buffer(dictionary);
+		int pad = _get_pad(alignment, file->get_position());
+		for (int j = 0; j < pad; j++) {
+			file->store_8(0);
+		}
+	}
+
 	const uint32_t buf_max = 65536;
 	uint8_t *buf = memnew_arr(uint8_t, buf_max);
 
@@ -246,28 +422,33 @@ Error PCKPacker::flush(bool p_verbose) {
 			continue;
 		}
 
-		Ref<FileAccess> src = FileAccess::open(files[i].src_path, FileAccess::READ);
-		uint64_t to_write = files[i].size;
-
-		Ref<FileAccess> ftmp = file;
-		if (files[i].encrypted) {
-			fae.instantiate();
-			ERR_FAIL_COND_V(fae.is_null(), ERR_CANT_CREATE);
-
-			Error err = fae->open_and_parse(file, key, FileAccessEncrypted::MODE_WRITE_AES256, false);
-			ERR_FAIL_COND_V(err != OK, ERR_CANT_CREATE);
-			ftmp = fae;
-		}
+		if (files[i].compressed) {
+			file->store_buffer(files[i].stored);
+			w[i].stored.clear();
+		} else {
+			Ref<FileAccess> src = FileAccess::open(files[i].src_path, FileAccess::READ);
+			uint64_t to_write = files[i].size;
+
+			Ref<FileAccess> ftmp = file;
+			if (files[i].encrypted) {
+				fae.instantiate();
+				ERR_FAIL_COND_V(fae.is_null(), ERR_CANT_CREATE);
+
+				Error err = fae->open_and_parse(file, key, FileAccessEncrypted::MODE_WRITE_AES256, false);
+				ERR_FAIL_COND_V(err != OK, ERR_CANT_CREATE);
+				ftmp = fae;
+			}
 
-		while (to_write > 0) {
-			uint64_t read = src->get_buffer(buf, MIN(to_write, buf_max));
-			ftmp->store_buffer(buf, read);
-			to_write -= read;
-		}
+			while (to_write > 0) {
+				uint64_t read = src->get_buffer(buf, MIN(to_write, buf_max));
+				ftmp->store_buffer(buf, read);
+				to_write -= read;
+			}
 
-		if (fae.is_valid()) {
-			ftmp.unref();
-			fae.unref();
+			if (fae.is_valid()) {
+				ftmp.unref();
+				fae.unref();
+			}
 		}
 
 		int pad = _get_pad(alignment, file->get_position());
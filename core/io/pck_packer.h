@@ -31,6 +31,7 @@
 #ifndef PCK_PACKER_H
 #define PCK_PACKER_H
 
+#include "core/io/compression.h"
 #include "core/object/ref_counted.h"
 
 class FileAccess;
@@ -38,12 +39,19 @@ class FileAccess;
 class PCKPacker : public RefCounted {
 	GDCLASS(PCKPacker, RefCounted);
 
+	// Compressed files are split into blocks of this size (see FileAccessPackCompressed).
+	static const uint32_t COMPRESSION_BLOCK_SIZE = 64 * 1024;
+	// Files of the same type share a dictionary once there are this many of them.
+	static const int DICTIONARY_MIN_FILES = 8;
+	static const uint32_t DICTIONARY_MAX_SIZE = 112 * 1024;
+
 	Ref<FileAccess> file;
 	int alignment = 0;
-	uint64_t ofs = 0;
 
 	Vector<uint8_t> key;
 	bool enc_dir = false;
+	bool compression_enabled = false;
+	bool compression_dictionaries_enabled = false;
 
 	static void _bind_methods();
 
@@ -54,16 +62,28 @@ class PCKPacker : public RefCounted {
 		uint64_t size = 0;
 		bool encrypted = false;
 		bool removal = false;
+		bool compressed = false;
 		Vector<uint8_t> md5;
+		Vector<uint8_t> stored; // Contents as written to the pack, if compressed.
+		int dictionary = -1;
 	};
 	Vector<File> files;
 
+	static Vector<uint8_t> _compress(Compression::ZstdContext &r_context, const Vector<uint8_t> &p_data, const Compression::ZstdCompressionDictionary *p_dictionary, uint32_t p_dictionary_size);
+	static Vector<uint8_t> _build_dictionary(const Vector<File *> &p_files);
+	void _compress_files(Vector<Vector<uint8_t>> &r_dictionaries);
+
 public:
 	Error pck_start(const String &p_pck_path, int p_alignment = 32, const String &p_key = "0000000000000000000000000000000000000000000000000000000000000000", bool p_encrypt_directory = false);
 	Error add_file(const String &p_target_path, const String &p_source_path, bool p_encrypt = false);
 	Error add_file_removal(const String &p_target_path);
 	Error flush(bool p_verbose = false);
 
+	void set_compression_enabled(bool p_enabled) { compression_enabled = p_enabled; }
+	bool is_compression_enabled() const { return compression_enabled; }
+	void set_compression_dictionaries_enabled(bool p_enabled) { compression_dictionaries_enabled = p_enabled; }
+	bool is_compression_dictionaries_enabled() const { return compression_dictionaries_enabled; }
+
 	PCKPacker() {}
 };
 
@@ -33,6 +33,7 @@
 #include "core/config/project_settings.h"
 #include "core/io/dir_access.h"
 #include "core/io/file_access_compressed.h"
+#include "core/io/marshalls.h"
 #include "core/io/missing_resource.h"
 #include "core/object/script_language.h"
 #include "core/version.h"
@@ -93,9 +94,21 @@ enum {
 	// Version 4: New string ID for ext/subresources, breaks forward compat.
 	// Version 5: Ability to store script class in the header.
 	// Version 6: Added PackedVector4Array Variant type.
-	FORMAT_VERSION = 6,
+	// Version 7: Packed arrays of plain values are stored as aligned blobs.
+	FORMAT_VERSION = 7,
 	FORMAT_VERSION_CAN_RENAME_DEPS = 1,
 	FORMAT_VERSION_NO_NODEPATH_PROPERTY = 3,
+	FORMAT_VERSION_PACKED_BLOBS = 7,
+	// A blob is the amount of padding, the padding itself (up to BLOB_ALIGNMENT in the file), then
+	// a header laid out like the one CowData keeps in front of its data (a reference count of one,
+	// which is never released, and the size), then the elements as they are in memory. Loaders can
+	// turn a blob inside a pinned mapping into a Vector without copying it. The padding is stored
+	// because renaming dependencies moves the blobs.
+	BLOB_ALIGNMENT = 16,
+	BLOB_HEADER_SIZE = 16,
+	// Views make the page holding the header writable, which then costs a private copy of it, so
+	// smaller blobs are copied instead.
+	BLOB_VIEW_MIN_SIZE = 16 * 1024,
 };
 
 void ResourceLoaderBinary::_advance_padding(uint32_t p_len) {
@@ -107,6 +120,46 @@ void ResourceLoaderBinary::_advance_padding(uint32_t p_len) {
 	}
 }
 
+template <typename T>
+Error ResourceLoaderBinary::_parse_blob(Vector<T> &r_array, uint32_t p_len, bool p_native, bool &r_read) {
+	r_read = false;
+	if (ver_format < FORMAT_VERSION_PACKED_BLOBS) {
+		return OK;
+	}
+
+	const uint32_t padding = f->get_32();
+	ERR_FAIL_COND_V(padding >= BLOB_ALIGNMENT, ERR_FILE_CORRUPT);
+
+#ifndef BIG_ENDIAN_ENABLED
+	if (p_native && p_len > 0 && !f->is_big_endian() && Vector<T>::EXTERNAL_HEADER_SIZE == BLOB_HEADER_SIZE) {
+		const uint64_t header_pos = f->get_position() + padding;
+		uint8_t *blob = f->get_pinned_span(padding + BLOB_HEADER_SIZE + uint64_t(p_len) * sizeof(T));
+		if (blob) {
+			uint8_t *header = blob + padding;
+			ERR_FAIL_COND_V(decode_uint64(header + 8) != p_len, ERR_FILE_CORRUPT);
+			T *data = reinterpret_cast<T *>(header + BLOB_HEADER_SIZE);
+			// The pack itself may have placed the file off the alignment, in which case it's copied.
+			// Only the reference count is ever written to.
+			const bool view = (uintptr_t)header % BLOB_ALIGNMENT == 0 && uint64_t(p_len) * sizeof(T) >= BLOB_VIEW_MIN_SIZE &&
+					f->make_mapping_writable(header_pos, BLOB_HEADER_SIZE);
+			if (!view || !r_array._ref_external(data)) {
+				r_array.resize(p_len);
+				memcpy(r_array.ptrw(), data, p_len * sizeof(T));
+			}
+			r_read = true;
+			return OK;
+		}
+	}
+#endif
+
+	for (uint32_t i = 0; i < padding; i++) {
+		f->get_8();
+	}
+	f->get_64(); // Reference count, only used in mappings.
+	ERR_FAIL_COND_V(f->get_64() != p_len, ERR_FILE_CORRUPT);
+	return OK;
+}
+
 static Error read_reals(real_t *dst, Ref<FileAccess> &f, size_t count) {
 	if (f->real_is_double) {
 		if constexpr (sizeof(real_t) == 8) {
@@ -510,9 +563,14 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<uint8_t> array;
-			array.resize(len);
-			uint8_t *w = array.ptrw();
-			f->get_buffer(w, len);
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				uint8_t *w = array.ptrw();
+				f->get_buffer(w, len);
+			}
 			_advance_padding(len);
 
 			r_v = array;
@@ -522,18 +580,23 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<int32_t> array;
-			array.resize(len);
-			int32_t *w = array.ptrw();
-			f->get_buffer((uint8_t *)w, len * sizeof(int32_t));
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				int32_t *w = array.ptrw();
+				f->get_buffer((uint8_t *)w, len * sizeof(int32_t));
 #ifdef BIG_ENDIAN_ENABLED
-			{
-				uint32_t *ptr = (uint32_t *)w.ptr();
-				for (int i = 0; i < len; i++) {
-					ptr[i] = BSWAP32(ptr[i]);
+				{
+					uint32_t *ptr = (uint32_t *)w.ptr();
+					for (int i = 0; i < len; i++) {
+						ptr[i] = BSWAP32(ptr[i]);
+					}
 				}
-			}
 
 #endif
+			}
 
 			r_v = array;
 		} break;
@@ -541,18 +604,23 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<int64_t> array;
-			array.resize(len);
-			int64_t *w = array.ptrw();
-			f->get_buffer((uint8_t *)w, len * sizeof(int64_t));
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				int64_t *w = array.ptrw();
+				f->get_buffer((uint8_t *)w, len * sizeof(int64_t));
 #ifdef BIG_ENDIAN_ENABLED
-			{
-				uint64_t *ptr = (uint64_t *)w.ptr();
-				for (int i = 0; i < len; i++) {
-					ptr[i] = BSWAP64(ptr[i]);
+				{
+					uint64_t *ptr = (uint64_t *)w.ptr();
+					for (int i = 0; i < len; i++) {
+						ptr[i] = BSWAP64(ptr[i]);
+					}
 				}
-			}
 
 #endif
+			}
 
 			r_v = array;
 		} break;
@@ -560,18 +628,23 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<float> array;
-			array.resize(len);
-			float *w = array.ptrw();
-			f->get_buffer((uint8_t *)w, len * sizeof(float));
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				float *w = array.ptrw();
+				f->get_buffer((uint8_t *)w, len * sizeof(float));
 #ifdef BIG_ENDIAN_ENABLED
-			{
-				uint32_t *ptr = (uint32_t *)w.ptr();
-				for (int i = 0; i < len; i++) {
-					ptr[i] = BSWAP32(ptr[i]);
+				{
+					uint32_t *ptr = (uint32_t *)w.ptr();
+					for (int i = 0; i < len; i++) {
+						ptr[i] = BSWAP32(ptr[i]);
+					}
 				}
-			}
 
 #endif
+			}
 
 			r_v = array;
 		} break;
@@ -579,18 +652,23 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<double> array;
-			array.resize(len);
-			double *w = array.ptrw();
-			f->get_buffer((uint8_t *)w, len * sizeof(double));
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				double *w = array.ptrw();
+				f->get_buffer((uint8_t *)w, len * sizeof(double));
 #ifdef BIG_ENDIAN_ENABLED
-			{
-				uint64_t *ptr = (uint64_t *)w.ptr();
-				for (int i = 0; i < len; i++) {
-					ptr[i] = BSWAP64(ptr[i]);
+				{
+					uint64_t *ptr = (uint64_t *)w.ptr();
+					for (int i = 0; i < len; i++) {
+						ptr[i] = BSWAP64(ptr[i]);
+					}
 				}
-			}
 
 #endif
+			}
 
 			r_v = array;
 		} break;
@@ -610,11 +688,16 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<Vector2> array;
-			array.resize(len);
-			Vector2 *w = array.ptrw();
-			static_assert(sizeof(Vector2) == 2 * sizeof(real_t));
-			const Error err = read_reals(reinterpret_cast<real_t *>(w), f, len * 2);
+			bool read = false;
+			Error err = _parse_blob(array, len, f->real_is_double == (sizeof(real_t) == 8), read);
 			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				Vector2 *w = array.ptrw();
+				static_assert(sizeof(Vector2) == 2 * sizeof(real_t));
+				err = read_reals(reinterpret_cast<real_t *>(w), f, len * 2);
+				ERR_FAIL_COND_V(err != OK, err);
+			}
 
 			r_v = array;
 
@@ -623,11 +706,16 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<Vector3> array;
-			array.resize(len);
-			Vector3 *w = array.ptrw();
-			static_assert(sizeof(Vector3) == 3 * sizeof(real_t));
-			const Error err = read_reals(reinterpret_cast<real_t *>(w), f, len * 3);
+			bool read = false;
+			Error err = _parse_blob(array, len, f->real_is_double == (sizeof(real_t) == 8), read);
 			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				Vector3 *w = array.ptrw();
+				static_assert(sizeof(Vector3) == 3 * sizeof(real_t));
+				err = read_reals(reinterpret_cast<real_t *>(w), f, len * 3);
+				ERR_FAIL_COND_V(err != OK, err);
+			}
 
 			r_v = array;
 
@@ -636,20 +724,25 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<Color> array;
-			array.resize(len);
-			Color *w = array.ptrw();
-			// Colors always use `float` even with double-precision support enabled
-			static_assert(sizeof(Color) == 4 * sizeof(float));
-			f->get_buffer((uint8_t *)w, len * sizeof(float) * 4);
+			bool read = false;
+			const Error err = _parse_blob(array, len, true, read);
+			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				Color *w = array.ptrw();
+				// Colors always use `float` even with double-precision support enabled
+				static_assert(sizeof(Color) == 4 * sizeof(float));
+				f->get_buffer((uint8_t *)w, len * sizeof(float) * 4);
 #ifdef BIG_ENDIAN_ENABLED
-			{
-				uint32_t *ptr = (uint32_t *)w.ptr();
-				for (int i = 0; i < len * 4; i++) {
-					ptr[i] = BSWAP32(ptr[i]);
+				{
+					uint32_t *ptr = (uint32_t *)w.ptr();
+					for (int i = 0; i < len * 4; i++) {
+						ptr[i] = BSWAP32(ptr[i]);
+					}
 				}
-			}
 
 #endif
+			}
 
 			r_v = array;
 		} break;
@@ -657,11 +750,16 @@ Error ResourceLoaderBinary::parse_variant(Variant &r_v) {
 			uint32_t len = f->get_32();
 
 			Vector<Vector4> array;
-			array.resize(len);
-			Vector4 *w = array.ptrw();
-			static_assert(sizeof(Vector4) == 4 * sizeof(real_t));
-			const Error err = read_reals(reinterpret_cast<real_t *>(w), f, len * 4);
+			bool read = false;
+			Error err = _parse_blob(array, len, f->real_is_double == (sizeof(real_t) == 8), read);
 			ERR_FAIL_COND_V(err != OK, err);
+			if (!read) {
+				array.resize(len);
+				Vector4 *w = array.ptrw();
+				static_assert(sizeof(Vector4) == 4 * sizeof(real_t));
+				err = read_reals(reinterpret_cast<real_t *>(w), f, len * 4);
+				ERR_FAIL_COND_V(err != OK, err);
+			}
 
 			r_v = array;
 
@@ -1220,7 +1318,8 @@ Ref<Resource> ResourceFormatLoaderBinary::load(const String &p_path, const Strin
 	}
 
 	Error err;
-	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ, &err);
+	// Mapped, so packed arrays come straight from the page cache, or aren't copied at all from packs.
+	Ref<FileAccess> f = FileAccess::open_mapped(p_path, &err);
 
 	ERR_FAIL_COND_V_MSG(err != OK, Ref<Resource>(), vformat("Cannot open file '%s'.", p_path));
 
@@ -1592,6 +1691,24 @@ void ResourceFormatSaverBinaryInstance::_pad_buffer(Ref<FileAccess> f, int p_byt
 	}
 }
 
+bool ResourceFormatSaverBinaryInstance::_store_blob(Ref<FileAccess> f, const void *p_data, uint32_t p_len, uint64_t p_size) {
+	const uint32_t padding = (BLOB_ALIGNMENT - (f->get_position() + 4) % BLOB_ALIGNMENT) % BLOB_ALIGNMENT;
+	f->store_32(padding);
+	for (uint32_t i = 0; i < padding; i++) {
+		f->store_8(0);
+	}
+	f->store_64(1); // Reference count, never released (see _parse_blob()).
+	f->store_64(p_len);
+
+#ifndef BIG_ENDIAN_ENABLED
+	if (!f->is_big_endian()) {
+		f->store_buffer((const uint8_t *)p_data, p_size);
+		return true;
+	}
+#endif
+	return false;
+}
+
 void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const Variant &p_property, HashMap<Ref<Resource>, int> &resource_map, HashMap<Ref<Resource>, int> &external_resources, HashMap<StringName, int> &string_map, const PropertyInfo &p_hint) {
 	switch (p_property.get_type()) {
 		case Variant::NIL: {
@@ -1900,7 +2017,9 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const uint8_t *r = arr.ptr();
-			f->store_buffer(r, len);
+			if (!_store_blob(f, r, len, len)) {
+				f->store_buffer(r, len); // Bytes have no byte order.
+			}
 			_pad_buffer(f, len);
 
 		} break;
@@ -1910,8 +2029,10 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const int32_t *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_32(uint32_t(r[i]));
+			if (!_store_blob(f, r, len, len * sizeof(int32_t))) {
+				for (int i = 0; i < len; i++) {
+					f->store_32(uint32_t(r[i]));
+				}
 			}
 
 		} break;
@@ -1921,8 +2042,10 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const int64_t *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_64(uint64_t(r[i]));
+			if (!_store_blob(f, r, len, len * sizeof(int64_t))) {
+				for (int i = 0; i < len; i++) {
+					f->store_64(uint64_t(r[i]));
+				}
 			}
 
 		} break;
@@ -1932,8 +2055,10 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const float *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_float(r[i]);
+			if (!_store_blob(f, r, len, len * sizeof(float))) {
+				for (int i = 0; i < len; i++) {
+					f->store_float(r[i]);
+				}
 			}
 
 		} break;
@@ -1943,8 +2068,10 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const double *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_double(r[i]);
+			if (!_store_blob(f, r, len, len * sizeof(double))) {
+				for (int i = 0; i < len; i++) {
+					f->store_double(r[i]);
+				}
 			}
 
 		} break;
@@ -1965,9 +2092,11 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const Vector2 *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_real(r[i].x);
-				f->store_real(r[i].y);
+			if (!_store_blob(f, r, len, len * sizeof(Vector2))) {
+				for (int i = 0; i < len; i++) {
+					f->store_real(r[i].x);
+					f->store_real(r[i].y);
+				}
 			}
 		} break;
 
@@ -1977,10 +2106,12 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const Vector3 *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_real(r[i].x);
-				f->store_real(r[i].y);
-				f->store_real(r[i].z);
+			if (!_store_blob(f, r, len, len * sizeof(Vector3))) {
+				for (int i = 0; i < len; i++) {
+					f->store_real(r[i].x);
+					f->store_real(r[i].y);
+					f->store_real(r[i].z);
+				}
 			}
 		} break;
 
@@ -1990,11 +2121,13 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const Color *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_float(r[i].r);
-				f->store_float(r[i].g);
-				f->store_float(r[i].b);
-				f->store_float(r[i].a);
+			if (!_store_blob(f, r, len, len * sizeof(Color))) {
+				for (int i = 0; i < len; i++) {
+					f->store_float(r[i].r);
+					f->store_float(r[i].g);
+					f->store_float(r[i].b);
+					f->store_float(r[i].a);
+				}
 			}
 
 		} break;
@@ -2004,11 +2137,13 @@ void ResourceFormatSaverBinaryInstance::write_variant(Ref<FileAccess> f, const V
 			int len = arr.size();
 			f->store_32(uint32_t(len));
 			const Vector4 *r = arr.ptr();
-			for (int i = 0; i < len; i++) {
-				f->store_real(r[i].x);
-				f->store_real(r[i].y);
-				f->store_real(r[i].z);
-				f->store_real(r[i].w);
+			if (!_store_blob(f, r, len, len * sizeof(Vector4))) {
+				for (int i = 0; i < len; i++) {
+					f->store_real(r[i].x);
+					f->store_real(r[i].y);
+					f->store_real(r[i].z);
+					f->store_real(r[i].w);
+				}
 			}
 
 		} break;
@@ -2094,6 +2229,17 @@ void ResourceFormatSaverBinaryInstance::_find_resources(const Variant &p_variant
 				_find_resources(v);
 			}
 		} break;
+		case Variant::PACKED_BYTE_ARRAY:
+		case Variant::PACKED_INT32_ARRAY:
+		case Variant::PACKED_INT64_ARRAY:
+		case Variant::PACKED_FLOAT32_ARRAY:
+		case Variant::PACKED_FLOAT64_ARRAY:
+		case Variant::PACKED_VECTOR2_ARRAY:
+		case Variant::PACKED_VECTOR3_ARRAY:
+		case Variant::PACKED_COLOR_ARRAY:
+		case Variant::PACKED_VECTOR4_ARRAY: {
+			has_packed_arrays = true;
+		} break;
 		case Variant::NODE_PATH: {
 			//take the chance and save node path strings
 			NodePath np = p_variant;
@@ -2188,7 +2334,8 @@ Error ResourceFormatSaverBinaryInstance::save(const String &p_path, const Ref<Re
 	f->store_32(0); //64 bits file, false for now
 	f->store_32(VERSION_MAJOR);
 	f->store_32(VERSION_MINOR);
-	f->store_32(FORMAT_VERSION);
+	// Older versions can still load files without blobs.
+	f->store_32(has_packed_arrays ? FORMAT_VERSION : FORMAT_VERSION_PACKED_BLOBS - 1);
 
 	if (f->get_error() != OK && f->get_error() != ERR_FILE_EOF) {
 		return ERR_CANT_CREATE;
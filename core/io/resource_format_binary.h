@@ -80,6 +80,11 @@ class ResourceLoaderBinary {
 
 	String get_unicode_string();
 	void _advance_padding(uint32_t p_len);
+	// Reads the blob header of a packed array. r_read is set if the elements were read too, which
+	// happens (without copying) when the file is a pinned mapping and p_native says the elements
+	// are stored exactly as they are in memory.
+	template <typename T>
+	Error _parse_blob(Vector<T> &r_array, uint32_t p_len, bool p_native, bool &r_read);
 
 	HashMap<String, String> remaps;
 	Error error = OK;
@@ -147,6 +152,7 @@ class ResourceFormatSaverBinaryInstance {
 
 	HashMap<Ref<Resource>, int> external_resources;
 	List<Ref<Resource>> saved_resources;
+	bool has_packed_arrays = false; // Needs FORMAT_VERSION_PACKED_BLOBS.
 
 	struct Property {
 		int name_idx;
@@ -160,6 +166,9 @@ class ResourceFormatSaverBinaryInstance {
 	};
 
 	static void _pad_buffer(Ref<FileAccess> f, int p_bytes);
+	// Writes the blob header of a packed array, then the elements straight from memory if their
+	// byte order allows it. Returns false if the caller still has to store the elements.
+	static bool _store_blob(Ref<FileAccess> f, const void *p_data, uint32_t p_len, uint64_t p_size);
 	void _find_resources(const Variant &p_variant, bool p_main = false);
 	static void save_unicode_string(Ref<FileAccess> f, const String &p_string, bool p_bit_on_len = false);
 	int get_string_index(const String &p_string);
@@ -390,11 +390,22 @@ void ResourceLoader::_run_load_task(void *p_userdata) {
 	}
 	// --
 
+	LocalVector<Ref<LoadToken>> prefetched_tokens;
+	if (load_task.prefetch_dependencies) {
+		_prefetch_dependencies(load_task, prefetched_tokens);
+	}
+
 	bool xl_remapped = false;
 	const String &remapped_path = _path_remap(load_task.local_path, &xl_remapped);
 
 	Error load_err = OK;
 	Ref<Resource> res = _load(remapped_path, remapped_path != load_task.local_path ? load_task.local_path : String(), load_task.type_hint, load_task.cache_mode, &load_err, load_task.use_sub_threads, &load_task.progress);
+	// The dependencies that were needed are referenced by the resource by now, but the ones it
+	// didn't get to may still be loading, and their tasks can't go away until they are done.
+	for (Ref<LoadToken> &token : prefetched_tokens) {
+		_load_complete(*token.ptr(), nullptr);
+	}
+	prefetched_tokens.clear();
 	if (MessageQueue::get_singleton() != MessageQueue::get_main_singleton()) {
 		MessageQueue::get_singleton()->flush();
 	}
@@ -503,6 +514,167 @@ void ResourceLoader::_run_load_task(void *p_userdata) {
 	curr_load_task = curr_load_task_backup;
 }
 
+// With sub-threads, the dependencies of a resource are only found once its own load task parses
+// it, so a deep dependency graph still loads one level after the other. Instead, this reads the
+// dependency lists of the whole graph up front (for scenes and resources, just the external
+// resource tables in their headers), a breadth-first level at a time in parallel, and starts all
+// of it at once: leaves first and, among equals, the ones on the longest chains, whose tasks also
+// go to the high priority queue. The loaders then find the tasks registered and just await them.
+// The tokens are kept in r_tokens until the requested resource is loaded.
+void ResourceLoader::_prefetch_dependencies(const ThreadLoadTask &p_load_task, LocalVector<Ref<LoadToken>> &r_tokens) {
+	struct Node {
+		String path;
+		String type_hint;
+		LocalVector<uint32_t> dependencies;
+		uint32_t height = 0; // Longest chain of dependencies below this node.
+		uint32_t depth = 0; // Longest chain from the requested resource down to this node.
+		uint32_t finish_order = 0;
+		uint8_t visit = 0;
+	};
+
+	LocalVector<Node> nodes;
+	HashMap<String, uint32_t> node_indices;
+	nodes.resize(1);
+	nodes[0].path = p_load_task.local_path;
+	node_indices.insert(p_load_task.local_path, 0);
+
+	LocalVector<uint32_t> level;
+	level.push_back(0);
+	LocalVector<List<String>> level_dependencies;
+	while (!level.is_empty()) {
+		level_dependencies.clear();
+		level_dependencies.resize(level.size());
+		WorkerThreadPool::get_singleton()->parallel_for(
+				level.size(), [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+					for (uint32_t i = p_from; i < p_to; i++) {
+						get_dependencies(nodes[level[i]].path, &level_dependencies[i], true);
+					}
+				},
+				1, "ResourceLoader::prefetch_dependencies");
+
+		LocalVector<uint32_t> next_level;
+		for (uint32_t i = 0; i < level.size(); i++) {
+			for (const String &dependency : level_dependencies[i]) {
+				// "path_or_uid::type::fallback_path", see ResourceFormatLoader::get_dependencies().
+				String path = dependency.get_slice("::", 0);
+				const ResourceUID::ID uid = ResourceUID::get_singleton()->text_to_id(path);
+				if (uid != ResourceUID::INVALID_ID) {
+					path = ResourceUID::get_singleton()->has_id(uid) ? ResourceUID::get_singleton()->get_id_path(uid) : dependency.get_slice("::", 2);
+				}
+				if (path.is_empty()) {
+					continue;
+				}
+				path = _validate_local_path(path);
+
+				uint32_t index;
+				HashMap<String, uint32_t>::Iterator E = node_indices.find(path);
+				if (E) {
+					index = E->value;
+				} else {
+					// Whoever loaded or is loading it takes care of what's below it.
+					if (ResourceCache::has(path)) {
+						continue;
+					}
+					{
+						MutexLock thread_load_lock(thread_load_mutex);
+						if (thread_load_tasks.has(path)) {
+							continue;
+						}
+					}
+					index = nodes.size();
+					nodes.resize(index + 1);
+					nodes[index].path = path;
+					nodes[index].type_hint = dependency.get_slice("::", 1);
+					node_indices.insert(path, index);
+					next_level.push_back(index);
+				}
+				nodes[level[i]].dependencies.push_back(index);
+			}
+		}
+		level = next_level;
+	}
+
+	if (nodes.size() == 1) {
+		return;
+	}
+
+	// Heights, in post-order. Edges closing a cycle (which the loaders report) are left out.
+	LocalVector<uint32_t> post_order;
+	post_order.reserve(nodes.size());
+	LocalVector<Pair<uint32_t, uint32_t>> stack; // Node and next dependency to visit.
+	stack.push_back(Pair<uint32_t, uint32_t>(0, 0));
+	nodes[0].visit = 1;
+	while (!stack.is_empty()) {
+		const uint32_t index = stack[stack.size() - 1].first;
+		Node &node = nodes[index];
+		if (stack[stack.size() - 1].second < node.dependencies.size()) {
+			const uint32_t dependency = node.dependencies[stack[stack.size() - 1].second++];
+			if (nodes[dependency].visit == 0) {
+				nodes[dependency].visit = 1;
+				stack.push_back(Pair<uint32_t, uint32_t>(dependency, 0));
+			}
+			continue;
+		}
+		for (uint32_t dependency : node.dependencies) {
+			if (nodes[dependency].visit == 2) {
+				node.height = MAX(node.height, nodes[dependency].height + 1);
+			}
+		}
+		node.visit = 2;
+		node.finish_order = post_order.size();
+		post_order.push_back(index);
+		stack.resize(stack.size() - 1);
+	}
+
+	// Depths, in reverse post-order (dependents before their dependencies).
+	for (uint32_t i = post_order.size(); i > 0; i--) {
+		const Node &node = nodes[post_order[i - 1]];
+		for (uint32_t dependency : node.dependencies) {
+			if (nodes[dependency].finish_order < node.finish_order) {
+				nodes[dependency].depth = MAX(nodes[dependency].depth, node.depth + 1);
+			}
+		}
+	}
+
+	struct Start {
+		uint32_t height = 0;
+		uint32_t chain = 0;
+		uint32_t index = 0;
+
+		bool operator<(const Start &p_other) const {
+			if (height != p_other.height) {
+				return height < p_other.height;
+			}
+			if (chain != p_other.chain) {
+				return chain > p_other.chain;
+			}
+			return index < p_other.index;
+		}
+	};
+
+	LocalVector<Start> starts;
+	starts.resize(nodes.size() - 1);
+	for (uint32_t i = 1; i < nodes.size(); i++) {
+		starts[i - 1].height = nodes[i].height;
+		starts[i - 1].chain = nodes[i].depth + nodes[i].height;
+		starts[i - 1].index = i;
+	}
+	starts.sort();
+
+	const uint32_t critical_chain = nodes[0].height;
+	r_tokens.reserve(starts.size());
+	for (const Start &start : starts) {
+		const Node &node = nodes[start.index];
+		// Externals of a non-deep load are always reused from the cache.
+		// This runs on a pool thread, whose own queue would run the tasks in reverse.
+		Ref<LoadToken> token = _load_start(node.path, node.type_hint, LOAD_THREAD_DISTRIBUTE, ResourceFormatLoader::CACHE_MODE_REUSE, false, start.chain == critical_chain, true);
+		if (token.is_valid()) {
+			r_tokens.push_back(token);
+		}
+	}
+	print_lt("PREFETCH: " + p_load_task.local_path + " started " + itos(r_tokens.size()) + " dependencies, critical path " + itos(critical_chain));
+}
+
 String ResourceLoader::_validate_local_path(const String &p_path) {
 	ResourceUID::ID uid = ResourceUID::get_singleton()->text_to_id(p_path);
 	if (uid != ResourceUID::INVALID_ID) {
@@ -564,7 +736,7 @@ Ref<Resource> ResourceLoader::load(const String &p_path, const String &p_type_hi
 	return res;
 }
 
-Ref<ResourceLoader::LoadToken> ResourceLoader::_load_start(const String &p_path, const String &p_type_hint, LoadThreadMode p_thread_mode, ResourceFormatLoader::CacheMode p_cache_mode, bool p_for_user) {
+Ref<ResourceLoader::LoadToken> ResourceLoader::_load_start(const String &p_path, const String &p_type_hint, LoadThreadMode p_thread_mode, ResourceFormatLoader::CacheMode p_cache_mode, bool p_for_user, bool p_high_priority, bool p_shared_queue) {
 	String local_path = _validate_local_path(p_path);
 
 	bool ignoring_cache = p_cache_mode == ResourceFormatLoader::CACHE_MODE_IGNORE || p_cache_mode == ResourceFormatLoader::CACHE_MODE_IGNORE_DEEP;
@@ -613,6 +785,8 @@ Ref<ResourceLoader::LoadToken> ResourceLoader::_load_start(const String &p_path,
 			load_task.type_hint = p_type_hint;
 			load_task.cache_mode = p_cache_mode;
 			load_task.use_sub_threads = p_thread_mode == LOAD_THREAD_DISTRIBUTE;
+			// Only the externals of non-deep loads come from the shared cache, where prefetched ones land.
+			load_task.prefetch_dependencies = p_for_user && load_task.use_sub_threads && p_cache_mode != ResourceFormatLoader::CACHE_MODE_IGNORE_DEEP && p_cache_mode != ResourceFormatLoader::CACHE_MODE_REPLACE_DEEP;
 			if (p_cache_mode == ResourceFormatLoader::CACHE_MODE_REUSE) {
 				Ref<Resource> existing = ResourceCache::get_ref(local_path);
 				if (existing.is_valid()) {
@@ -652,7 +826,7 @@ Ref<ResourceLoader::LoadToken> ResourceLoader::_load_start(const String &p_path,
 				load_task_ptr->thread_id = Thread::get_caller_id();
 			}
 		} else {
-			load_task_ptr->task_id = WorkerThreadPool::get_singleton()->add_native_task(&ResourceLoader::_run_load_task, load_task_ptr);
+			load_task_ptr->task_id = WorkerThreadPool::get_singleton()->add_native_task(&ResourceLoader::_run_load_task, load_task_ptr, p_high_priority, String(), p_shared_queue);
 		}
 	} // MutexLock(thread_load_mutex).
 
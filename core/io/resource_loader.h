@@ -140,7 +140,7 @@ public:
 
 	static const int BINARY_MUTEX_TAG = 1;
 
-	static Ref<LoadToken> _load_start(const String &p_path, const String &p_type_hint, LoadThreadMode p_thread_mode, ResourceFormatLoader::CacheMode p_cache_mode, bool p_for_user = false);
+	static Ref<LoadToken> _load_start(const String &p_path, const String &p_type_hint, LoadThreadMode p_thread_mode, ResourceFormatLoader::CacheMode p_cache_mode, bool p_for_user = false, bool p_high_priority = false, bool p_shared_queue = false);
 	static Ref<Resource> _load_complete(LoadToken &p_load_token, Error *r_error);
 
 private:
@@ -193,6 +193,7 @@ private:
 		Error error = OK;
 		Ref<Resource> resource;
 		bool use_sub_threads = false;
+		bool prefetch_dependencies = false; // Start the whole dependency graph before loading (threaded user requests).
 		HashSet<String> sub_tasks;
 
 		struct ResourceChangedConnection {
@@ -204,6 +205,7 @@ private:
 	};
 
 	static void _run_load_task(void *p_userdata);
+	static void _prefetch_dependencies(const ThreadLoadTask &p_load_task, LocalVector<Ref<LoadToken>> &r_tokens);
 
 	static thread_local bool import_thread;
 	static thread_local int load_nesting;
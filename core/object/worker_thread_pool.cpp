@@ -48,6 +48,57 @@ void WorkerThreadPool::Task::free_template_userdata() {
 
 WorkerThreadPool *WorkerThreadPool::singleton = nullptr;
 
+// The deque follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., 2013).
+
+bool WorkerThreadPool::TaskDeque::push(Task *p_task) {
+	const int64_t b = bottom.load(std::memory_order_relaxed);
+	const int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= (int64_t)CAPACITY) {
+		return false; // Full; the caller queues the task elsewhere.
+	}
+	buffer[b & MASK].store(p_task, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::TaskDeque::pop() {
+	const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+
+	Task *task = nullptr;
+	if (t <= b) {
+		task = buffer[b & MASK].load(std::memory_order_relaxed);
+		if (t == b) {
+			// Last task; race against thieves for it.
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				task = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+	} else {
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return task;
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::TaskDeque::steal() {
+	while (true) {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b) {
+			return nullptr;
+		}
+		Task *task = buffer[t & MASK].load(std::memory_order_relaxed);
+		if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return task;
+		}
+		// Lost the race to another thief or the owner; the deque may still hold more.
+	}
+}
+
 #ifdef THREADS_ENABLED
 thread_local WorkerThreadPool::UnlockableLocks WorkerThreadPool::unlockable_locks[MAX_UNLOCKABLE_LOCKS];
 #endif
@@ -145,16 +196,20 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 		}
 
 		task_mutex.lock();
-		p_task->completed = true;
-		p_task->pool_thread_index = -1;
-		if (p_task->waiting_user) {
-			p_task->done_semaphore.post(p_task->waiting_user);
-		}
-		// Let awaiters know.
-		for (uint32_t i = 0; i < threads.size(); i++) {
-			if (threads[i].awaited_task == p_task) {
-				threads[i].cond_var.notify_one();
-				threads[i].signaled = true;
+		if (p_task->detached) {
+			task_allocator.free(p_task);
+		} else {
+			p_task->completed = true;
+			p_task->pool_thread_index = -1;
+			if (p_task->waiting_user) {
+				p_task->done_semaphore.post(p_task->waiting_user);
+			}
+			// Let awaiters know.
+			for (uint32_t i = 0; i < threads.size(); i++) {
+				if (threads[i].awaited_task == p_task) {
+					threads[i].cond_var.notify_one();
+					threads[i].signaled = true;
+				}
 			}
 		}
 	}
@@ -184,8 +239,9 @@ void WorkerThreadPool::_thread_function(void *p_user) {
 	ThreadData *thread_data = (ThreadData *)p_user;
 
 	while (true) {
-		Task *task_to_process = nullptr;
-		{
+		// Deques can be drained without taking the lock; everything else needs it.
+		Task *task_to_process = thread_data->pool->_pop_task_lockless(thread_data);
+		if (!task_to_process) {
 			MutexLock lock(thread_data->pool->task_mutex);
 
 			bool exit = thread_data->pool->_handle_runlevel(thread_data, lock);
@@ -195,10 +251,8 @@ void WorkerThreadPool::_thread_function(void *p_user) {
 
 			thread_data->signaled = false;
 
-			if (thread_data->pool->task_queue.first()) {
-				task_to_process = thread_data->pool->task_queue.first()->self();
-				thread_data->pool->task_queue.remove(thread_data->pool->task_queue.first());
-			} else {
+			task_to_process = thread_data->pool->_pop_task(thread_data);
+			if (!task_to_process) {
 				thread_data->cond_var.wait(lock);
 			}
 		}
@@ -209,7 +263,74 @@ void WorkerThreadPool::_thread_function(void *p_user) {
 	}
 }
 
-void WorkerThreadPool::_post_tasks(Task **p_tasks, uint32_t p_count, bool p_high_priority, MutexLock<BinaryMutex> &p_lock) {
+WorkerThreadPool::Task *WorkerThreadPool::_pop_task_lockless(ThreadData *p_thread_data) {
+	Task *task = p_thread_data->deque.pop();
+	if (task) {
+		return task;
+	}
+	// Start with the next thread, so thieves spread over victims.
+	uint32_t thread_count = threads.size();
+	for (uint32_t i = 1; i < thread_count; i++) {
+		task = threads[(p_thread_data->index + i) % thread_count].deque.steal();
+		if (task) {
+			p_thread_data->steal_count.fetch_add(1, std::memory_order_relaxed);
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+// Must be called with task_mutex locked, by the pool thread p_thread_data belongs to.
+WorkerThreadPool::Task *WorkerThreadPool::_pop_task(ThreadData *p_thread_data) {
+	Task *task = p_thread_data->deque.pop();
+	if (task) {
+		return task;
+	}
+	if (p_thread_data->affinity_queue.first()) {
+		task = p_thread_data->affinity_queue.first()->self();
+		p_thread_data->affinity_queue.remove(p_thread_data->affinity_queue.first());
+		p_thread_data->affinity_queue_size--;
+		return task;
+	}
+	if (task_queue.first()) {
+		task = task_queue.first()->self();
+		task_queue.remove(task_queue.first());
+		task_queue_size--;
+		return task;
+	}
+	task = _pop_task_lockless(p_thread_data);
+	if (task) {
+		return task;
+	}
+	// Affinity is only a hint; take over tasks meant for a thread that is busy.
+	uint32_t thread_count = threads.size();
+	for (uint32_t i = 1; i < thread_count; i++) {
+		ThreadData &victim = threads[(p_thread_data->index + i) % thread_count];
+		if (victim.affinity_queue.first()) {
+			task = victim.affinity_queue.first()->self();
+			victim.affinity_queue.remove(victim.affinity_queue.first());
+			victim.affinity_queue_size--;
+			p_thread_data->steal_count.fetch_add(1, std::memory_order_relaxed);
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+// Whether tasks are waiting that any thread could run now. Must be called with task_mutex locked.
+bool WorkerThreadPool::_has_queued_tasks() const {
+	if (task_queue.first()) {
+		return true;
+	}
+	for (const ThreadData &th : threads) {
+		if (th.affinity_queue.first() || th.deque.size()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkerThreadPool::_post_tasks(Task **p_tasks, uint32_t p_count, bool p_high_priority, MutexLock<BinaryMutex> &p_lock, int p_affinity, bool p_shared_queue) {
 	// Fall back to processing on the calling thread if there are no worker threads.
 	// Separated into its own variable to make it easier to extend this logic
 	// in custom builds.
@@ -233,16 +354,35 @@ void WorkerThreadPool::_post_tasks(Task **p_tasks, uint32_t p_count, bool p_high
 	ThreadData *caller_pool_thread = thread_ids.has(Thread::get_caller_id()) ? &threads[thread_ids[Thread::get_caller_id()]] : nullptr;
 
 	for (uint32_t i = 0; i < p_count; i++) {
-		p_tasks[i]->low_priority = !p_high_priority;
+		Task *task = p_tasks[i];
+		task->low_priority = !p_high_priority;
 		if (p_high_priority || low_priority_threads_used < max_low_priority_threads) {
-			task_queue.add_last(&p_tasks[i]->task_elem);
 			if (!p_high_priority) {
 				low_priority_threads_used++;
 			}
+			if (p_affinity >= 0) {
+				ThreadData &target = threads[(p_affinity + i) % threads.size()];
+				target.affinity_queue.add_last(&task->task_elem);
+				target.affinity_queue_size++;
+				if (!target.signaled && (!target.current_task || target.awaited_task)) {
+					// The target can pick it up right away.
+					if (likely(&target != caller_pool_thread)) {
+						target.cond_var.notify_one();
+					}
+					target.signaled = true;
+					continue;
+				}
+				// The target is busy, so let whichever thread is free steal it.
+			} else if (p_shared_queue || !caller_pool_thread || !caller_pool_thread->deque.push(task)) {
+				// Tasks posted from pool threads stay in their deque, for locality.
+				task_queue.add_last(&task->task_elem);
+				task_queue_size++;
+			}
 			to_process++;
 		} else {
 			// Too many threads using low priority, must go to queue.
-			low_priority_task_queue.add_last(&p_tasks[i]->task_elem);
+			low_priority_task_queue.add_last(&task->task_elem);
+			low_priority_task_queue_size++;
 			to_promote++;
 		}
 	}
@@ -318,7 +458,9 @@ bool WorkerThreadPool::_try_promote_low_priority_task() {
 	if (low_priority_task_queue.first()) {
 		Task *low_prio_task = low_priority_task_queue.first()->self();
 		low_priority_task_queue.remove(low_priority_task_queue.first());
+		low_priority_task_queue_size--;
 		task_queue.add_last(&low_prio_task->task_elem);
+		task_queue_size++;
 		low_priority_threads_used++;
 		return true;
 	} else {
@@ -326,11 +468,11 @@ bool WorkerThreadPool::_try_promote_low_priority_task() {
 	}
 }
 
-WorkerThreadPool::TaskID WorkerThreadPool::add_native_task(void (*p_func)(void *), void *p_userdata, bool p_high_priority, const String &p_description) {
-	return _add_task(Callable(), p_func, p_userdata, nullptr, p_high_priority, p_description);
+WorkerThreadPool::TaskID WorkerThreadPool::add_native_task(void (*p_func)(void *), void *p_userdata, bool p_high_priority, const String &p_description, bool p_shared_queue) {
+	return _add_task(Callable(), p_func, p_userdata, nullptr, p_high_priority, p_description, p_shared_queue);
 }
 
-WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description) {
+WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description, bool p_shared_queue) {
 	MutexLock<BinaryMutex> lock(task_mutex);
 
 	// Get a free task
@@ -344,7 +486,7 @@ WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable,
 	task->template_userdata = p_template_userdata;
 	tasks.insert(id, task);
 
-	_post_tasks(&task, 1, p_high_priority, lock);
+	_post_tasks(&task, 1, p_high_priority, lock, -1, p_shared_queue);
 
 	return id;
 }
@@ -481,7 +623,7 @@ void WorkerThreadPool::_wait_collaboratively(ThreadData *p_caller_pool_thread, T
 				if (was_signaled) {
 					// This thread was awaken for some additional reason, but it's about to exit.
 					// Let's find out what may be pending and forward the requests.
-					uint32_t to_process = task_queue.first() ? 1 : 0;
+					uint32_t to_process = _has_queued_tasks() ? 1 : 0;
 					uint32_t to_promote = p_caller_pool_thread->current_task->low_priority && low_priority_task_queue.first() ? 1 : 0;
 					if (to_process || to_promote) {
 						// This thread must be left alone since it won't loop again.
@@ -499,10 +641,7 @@ void WorkerThreadPool::_wait_collaboratively(ThreadData *p_caller_pool_thread, T
 				}
 			}
 
-			if (p_caller_pool_thread->pool->task_queue.first()) {
-				task_to_process = task_queue.first()->self();
-				task_queue.remove(task_queue.first());
-			}
+			task_to_process = _pop_task(p_caller_pool_thread);
 
 			if (!task_to_process) {
 				p_caller_pool_thread->awaited_task = p_task;
@@ -547,7 +686,7 @@ bool WorkerThreadPool::_handle_runlevel(ThreadData *p_thread_data, MutexLock<Bin
 		} break;
 		case RUNLEVEL_PRE_EXIT_LANGUAGES: {
 			if (!p_thread_data->pre_exited_languages) {
-				if (!task_queue.first() && !low_priority_task_queue.first()) {
+				if (!_has_queued_tasks() && !low_priority_task_queue.first()) {
 					p_thread_data->pre_exited_languages = true;
 					runlevel_data.pre_exit_languages.num_idle_threads++;
 					control_cond_var.notify_all();
@@ -610,7 +749,7 @@ void WorkerThreadPool::notify_yield_over(TaskID p_task_id) {
 	td.cond_var.notify_one();
 }
 
-WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
+WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description, int p_affinity) {
 	ERR_FAIL_COND_V(p_elements < 0, INVALID_TASK_ID);
 	if (p_tasks < 0) {
 		p_tasks = MAX(1u, threads.size());
@@ -652,13 +791,13 @@ WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_ca
 
 	groups[id] = group;
 
-	_post_tasks(tasks_posted, p_tasks, p_high_priority, lock);
+	_post_tasks(tasks_posted, p_tasks, p_high_priority, lock, p_affinity);
 
 	return id;
 }
 
-WorkerThreadPool::GroupID WorkerThreadPool::add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
-	return _add_group_task(Callable(), p_func, p_userdata, nullptr, p_elements, p_tasks, p_high_priority, p_description);
+WorkerThreadPool::GroupID WorkerThreadPool::add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description, int p_affinity) {
+	return _add_group_task(Callable(), p_func, p_userdata, nullptr, p_elements, p_tasks, p_high_priority, p_description, p_affinity);
 }
 
 WorkerThreadPool::GroupID WorkerThreadPool::add_group_task(const Callable &p_action, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
@@ -717,6 +856,103 @@ void WorkerThreadPool::wait_for_group_task_completion(GroupID p_group) {
 #endif
 }
 
+void WorkerThreadPool::_parallel_for(BaseParallelFor *p_work, uint32_t p_elements, uint32_t p_min_grain, const String &p_description) {
+	if (p_elements == 0) {
+		return;
+	}
+	p_min_grain = MAX(1u, p_min_grain);
+
+	// Helpers beyond the number of ranges of minimum size would never get any work.
+	uint32_t helpers = 0;
+#ifdef THREADS_ENABLED
+	const uint32_t max_ranges = (p_elements + p_min_grain - 1) / p_min_grain;
+	const uint32_t free_threads = get_thread_index() == -1 ? threads.size() : threads.size() - 1;
+	helpers = MIN(free_threads, max_ranges - 1);
+#endif
+
+	if (helpers == 0) {
+		p_work->prepare(1);
+		p_work->run(0, p_elements, 0);
+		return;
+	}
+
+	ParallelForState *state = memnew(ParallelForState);
+	state->work = p_work;
+	state->elements = p_elements;
+	state->min_grain = p_min_grain;
+	state->participants = helpers + 1;
+	state->users.store(helpers + 1, std::memory_order_relaxed);
+	p_work->prepare(helpers + 1);
+
+	{
+		MutexLock<BinaryMutex> lock(task_mutex);
+		Task **tasks_posted = (Task **)alloca(sizeof(Task *) * helpers);
+		for (uint32_t i = 0; i < helpers; i++) {
+			Task *task = task_allocator.alloc();
+			task->native_func = &WorkerThreadPool::_parallel_for_helper;
+			task->native_func_userdata = state;
+			task->description = p_description;
+			task->detached = true;
+			tasks_posted[i] = task;
+		}
+		// Posted from a pool thread, helpers land in its own deque, where idle threads steal them.
+		_post_tasks(tasks_posted, helpers, true, lock);
+	}
+
+	_parallel_for_work(state, 0);
+
+	// Whatever is left has been claimed by helpers that are running it right now, so this can't
+	// wait on work that is still queued behind this thread.
+	if (state->completed.load(std::memory_order_acquire) < p_elements) {
+		if (this == singleton) {
+			_unlock_unlockable_mutexes();
+		}
+		state->done_semaphore.wait();
+		if (this == singleton) {
+			_lock_unlockable_mutexes();
+		}
+	}
+
+	_parallel_for_release(state);
+}
+
+void WorkerThreadPool::_parallel_for_helper(void *p_state) {
+	ParallelForState *state = (ParallelForState *)p_state;
+	// Helpers that start after the work ran out must not touch it; it may be gone already.
+	if (state->next_index.load(std::memory_order_relaxed) < state->elements) {
+		_parallel_for_work(state, state->next_participant.fetch_add(1, std::memory_order_relaxed));
+	}
+	_parallel_for_release(state);
+}
+
+void WorkerThreadPool::_parallel_for_work(ParallelForState *p_state, uint32_t p_participant) {
+	const uint32_t elements = p_state->elements;
+	const uint32_t divisor = p_state->participants * 2;
+	uint32_t from = p_state->next_index.load(std::memory_order_relaxed);
+	while (from < elements) {
+		// Guided scheduling: big ranges while plenty is left, down to min_grain near the end.
+		const uint32_t chunk = MAX(p_state->min_grain, (elements - from) / divisor);
+		const uint32_t to = MIN(elements, from + chunk);
+		if (!p_state->next_index.compare_exchange_weak(from, to, std::memory_order_relaxed)) {
+			continue; // from now holds the current index.
+		}
+
+		p_state->work->run(from, to, p_participant);
+
+		const uint32_t done = p_state->completed.fetch_add(to - from, std::memory_order_acq_rel) + (to - from);
+		if (done == elements) {
+			p_state->done_semaphore.post();
+		}
+		from = p_state->next_index.load(std::memory_order_relaxed);
+	}
+}
+
+void WorkerThreadPool::_parallel_for_release(ParallelForState *p_state) {
+	if (p_state->users.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		memdelete(p_state);
+	}
+}
+
 int WorkerThreadPool::get_thread_index() const {
 	Thread::ID tid = Thread::get_caller_id();
 	return thread_ids.has(tid) ? thread_ids[tid] : -1;
@@ -731,6 +967,25 @@ WorkerThreadPool::TaskID WorkerThreadPool::get_caller_task_id() const {
 	}
 }
 
+WorkerThreadPool::ThreadStats WorkerThreadPool::get_thread_stats(int p_thread_index) const {
+	ThreadStats stats;
+	MutexLock task_lock(task_mutex);
+	ERR_FAIL_INDEX_V(p_thread_index, (int)threads.size(), stats);
+	const ThreadData &th = threads[p_thread_index];
+	stats.queue_depth = th.deque.size() + th.affinity_queue_size;
+	stats.steal_count = th.steal_count.load(std::memory_order_relaxed);
+	return stats;
+}
+
+uint32_t WorkerThreadPool::get_queued_task_count() const {
+	MutexLock task_lock(task_mutex);
+	uint32_t count = task_queue_size + low_priority_task_queue_size;
+	for (const ThreadData &th : threads) {
+		count += th.deque.size() + th.affinity_queue_size;
+	}
+	return count;
+}
+
 #ifdef THREADS_ENABLED
 uint32_t WorkerThreadPool::_thread_enter_unlock_allowance_zone(THREADING_NAMESPACE::unique_lock<THREADING_NAMESPACE::mutex> &p_ulock) {
 	for (uint32_t i = 0; i < MAX_UNLOCKABLE_LOCKS; i++) {
@@ -818,6 +1073,7 @@ void WorkerThreadPool::finish() {
 
 	for (ThreadData &data : threads) {
 		data.thread.wait_to_finish();
+		data.affinity_queue.clear();
 	}
 
 	{
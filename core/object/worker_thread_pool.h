@@ -41,6 +41,8 @@
 #include "core/templates/rid.h"
 #include "core/templates/safe_refcount.h"
 
+#include <atomic>
+
 class WorkerThreadPool : public Object {
 	GDCLASS(WorkerThreadPool, Object)
 public:
@@ -86,6 +88,7 @@ private:
 		uint32_t waiting_pool = 0;
 		uint32_t waiting_user = 0;
 		bool low_priority = false;
+		bool detached = false; // Nobody waits for it by ID; freed as soon as it has run.
 		BaseTemplateUserdata *template_userdata = nullptr;
 		int pool_thread_index = -1;
 
@@ -107,6 +110,30 @@ private:
 
 	BinaryMutex task_mutex;
 
+	// Chase-Lev work-stealing deque (fixed capacity). Only the owning pool thread pushes and pops
+	// at the bottom, in LIFO order; any thread may steal the oldest task from the top without
+	// taking task_mutex.
+	class TaskDeque {
+		static const uint32_t CAPACITY = 256;
+		static const uint32_t MASK = CAPACITY - 1;
+
+		// Owner and thieves touch different ends; keep them off the same cache line.
+		std::atomic<int64_t> top = { 0 };
+		char padding_top[Thread::CACHE_LINE_BYTES];
+		std::atomic<int64_t> bottom = { 0 };
+		char padding_bottom[Thread::CACHE_LINE_BYTES];
+		std::atomic<Task *> buffer[CAPACITY] = {};
+
+	public:
+		bool push(Task *p_task);
+		Task *pop();
+		Task *steal();
+		uint32_t size() const {
+			const int64_t count = bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+			return count > 0 ? count : 0;
+		}
+	};
+
 	struct ThreadData {
 		static Task *const YIELDING; // Too bad constexpr doesn't work here.
 
@@ -120,6 +147,10 @@ private:
 		Task *awaited_task = nullptr; // Null if not awaiting the condition variable, or special value (YIELDING).
 		ConditionVariable cond_var;
 		WorkerThreadPool *pool = nullptr;
+		TaskDeque deque; // Tasks posted by this thread.
+		SelfList<Task>::List affinity_queue; // Tasks hinted to run on this thread (under task_mutex).
+		uint32_t affinity_queue_size = 0;
+		std::atomic<uint64_t> steal_count = { 0 }; // Tasks this thread took from another thread's queues.
 
 		ThreadData() :
 				signaled(false),
@@ -163,7 +194,9 @@ private:
 
 	uint32_t max_low_priority_threads = 0;
 	uint32_t low_priority_threads_used = 0;
-	uint32_t notify_index = 0; // For rotating across threads, no help distributing load.
+	uint32_t notify_index = 0; // For rotating across threads when no specific thread is targeted.
+	uint32_t task_queue_size = 0;
+	uint32_t low_priority_task_queue_size = 0;
 
 	uint64_t last_task = 1;
 
@@ -173,7 +206,10 @@ private:
 
 	void _process_task(Task *task);
 
-	void _post_tasks(Task **p_tasks, uint32_t p_count, bool p_high_priority, MutexLock<BinaryMutex> &p_lock);
+	void _post_tasks(Task **p_tasks, uint32_t p_count, bool p_high_priority, MutexLock<BinaryMutex> &p_lock, int p_affinity = -1, bool p_shared_queue = false);
+	Task *_pop_task_lockless(ThreadData *p_thread_data);
+	Task *_pop_task(ThreadData *p_thread_data);
+	bool _has_queued_tasks() const;
 	void _notify_threads(const ThreadData *p_current_thread_data, uint32_t p_process_count, uint32_t p_promote_count);
 
 	bool _try_promote_low_priority_task();
@@ -189,8 +225,8 @@ private:
 	static thread_local UnlockableLocks unlockable_locks[MAX_UNLOCKABLE_LOCKS];
 #endif
 
-	TaskID _add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description);
-	GroupID _add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description);
+	TaskID _add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description, bool p_shared_queue = false);
+	GroupID _add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description, int p_affinity = -1);
 
 	template <typename C, typename M, typename U>
 	struct TaskUserData : public BaseTemplateUserdata {
@@ -212,6 +248,59 @@ private:
 		}
 	};
 
+	struct BaseParallelFor {
+		virtual void prepare(uint32_t p_participants) {}
+		virtual void run(uint32_t p_from, uint32_t p_to, uint32_t p_participant) = 0;
+		virtual ~BaseParallelFor() {}
+	};
+
+	template <typename F>
+	struct ParallelForUserData : public BaseParallelFor {
+		F function;
+		virtual void run(uint32_t p_from, uint32_t p_to, uint32_t p_participant) override {
+			function(p_from, p_to, p_participant);
+		}
+		ParallelForUserData(const F &p_function) :
+				function(p_function) {}
+	};
+
+	template <typename T, typename F>
+	struct ParallelReduceUserData : public BaseParallelFor {
+		F function;
+		T identity;
+		LocalVector<T> partials;
+		virtual void prepare(uint32_t p_participants) override {
+			partials.resize(p_participants);
+			for (T &partial : partials) {
+				partial = identity;
+			}
+		}
+		virtual void run(uint32_t p_from, uint32_t p_to, uint32_t p_participant) override {
+			function(p_from, p_to, partials[p_participant]);
+		}
+		ParallelReduceUserData(const F &p_function, const T &p_identity) :
+				function(p_function), identity(p_identity) {}
+	};
+
+	// Shared by the caller of parallel_for() and its helper tasks; freed by the last one to leave.
+	struct ParallelForState {
+		BaseParallelFor *work = nullptr;
+		uint32_t elements = 0;
+		uint32_t min_grain = 1;
+		uint32_t participants = 1;
+		std::atomic<uint32_t> next_index = { 0 }; // First element not claimed yet.
+		char padding[Thread::CACHE_LINE_BYTES];
+		std::atomic<uint32_t> completed = { 0 }; // Elements whose range has finished running.
+		std::atomic<uint32_t> next_participant = { 1 }; // 0 is the caller.
+		std::atomic<uint32_t> users = { 0 };
+		Semaphore done_semaphore;
+	};
+
+	void _parallel_for(BaseParallelFor *p_work, uint32_t p_elements, uint32_t p_min_grain, const String &p_description);
+	static void _parallel_for_helper(void *p_state);
+	static void _parallel_for_work(ParallelForState *p_state, uint32_t p_participant);
+	static void _parallel_for_release(ParallelForState *p_state);
+
 	void _wait_collaboratively(ThreadData *p_caller_pool_thread, Task *p_task);
 
 	void _switch_runlevel(Runlevel p_runlevel);
@@ -237,7 +326,9 @@ public:
 		ud->userdata = p_userdata;
 		return _add_task(Callable(), nullptr, nullptr, ud, p_high_priority, p_description);
 	}
-	TaskID add_native_task(void (*p_func)(void *), void *p_userdata, bool p_high_priority = false, const String &p_description = String());
+	// Tasks added from a pool thread go to its own queue, which it runs last-in first-out.
+	// p_shared_queue sends them to the queue all threads take from in order instead.
+	TaskID add_native_task(void (*p_func)(void *), void *p_userdata, bool p_high_priority = false, const String &p_description = String(), bool p_shared_queue = false);
 	TaskID add_task(const Callable &p_action, bool p_high_priority = false, const String &p_description = String());
 
 	bool is_task_completed(TaskID p_task_id) const;
@@ -246,21 +337,52 @@ public:
 	void yield();
 	void notify_yield_over(TaskID p_task_id);
 
+	// p_affinity is a hint for locality: if not negative, task i of the group is queued for pool
+	// thread (p_affinity + i) % get_thread_count(), so work submitted the same way every frame keeps
+	// landing on the same threads. Other threads still steal it if that thread is busy.
 	template <typename C, typename M, typename U>
-	GroupID add_template_group_task(C *p_instance, M p_method, U p_userdata, int p_elements, int p_tasks = -1, bool p_high_priority = false, const String &p_description = String()) {
+	GroupID add_template_group_task(C *p_instance, M p_method, U p_userdata, int p_elements, int p_tasks = -1, bool p_high_priority = false, const String &p_description = String(), int p_affinity = -1) {
 		typedef GroupUserData<C, M, U> GroupUD;
 		GroupUD *ud = memnew(GroupUD);
 		ud->instance = p_instance;
 		ud->method = p_method;
 		ud->userdata = p_userdata;
-		return _add_group_task(Callable(), nullptr, nullptr, ud, p_elements, p_tasks, p_high_priority, p_description);
+		return _add_group_task(Callable(), nullptr, nullptr, ud, p_elements, p_tasks, p_high_priority, p_description, p_affinity);
 	}
-	GroupID add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, int p_tasks = -1, bool p_high_priority = false, const String &p_description = String());
+	GroupID add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, int p_tasks = -1, bool p_high_priority = false, const String &p_description = String(), int p_affinity = -1);
 	GroupID add_group_task(const Callable &p_action, int p_elements, int p_tasks = -1, bool p_high_priority = false, const String &p_description = String());
 	uint32_t get_group_processed_element_count(GroupID p_group) const;
 	bool is_group_task_completed(GroupID p_group) const;
 	void wait_for_group_task_completion(GroupID p_group);
 
+	// Calls p_function(from, to, participant) for consecutive ranges covering [0, p_elements) and
+	// returns when all of them have run. Ranges are claimed on demand (guided scheduling): they start
+	// large and shrink towards p_min_grain as the work runs out, so uneven elements don't leave threads
+	// idle. The calling thread works too, which makes it safe to nest from inside pool tasks; helpers
+	// that find no work left just exit. participant is below get_max_parallel_participants() and is
+	// only used by one thread at a time, so it can index per-thread scratch data.
+	template <typename F>
+	void parallel_for(uint32_t p_elements, const F &p_function, uint32_t p_min_grain = 1, const String &p_description = String()) {
+		ParallelForUserData<F> work(p_function);
+		_parallel_for(&work, p_elements, p_min_grain, p_description);
+	}
+
+	// Like parallel_for(), but p_function(from, to, partial) accumulates into a per-participant value
+	// that starts as p_identity. The partials are combined with p_reduce(a, b) in participant order,
+	// so p_reduce must be associative and commutative for the result not to depend on scheduling.
+	template <typename T, typename F, typename R>
+	T parallel_reduce(uint32_t p_elements, const T &p_identity, const F &p_function, const R &p_reduce, uint32_t p_min_grain = 1, const String &p_description = String()) {
+		ParallelReduceUserData<T, F> work(p_function, p_identity);
+		_parallel_for(&work, p_elements, p_min_grain, p_description);
+		T result = p_identity;
+		for (const T &partial : work.partials) {
+			result = p_reduce(result, partial);
+		}
+		return result;
+	}
+
+	_FORCE_INLINE_ uint32_t get_max_parallel_participants() const { return get_thread_count() + 1; }
+
 	_FORCE_INLINE_ int get_thread_count() const {
 #ifdef THREADS_ENABLED
 		return threads.size();
@@ -276,6 +398,14 @@ public:
 	int get_thread_index() const;
 	TaskID get_caller_task_id() const;
 
+	struct ThreadStats {
+		uint32_t queue_depth = 0; // Tasks queued for this thread (own deque and affinity queue).
+		uint64_t steal_count = 0; // Tasks taken from other threads' queues since start.
+	};
+	ThreadStats get_thread_stats(int p_thread_index) const;
+	// All tasks waiting to run, including shared and low-priority queues.
+	uint32_t get_queued_task_count() const;
+
 #ifdef THREADS_ENABLED
 	_ALWAYS_INLINE_ static uint32_t thread_enter_unlock_allowance_zone(const MutexLock<BinaryMutex> &p_lock) { return _thread_enter_unlock_allowance_zone(p_lock._get_lock()); }
 	template <int Tag>
@@ -31,6 +31,7 @@
 #include "string_name.h"
 
 #include "core/os/os.h"
+#include "core/os/thread.h"
 #include "core/string/print_string.h"
 
 StaticCString StaticCString::create(const char *p_ptr) {
@@ -67,10 +68,19 @@ StringName _scs_create(const char *p_chr, bool p_static) {
 	return (p_chr[0] ? StringName(StaticCString::create(p_chr), p_static) : StringName());
 }
 
+struct StringName::_Shard {
+	Mutex mutex;
+	std::atomic<uint32_t> readers = { 0 }; // Lookups currently walking a bucket of this shard.
+	_Data *retired = nullptr; // Unlinked, but possibly still seen by a lookup.
+	char padding[Thread::CACHE_LINE_BYTES];
+};
+
+StringName::_Shard StringName::_shards[StringName::SHARD_COUNT];
+
 void StringName::setup() {
 	ERR_FAIL_COND(configured);
 	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		_table[i] = nullptr;
+		_table[i].store(nullptr, std::memory_order_relaxed);
 	}
 	configured = true;
 }
@@ -82,10 +92,10 @@ void StringName::cleanup() {
 	if (unlikely(debug_stringname)) {
 		Vector<_Data *> data;
 		for (int i = 0; i < STRING_TABLE_LEN; i++) {
-			_Data *d = _table[i];
+			_Data *d = _table[i].load(std::memory_order_relaxed);
 			while (d) {
 				data.push_back(d);
-				d = d->next;
+				d = d->next.load(std::memory_order_relaxed);
 			}
 		}
 
@@ -109,8 +119,8 @@ void StringName::cleanup() {
 #endif
 	int lost_strings = 0;
 	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		while (_table[i]) {
-			_Data *d = _table[i];
+		_Data *d = _table[i].load(std::memory_order_relaxed);
+		while (d) {
 			if (d->static_count.get() != d->refcount.get()) {
 				lost_strings++;
 
@@ -121,9 +131,14 @@ void StringName::cleanup() {
 				}
 			}
 
-			_table[i] = _table[i]->next;
+			_Data *next = d->next.load(std::memory_order_relaxed);
 			memdelete(d);
+			d = next;
 		}
+		_table[i].store(nullptr, std::memory_order_relaxed);
+	}
+	for (int i = 0; i < SHARD_COUNT; i++) {
+		_free_retired(_shards[i]);
 	}
 	if (lost_strings) {
 		print_verbose(vformat("StringName: %d unclaimed string names at exit.", lost_strings));
@@ -131,11 +146,21 @@ void StringName::cleanup() {
 	configured = false;
 }
 
+// Must be called with the shard locked.
+void StringName::_free_retired(_Shard &p_shard) {
+	while (p_shard.retired) {
+		_Data *d = p_shard.retired;
+		p_shard.retired = d->prev;
+		memdelete(d);
+	}
+}
+
 void StringName::unref() {
 	ERR_FAIL_COND(!configured);
 
 	if (_data && _data->refcount.unref()) {
-		MutexLock lock(mutex);
+		_Shard &shard = _shards[_data->idx & SHARD_MASK];
+		MutexLock lock(shard.mutex);
 
 		if (CoreGlobals::leak_reporting_enabled && _data->static_count.get() > 0) {
 			if (_data->cname) {
@@ -144,19 +169,27 @@ void StringName::unref() {
 				ERR_PRINT("BUG: Unreferenced static string to 0: " + String(_data->name));
 			}
 		}
+		_Data *next = _data->next.load(std::memory_order_relaxed);
 		if (_data->prev) {
-			_data->prev->next = _data->next;
+			_data->prev->next.store(next, std::memory_order_seq_cst);
 		} else {
-			if (_table[_data->idx] != _data) {
+			if (_table[_data->idx].load(std::memory_order_relaxed) != _data) {
 				ERR_PRINT("BUG!");
 			}
-			_table[_data->idx] = _data->next;
+			_table[_data->idx].store(next, std::memory_order_seq_cst);
+		}
+
+		if (next) {
+			next->prev = _data->prev;
 		}
 
-		if (_data->next) {
-			_data->next->prev = _data->prev;
+		// A lookup may still be standing on this entry (its next link stays intact for that).
+		// Lookups that start from now on can't reach it, so it's safe to free once none is left.
+		_data->prev = shard.retired;
+		shard.retired = _data;
+		if (shard.readers.load(std::memory_order_seq_cst) == 0) {
+			_free_retired(shard);
 		}
-		memdelete(_data);
 	}
 
 	_data = nullptr;
@@ -260,119 +293,126 @@ void StringName::assign_static_unique_class_name(StringName *ptr, const char *p_
 	}
 }
 
-StringName::StringName(const char *p_name, bool p_static) {
-	_data = nullptr;
-
-	ERR_FAIL_COND(!configured);
+// Looks up an entry without taking the shard lock and returns it referenced, or nullptr.
+// Entries whose last reference is being dropped are skipped, since they can't be referenced again.
+template <typename T>
+StringName::_Data *StringName::_find(const T &p_name, uint32_t p_hash) {
+	const uint32_t idx = p_hash & STRING_TABLE_MASK;
+	_Shard &shard = _shards[idx & SHARD_MASK];
 
-	if (!p_name || p_name[0] == 0) {
-		return; //empty, ignore
+#ifdef DEBUG_ENABLED
+	if (unlikely(debug_stringname)) {
+		// Reference counting for debugging isn't atomic, so it goes through the lock.
+		MutexLock lock(shard.mutex);
+		return _find_locked(p_name, p_hash);
 	}
+#endif
 
-	const uint32_t hash = String::hash(p_name);
-	const uint32_t idx = hash & STRING_TABLE_MASK;
-
-	MutexLock lock(mutex);
-	_data = _table[idx];
+	// Sequentially consistent with unlinking in unref(): either it sees this lookup in readers,
+	// or this lookup can't reach what it unlinked.
+	shard.readers.fetch_add(1, std::memory_order_seq_cst);
 
-	while (_data) {
+	_Data *d = _table[idx].load(std::memory_order_seq_cst);
+	while (d) {
 		// compare hash first
-		if (_data->hash == hash && _data->operator==(p_name)) {
+		if (d->hash == p_hash && d->operator==(p_name) && d->refcount.ref()) {
 			break;
 		}
-		_data = _data->next;
+		d = d->next.load(std::memory_order_seq_cst);
 	}
 
-	if (_data && _data->refcount.ref()) {
-		// exists
-		if (p_static) {
-			_data->static_count.increment();
+	shard.readers.fetch_sub(1, std::memory_order_release);
+	return d;
+}
+
+// Same as _find(), but with the shard lock held, so entries can't be unlinked meanwhile.
+template <typename T>
+StringName::_Data *StringName::_find_locked(const T &p_name, uint32_t p_hash) {
+	_Data *d = _table[p_hash & STRING_TABLE_MASK].load(std::memory_order_relaxed);
+	while (d) {
+		if (d->hash == p_hash && d->operator==(p_name) && d->refcount.ref()) {
+			break;
 		}
+		d = d->next.load(std::memory_order_relaxed);
+	}
 #ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-		return;
+	if (d && unlikely(debug_stringname)) {
+		d->debug_references++;
 	}
+#endif
+	return d;
+}
 
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
+// Returns the referenced entry for p_name, adding it if needed. Existing entries are usually
+// found without locking; only misses serialize on the lock of their shard.
+template <typename T>
+StringName::_Data *StringName::_intern(const T &p_name, uint32_t p_hash, const char *p_static_cname, bool p_static) {
+	const uint32_t idx = p_hash & STRING_TABLE_MASK;
+	_Shard &shard = _shards[idx & SHARD_MASK];
+
+	_Data *d = _find(p_name, p_hash);
+	if (!d) {
+		MutexLock lock(shard.mutex);
+		d = _find_locked(p_name, p_hash);
+
+		if (!d) {
+			d = memnew(_Data);
+			if (p_static_cname) {
+				d->cname = p_static_cname;
+			} else {
+				d->name = p_name;
+			}
+			d->refcount.init();
+			d->static_count.set(p_static ? 1 : 0);
+			d->hash = p_hash;
+			d->idx = idx;
+			d->prev = nullptr;
 
 #ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
+			if (unlikely(debug_stringname)) {
+				// Keep in memory, force static.
+				d->refcount.ref();
+				d->static_count.increment();
+			}
 #endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
+			_Data *head = _table[idx].load(std::memory_order_relaxed);
+			d->next.store(head, std::memory_order_relaxed);
+			if (head) {
+				head->prev = d;
+			}
+			// Publishes the fully built entry to lookups.
+			_table[idx].store(d, std::memory_order_release);
+			return d;
+		}
 	}
-	_table[idx] = _data;
+
+	// exists
+	if (p_static) {
+		d->static_count.increment();
+	}
+	return d;
 }
 
-StringName::StringName(const StaticCString &p_static_string, bool p_static) {
+StringName::StringName(const char *p_name, bool p_static) {
 	_data = nullptr;
 
 	ERR_FAIL_COND(!configured);
 
-	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
-
-	const uint32_t hash = String::hash(p_static_string.ptr);
-	const uint32_t idx = hash & STRING_TABLE_MASK;
+	if (!p_name || p_name[0] == 0) {
+		return; //empty, ignore
+	}
 
-	MutexLock lock(mutex);
-	_data = _table[idx];
+	_data = _intern(p_name, String::hash(p_name), nullptr, p_static);
+}
 
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->operator==(p_static_string.ptr)) {
-			break;
-		}
-		_data = _data->next;
-	}
+StringName::StringName(const StaticCString &p_static_string, bool p_static) {
+	_data = nullptr;
 
-	if (_data && _data->refcount.ref()) {
-		// exists
-		if (p_static) {
-			_data->static_count.increment();
-		}
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-		return;
-	}
+	ERR_FAIL_COND(!configured);
 
-	_data = memnew(_Data);
+	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = p_static_string.ptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_data = _intern(p_static_string.ptr, String::hash(p_static_string.ptr), p_static_string.ptr, p_static);
 }
 
 StringName::StringName(const String &p_name, bool p_static) {
@@ -384,53 +424,7 @@ StringName::StringName(const String &p_name, bool p_static) {
 		return;
 	}
 
-	const uint32_t hash = p_name.hash();
-	const uint32_t idx = hash & STRING_TABLE_MASK;
-
-	MutexLock lock(mutex);
-	_data = _table[idx];
-
-	while (_data) {
-		if (_data->hash == hash && _data->operator==(p_name)) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		// exists
-		if (p_static) {
-			_data->static_count.increment();
-		}
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-		return;
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_data = _intern(p_name, p_name.hash(), nullptr, p_static);
 }
 
 StringName StringName::search(const char *p_name) {
@@ -441,31 +435,8 @@ StringName StringName::search(const char *p_name) {
 		return StringName();
 	}
 
-	const uint32_t hash = String::hash(p_name);
-	const uint32_t idx = hash & STRING_TABLE_MASK;
-
-	MutexLock lock(mutex);
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->operator==(p_name)) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-
-		return StringName(_data);
-	}
-
-	return StringName(); //does not exist
+	_Data *d = _find(p_name, String::hash(p_name));
+	return d ? StringName(d) : StringName(); //does not exist
 }
 
 StringName StringName::search(const char32_t *p_name) {
@@ -476,54 +447,15 @@ StringName StringName::search(const char32_t *p_name) {
 		return StringName();
 	}
 
-	const uint32_t hash = String::hash(p_name);
-	const uint32_t idx = hash & STRING_TABLE_MASK;
-
-	MutexLock lock(mutex);
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->operator==(p_name)) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		return StringName(_data);
-	}
-
-	return StringName(); //does not exist
+	_Data *d = _find(p_name, String::hash(p_name));
+	return d ? StringName(d) : StringName(); //does not exist
 }
 
 StringName StringName::search(const String &p_name) {
 	ERR_FAIL_COND_V(p_name.is_empty(), StringName());
 
-	const uint32_t hash = p_name.hash();
-	const uint32_t idx = hash & STRING_TABLE_MASK;
-
-	MutexLock lock(mutex);
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->operator==(p_name)) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
-		return StringName(_data);
-	}
-
-	return StringName(); //does not exist
+	_Data *d = _find(p_name, p_name.hash());
+	return d ? StringName(d) : StringName(); //does not exist
 }
 
 bool operator==(const String &p_name, const StringName &p_string_name) {
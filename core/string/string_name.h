@@ -48,7 +48,11 @@ class StringName {
 	enum {
 		STRING_TABLE_BITS = 16,
 		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		STRING_TABLE_MASK = STRING_TABLE_LEN - 1,
+		// Buckets are spread over this many locks by their low bits.
+		SHARD_BITS = 6,
+		SHARD_COUNT = 1 << SHARD_BITS,
+		SHARD_MASK = SHARD_COUNT - 1
 	};
 
 	struct _Data {
@@ -67,20 +71,33 @@ class StringName {
 
 		int idx = 0;
 		uint32_t hash = 0;
-		_Data *prev = nullptr;
-		_Data *next = nullptr;
+		_Data *prev = nullptr; // Under the shard lock only. Links the retired list once unlinked.
+		std::atomic<_Data *> next = { nullptr }; // Followed by lookups without the lock.
 		_Data() {}
 	};
 
-	static inline _Data *_table[STRING_TABLE_LEN];
+	// Writers to a bucket hold the lock of its shard. Lookups walk buckets without it, so unlinked
+	// entries are only freed once no lookup is inside the shard.
+	struct _Shard;
+
+	static inline std::atomic<_Data *> _table[STRING_TABLE_LEN];
+	static _Shard _shards[SHARD_COUNT];
 
 	_Data *_data = nullptr;
 
+	template <typename T>
+	static _Data *_find(const T &p_name, uint32_t p_hash);
+	template <typename T>
+	static _Data *_find_locked(const T &p_name, uint32_t p_hash);
+	template <typename T>
+	static _Data *_intern(const T &p_name, uint32_t p_hash, const char *p_static_cname, bool p_static);
+	static void _free_retired(_Shard &p_shard);
+
 	void unref();
 	friend void register_core_types();
 	friend void unregister_core_types();
 	friend class Main;
-	static inline Mutex mutex;
+	static inline Mutex mutex; // For assign_static_unique_class_name().
 	static void setup();
 	static void cleanup();
 	static uint32_t get_empty_hash();
@@ -30,9 +30,139 @@
 
 #include "command_queue_mt.h"
 
+#include <thread>
+
+CommandQueueMT::Block *CommandQueueMT::_allocate_block(uint32_t p_min_capacity) {
+	const uint32_t capacity = MAX(DEFAULT_COMMAND_MEM_SIZE_KB * 1024, p_min_capacity);
+	Block *block = nullptr;
+	if (spare_block && spare_block->capacity >= capacity) {
+		block = spare_block;
+		spare_block = nullptr;
+		block->~Block();
+	} else {
+		block = static_cast<Block *>(Memory::alloc_static(sizeof(Block) + capacity));
+	}
+	// Headers must read as unpublished until a producer writes them.
+	memset(reinterpret_cast<uint8_t *>(block) + sizeof(Block), 0, capacity);
+	new (block) Block;
+	block->capacity = capacity;
+	return block;
+}
+
+void CommandQueueMT::_close_block(Block *p_block, uint32_t p_offset, uint32_t p_size) {
+	// Reservations are handed out in increasing order, so the lowest failing offset is where
+	// the valid entries of this block end.
+	uint32_t end = p_block->end.load(std::memory_order_seq_cst);
+	while (p_offset < end && !p_block->end.compare_exchange_weak(end, p_offset, std::memory_order_seq_cst)) {
+	}
+
+	MutexLock lock(block_mutex);
+	if (p_block->next.load(std::memory_order_seq_cst)) {
+		return; // Another producer already linked the next block.
+	}
+	Block *next = _allocate_block(p_size);
+	// Publish the new write block before linking it, so that once the consumer sees the link,
+	// no newly arriving producer can pick up the old block anymore.
+	write_block.store(next, std::memory_order_seq_cst);
+	p_block->next.store(next, std::memory_order_seq_cst);
+	block_overflows.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CommandQueueMT::_release_retired_blocks() {
+	if (retired_blocks.is_empty() || active_producers.load(std::memory_order_seq_cst) != 0) {
+		return; // Try again after the next flush.
+	}
+	MutexLock lock(block_mutex);
+	for (Block *block : retired_blocks) {
+		if (!spare_block && block->capacity == DEFAULT_COMMAND_MEM_SIZE_KB * 1024) {
+			spare_block = block; // Keep one block around for the next overflow.
+		} else {
+			block->~Block();
+			Memory::free_static(block);
+		}
+	}
+	retired_blocks.clear();
+}
+
+void CommandQueueMT::_flush() {
+	if (unlikely(flushing)) {
+		// Re-entrant call.
+		return;
+	}
+
+	MutexLock lock(flush_mutex);
+	flushing = true;
+	// Cleared before reading, so that a command published after this point sets it again.
+	// The exchange also makes every command published before it visible to this flush.
+	pending.exchange(false, std::memory_order_acq_rel);
+
+	while (true) {
+		Block *block = read_block;
+		if (read_offset >= block->end.load(std::memory_order_seq_cst)) {
+			Block *next = block->next.load(std::memory_order_seq_cst);
+			if (!next) {
+				break; // The producer that filled the block is still linking the next one.
+			}
+			retired_blocks.push_back(block);
+			read_block = next;
+			read_offset = 0;
+			continue;
+		}
+		if (read_offset >= block->reserved.load(std::memory_order_acquire)) {
+			break; // Nothing more has been pushed.
+		}
+
+		uint32_t size = 0;
+		if (read_offset + sizeof(CommandHeader) <= block->capacity) {
+			size = reinterpret_cast<CommandHeader *>(block->get_data() + read_offset)->size.load(std::memory_order_acquire);
+		}
+		if (size == 0) {
+			// Space is reserved but the producer is still writing, or this is the reservation
+			// that overflowed the block and its end has not been recorded yet.
+			commit_waits.fetch_add(1, std::memory_order_relaxed);
+			std::this_thread::yield();
+			continue;
+		}
+
+		CommandBase *cmd = reinterpret_cast<CommandBase *>(block->get_data() + read_offset + sizeof(CommandHeader));
+		uint32_t allowance_id = WorkerThreadPool::thread_enter_unlock_allowance_zone(lock);
+		cmd->call();
+		WorkerThreadPool::thread_exit_unlock_allowance_zone(allowance_id);
+		if (unlikely(cmd->sync_done)) {
+			{
+				MutexLock sync_lock(sync_mutex);
+				*cmd->sync_done = true;
+			}
+			sync_cond_var.notify_all();
+		}
+		cmd->~CommandBase();
+		read_offset += size;
+	}
+
+	_release_retired_blocks();
+	flushing = false;
+}
+
 CommandQueueMT::CommandQueueMT() {
-	command_mem.reserve(DEFAULT_COMMAND_MEM_SIZE_KB * 1024);
+	read_block = _allocate_block(DEFAULT_COMMAND_MEM_SIZE_KB * 1024);
+	write_block.store(read_block);
+	pending.store(false);
 }
 
 CommandQueueMT::~CommandQueueMT() {
+	Block *block = read_block;
+	while (block) {
+		Block *next = block->next.load();
+		block->~Block();
+		Memory::free_static(block);
+		block = next;
+	}
+	for (Block *retired : retired_blocks) {
+		retired->~Block();
+		Memory::free_static(retired);
+	}
+	if (spare_block) {
+		spare_block->~Block();
+		Memory::free_static(spare_block);
+	}
 }
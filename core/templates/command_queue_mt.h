@@ -39,14 +39,18 @@
 #include "core/templates/tuple.h"
 #include "core/typedefs.h"
 
+#include <atomic>
+
+// Multi-producer, single-consumer command queue.
+// Pushing is lock-free: producers reserve space in the current block with one atomic add and
+// publish the command by storing its size into the entry header. Only the producer that
+// overflows a block takes a mutex, to link the next one. The consumer walks the blocks in
+// reservation order, so commands run in the same global order in which they were pushed.
 class CommandQueueMT {
 	struct CommandBase {
-		bool sync = false;
+		bool *sync_done = nullptr; // Set by the consumer once the command has run, for synced pushes.
 		virtual void call() = 0;
 		virtual ~CommandBase() = default;
-
-		CommandBase(bool p_sync) :
-				sync(p_sync) {}
 	};
 
 	template <typename T, typename M, bool NeedsSync, typename... Args>
@@ -57,7 +61,7 @@ class CommandQueueMT {
 
 		template <typename... FwdArgs>
 		_FORCE_INLINE_ Command(T *p_instance, M p_method, FwdArgs &&...p_args) :
-				CommandBase(NeedsSync), instance(p_instance), method(p_method), args(std::forward<FwdArgs>(p_args)...) {}
+				instance(p_instance), method(p_method), args(std::forward<FwdArgs>(p_args)...) {}
 
 		void call() {
 			call_impl(BuildIndexSequence<sizeof...(Args)>{});
@@ -84,7 +88,7 @@ class CommandQueueMT {
 		Tuple<GetSimpleTypeT<Args>...> args;
 
 		_FORCE_INLINE_ CommandRet(T *p_instance, M p_method, R *p_ret, GetSimpleTypeT<Args>... p_args) :
-				CommandBase(true), instance(p_instance), method(p_method), ret(p_ret), args{ p_args... } {}
+				instance(p_instance), method(p_method), ret(p_ret), args{ p_args... } {}
 
 		void call() override {
 			*ret = call_impl(BuildIndexSequence<sizeof...(Args)>{});
@@ -106,103 +110,97 @@ class CommandQueueMT {
 
 	static const uint32_t DEFAULT_COMMAND_MEM_SIZE_KB = 64;
 
-	BinaryMutex mutex;
-	LocalVector<uint8_t> command_mem;
-	ConditionVariable sync_cond_var;
-	uint32_t sync_head = 0;
-	uint32_t sync_tail = 0;
-	uint32_t sync_awaiters = 0;
-	WorkerThreadPool::TaskID pump_task_id = WorkerThreadPool::INVALID_TASK_ID;
-	uint64_t flush_read_ptr = 0;
+	struct Block {
+		std::atomic<uint32_t> reserved = { 0 }; // Bytes handed out; exceeds capacity once the block is full.
+		std::atomic<uint32_t> end = { UINT32_MAX }; // Offset of the first reservation that did not fit.
+		std::atomic<Block *> next = { nullptr };
+		uint32_t capacity = 0;
+
+		_FORCE_INLINE_ uint8_t *get_data() { return reinterpret_cast<uint8_t *>(this) + sizeof(Block); }
+	};
+	static_assert(sizeof(Block) % 8 == 0, "Commands must stay 8-byte aligned.");
+
+	struct CommandHeader {
+		std::atomic<uint32_t> size; // Entry size including the header; 0 until the command is published.
+		uint32_t padding;
+	};
+
+	// Producer side.
+	std::atomic<Block *> write_block = { nullptr };
+	std::atomic<uint32_t> active_producers = { 0 }; // Producers that may still hold a stale block pointer.
+	BinaryMutex block_mutex; // Links new blocks and guards spare_block.
+	Block *spare_block = nullptr;
+	std::atomic<WorkerThreadPool::TaskID> pump_task_id = { WorkerThreadPool::INVALID_TASK_ID };
 	std::atomic<bool> pending;
 
-	template <typename T, typename... Args>
-	_FORCE_INLINE_ void create_command(Args &&...p_args) {
-		// alloc size is size+T+safeguard
-		constexpr uint64_t alloc_size = ((sizeof(T) + 8U - 1U) & ~(8U - 1U));
-		static_assert(alloc_size < UINT32_MAX, "Type too large to fit in the command queue.");
-
-		uint64_t size = command_mem.size();
-		command_mem.resize(size + alloc_size + sizeof(uint64_t));
-		*(uint64_t *)&command_mem[size] = alloc_size;
-		void *cmd = &command_mem[size + sizeof(uint64_t)];
-		new (cmd) T(std::forward<Args>(p_args)...);
-		pending.store(true);
+	// Consumer side (one flush at a time).
+	BinaryMutex flush_mutex;
+	bool flushing = false;
+	Block *read_block = nullptr;
+	uint32_t read_offset = 0;
+	LocalVector<Block *> retired_blocks;
+
+	// Synced pushes wait here until the consumer has run their command.
+	BinaryMutex sync_mutex;
+	ConditionVariable sync_cond_var;
+
+	// Contention counters.
+	std::atomic<uint64_t> block_overflows = { 0 };
+	std::atomic<uint64_t> commit_waits = { 0 };
+	std::atomic<uint64_t> sync_waits = { 0 };
+
+	Block *_allocate_block(uint32_t p_min_capacity);
+	void _close_block(Block *p_block, uint32_t p_offset, uint32_t p_size);
+	void _release_retired_blocks();
+
+	_FORCE_INLINE_ uint8_t *_reserve(uint32_t p_size) {
+		// Blocks are only freed while no producer is inside this function, so a stale
+		// write_block pointer is never dereferenced after its block was released.
+		active_producers.fetch_add(1, std::memory_order_seq_cst);
+		uint8_t *entry = nullptr;
+		while (true) {
+			Block *block = write_block.load(std::memory_order_seq_cst);
+			const uint32_t offset = block->reserved.fetch_add(p_size, std::memory_order_relaxed);
+			if (likely(uint64_t(offset) + p_size <= block->capacity)) {
+				entry = block->get_data() + offset;
+				break;
+			}
+			_close_block(block, offset, p_size);
+		}
+		active_producers.fetch_sub(1, std::memory_order_release);
+		return entry;
 	}
 
 	template <typename T, bool NeedsSync, typename... Args>
 	_FORCE_INLINE_ void _push_internal(Args &&...args) {
-		MutexLock mlock(mutex);
-		create_command<T>(std::forward<Args>(args)...);
-
-		if (pump_task_id != WorkerThreadPool::INVALID_TASK_ID) {
-			WorkerThreadPool::get_singleton()->notify_yield_over(pump_task_id);
-		}
+		// alloc size is header+T, padded to keep the next entry aligned
+		constexpr uint64_t alloc_size = sizeof(CommandHeader) + ((sizeof(T) + 8U - 1U) & ~(8U - 1U));
+		static_assert(alloc_size < UINT32_MAX / 2, "Type too large to fit in the command queue.");
 
+		bool done = false;
+		uint8_t *entry = _reserve(alloc_size);
+		T *cmd = new (entry + sizeof(CommandHeader)) T(std::forward<Args>(args)...);
 		if constexpr (NeedsSync) {
-			sync_tail++;
-			_wait_for_sync(mlock);
+			cmd->sync_done = &done;
 		}
-	}
-
-	_FORCE_INLINE_ void _prevent_sync_wraparound() {
-		bool safe_to_reset = !sync_awaiters;
-		bool already_sync_to_latest = sync_head == sync_tail;
-		if (safe_to_reset && already_sync_to_latest) {
-			sync_head = 0;
-			sync_tail = 0;
-		}
-	}
+		reinterpret_cast<CommandHeader *>(entry)->size.store(alloc_size, std::memory_order_release);
+		pending.store(true);
 
-	void _flush() {
-		if (unlikely(flush_read_ptr)) {
-			// Re-entrant call.
-			return;
+		const WorkerThreadPool::TaskID pump = pump_task_id.load(std::memory_order_acquire);
+		if (pump != WorkerThreadPool::INVALID_TASK_ID) {
+			WorkerThreadPool::get_singleton()->notify_yield_over(pump);
 		}
 
-		MutexLock lock(mutex);
-
-		while (flush_read_ptr < command_mem.size()) {
-			uint64_t size = *(uint64_t *)&command_mem[flush_read_ptr];
-			flush_read_ptr += 8;
-			CommandBase *cmd = reinterpret_cast<CommandBase *>(&command_mem[flush_read_ptr]);
-			uint32_t allowance_id = WorkerThreadPool::thread_enter_unlock_allowance_zone(lock);
-			cmd->call();
-			WorkerThreadPool::thread_exit_unlock_allowance_zone(allowance_id);
-
-			// Handle potential realloc due to the command and unlock allowance.
-			cmd = reinterpret_cast<CommandBase *>(&command_mem[flush_read_ptr]);
-
-			if (unlikely(cmd->sync)) {
-				sync_head++;
-				lock.~MutexLock(); // Give an opportunity to awaiters right away.
-				sync_cond_var.notify_all();
-				new (&lock) MutexLock(mutex);
-				// Handle potential realloc happened during unlock.
-				cmd = reinterpret_cast<CommandBase *>(&command_mem[flush_read_ptr]);
+		if constexpr (NeedsSync) {
+			sync_waits.fetch_add(1, std::memory_order_relaxed);
+			MutexLock lock(sync_mutex);
+			while (!done) {
+				sync_cond_var.wait(lock);
 			}
-
-			cmd->~CommandBase();
-
-			flush_read_ptr += size;
 		}
-
-		command_mem.clear();
-		pending.store(false);
-		flush_read_ptr = 0;
-
-		_prevent_sync_wraparound();
 	}
 
-	_FORCE_INLINE_ void _wait_for_sync(MutexLock<BinaryMutex> &p_lock) {
-		sync_awaiters++;
-		uint32_t sync_head_goal = sync_tail;
-		do {
-			sync_cond_var.wait(p_lock);
-		} while (sync_head < sync_head_goal);
-		sync_awaiters--;
-		_prevent_sync_wraparound();
-	}
+	void _flush();
 
 	void _no_op() {}
 
@@ -243,14 +241,28 @@ public:
 	}
 
 	void wait_and_flush() {
-		ERR_FAIL_COND(pump_task_id == WorkerThreadPool::INVALID_TASK_ID);
-		WorkerThreadPool::get_singleton()->wait_for_task_completion(pump_task_id);
+		const WorkerThreadPool::TaskID pump = pump_task_id.load(std::memory_order_acquire);
+		ERR_FAIL_COND(pump == WorkerThreadPool::INVALID_TASK_ID);
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(pump);
 		_flush();
 	}
 
 	void set_pump_task_id(WorkerThreadPool::TaskID p_task_id) {
-		MutexLock lock(mutex);
-		pump_task_id = p_task_id;
+		pump_task_id.store(p_task_id, std::memory_order_release);
+	}
+
+	struct Stats {
+		uint64_t block_overflows = 0; // Pushes that filled a block and had to link the next one.
+		uint64_t commit_waits = 0; // Times the consumer waited for a producer to finish writing a command.
+		uint64_t sync_waits = 0; // Pushes that blocked until their command had run.
+	};
+
+	Stats get_stats() const {
+		Stats stats;
+		stats.block_overflows = block_overflows.load(std::memory_order_relaxed);
+		stats.commit_waits = commit_waits.load(std::memory_order_relaxed);
+		stats.sync_waits = sync_waits.load(std::memory_order_relaxed);
+		return stats;
 	}
 
 	CommandQueueMT();
@@ -169,6 +169,7 @@ private:
 	void _ref(const CowData &p_from);
 	USize _copy_on_write();
 	Error _realloc(Size p_alloc_size);
+	bool _ref_external(T *p_data);
 
 public:
 	void operator=(const CowData<T> &p_from) { _ref(p_from); }
@@ -504,6 +505,19 @@ void CowData<T>::_ref(const CowData &p_from) {
 	}
 }
 
+template <typename T>
+bool CowData<T>::_ref_external(T *p_data) {
+	_unref(); // Resets _ptr to nullptr.
+
+	// The owner of the buffer holds a reference it never releases, so it is never freed here
+	// and any write copies it into memory of our own first.
+	if (_get_refcount_ptr((uint8_t *)p_data - DATA_OFFSET)->conditional_increment() == 0) {
+		return false;
+	}
+	_ptr = p_data;
+	return true;
+}
+
 template <typename T>
 CowData<T>::CowData(std::initializer_list<T> p_init) {
 	Error err = resize(p_init.size());
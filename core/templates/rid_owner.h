@@ -33,6 +33,8 @@
 
 #include "core/os/memory.h"
 #include "core/os/mutex.h"
+#include "core/os/spin_lock.h"
+#include "core/os/thread.h"
 #include "core/string/print_string.h"
 #include "core/templates/list.h"
 #include "core/templates/rid.h"
@@ -99,8 +101,15 @@ public:
 	virtual ~RID_AllocBase() {}
 };
 
-template <typename T, bool THREAD_SAFE = false>
+// With SHARDED (requires THREAD_SAFE), free indices are cached per thread in a small
+// array of shards and handed to and from a shared pool in batches. Allocating and
+// freeing then only take the shard's spin lock, which other threads rarely touch;
+// the mutex is left for growing and rebalancing. Lookups and owns() don't lock at all.
+// Suited for owners where many threads create and free RIDs at the same time.
+template <typename T, bool THREAD_SAFE = false, bool SHARDED = false>
 class RID_Alloc : public RID_AllocBase {
+	static_assert(THREAD_SAFE || !SHARDED, "A sharded RID_Alloc must be thread-safe.");
+
 	struct Chunk {
 		T data;
 		uint32_t validator;
@@ -117,7 +126,150 @@ class RID_Alloc : public RID_AllocBase {
 
 	mutable Mutex mutex;
 
+	static const uint32_t SHARD_COUNT = 32;
+	static const uint32_t SHARD_CACHE_SIZE = 64;
+	static const uint32_t SHARD_BATCH_SIZE = SHARD_CACHE_SIZE / 2;
+
+	struct Shard {
+		SpinLock lock;
+		std::atomic<int32_t> live_count = { 0 }; // Allocations minus frees done through this shard.
+		uint32_t cache_count = 0;
+		uint32_t cache[SHARD_CACHE_SIZE];
+	};
+	Shard *shards = nullptr;
+	// In sharded mode, the free indices that no shard holds live at the start of free_list_chunks.
+	uint32_t pool_count = 0;
+
+	_FORCE_INLINE_ Shard &_get_shard() const {
+		return shards[Thread::get_caller_id() % SHARD_COUNT];
+	}
+
+	_FORCE_INLINE_ uint32_t &_get_free_list_slot(uint32_t p_pos) const {
+		return free_list_chunks[p_pos / elements_in_chunk][p_pos % elements_in_chunk];
+	}
+
+	_FORCE_INLINE_ static std::atomic<uint32_t> &_get_validator_atomic(Chunk &p_chunk) {
+		return *(std::atomic<uint32_t> *)&p_chunk.validator;
+	}
+
+	// Validator of an element for iterating; other shards may write it concurrently in sharded mode.
+	_FORCE_INLINE_ uint32_t _load_validator(uint32_t p_index) const {
+		Chunk &c = chunks[p_index / elements_in_chunk][p_index % elements_in_chunk];
+		if constexpr (SHARDED) {
+			return _get_validator_atomic(c).load(std::memory_order_acquire);
+		} else {
+			return c.validator;
+		}
+	}
+
+	RID _fail_element_limit() const {
+		if (description != nullptr) {
+			ERR_FAIL_V_MSG(RID(), vformat("Element limit for RID of type '%s' reached.", String(description)));
+		} else {
+			ERR_FAIL_V_MSG(RID(), "Element limit reached.");
+		}
+	}
+
+	// Moves a batch of free indices from the pool into p_shard, growing by a chunk if the pool is empty.
+	// Must be called with the shard locked.
+	bool _refill_shard(Shard &p_shard) {
+		MutexLock lock(mutex);
+		if (pool_count == 0) {
+			uint32_t chunk_count = max_alloc / elements_in_chunk;
+			if (chunk_count == chunk_limit) {
+				return false;
+			}
+			chunks[chunk_count] = (Chunk *)memalloc(sizeof(Chunk) * elements_in_chunk); //but don't initialize
+			free_list_chunks[chunk_count] = (uint32_t *)memalloc(sizeof(uint32_t) * elements_in_chunk);
+			// The pool is empty, so the new indices go to its start.
+			for (uint32_t i = 0; i < elements_in_chunk; i++) {
+				chunks[chunk_count][i].validator = 0xFFFFFFFF;
+				_get_free_list_slot(i) = max_alloc + i;
+			}
+			pool_count = elements_in_chunk;
+			// Publishes the new chunk to lock-free readers.
+			((std::atomic<uint32_t> *)&max_alloc)->store(max_alloc + elements_in_chunk, std::memory_order_release);
+		}
+		uint32_t count = MIN(pool_count, SHARD_BATCH_SIZE);
+		for (uint32_t i = 0; i < count; i++) {
+			p_shard.cache[p_shard.cache_count++] = _get_free_list_slot(--pool_count);
+		}
+		return true;
+	}
+
+	RID _allocate_rid_sharded() {
+		Shard &shard = _get_shard();
+		shard.lock.lock();
+		if (shard.cache_count == 0 && !_refill_shard(shard)) {
+			shard.lock.unlock();
+			return _fail_element_limit();
+		}
+		uint32_t free_index = shard.cache[--shard.cache_count];
+
+		uint32_t validator = (uint32_t)(_gen_id() & 0x7FFFFFFF);
+		CRASH_COND_MSG(validator == 0x7FFFFFFF, "Overflow in RID validator");
+		uint64_t id = validator;
+		id <<= 32;
+		id |= free_index;
+
+		Chunk &c = chunks[free_index / elements_in_chunk][free_index % elements_in_chunk];
+		_get_validator_atomic(c).store(validator | 0x80000000, std::memory_order_release); //mark uninitialized bit
+		shard.live_count.fetch_add(1, std::memory_order_relaxed);
+		shard.lock.unlock();
+
+		return _make_from_id(id);
+	}
+
+	void _free_sharded(const RID &p_rid) {
+		uint64_t id = p_rid.get_id();
+		uint32_t idx = uint32_t(id & 0xFFFFFFFF);
+		ERR_FAIL_COND(idx >= ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_acquire));
+
+		Chunk &c = chunks[idx / elements_in_chunk][idx % elements_in_chunk];
+		uint32_t validator = uint32_t(id >> 32);
+		uint32_t current = _get_validator_atomic(c).load(std::memory_order_acquire);
+		if (unlikely(current & 0x80000000)) {
+			ERR_FAIL_MSG("Attempted to free an uninitialized or invalid RID");
+		}
+		// Claiming the element by setting the uninitialized bit lets only one of two racing frees through.
+		ERR_FAIL_COND(current != validator || !_get_validator_atomic(c).compare_exchange_strong(current, validator | 0x80000000, std::memory_order_acq_rel));
+
+		c.data.~T();
+
+		Shard &shard = _get_shard();
+		shard.lock.lock();
+		_get_validator_atomic(c).store(0xFFFFFFFF, std::memory_order_release); // go invalid
+		shard.live_count.fetch_sub(1, std::memory_order_relaxed);
+		if (shard.cache_count == SHARD_CACHE_SIZE) {
+			// Hand the older half back to the pool.
+			MutexLock lock(mutex);
+			for (uint32_t i = 0; i < SHARD_BATCH_SIZE; i++) {
+				_get_free_list_slot(pool_count++) = shard.cache[i];
+			}
+			shard.cache_count -= SHARD_BATCH_SIZE;
+			memmove(shard.cache, shard.cache + SHARD_BATCH_SIZE, sizeof(uint32_t) * shard.cache_count);
+		}
+		shard.cache[shard.cache_count++] = idx;
+		shard.lock.unlock();
+	}
+
+	// Blocks allocations and frees in every shard, so the validators match get_rid_count().
+	void _lock_shards() const {
+		for (uint32_t i = 0; i < SHARD_COUNT; i++) {
+			shards[i].lock.lock();
+		}
+	}
+	void _unlock_shards() const {
+		for (uint32_t i = 0; i < SHARD_COUNT; i++) {
+			shards[i].lock.unlock();
+		}
+	}
+
 	_FORCE_INLINE_ RID _allocate_rid() {
+		if constexpr (SHARDED) {
+			return _allocate_rid_sharded();
+		}
+
 		if constexpr (THREAD_SAFE) {
 			mutex.lock();
 		}
@@ -127,11 +279,7 @@ class RID_Alloc : public RID_AllocBase {
 			uint32_t chunk_count = alloc_count == 0 ? 0 : (max_alloc / elements_in_chunk);
 			if (THREAD_SAFE && chunk_count == chunk_limit) {
 				mutex.unlock();
-				if (description != nullptr) {
-					ERR_FAIL_V_MSG(RID(), vformat("Element limit for RID of type '%s' reached.", String(description)));
-				} else {
-					ERR_FAIL_V_MSG(RID(), "Element limit reached.");
-				}
+				return _fail_element_limit();
 			}
 
 			//grow chunks
@@ -212,7 +360,9 @@ public:
 		uint64_t id = p_rid.get_id();
 		uint32_t idx = uint32_t(id & 0xFFFFFFFF);
 		uint32_t ma;
-		if constexpr (THREAD_SAFE) { // Read atomically to avoid data race with the store in _allocate_rid().
+		if constexpr (SHARDED) { // Pairs with the release in _refill_shard(), which publishes the chunk pointer.
+			ma = ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_acquire);
+		} else if constexpr (THREAD_SAFE) { // Read atomically to avoid data race with the store in _allocate_rid().
 			ma = ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_relaxed);
 		} else {
 			ma = max_alloc;
@@ -243,19 +393,31 @@ public:
 #endif
 		}
 
+		// Other shards may write validators of neighboring elements concurrently.
+		uint32_t current;
+		if constexpr (SHARDED) {
+			current = _get_validator_atomic(c).load(std::memory_order_acquire);
+		} else {
+			current = c.validator;
+		}
+
 		if (unlikely(p_initialize)) {
-			if (unlikely(!(c.validator & 0x80000000))) {
+			if (unlikely(!(current & 0x80000000))) {
 				ERR_FAIL_V_MSG(nullptr, "Initializing already initialized RID");
 			}
 
-			if (unlikely((c.validator & 0x7FFFFFFF) != validator)) {
+			if (unlikely((current & 0x7FFFFFFF) != validator)) {
 				ERR_FAIL_V_MSG(nullptr, "Attempting to initialize the wrong RID");
 			}
 
-			c.validator &= 0x7FFFFFFF; //initialized
+			if constexpr (SHARDED) {
+				_get_validator_atomic(c).store(validator, std::memory_order_release); //initialized
+			} else {
+				c.validator &= 0x7FFFFFFF; //initialized
+			}
 
-		} else if (unlikely(c.validator != validator)) {
-			if ((c.validator & 0x80000000) && c.validator != 0xFFFFFFFF) {
+		} else if (unlikely(current != validator)) {
+			if ((current & 0x80000000) && current != 0xFFFFFFFF) {
 				ERR_FAIL_V_MSG(nullptr, "Attempting to use an uninitialized RID");
 			}
 			return nullptr;
@@ -312,6 +474,17 @@ public:
 	}
 
 	_FORCE_INLINE_ bool owns(const RID &p_rid) const {
+		if constexpr (SHARDED) {
+			uint64_t id = p_rid.get_id();
+			uint32_t idx = uint32_t(id & 0xFFFFFFFF);
+			if (unlikely(idx >= ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_acquire))) {
+				return false;
+			}
+			uint32_t validator = uint32_t(id >> 32);
+			Chunk &c = chunks[idx / elements_in_chunk][idx % elements_in_chunk];
+			return (validator != 0x7FFFFFFF) && (_get_validator_atomic(c).load(std::memory_order_acquire) & 0x7FFFFFFF) == validator;
+		}
+
 		if constexpr (THREAD_SAFE) {
 			mutex.lock();
 		}
@@ -340,6 +513,11 @@ public:
 	}
 
 	_FORCE_INLINE_ void free(const RID &p_rid) {
+		if constexpr (SHARDED) {
+			_free_sharded(p_rid);
+			return;
+		}
+
 		if constexpr (THREAD_SAFE) {
 			mutex.lock();
 		}
@@ -381,38 +559,55 @@ public:
 	}
 
 	_FORCE_INLINE_ uint32_t get_rid_count() const {
+		if constexpr (SHARDED) {
+			int32_t count = 0;
+			for (uint32_t i = 0; i < SHARD_COUNT; i++) {
+				count += shards[i].live_count.load(std::memory_order_relaxed);
+			}
+			return MAX(count, 0);
+		}
 		return alloc_count;
 	}
 	void get_owned_list(List<RID> *p_owned) const {
-		if constexpr (THREAD_SAFE) {
+		if constexpr (SHARDED) {
+			_lock_shards();
+		} else if constexpr (THREAD_SAFE) {
 			mutex.lock();
 		}
-		for (size_t i = 0; i < max_alloc; i++) {
-			uint64_t validator = chunks[i / elements_in_chunk][i % elements_in_chunk].validator;
+		const uint32_t ma = ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_acquire);
+		for (size_t i = 0; i < ma; i++) {
+			uint64_t validator = _load_validator(i);
 			if (validator != 0xFFFFFFFF) {
 				p_owned->push_back(_make_from_id((validator << 32) | i));
 			}
 		}
-		if constexpr (THREAD_SAFE) {
+		if constexpr (SHARDED) {
+			_unlock_shards();
+		} else if constexpr (THREAD_SAFE) {
 			mutex.unlock();
 		}
 	}
 
 	//used for fast iteration in the elements or RIDs
 	void fill_owned_buffer(RID *p_rid_buffer) const {
-		if constexpr (THREAD_SAFE) {
+		if constexpr (SHARDED) {
+			_lock_shards();
+		} else if constexpr (THREAD_SAFE) {
 			mutex.lock();
 		}
 		uint32_t idx = 0;
-		for (size_t i = 0; i < max_alloc; i++) {
-			uint64_t validator = chunks[i / elements_in_chunk][i % elements_in_chunk].validator;
+		const uint32_t ma = ((std::atomic<uint32_t> *)&max_alloc)->load(std::memory_order_acquire);
+		for (size_t i = 0; i < ma; i++) {
+			uint64_t validator = _load_validator(i);
 			if (validator != 0xFFFFFFFF) {
 				p_rid_buffer[idx] = _make_from_id((validator << 32) | i);
 				idx++;
 			}
 		}
 
-		if constexpr (THREAD_SAFE) {
+		if constexpr (SHARDED) {
+			_unlock_shards();
+		} else if constexpr (THREAD_SAFE) {
 			mutex.unlock();
 		}
 	}
@@ -427,6 +622,9 @@ public:
 			chunk_limit = (p_maximum_number_of_elements / elements_in_chunk) + 1;
 			chunks = (Chunk **)memalloc(sizeof(Chunk *) * chunk_limit);
 			free_list_chunks = (uint32_t **)memalloc(sizeof(uint32_t *) * chunk_limit);
+			if constexpr (SHARDED) {
+				shards = memnew_arr(Shard, SHARD_COUNT);
+			}
 			SYNC_RELEASE;
 		}
 	}
@@ -436,9 +634,10 @@ public:
 			SYNC_ACQUIRE;
 		}
 
-		if (alloc_count) {
+		uint32_t leaked_count = get_rid_count();
+		if (leaked_count) {
 			print_error(vformat("ERROR: %d RID allocations of type '%s' were leaked at exit.",
-					alloc_count, description ? description : typeid(T).name()));
+					leaked_count, description ? description : typeid(T).name()));
 
 			for (size_t i = 0; i < max_alloc; i++) {
 				uint32_t validator = chunks[i / elements_in_chunk][i % elements_in_chunk].validator;
@@ -461,12 +660,15 @@ public:
 			memfree(chunks);
 			memfree(free_list_chunks);
 		}
+		if (shards) {
+			memdelete_arr(shards);
+		}
 	}
 };
 
-template <typename T, bool THREAD_SAFE = false>
+template <typename T, bool THREAD_SAFE = false, bool SHARDED = false>
 class RID_PtrOwner {
-	RID_Alloc<T *, THREAD_SAFE> alloc;
+	RID_Alloc<T *, THREAD_SAFE, SHARDED> alloc;
 
 public:
 	_FORCE_INLINE_ RID make_rid(T *p_ptr) {
@@ -523,9 +725,9 @@ public:
 			alloc(p_target_chunk_byte_size, p_maximum_number_of_elements) {}
 };
 
-template <typename T, bool THREAD_SAFE = false>
+template <typename T, bool THREAD_SAFE = false, bool SHARDED = false>
 class RID_Owner {
-	RID_Alloc<T, THREAD_SAFE> alloc;
+	RID_Alloc<T, THREAD_SAFE, SHARDED> alloc;
 
 public:
 	_FORCE_INLINE_ RID make_rid() {
@@ -70,6 +70,19 @@ public:
 private:
 	CowData<T> _cowdata;
 
+	// Binary resources store packed arrays in the layout CowData uses, so those inside mapped packs
+	// can be shared without copying them.
+	friend class ResourceLoaderBinary;
+
+	// Shares a buffer CowData didn't allocate, such as one inside a pinned file mapping, which must
+	// outlive the Vector and its copies. The EXTERNAL_HEADER_SIZE bytes in front of p_data must be
+	// writable and hold the 64-bit reference count followed by the 64-bit size. The reference count
+	// must include one that is never released, so the buffer is never freed; the data itself is
+	// never written to, as the first write copies it like with any shared Vector.
+	// Returns false if the reference count is zero.
+	static constexpr size_t EXTERNAL_HEADER_SIZE = CowData<T>::DATA_OFFSET;
+	bool _ref_external(T *p_data) { return _cowdata._ref_external(p_data); }
+
 public:
 	// Must take a copy instead of a reference (see GH-31736).
 	bool push_back(T p_elem);
@@ -99,6 +112,7 @@ public:
 	_FORCE_INLINE_ Size size() const { return _cowdata.size(); }
 	Error resize(Size p_size) { return _cowdata.resize(p_size); }
 	Error resize_zeroed(Size p_size) { return _cowdata.template resize<true>(p_size); }
+
 	_FORCE_INLINE_ const T &operator[](Size p_index) const { return _cowdata.get(p_index); }
 	// Must take a copy instead of a reference (see GH-31736).
 	Error insert(Size p_pos, T p_val) { return _cowdata.insert(p_pos, p_val); }
@@ -37,6 +37,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -166,11 +167,42 @@ Error FileAccessUnix::open_internal(const String &p_path, int p_mode_flags) {
 	return OK;
 }
 
+Error FileAccessUnix::open_mapped_internal(const String &p_path) {
+	Error err = open_internal(p_path, READ);
+	if (err != OK) {
+		return err;
+	}
+
+	struct stat st = {};
+	if (fstat(fileno(f), &st) || st.st_size <= 0 || uint64_t(st.st_size) > SIZE_MAX) {
+		return OK; // Empty, or too big for the address space; stdio reads still work.
+	}
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (data == MAP_FAILED) {
+		WARN_VERBOSE(vformat("Can't memory-map '%s', reading it through a regular file instead.", path));
+		return OK;
+	}
+	map_data = (uint8_t *)data;
+	map_length = st.st_size;
+	map_pos = 0;
+	map_eof = false;
+	return OK;
+}
+
 void FileAccessUnix::_close() {
 	if (!f) {
 		return;
 	}
 
+	if (map_data) {
+		if (!map_pinned) {
+			munmap(map_data, map_length);
+		}
+		map_data = nullptr;
+		map_length = 0;
+		map_pinned = false;
+	}
+
 	fclose(f);
 	f = nullptr;
 
@@ -225,6 +257,12 @@ String FileAccessUnix::get_real_path() const {
 void FileAccessUnix::seek(uint64_t p_position) {
 	ERR_FAIL_NULL_MSG(f, "File must be opened before use.");
 
+	if (map_data) {
+		map_pos = p_position;
+		map_eof = false;
+		return;
+	}
+
 	if (fseeko(f, p_position, SEEK_SET)) {
 		check_errors();
 	}
@@ -233,6 +271,12 @@ void FileAccessUnix::seek(uint64_t p_position) {
 void FileAccessUnix::seek_end(int64_t p_position) {
 	ERR_FAIL_NULL_MSG(f, "File must be opened before use.");
 
+	if (map_data) {
+		map_pos = map_length + p_position;
+		map_eof = false;
+		return;
+	}
+
 	if (fseeko(f, p_position, SEEK_END)) {
 		check_errors();
 	}
@@ -241,6 +285,10 @@ void FileAccessUnix::seek_end(int64_t p_position) {
 uint64_t FileAccessUnix::get_position() const {
 	ERR_FAIL_NULL_V_MSG(f, 0, "File must be opened before use.");
 
+	if (map_data) {
+		return map_pos;
+	}
+
 	int64_t pos = ftello(f);
 	if (pos < 0) {
 		check_errors();
@@ -252,6 +300,10 @@ uint64_t FileAccessUnix::get_position() const {
 uint64_t FileAccessUnix::get_length() const {
 	ERR_FAIL_NULL_V_MSG(f, 0, "File must be opened before use.");
 
+	if (map_data) {
+		return map_length;
+	}
+
 	int64_t pos = ftello(f);
 	ERR_FAIL_COND_V(pos < 0, 0);
 	ERR_FAIL_COND_V(fseeko(f, 0, SEEK_END), 0);
@@ -263,6 +315,9 @@ uint64_t FileAccessUnix::get_length() const {
 }
 
 bool FileAccessUnix::eof_reached() const {
+	if (map_data) {
+		return map_eof;
+	}
 	return feof(f);
 }
 
@@ -270,12 +325,93 @@ uint64_t FileAccessUnix::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
 	ERR_FAIL_NULL_V_MSG(f, -1, "File must be opened before use.");
 	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
 
+	if (map_data) {
+		const uint64_t available = map_pos < map_length ? map_length - map_pos : 0;
+		const uint64_t read = MIN(p_length, available);
+		memcpy(p_dst, map_data + map_pos, read);
+		map_pos += read;
+		// Like fread(), reading past the end sets EOF.
+		map_eof = read < p_length;
+		last_error = map_eof ? ERR_FILE_EOF : OK;
+		return read;
+	}
+
 	uint64_t read = fread(p_dst, 1, p_length, f);
 	check_errors();
 
 	return read;
 }
 
+const uint8_t *FileAccessUnix::get_buffer_span(uint64_t p_length) const {
+	if (!map_data || map_pos > map_length || p_length > map_length - map_pos) {
+		return nullptr;
+	}
+	const uint8_t *span = map_data + map_pos;
+	map_pos += p_length;
+	return span;
+}
+
+void FileAccessUnix::advise(MapAdvice p_advice, uint64_t p_from, uint64_t p_length) const {
+	if (!map_data || p_from >= map_length) {
+		return;
+	}
+	if (p_length == 0 || p_length > map_length - p_from) {
+		p_length = map_length - p_from;
+	}
+
+	int advice = MADV_NORMAL;
+	switch (p_advice) {
+		case MAP_ADVICE_NORMAL: {
+		} break;
+		case MAP_ADVICE_SEQUENTIAL: {
+			advice = MADV_SEQUENTIAL;
+		} break;
+		case MAP_ADVICE_RANDOM: {
+			advice = MADV_RANDOM;
+		} break;
+		case MAP_ADVICE_WILL_NEED: {
+			advice = MADV_WILLNEED;
+		} break;
+		case MAP_ADVICE_DONT_NEED: {
+			if (map_pinned) {
+				return; // Would throw away pages that were written to.
+			}
+			advice = MADV_DONTNEED;
+		} break;
+	}
+
+	// madvise() wants a page-aligned start.
+	static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+	const uint64_t start = p_from - p_from % page_size;
+	madvise(map_data + start, p_length + (p_from - start), advice);
+}
+
+bool FileAccessUnix::pin_mapping() {
+	if (!map_data) {
+		return false;
+	}
+	map_pinned = true;
+	return true;
+}
+
+uint8_t *FileAccessUnix::get_pinned_span(uint64_t p_length) const {
+	if (!map_pinned) {
+		return nullptr;
+	}
+	return const_cast<uint8_t *>(get_buffer_span(p_length));
+}
+
+bool FileAccessUnix::make_mapping_writable(uint64_t p_from, uint64_t p_length) const {
+	if (!map_pinned || p_from > map_length || p_length > map_length - p_from) {
+		return false;
+	}
+	// The mapping is private, so the pages are copied on the first write and the file is never
+	// touched. mprotect() wants a page-aligned start.
+	static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+	const uint64_t start = p_from - p_from % page_size;
+	return mprotect(map_data + start, p_length + (p_from - start), PROT_READ | PROT_WRITE) == 0;
+}
+
 Error FileAccessUnix::get_error() const {
 	return last_error;
 }
@@ -47,6 +47,15 @@ class FileAccessUnix : public FileAccess {
 	String path;
 	String path_src;
 
+	// Private, read-only mapping of the whole file (open_mapped()), apart from the pages made
+	// writable by make_mapping_writable(). While mapped, reads and the position are served from here
+	// instead of f.
+	uint8_t *map_data = nullptr;
+	uint64_t map_length = 0;
+	mutable uint64_t map_pos = 0;
+	mutable bool map_eof = false;
+	bool map_pinned = false; // Never unmapped (see pin_mapping()).
+
 	void _close();
 
 #if defined(TOOLS_ENABLED)
@@ -58,6 +67,7 @@ public:
 	static CloseNotificationFunc close_notification_func;
 
 	virtual Error open_internal(const String &p_path, int p_mode_flags) override; ///< open a file
+	virtual Error open_mapped_internal(const String &p_path) override;
 	virtual bool is_open() const override; ///< true when file is open
 
 	virtual String get_path() const override; /// returns the path for the current open file
@@ -72,6 +82,14 @@ public:
 
 	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
 
+	virtual const uint8_t *get_mapped_data() const override { return map_data; }
+	virtual const uint8_t *get_buffer_span(uint64_t p_length) const override;
+	virtual void advise(MapAdvice p_advice, uint64_t p_from = 0, uint64_t p_length = 0) const override;
+	virtual bool pin_mapping() override;
+	virtual bool is_mapping_pinned() const override { return map_pinned; }
+	virtual uint8_t *get_pinned_span(uint64_t p_length) const override;
+	virtual bool make_mapping_writable(uint64_t p_from, uint64_t p_length) const override;
+
 	virtual Error get_error() const override; ///< get last error
 
 	virtual Error resize(int64_t p_length) override;
@@ -30,6 +30,7 @@
 
 #include "performance.h"
 
+#include "core/object/worker_thread_pool.h"
 #include "core/os/os.h"
 #include "core/variant/typed_array.h"
 #include "scene/main/node.h"
@@ -97,6 +98,9 @@ void Performance::_bind_methods() {
 	BIND_ENUM_CONSTANT(PIPELINE_COMPILATIONS_SURFACE);
 	BIND_ENUM_CONSTANT(PIPELINE_COMPILATIONS_DRAW);
 	BIND_ENUM_CONSTANT(PIPELINE_COMPILATIONS_SPECIALIZATION);
+	BIND_ENUM_CONSTANT(THREADS_TASK_QUEUE_DEPTH);
+	BIND_ENUM_CONSTANT(THREADS_TASK_QUEUE_DEPTH_MAX);
+	BIND_ENUM_CONSTANT(THREADS_TASK_STEALS);
 	BIND_ENUM_CONSTANT(MONITOR_MAX);
 }
 
@@ -151,6 +155,9 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		PNAME("pipeline/compilations_surface"),
 		PNAME("pipeline/compilations_draw"),
 		PNAME("pipeline/compilations_specialization"),
+		PNAME("threads/task_queue_depth"),
+		PNAME("threads/task_queue_depth_max"),
+		PNAME("threads/task_steals"),
 	};
 	static_assert((sizeof(names) / sizeof(const char *)) == MONITOR_MAX);
 
@@ -247,6 +254,22 @@ double Performance::get_monitor(Monitor p_monitor) const {
 			return NavigationServer3D::get_singleton()->get_process_info(NavigationServer3D::INFO_EDGE_FREE_COUNT);
 		case NAVIGATION_OBSTACLE_COUNT:
 			return NavigationServer3D::get_singleton()->get_process_info(NavigationServer3D::INFO_OBSTACLE_COUNT);
+		case THREADS_TASK_QUEUE_DEPTH:
+			return WorkerThreadPool::get_singleton()->get_queued_task_count();
+		case THREADS_TASK_QUEUE_DEPTH_MAX: {
+			uint32_t depth = 0;
+			for (int i = 0; i < WorkerThreadPool::get_singleton()->get_thread_count(); i++) {
+				depth = MAX(depth, WorkerThreadPool::get_singleton()->get_thread_stats(i).queue_depth);
+			}
+			return depth;
+		}
+		case THREADS_TASK_STEALS: {
+			uint64_t steals = 0;
+			for (int i = 0; i < WorkerThreadPool::get_singleton()->get_thread_count(); i++) {
+				steals += WorkerThreadPool::get_singleton()->get_thread_stats(i).steal_count;
+			}
+			return steals;
+		}
 
 		default: {
 		}
@@ -298,6 +321,9 @@ Performance::MonitorType Performance::get_monitor_type(Monitor p_monitor) const
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_QUANTITY,
 
 	};
 	static_assert((sizeof(types) / sizeof(MonitorType)) == MONITOR_MAX);
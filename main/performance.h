@@ -106,6 +106,9 @@ public:
 		PIPELINE_COMPILATIONS_SURFACE,
 		PIPELINE_COMPILATIONS_DRAW,
 		PIPELINE_COMPILATIONS_SPECIALIZATION,
+		THREADS_TASK_QUEUE_DEPTH,
+		THREADS_TASK_QUEUE_DEPTH_MAX,
+		THREADS_TASK_STEALS,
 		MONITOR_MAX
 	};
 
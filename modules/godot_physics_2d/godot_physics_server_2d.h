@@ -58,11 +58,12 @@ class GodotPhysicsServer2D : public PhysicsServer2D {
 	GodotStep2D *stepper = nullptr;
 	HashSet<GodotSpace2D *> active_spaces;
 
-	mutable RID_PtrOwner<GodotShape2D, true> shape_owner;
-	mutable RID_PtrOwner<GodotSpace2D, true> space_owner;
-	mutable RID_PtrOwner<GodotArea2D, true> area_owner;
-	mutable RID_PtrOwner<GodotBody2D, true> body_owner;
-	mutable RID_PtrOwner<GodotJoint2D, true> joint_owner;
+	// Sharded: with PhysicsServer2DWrapMT, *_create() still runs on the calling thread while free() runs on the server thread.
+	mutable RID_PtrOwner<GodotShape2D, true, true> shape_owner;
+	mutable RID_PtrOwner<GodotSpace2D, true, true> space_owner;
+	mutable RID_PtrOwner<GodotArea2D, true, true> area_owner;
+	mutable RID_PtrOwner<GodotBody2D, true, true> body_owner;
+	mutable RID_PtrOwner<GodotJoint2D, true, true> joint_owner;
 
 	static GodotPhysicsServer2D *godot_singleton;
 
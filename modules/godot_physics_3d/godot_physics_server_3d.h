@@ -56,12 +56,13 @@ class GodotPhysicsServer3D : public PhysicsServer3D {
 	GodotStep3D *stepper = nullptr;
 	HashSet<GodotSpace3D *> active_spaces;
 
-	mutable RID_PtrOwner<GodotShape3D, true> shape_owner;
-	mutable RID_PtrOwner<GodotSpace3D, true> space_owner;
-	mutable RID_PtrOwner<GodotArea3D, true> area_owner;
-	mutable RID_PtrOwner<GodotBody3D, true> body_owner;
-	mutable RID_PtrOwner<GodotSoftBody3D, true> soft_body_owner;
-	mutable RID_PtrOwner<GodotJoint3D, true> joint_owner;
+	// Sharded: with PhysicsServer3DWrapMT, *_create() still runs on the calling thread while free() runs on the server thread.
+	mutable RID_PtrOwner<GodotShape3D, true, true> shape_owner;
+	mutable RID_PtrOwner<GodotSpace3D, true, true> space_owner;
+	mutable RID_PtrOwner<GodotArea3D, true, true> area_owner;
+	mutable RID_PtrOwner<GodotBody3D, true, true> body_owner;
+	mutable RID_PtrOwner<GodotSoftBody3D, true, true> soft_body_owner;
+	mutable RID_PtrOwner<GodotJoint3D, true, true> joint_owner;
 
 	//void _clear_query(QuerySW *p_query);
 	friend class GodotCollisionObject3D;
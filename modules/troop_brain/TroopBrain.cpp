@@ -16,6 +16,8 @@ void TroopBrain::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_speed", "speed"), &TroopBrain::set_speed);
     ClassDB::bind_method(D_METHOD("set_max_building_path_length", "length"), &TroopBrain::set_max_building_path_length);
     ClassDB::bind_method(D_METHOD("set_max_detour", "detour"), &TroopBrain::set_max_detour);
+    ClassDB::bind_method(D_METHOD("set_use_flow_field", "enable"), &TroopBrain::set_use_flow_field);
+    ClassDB::bind_method(D_METHOD("set_curve_segments", "segments"), &TroopBrain::set_curve_segments);
 
     // Optionally bind getters if needed in scripts
     ClassDB::bind_method(D_METHOD("get_detection_range"), &TroopBrain::get_detection_range);
@@ -23,6 +25,8 @@ void TroopBrain::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_speed"), &TroopBrain::get_speed);
     ClassDB::bind_method(D_METHOD("get_max_building_path_length"), &TroopBrain::get_max_building_path_length);
     ClassDB::bind_method(D_METHOD("get_max_detour"), &TroopBrain::get_max_detour);
+    ClassDB::bind_method(D_METHOD("is_using_flow_field"), &TroopBrain::is_using_flow_field);
+    ClassDB::bind_method(D_METHOD("get_curve_segments"), &TroopBrain::get_curve_segments);
     ClassDB::bind_method(D_METHOD("get_attack_target_point"), &TroopBrain::get_attack_target_point);
     ClassDB::bind_method(D_METHOD("get_attack_target"), &TroopBrain::get_attack_target);
 }
@@ -34,8 +38,62 @@ TroopBrain::TroopBrain() {
 }
 
 void TroopBrain::initialize(Node2D *p_troop_unit, GridManager *p_grid_manager) {
+    const Callable on_changed = callable_mp(this, &TroopBrain::_on_occupancy_changed);
+    if (grid_manager && grid_manager->is_connected(SNAME("occupancy_changed"), on_changed)) {
+        grid_manager->disconnect(SNAME("occupancy_changed"), on_changed);
+    }
     troop_unit = p_troop_unit;
     grid_manager = p_grid_manager;
+    if (grid_manager) {
+        grid_manager->connect(SNAME("occupancy_changed"), on_changed);
+    }
+}
+
+void TroopBrain::_on_occupancy_changed(const PackedVector2Array &p_cells) {
+    bool path_blocked = false;
+    bool target_changed = false;
+    Rect2i target_rect;
+    if (attack_target) {
+        // Ziel verschoben, entfernt oder zerstört
+        const GridManager::BuildingRecord *record = grid_manager->get_building_record(attack_target->get_instance_id());
+        target_changed = !record || record->destroyed || record->top_left != attack_target_origin;
+        if (record) {
+            target_rect = Rect2i(record->top_left, Vector2i(record->size, record->size));
+        }
+    }
+    HashSet<Vector2i> new_walls;
+    for (int i = 0; i < p_cells.size(); i++) {
+        const Vector2i cell = Vector2i(p_cells[i]);
+        if (grid_manager->is_wall_at(cell) && !target_rect.has_point(cell)) {
+            new_walls.insert(cell);
+        }
+    }
+
+    // Nur verwerfen, wenn eine neue Wand den noch zu laufenden Teil des Pfades schneidet.
+    // Zwischen den Eckpunkten zählt die Sichtlinie, da dort keine Zellen gespeichert sind.
+    if (!new_walls.is_empty()) {
+        for (int i = path_index; i < path.size() && !path_blocked; i++) {
+            const Vector2i cell = Vector2i(grid_manager->screen_to_grid(path[i]).floor());
+            if (new_walls.has(cell)) {
+                path_blocked = true;
+            } else if (i + 1 < path.size()) {
+                const Vector2i next_cell = Vector2i(grid_manager->screen_to_grid(path[i + 1]).floor());
+                path_blocked = !grid_manager->has_line_of_sight(cell, next_cell);
+            }
+        }
+    }
+
+    if (target_changed) {
+        attack_target = nullptr;
+        attack_target_point = Vector2();
+    }
+    if (target_changed || path_blocked) {
+        path.resize(0);
+        path_index = 0;
+        path_sample = 1;
+    }
+    // Die Umweglänge im Flussfeld-Modus kann sich geändert haben
+    flow_checked_goal = Vector2i(-1, -1);
 }
 
 void TroopBrain::update_target() {
@@ -43,138 +101,127 @@ void TroopBrain::update_target() {
         //print_line("update_target: grid_manager oder troop_unit nicht gesetzt.");
         return;
     }
-        
-    Dictionary occupancy = grid_manager->get_grid_occupancy();
-    //print_line(vformat("update_target: occupancy keys count: %d", occupancy.keys().size()));
-    
-    float best_dist = detection_range;
+
     attack_target = nullptr;
     attack_target_point = Vector2();
-    
-    Array keys = occupancy.keys();
-    // Zuerst Gebäude-Ziel suchen (nicht Wand)
-    for (int i = 0; i < keys.size(); i++) {
-        Vector2 cell = keys[i];
-        Dictionary obj = occupancy[cell];
-        bool is_wall = obj.has("is_wall") ? bool(obj["is_wall"]) : false;
-        //print_line(vformat("update_target: cell: (%f, %f) is_wall: %s", cell.x, cell.y, is_wall ? "true" : "false"));
-        if (!is_wall) {
-            // If a building size is provided, use it. Otherwise assume size = 1.
-            int b_size = obj.has("size") ? int(obj["size"]) : 1;
-            Vector2 offset = Vector2(b_size * 0.5f, b_size * 0.5f);
-            Vector2 center = grid_manager->grid_to_screen(cell + offset);
-            
-            // Calculate the building border point along the line from its center to troop position.
-            Vector2 diff = troop_unit->get_global_position() - center;
-            if (diff == Vector2()) {
-                // Avoid divide-by-zero; choose center.
-                diff = Vector2(1,0);
-            }
-            Vector2 direction = diff.normalized();
-            float hx = b_size * 0.5f;
-            float hy = b_size * 0.5f;
-            float tx = fabsf(direction.x) > 0.0001f ? hx / fabsf(direction.x) : FLT_MAX;
-            float ty = fabsf(direction.y) > 0.0001f ? hy / fabsf(direction.y) : FLT_MAX;
-            float t = MIN(tx, ty);
-            Vector2 target_point = center + direction * t;
-            
-            float d = troop_unit->get_global_position().distance_to(target_point);
-            Node2D *potential_target = Object::cast_to<Node2D>(obj["obj"]);
-            if (potential_target && d < best_dist) {
-                best_dist = d;
-                attack_target_point = target_point;
-                attack_target = potential_target;
-                //print_line("update_target: Found non-wall target.");
-            }
-        }
+
+    // Über den räumlichen Index nur Gebäude im Erkennungsradius prüfen.
+    // Gebäude haben Vorrang; nur wenn keines in Reichweite ist, wird eine Wand gesucht.
+    const Vector2 position = troop_unit->get_global_position();
+    GridManager::TargetHit hit;
+    if (!grid_manager->query_nearest_target(position, detection_range, GridManager::TARGET_FILTER_BUILDINGS, hit) &&
+            !grid_manager->query_nearest_target(position, detection_range, GridManager::TARGET_FILTER_WALLS, hit)) {
+        return;
     }
-    
-    // Falls kein gültiges Gebäude-Ziel gefunden wurde, suche nach einem Wand-Ziel.
-    if (!attack_target) {
-        //print_line("update_target: Kein Building-Ziel gefunden, suche Wand-Ziel.");
-        for (int i = 0; i < keys.size(); i++) {
-            Vector2 cell = keys[i];
-            Dictionary obj = occupancy[cell];
-            bool is_wall = obj.has("is_wall") ? bool(obj["is_wall"]) : false;
-            if (is_wall) {
-                int b_size = obj.has("size") ? int(obj["size"]) : 1;
-                Vector2 offset = Vector2(b_size * 0.5f, b_size * 0.5f);
-                Vector2 center = grid_manager->grid_to_screen(cell + offset);
-                
-                Vector2 diff = troop_unit->get_global_position() - center;
-                if (diff == Vector2()) {
-                    diff = Vector2(1,0);
-                }
-                Vector2 direction = diff.normalized();
-                float hx = b_size * 0.5f;
-                float hy = b_size * 0.5f;
-                float tx = fabsf(direction.x) > 0.0001f ? hx / fabsf(direction.x) : FLT_MAX;
-                float ty = fabsf(direction.y) > 0.0001f ? hy / fabsf(direction.y) : FLT_MAX;
-                float t = MIN(tx, ty);
-
-                float cell_adjustment = 1.0f; // adjust this constant if needed
-                float t_adjusted = (t > cell_adjustment) ? (t - cell_adjustment) : t;
-
-                Vector2 target_point = center + direction * t_adjusted;
-                
-                float d = troop_unit->get_global_position().distance_to(target_point);
-                Node2D *potential_target = Object::cast_to<Node2D>(obj["obj"]);
-                if (potential_target && d < best_dist) {
-                    best_dist = d;
-                    attack_target_point = target_point;
-                    attack_target = potential_target;
-                    //print_line("update_target: Found wall target.");
-                }
+    set_attack_target(Object::cast_to<Node2D>(ObjectDB::get_instance(hit.id)), hit.point);
+}
+
+void TroopBrain::set_attack_target(Node2D *p_target, const Vector2 &p_point) {
+    attack_target = p_target;
+    attack_target_point = p_point;
+    // Lage des Ziels merken, um Verschieben oder Entfernen zu erkennen
+    const GridManager::BuildingRecord *record = p_target ? grid_manager->get_building_record(p_target->get_instance_id()) : nullptr;
+    attack_target_origin = record ? record->top_left : Vector2i(-1, -1);
+}
+
+bool TroopBrain::step_towards(const Vector2 &target_point, float delta) {
+    Vector2 direction = target_point - troop_unit->get_global_position();
+    float distance = direction.length();
+    Vector2 velocity = direction.normalized() * speed * delta;
+    // Beispiel: Anpassung der Y-Komponente
+    velocity.y *= 0.5f;
+    if (distance <= velocity.length()) {
+        troop_unit->set_global_position(target_point);
+        return true;
+    }
+    troop_unit->set_global_position(troop_unit->get_global_position() + velocity);
+    return false;
+}
+
+void TroopBrain::move_along_flow_field(float delta) {
+    Vector2 position = troop_unit->get_global_position();
+    Vector2i cell = Vector2i(grid_manager->screen_to_grid(position).floor());
+    Vector2i goal_cell = Vector2i(grid_manager->screen_to_grid(attack_target_point).floor());
+    if (cell == goal_cell) {
+        step_towards(attack_target_point, delta);
+        return;
+    }
+
+    // Weglänge nur einmal pro Ziel prüfen, nicht in jedem Frame
+    if (goal_cell != flow_checked_goal) {
+        flow_checked_goal = goal_cell;
+        float distance = grid_manager->get_flow_field_distance(cell, goal_cell, true);
+        if (distance < 0.0f || distance > max_building_path_length) {
+            // Umweg zu lang oder kein Weg: erste Wand auf dem direkten Weg angreifen
+            PackedVector2Array ignore_path = grid_manager->get_simple_path_iso_ignore_walls(position, attack_target_point);
+            Node2D *wall_target = get_first_wall_on_path(ignore_path);
+            if (wall_target) {
+                set_attack_target(wall_target, wall_target->get_global_position());
+                goal_cell = Vector2i(grid_manager->screen_to_grid(attack_target_point).floor());
+                flow_checked_goal = goal_cell;
             }
         }
     }
+
+    // Nächsten Schritt in O(1) aus dem gemeinsamen Flussfeld des Ziels ablesen
+    Vector2i next_cell = grid_manager->get_flow_field_next_cell(cell, goal_cell, true);
+    if (next_cell == Vector2i(-1, -1)) {
+        return;
+    }
+    if (next_cell == goal_cell) {
+        step_towards(attack_target_point, delta);
+    } else {
+        step_towards(grid_manager->grid_to_screen(Vector2(next_cell) + Vector2(0.5, 0.5)), delta);
+    }
 }
 
 void TroopBrain::move(float delta) {
     if (!troop_unit || !grid_manager)
         return;
 
+    if (use_flow_field) {
+        move_along_flow_field(delta);
+        return;
+    }
+
     // Falls noch kein Pfad berechnet oder abgelaufen: Pfad neu ermitteln
-    if (path.size() == 0 || path_index >= path.size()) {
+    if (path.size() < 2 || path_index >= path.size() - 1) {
         //print_line("Berechne neuen Pfad");
-        Array avoid_path = grid_manager->get_simple_path_iso_avoid_walls_smoothed(
+        PackedVector2Array avoid_path = grid_manager->get_waypoint_path(
             troop_unit->get_global_position(), attack_target_point);
-        // Falls der Umwegs-Pfad zu lang ist, ignore-Pfad betrachten:
-        if (avoid_path.size() > max_building_path_length) {
+        // Falls der Umwegs-Pfad zu lang ist, ignore-Pfad betrachten (Länge in Zellen, nicht in Punkten):
+        if (grid_manager->get_path_cell_length(avoid_path) > max_building_path_length) {
             //print_line("Umweg zu lang, ignoriere Wände");
-            Array ignore_path = grid_manager->get_simple_path_iso_ignore_walls(
+            PackedVector2Array ignore_path = grid_manager->get_simple_path_iso_ignore_walls(
                 troop_unit->get_global_position(), attack_target_point);
             Node2D *wall_target = get_first_wall_on_path(ignore_path);
             if (wall_target) {
                 //print_line("Wand gefunden");
-                attack_target = wall_target;
-                attack_target_point = wall_target->get_global_position();
-                avoid_path = grid_manager->get_simple_path_iso_avoid_walls_smoothed(
+                set_attack_target(wall_target, wall_target->get_global_position());
+                avoid_path = grid_manager->get_waypoint_path(
                     troop_unit->get_global_position(), attack_target_point);
             }
         }
         path = avoid_path;
         path_index = 0;
+        path_sample = 1;
     }
 
-    // Bewege die Truppe entlang des Pfades
-    if (path.size() > 0) {
-        Vector2 target_point = path[path_index];
-        Vector2 direction = target_point - troop_unit->get_global_position();
-        float distance = direction.length();
-        Vector2 velocity = direction.normalized() * speed * delta;
-        // Beispiel: Anpassung der Y-Komponente
-        velocity.y *= 0.5f;
-        if (distance <= velocity.length()) {
-            troop_unit->set_global_position(target_point);
-            path_index++;
-            if (path_index >= path.size()) {
+    // Bewege die Truppe entlang des Pfades. Die Kurve durch die Eckpunkte wird erst hier
+    // ausgewertet, immer nur für den nächsten anzusteuernden Punkt.
+    if (path.size() >= 2) {
+        const Vector2 target_point = GridManager::sample_path_curve(path, path_index, path_sample / float(curve_segments));
+        if (step_towards(target_point, delta)) {
+            path_sample++;
+            if (path_sample > curve_segments) {
+                path_index++;
+                path_sample = 1;
+            }
+            if (path_index >= path.size() - 1) {
                 // Pfad abgeschlossen, reset
                 path.resize(0);
                 path_index = 0;
             }
-        } else {
-            troop_unit->set_global_position(troop_unit->get_global_position() + velocity);
         }
     }
 }
@@ -200,18 +247,12 @@ void TroopBrain::update(float delta) {
     move(delta);
 }
 
-Node2D *TroopBrain::get_first_wall_on_path(const Array &ignore_path) {
+Node2D *TroopBrain::get_first_wall_on_path(const PackedVector2Array &ignore_path) {
     for (int i = 0; i < ignore_path.size(); i++) {
         Vector2 screen_point = ignore_path[i];
-        Vector2 cell = grid_manager->screen_to_grid(screen_point);
-        cell.x = Math::floor(cell.x);
-        cell.y = Math::floor(cell.y);
-        Dictionary occ = grid_manager->get_grid_occupancy();
-        if (occ.has(cell)) {
-            Dictionary obj = occ[cell];
-            if (obj.has("is_wall") && obj["is_wall"]) {
-                return Object::cast_to<Node2D>(obj["obj"]);
-            }
+        Vector2i cell = Vector2i(grid_manager->screen_to_grid(screen_point).floor());
+        if (grid_manager->is_wall_at(cell)) {
+            return grid_manager->get_occupant(cell);
         }
     }
     return nullptr;
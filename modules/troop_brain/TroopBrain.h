@@ -7,6 +7,7 @@
 #include "core/math/vector2.h"
 #include "core/variant/dictionary.h"
 #include "core/object/ref_counted.h"
+#include "core/templates/hash_set.h"
 
 class TroopBrain : public RefCounted {
     GDCLASS(TroopBrain, RefCounted);
@@ -19,8 +20,10 @@ private:
     // Ziel, Pfad und Pfadindex
     Node2D *attack_target = nullptr;
     Vector2 attack_target_point;
-    Array path;
-    int path_index = 0;
+    Vector2i attack_target_origin = Vector2i(-1, -1); // Obere linke Zelle des Ziels bei der Auswahl
+    PackedVector2Array path;             // Eckpunkte aus GridManager::get_waypoint_path
+    int path_index = 0;                  // Aktueller Abschnitt (von path[path_index] zum nächsten Eckpunkt)
+    int path_sample = 1;                 // Nächster Kurvenpunkt im Abschnitt (1..curve_segments)
 
     // Konfigurationsparameter
     float detection_range = 100.0f;
@@ -28,6 +31,19 @@ private:
     float speed = 100.0f;
     int max_building_path_length = 50;
     float max_detour = 5.0f;
+    bool use_flow_field = false;          // Schritte aus dem gemeinsamen Flussfeld des Ziels lesen
+    int curve_segments = 10;              // Kurvenpunkte pro Abschnitt, 1 = gerade Linien
+
+    // Zielzelle, für die die Weglänge im Flussfeld-Modus zuletzt geprüft wurde
+    Vector2i flow_checked_goal = Vector2i(-1, -1);
+
+    // Bewegt die Truppe einen Frame lang auf einen Punkt zu; true, wenn er erreicht wurde
+    bool step_towards(const Vector2 &target_point, float delta);
+    void move_along_flow_field(float delta);
+    void set_attack_target(Node2D *p_target, const Vector2 &p_point);
+
+    // Reagiert auf GridManager::occupancy_changed: verwirft nur betroffene Pfade und Ziele
+    void _on_occupancy_changed(const PackedVector2Array &p_cells);
 
 protected:
     static void _bind_methods();
@@ -47,7 +63,7 @@ public:
     void update(float delta);
 
     // Hilfsmethode: Liefert aus einem idealen (ignore) Pfad das erste Wandziel (falls vorhanden)
-    Node2D *get_first_wall_on_path(const Array &ignore_path);
+    Node2D *get_first_wall_on_path(const PackedVector2Array &ignore_path);
 
     // Setter für Parameter (zum Beispiel aus GDScript, falls nötig)
     void set_detection_range(float p_range) { detection_range = p_range; }
@@ -55,6 +71,8 @@ public:
     void set_speed(float p_speed) { speed = p_speed; }
     void set_max_building_path_length(int p_length) { max_building_path_length = p_length; }
     void set_max_detour(float p_detour) { max_detour = p_detour; }
+    void set_use_flow_field(bool p_enable) { use_flow_field = p_enable; }
+    void set_curve_segments(int p_segments) { curve_segments = MAX(p_segments, 1); }
 
     // Getter um via GDScript auf die Parameter zuzugreifen
     float get_detection_range() const { return detection_range; }
@@ -62,6 +80,8 @@ public:
     float get_speed() const { return speed; }
     int get_max_building_path_length() const { return max_building_path_length; }
     float get_max_detour() const { return max_detour; }
+    bool is_using_flow_field() const { return use_flow_field; }
+    int get_curve_segments() const { return curve_segments; }
     Vector2 get_attack_target_point() const { return attack_target_point; }
     Node2D *get_attack_target() const { return attack_target; }
 };
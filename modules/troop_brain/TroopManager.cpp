@@ -0,0 +1,715 @@
+#include "TroopManager.h"
+#include "core/object/class_db.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/sort_array.h"
+#include "servers/rendering_server.h"
+
+#include <Agent2d.h>
+#include <RVOSimulator2d.h>
+
+void TroopManager::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("initialize", "grid_manager"), &TroopManager::initialize);
+    ClassDB::bind_method(D_METHOD("get_grid_manager"), &TroopManager::get_grid_manager);
+
+    ClassDB::bind_method(D_METHOD("add_troop", "position", "node"), &TroopManager::add_troop, DEFVAL(Variant()));
+    ClassDB::bind_method(D_METHOD("remove_troop", "troop_id"), &TroopManager::remove_troop);
+    ClassDB::bind_method(D_METHOD("clear_troops"), &TroopManager::clear_troops);
+    ClassDB::bind_method(D_METHOD("get_troop_count"), &TroopManager::get_troop_count);
+    ClassDB::bind_method(D_METHOD("has_troop", "troop_id"), &TroopManager::has_troop);
+    ClassDB::bind_method(D_METHOD("get_troop_position", "troop_id"), &TroopManager::get_troop_position);
+    ClassDB::bind_method(D_METHOD("set_troop_position", "troop_id", "position"), &TroopManager::set_troop_position);
+    ClassDB::bind_method(D_METHOD("get_troop_state", "troop_id"), &TroopManager::get_troop_state);
+    ClassDB::bind_method(D_METHOD("get_troop_target", "troop_id"), &TroopManager::get_troop_target);
+    ClassDB::bind_method(D_METHOD("get_troop_target_point", "troop_id"), &TroopManager::get_troop_target_point);
+    ClassDB::bind_method(D_METHOD("get_troop_positions"), &TroopManager::get_troop_positions);
+    ClassDB::bind_method(D_METHOD("update", "delta"), &TroopManager::update);
+
+    ClassDB::bind_method(D_METHOD("set_speed", "speed"), &TroopManager::set_speed);
+    ClassDB::bind_method(D_METHOD("get_speed"), &TroopManager::get_speed);
+    ClassDB::bind_method(D_METHOD("set_attack_range", "range"), &TroopManager::set_attack_range);
+    ClassDB::bind_method(D_METHOD("get_attack_range"), &TroopManager::get_attack_range);
+    ClassDB::bind_method(D_METHOD("set_detection_range", "range"), &TroopManager::set_detection_range);
+    ClassDB::bind_method(D_METHOD("get_detection_range"), &TroopManager::get_detection_range);
+    ClassDB::bind_method(D_METHOD("set_max_building_path_length", "length"), &TroopManager::set_max_building_path_length);
+    ClassDB::bind_method(D_METHOD("get_max_building_path_length"), &TroopManager::get_max_building_path_length);
+    ClassDB::bind_method(D_METHOD("set_avoidance_enabled", "enabled"), &TroopManager::set_avoidance_enabled);
+    ClassDB::bind_method(D_METHOD("is_avoidance_enabled"), &TroopManager::is_avoidance_enabled);
+    ClassDB::bind_method(D_METHOD("set_troop_radius", "radius"), &TroopManager::set_troop_radius);
+    ClassDB::bind_method(D_METHOD("get_troop_radius"), &TroopManager::get_troop_radius);
+    ClassDB::bind_method(D_METHOD("set_avoidance_neighbor_distance", "distance"), &TroopManager::set_avoidance_neighbor_distance);
+    ClassDB::bind_method(D_METHOD("get_avoidance_neighbor_distance"), &TroopManager::get_avoidance_neighbor_distance);
+    ClassDB::bind_method(D_METHOD("set_avoidance_time_horizon", "time"), &TroopManager::set_avoidance_time_horizon);
+    ClassDB::bind_method(D_METHOD("get_avoidance_time_horizon"), &TroopManager::get_avoidance_time_horizon);
+    ClassDB::bind_method(D_METHOD("set_avoidance_max_neighbors", "count"), &TroopManager::set_avoidance_max_neighbors);
+    ClassDB::bind_method(D_METHOD("get_avoidance_max_neighbors"), &TroopManager::get_avoidance_max_neighbors);
+    ClassDB::bind_method(D_METHOD("set_deterministic", "enabled"), &TroopManager::set_deterministic);
+    ClassDB::bind_method(D_METHOD("is_deterministic"), &TroopManager::is_deterministic);
+    ClassDB::bind_method(D_METHOD("get_state_hash"), &TroopManager::get_state_hash);
+    ClassDB::bind_method(D_METHOD("set_multimesh", "multimesh"), &TroopManager::set_multimesh);
+    ClassDB::bind_method(D_METHOD("get_multimesh"), &TroopManager::get_multimesh);
+    ClassDB::bind_method(D_METHOD("set_texture", "texture"), &TroopManager::set_texture);
+    ClassDB::bind_method(D_METHOD("get_texture"), &TroopManager::get_texture);
+
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "speed"), "set_speed", "get_speed");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "attack_range"), "set_attack_range", "get_attack_range");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "detection_range"), "set_detection_range", "get_detection_range");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_building_path_length"), "set_max_building_path_length", "get_max_building_path_length");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "deterministic"), "set_deterministic", "is_deterministic");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "troop_radius", PROPERTY_HINT_RANGE, "0,64,0.1,or_greater,suffix:px"), "set_troop_radius", "get_troop_radius");
+    ADD_GROUP("Avoidance", "avoidance_");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "avoidance_enabled"), "set_avoidance_enabled", "is_avoidance_enabled");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "avoidance_neighbor_distance", PROPERTY_HINT_RANGE, "0,256,0.1,or_greater,suffix:px"), "set_avoidance_neighbor_distance", "get_avoidance_neighbor_distance");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "avoidance_time_horizon", PROPERTY_HINT_RANGE, "0.01,10,0.01,suffix:s"), "set_avoidance_time_horizon", "get_avoidance_time_horizon");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "avoidance_max_neighbors", PROPERTY_HINT_RANGE, "1,64,1"), "set_avoidance_max_neighbors", "get_avoidance_max_neighbors");
+    ADD_GROUP("", "");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "multimesh", PROPERTY_HINT_RESOURCE_TYPE, "MultiMesh"), "set_multimesh", "get_multimesh");
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "texture", PROPERTY_HINT_RESOURCE_TYPE, "Texture2D"), "set_texture", "get_texture");
+
+    BIND_ENUM_CONSTANT(TROOP_STATE_IDLE);
+    BIND_ENUM_CONSTANT(TROOP_STATE_MOVING);
+    BIND_ENUM_CONSTANT(TROOP_STATE_ATTACKING);
+}
+
+void TroopManager::_notification(int p_what) {
+    switch (p_what) {
+        case NOTIFICATION_READY: {
+            set_physics_process_internal(true);
+        } break;
+        case NOTIFICATION_INTERNAL_PHYSICS_PROCESS: {
+            update(get_physics_process_delta_time());
+        } break;
+        case NOTIFICATION_DRAW: {
+            if (multimesh.is_valid()) {
+                draw_multimesh(multimesh, texture);
+            }
+        } break;
+    }
+}
+
+TroopManager::TroopManager() {
+}
+
+TroopManager::~TroopManager() {
+    if (avoidance_simulation) {
+        memdelete(avoidance_simulation);
+    }
+}
+
+void TroopManager::initialize(GridManager *p_grid_manager) {
+    const Callable on_changed = callable_mp(this, &TroopManager::_on_occupancy_changed);
+    if (grid_manager && grid_manager->is_connected(SNAME("occupancy_changed"), on_changed)) {
+        grid_manager->disconnect(SNAME("occupancy_changed"), on_changed);
+    }
+    grid_manager = p_grid_manager;
+    if (grid_manager) {
+        grid_manager->connect(SNAME("occupancy_changed"), on_changed);
+    }
+    for (uint32_t i = 0; i < troop_ids.size(); i++) {
+        _clear_target(i);
+    }
+}
+
+int TroopManager::add_troop(Vector2 position, Node2D *node) {
+    const int troop_id = next_troop_id++;
+    id_to_slot[troop_id] = troop_ids.size();
+    troop_ids.push_back(troop_id);
+    positions.push_back(_snap(position));
+    speeds.push_back(speed);
+    attack_ranges.push_back(attack_range);
+    detection_ranges.push_back(detection_range);
+    states.push_back(TROOP_STATE_IDLE);
+    targets.push_back(ObjectID());
+    target_points.push_back(Vector2());
+    target_origins.push_back(Vector2i(-1, -1));
+    goal_cells.push_back(Vector2i(-1, -1));
+    needs_path_check.push_back(0);
+    nodes.push_back(node ? node->get_instance_id() : ObjectID());
+    velocities.push_back(Vector2());
+    return troop_id;
+}
+
+void TroopManager::remove_troop(int troop_id) {
+    HashMap<int, uint32_t>::Iterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND_MSG(!E, vformat("Unbekannte Truppe %d.", troop_id));
+    const uint32_t slot = E->value;
+    id_to_slot.remove(E);
+
+    // Letzte Truppe in die Lücke verschieben
+    troop_ids.remove_at_unordered(slot);
+    positions.remove_at_unordered(slot);
+    speeds.remove_at_unordered(slot);
+    attack_ranges.remove_at_unordered(slot);
+    detection_ranges.remove_at_unordered(slot);
+    states.remove_at_unordered(slot);
+    targets.remove_at_unordered(slot);
+    target_points.remove_at_unordered(slot);
+    target_origins.remove_at_unordered(slot);
+    goal_cells.remove_at_unordered(slot);
+    needs_path_check.remove_at_unordered(slot);
+    nodes.remove_at_unordered(slot);
+    velocities.remove_at_unordered(slot);
+    if (slot < troop_ids.size()) {
+        id_to_slot[troop_ids[slot]] = slot;
+    }
+}
+
+void TroopManager::clear_troops() {
+    troop_ids.clear();
+    positions.clear();
+    speeds.clear();
+    attack_ranges.clear();
+    detection_ranges.clear();
+    states.clear();
+    targets.clear();
+    target_points.clear();
+    target_origins.clear();
+    goal_cells.clear();
+    needs_path_check.clear();
+    nodes.clear();
+    velocities.clear();
+    id_to_slot.clear();
+    _write_back();
+}
+
+Vector2 TroopManager::get_troop_position(int troop_id) const {
+    HashMap<int, uint32_t>::ConstIterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND_V(!E, Vector2());
+    return positions[E->value];
+}
+
+void TroopManager::set_troop_position(int troop_id, Vector2 position) {
+    HashMap<int, uint32_t>::Iterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND(!E);
+    positions[E->value] = _snap(position);
+    needs_path_check[E->value] = targets[E->value].is_valid();
+}
+
+TroopManager::TroopState TroopManager::get_troop_state(int troop_id) const {
+    HashMap<int, uint32_t>::ConstIterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND_V(!E, TROOP_STATE_IDLE);
+    return TroopState(states[E->value]);
+}
+
+Node2D *TroopManager::get_troop_target(int troop_id) const {
+    HashMap<int, uint32_t>::ConstIterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND_V(!E, nullptr);
+    return Object::cast_to<Node2D>(ObjectDB::get_instance(targets[E->value]));
+}
+
+Vector2 TroopManager::get_troop_target_point(int troop_id) const {
+    HashMap<int, uint32_t>::ConstIterator E = id_to_slot.find(troop_id);
+    ERR_FAIL_COND_V(!E, Vector2());
+    return target_points[E->value];
+}
+
+PackedVector2Array TroopManager::get_troop_positions() const {
+    PackedVector2Array result;
+    result.resize(positions.size());
+    if (!positions.is_empty()) {
+        memcpy(result.ptrw(), positions.ptr(), positions.size() * sizeof(Vector2));
+    }
+    return result;
+}
+
+void TroopManager::set_deterministic(bool p_enabled) {
+    deterministic = p_enabled;
+    for (uint32_t i = 0; i < troop_ids.size(); i++) {
+        positions[i] = _snap(positions[i]);
+        target_points[i] = _snap(target_points[i]);
+    }
+}
+
+uint64_t TroopManager::get_state_hash() const {
+    // Gleiche Eingaben erzeugen dieselbe Slot-Reihenfolge, daher wird in Slot-Reihenfolge gehasht
+    uint64_t hash = grid_manager ? grid_manager->get_state_hash() : hash_djb2_one_64(0);
+    hash = hash_djb2_one_64(uint64_t(troop_ids.size()), hash);
+    for (uint32_t i = 0; i < troop_ids.size(); i++) {
+        const Vector2i position = Vector2i((positions[i] * FIXED_POINT_SCALE).round());
+        hash = hash_djb2_one_64(uint64_t(uint32_t(troop_ids[i])) | (uint64_t(states[i]) << 32), hash);
+        hash = hash_djb2_one_64(uint64_t(uint32_t(position.x)) | (uint64_t(uint32_t(position.y)) << 32), hash);
+        hash = hash_djb2_one_64(uint64_t(uint32_t(target_origins[i].x)) | (uint64_t(uint32_t(target_origins[i].y)) << 32), hash);
+        hash = hash_djb2_one_64(uint64_t(uint32_t(goal_cells[i].x)) | (uint64_t(uint32_t(goal_cells[i].y)) << 32), hash);
+    }
+    return hash;
+}
+
+void TroopManager::set_multimesh(const Ref<MultiMesh> &p_multimesh) {
+    multimesh = p_multimesh;
+    multimesh_buffer.clear();
+    _write_back();
+    queue_redraw();
+}
+
+void TroopManager::set_texture(const Ref<Texture2D> &p_texture) {
+    texture = p_texture;
+    queue_redraw();
+}
+
+void TroopManager::_set_target(uint32_t p_slot, const GridManager::TargetHit &p_hit) {
+    const GridManager::BuildingRecord *record = grid_manager->get_building_record(p_hit.id);
+    targets[p_slot] = p_hit.id;
+    target_points[p_slot] = _snap(p_hit.point);
+    target_origins[p_slot] = record ? record->top_left : Vector2i(-1, -1);
+    goal_cells[p_slot] = _get_cell(target_points[p_slot]);
+    needs_path_check[p_slot] = 1;
+}
+
+void TroopManager::_clear_target(uint32_t p_slot) {
+    targets[p_slot] = ObjectID();
+    target_origins[p_slot] = Vector2i(-1, -1);
+    needs_path_check[p_slot] = 0;
+    states[p_slot] = TROOP_STATE_IDLE;
+}
+
+void TroopManager::_run_chunked(void (TroopManager::*p_method)(uint32_t, uint32_t), uint32_t p_count, const StringName &p_description) {
+    const uint32_t chunks = _get_chunk_count(p_count);
+    if (chunks == 0) {
+        return;
+    }
+    if (chunks == 1) {
+        // Kleine Mengen direkt ausführen, ohne Aufgaben zu verteilen
+        (this->*p_method)(0, p_count);
+        return;
+    }
+    WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, p_method, p_count, chunks, -1, true, p_description);
+    WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+}
+
+void TroopManager::_retarget_chunk(uint32_t p_chunk, uint32_t p_count) {
+    // Nur lesende Zugriffe auf den GridManager; jede Aufgabe schreibt ausschließlich ihre eigenen Slots
+    const uint32_t end = MIN(p_count, (p_chunk + 1) * STEP_CHUNK_SIZE);
+    for (uint32_t i = p_chunk * STEP_CHUNK_SIZE; i < end; i++) {
+        if (targets[i].is_valid()) {
+            continue;
+        }
+        GridManager::TargetHit hit;
+        // Gebäude haben Vorrang vor Wänden
+        if (grid_manager->query_nearest_target(positions[i], detection_ranges[i], GridManager::TARGET_FILTER_BUILDINGS, hit) ||
+                grid_manager->query_nearest_target(positions[i], detection_ranges[i], GridManager::TARGET_FILTER_WALLS, hit)) {
+            _set_target(i, hit);
+            states[i] = TROOP_STATE_MOVING;
+        } else {
+            states[i] = TROOP_STATE_IDLE;
+        }
+    }
+}
+
+void TroopManager::_move_chunk(uint32_t p_chunk, uint32_t p_count) {
+    const uint32_t end = MIN(p_count, (p_chunk + 1) * STEP_CHUNK_SIZE);
+    for (uint32_t e = p_chunk * STEP_CHUNK_SIZE; e < end; e++) {
+        const uint32_t i = step_order[e];
+        const GridFlowField2D *field = step_fields[step_field_slots[e]];
+        const Vector2 position = positions[i];
+        const Vector2 target_point = target_points[i];
+        if (_is_in_range(position, target_point, attack_ranges[i])) {
+            states[i] = TROOP_STATE_ATTACKING;
+            continue;
+        }
+        states[i] = TROOP_STATE_MOVING;
+
+        // Nächsten Wegpunkt aus dem Flussfeld des Ziels ablesen
+        const Vector2i cell = _get_cell(position);
+        Vector2 waypoint = target_point;
+        if (cell != goal_cells[i]) {
+            const uint8_t direction = field ? field->get_direction(cell) : GridFlowField2D::NO_DIRECTION;
+            if (direction == GridFlowField2D::NO_DIRECTION) {
+                continue; // Kein Weg; die Umwegprüfung wählt bei Bedarf eine Wand
+            }
+            const Vector2i next_cell = cell + GridAStar2D::DIRECTIONS[direction];
+            if (next_cell != goal_cells[i]) {
+                waypoint = _get_cell_center(next_cell);
+            }
+        }
+
+        if (deterministic) {
+            _step_fixed(i, waypoint);
+            continue;
+        }
+
+        // Wie TroopBrain::step_towards, mit halbierter Y-Geschwindigkeit
+        const Vector2 to_waypoint = waypoint - position;
+        Vector2 velocity = to_waypoint.normalized() * speeds[i] * step_delta;
+        velocity.y *= 0.5f;
+        const bool reached = to_waypoint.length() <= velocity.length();
+        if (step_avoidance) {
+            // Nur die Wunschgeschwindigkeit festhalten; bewegt wird nach dem Ausweichschritt
+            preferred_velocities[i] = (reached ? to_waypoint : velocity) / step_delta;
+        } else if (reached) {
+            positions[i] = waypoint;
+        } else {
+            positions[i] = position + velocity;
+        }
+    }
+}
+
+Vector2 TroopManager::_snap(const Vector2 &p_position) const {
+    if (!deterministic) {
+        return p_position;
+    }
+    return (p_position * FIXED_POINT_SCALE).round() / FIXED_POINT_SCALE;
+}
+
+Vector2i TroopManager::_get_fixed_cell_size() const {
+    return Vector2i((grid_manager->get_cell_size() * FIXED_POINT_SCALE).round()).maxi(1);
+}
+
+// Abrunden auch für negative Zähler (p_denominator > 0)
+static _FORCE_INLINE_ int64_t floor_div(int64_t p_numerator, int64_t p_denominator) {
+    const int64_t quotient = p_numerator / p_denominator;
+    return (p_numerator % p_denominator != 0 && p_numerator < 0) ? quotient - 1 : quotient;
+}
+
+static uint64_t integer_sqrt(uint64_t p_value) {
+    uint64_t root = uint64_t(Math::sqrt(double(p_value)));
+    // Die Gleitkomma-Schätzung nur als Startwert nutzen, das Ergebnis ist exakt
+    while (root * root > p_value) {
+        root--;
+    }
+    while ((root + 1) * (root + 1) <= p_value) {
+        root++;
+    }
+    return root;
+}
+
+Vector2i TroopManager::_get_cell(const Vector2 &p_position) const {
+    if (!deterministic) {
+        return Vector2i(grid_manager->screen_to_grid(p_position).floor());
+    }
+    // Ganzzahlige Umkehrung der isometrischen Projektion: i = x / w + y / h, j = y / h - x / w
+    const Vector2i size = _get_fixed_cell_size();
+    const int64_t x = int64_t(Math::round(p_position.x * FIXED_POINT_SCALE)) * size.y;
+    const int64_t y = int64_t(Math::round(p_position.y * FIXED_POINT_SCALE)) * size.x;
+    const int64_t area = int64_t(size.x) * size.y;
+    return Vector2i(floor_div(y + x, area), floor_div(y - x, area));
+}
+
+Vector2 TroopManager::_get_cell_center(const Vector2i &p_cell) const {
+    if (!deterministic) {
+        return grid_manager->grid_to_screen(Vector2(p_cell) + Vector2(0.5, 0.5));
+    }
+    const Vector2i size = _get_fixed_cell_size();
+    const int64_t x = floor_div(int64_t(p_cell.x - p_cell.y) * size.x, 2);
+    const int64_t y = floor_div(int64_t(p_cell.x + p_cell.y + 1) * size.y, 2);
+    return Vector2(x, y) / FIXED_POINT_SCALE;
+}
+
+bool TroopManager::_is_in_range(const Vector2 &p_from, const Vector2 &p_to, float p_range) const {
+    if (!deterministic) {
+        return p_from.distance_to(p_to) <= p_range;
+    }
+    const int64_t dx = int64_t(Math::round((p_to.x - p_from.x) * FIXED_POINT_SCALE));
+    const int64_t dy = int64_t(Math::round((p_to.y - p_from.y) * FIXED_POINT_SCALE));
+    const int64_t range = int64_t(Math::round(p_range * FIXED_POINT_SCALE));
+    return dx * dx + dy * dy <= range * range;
+}
+
+void TroopManager::_step_fixed(uint32_t p_slot, const Vector2 &p_waypoint) {
+    // Ganzzahlige Fassung von TroopBrain::step_towards (halbierte Y-Geschwindigkeit); Positionen
+    // und Wegpunkte liegen auf dem Festkommaraster, die Umrechnung ist daher exakt
+    const int64_t dx = int64_t(Math::round((p_waypoint.x - positions[p_slot].x) * FIXED_POINT_SCALE));
+    const int64_t dy = int64_t(Math::round((p_waypoint.y - positions[p_slot].y) * FIXED_POINT_SCALE));
+    const int64_t distance_sq = dx * dx + dy * dy;
+    const int64_t distance = int64_t(integer_sqrt(uint64_t(distance_sq)));
+    const int64_t step = int64_t(Math::round(speeds[p_slot] * FIXED_POINT_SCALE)) * step_delta_usec / 1000000;
+    const int64_t vx = distance > 0 ? dx * step / distance : 0;
+    const int64_t vy = distance > 0 ? dy * step / distance / 2 : 0;
+    if (distance_sq <= vx * vx + vy * vy) {
+        positions[p_slot] = p_waypoint;
+    } else {
+        positions[p_slot] += Vector2(vx, vy) / FIXED_POINT_SCALE;
+    }
+}
+
+void TroopManager::_apply_avoidance() {
+    const uint32_t count = troop_ids.size();
+    const int grid_size = grid_manager->get_grid_size();
+    if (grid_size <= 0) {
+        return;
+    }
+
+    // Nachbarraster: Truppen nach Zelle sortieren, pro Zelle den Anfang merken
+    avoidance_cells.resize(count);
+    avoidance_order.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const Vector2i cell = Vector2i(grid_manager->screen_to_grid(positions[i]).floor()).clamp(Vector2i(), Vector2i(grid_size - 1, grid_size - 1));
+        avoidance_cells[i] = cell.y * grid_size + cell.x;
+        avoidance_order[i] = i;
+    }
+    struct CellComparator {
+        const int32_t *cells;
+        bool operator()(uint32_t p_a, uint32_t p_b) const {
+            return cells[p_a] < cells[p_b] || (cells[p_a] == cells[p_b] && p_a < p_b);
+        }
+    };
+    SortArray<uint32_t, CellComparator> sorter;
+    sorter.compare.cells = avoidance_cells.ptr();
+    sorter.sort(avoidance_order.ptr(), count);
+    avoidance_buckets.clear();
+    for (uint32_t e = 0; e < count; e++) {
+        if (e == 0 || avoidance_cells[avoidance_order[e]] != avoidance_cells[avoidance_order[e - 1]]) {
+            avoidance_buckets.insert(avoidance_cells[avoidance_order[e]], e);
+        }
+    }
+
+    // Zellabstand, der die Nachbardistanz abdeckt (eine Bildschirmstrecke d überspannt
+    // höchstens d * (1 / halbe Zellbreite + 1 / halbe Zellhöhe) / 2 Zellen)
+    const Vector2 half_cell = grid_manager->get_cell_size() / 2;
+    const float cells_per_pixel = (1.0f / MAX(half_cell.x, CMP_EPSILON) + 1.0f / MAX(half_cell.y, CMP_EPSILON)) / 2;
+    avoidance_cell_range = CLAMP(int(Math::ceil(avoidance_neighbor_distance * cells_per_pixel)), 1, MAX_AVOIDANCE_CELL_RANGE);
+
+    if (!avoidance_simulation) {
+        avoidance_simulation = memnew(RVO2D::RVOSimulator2D);
+    }
+    avoidance_simulation->setTimeStep(step_delta);
+    avoidance_agents.resize(count);
+    _run_chunked(&TroopManager::_sync_agents_chunk, count, SNAME("TroopManager avoidance sync"));
+    _run_chunked(&TroopManager::_avoid_chunk, count, SNAME("TroopManager avoidance"));
+    _run_chunked(&TroopManager::_integrate_chunk, count, SNAME("TroopManager integrate"));
+}
+
+void TroopManager::_sync_agents_chunk(uint32_t p_chunk, uint32_t p_count) {
+    const uint32_t end = MIN(p_count, (p_chunk + 1) * STEP_CHUNK_SIZE);
+    for (uint32_t i = p_chunk * STEP_CHUNK_SIZE; i < end; i++) {
+        RVO2D::Agent2D &agent = avoidance_agents[i];
+        // Winziger fester Versatz je Slot, damit exakt übereinanderliegende Truppen eine
+        // Trennrichtung haben (RVO2 teilt sonst durch null)
+        const float jitter_angle = i * 2.3999632f;
+        const Vector2 position = positions[i] + Vector2(Math::cos(jitter_angle), Math::sin(jitter_angle)) * 0.001f;
+        agent.position_ = RVO2D::Vector2(position.x, position.y);
+        agent.velocity_ = RVO2D::Vector2(velocities[i].x, velocities[i].y);
+        agent.prefVelocity_ = RVO2D::Vector2(preferred_velocities[i].x, preferred_velocities[i].y);
+        agent.radius_ = troop_radius;
+        agent.maxSpeed_ = speeds[i];
+        agent.neighborDist_ = avoidance_neighbor_distance;
+        agent.maxNeighbors_ = avoidance_max_neighbors;
+        agent.timeHorizon_ = avoidance_time_horizon;
+        agent.timeHorizonObst_ = avoidance_time_horizon;
+        agent.agentNeighbors_.clear();
+        agent.obstacleNeighbors_.clear();
+    }
+}
+
+void TroopManager::_avoid_chunk(uint32_t p_chunk, uint32_t p_count) {
+    // Liest nur Position und Geschwindigkeit der Nachbarn, schreibt nur den eigenen Agenten
+    const int grid_size = grid_manager->get_grid_size();
+    const uint32_t end = MIN(p_count, (p_chunk + 1) * STEP_CHUNK_SIZE);
+    for (uint32_t i = p_chunk * STEP_CHUNK_SIZE; i < end; i++) {
+        RVO2D::Agent2D &agent = avoidance_agents[i];
+        float range_sq = avoidance_neighbor_distance * avoidance_neighbor_distance;
+        const int cx = avoidance_cells[i] % grid_size;
+        const int cy = avoidance_cells[i] / grid_size;
+        for (int y = MAX(cy - avoidance_cell_range, 0); y <= MIN(cy + avoidance_cell_range, grid_size - 1); y++) {
+            for (int x = MAX(cx - avoidance_cell_range, 0); x <= MIN(cx + avoidance_cell_range, grid_size - 1); x++) {
+                const int32_t cell = y * grid_size + x;
+                HashMap<int32_t, uint32_t>::ConstIterator E = avoidance_buckets.find(cell);
+                if (!E) {
+                    continue;
+                }
+                for (uint32_t e = E->value; e < p_count && avoidance_cells[avoidance_order[e]] == cell; e++) {
+                    agent.insertAgentNeighbor(&avoidance_agents[avoidance_order[e]], range_sq);
+                }
+            }
+        }
+        agent.computeNewVelocity(avoidance_simulation);
+    }
+}
+
+void TroopManager::_integrate_chunk(uint32_t p_chunk, uint32_t p_count) {
+    const uint32_t end = MIN(p_count, (p_chunk + 1) * STEP_CHUNK_SIZE);
+    for (uint32_t i = p_chunk * STEP_CHUNK_SIZE; i < end; i++) {
+        const RVO2D::Vector2 &new_velocity = avoidance_agents[i].newVelocity_;
+        Vector2 velocity = Vector2(new_velocity.x(), new_velocity.y());
+        if (!velocity.is_finite()) {
+            velocity = preferred_velocities[i];
+        }
+        velocities[i] = velocity;
+        positions[i] += velocity * step_delta;
+    }
+}
+
+void TroopManager::_check_path_length(uint32_t p_slot, const GridFlowField2D *p_field) {
+    needs_path_check[p_slot] = 0;
+    const Vector2 position = positions[p_slot];
+    const Vector2i cell = _get_cell(position);
+    const uint32_t distance = p_field ? p_field->get_distance(cell) : GridFlowField2D::UNREACHABLE;
+    if (distance != GridFlowField2D::UNREACHABLE && distance <= uint32_t(MAX(max_building_path_length, 0)) * GridAStar2D::COST_STRAIGHT) {
+        return;
+    }
+    // Umweg zu lang oder kein Weg: erste Wand auf dem direkten Weg angreifen
+    PackedVector2Array ignore_path = grid_manager->get_simple_path_iso_ignore_walls(position, target_points[p_slot]);
+    for (int i = 0; i < ignore_path.size(); i++) {
+        const Vector2i path_cell = _get_cell(ignore_path[i]);
+        if (!grid_manager->is_wall_at(path_cell)) {
+            continue;
+        }
+        const Node2D *wall = grid_manager->get_occupant(path_cell);
+        if (wall && wall->get_instance_id() != targets[p_slot]) {
+            GridManager::TargetHit hit;
+            hit.id = wall->get_instance_id();
+            hit.point = _get_cell_center(path_cell);
+            hit.is_wall = true;
+            _set_target(p_slot, hit);
+            needs_path_check[p_slot] = 0;
+        }
+        return;
+    }
+}
+
+void TroopManager::update(float delta) {
+    if (!grid_manager || troop_ids.is_empty()) {
+        return;
+    }
+    const uint32_t count = troop_ids.size();
+    step_delta = delta;
+    step_delta_usec = int64_t(Math::round(double(delta) * 1000000.0));
+    // Der RVO2-Schritt rechnet in Gleitkomma und entfällt im deterministischen Modus
+    step_avoidance = avoidance_enabled && !deterministic && delta > 0.0f;
+    if (step_avoidance) {
+        preferred_velocities.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            preferred_velocities[i] = Vector2();
+        }
+    }
+
+    // 1. Truppen ohne Ziel parallel über den räumlichen Index des GridManager zuordnen
+    _run_chunked(&TroopManager::_retarget_chunk, count, SNAME("TroopManager retarget"));
+
+    // 2. Zielzellen sammeln; die Flussfelder werden seriell geholt (der Cache ist nicht threadsicher)
+    HashMap<Vector2i, uint32_t> goal_to_index;
+    LocalVector<Vector2i> goals;
+    LocalVector<uint32_t> troop_goal;
+    troop_goal.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        troop_goal[i] = UINT32_MAX;
+        if (!targets[i].is_valid()) {
+            continue;
+        }
+        HashMap<Vector2i, uint32_t>::Iterator E = goal_to_index.find(goal_cells[i]);
+        if (E) {
+            troop_goal[i] = E->value;
+        } else {
+            troop_goal[i] = goals.size();
+            goal_to_index.insert(goal_cells[i], goals.size());
+            goals.push_back(goal_cells[i]);
+        }
+    }
+
+    // 3. Höchstens so viele Ziele pro Durchgang, wie der Feld-Cache fasst, damit kein
+    //    Feld verdrängt wird, während die Bewegungsaufgaben es noch lesen
+    const uint32_t per_pass = MAX(grid_manager->get_flow_field_cache_size(), 1);
+    for (uint32_t first_goal = 0; first_goal < goals.size(); first_goal += per_pass) {
+        const uint32_t last_goal = MIN(goals.size(), first_goal + per_pass);
+        step_fields.resize(last_goal - first_goal);
+        for (uint32_t g = first_goal; g < last_goal; g++) {
+            step_fields[g - first_goal] = grid_manager->get_flow_field(goals[g], true);
+        }
+
+        step_order.clear();
+        step_field_slots.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            if (troop_goal[i] < first_goal || troop_goal[i] >= last_goal) {
+                continue;
+            }
+            const uint32_t field_slot = troop_goal[i] - first_goal;
+            if (needs_path_check[i]) {
+                _check_path_length(i, step_fields[field_slot]);
+                if (goal_cells[i] != goals[troop_goal[i]]) {
+                    continue; // Neues Wandziel, Bewegung ab dem nächsten Schritt
+                }
+            }
+            step_order.push_back(i);
+            step_field_slots.push_back(field_slot);
+        }
+        _run_chunked(&TroopManager::_move_chunk, step_order.size(), SNAME("TroopManager move"));
+    }
+    step_fields.clear();
+
+    // 4. Gegenseitiges Ausweichen auf Basis der Wunschgeschwindigkeiten
+    if (step_avoidance) {
+        _apply_avoidance();
+    }
+
+    // 5. Positionen gesammelt übertragen
+    _write_back();
+}
+
+void TroopManager::_write_back() {
+    const uint32_t count = troop_ids.size();
+    const Transform2D grid_transform = grid_manager && grid_manager->is_inside_tree() ? grid_manager->get_global_transform() : Transform2D();
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (nodes[i].is_null()) {
+            continue;
+        }
+        Node2D *node = Object::cast_to<Node2D>(ObjectDB::get_instance(nodes[i]));
+        if (!node) {
+            nodes[i] = ObjectID();
+            continue;
+        }
+        if (node->is_inside_tree()) {
+            node->set_global_position(grid_transform.xform(positions[i]));
+        } else {
+            node->set_position(positions[i]);
+        }
+    }
+
+    if (multimesh.is_null()) {
+        return;
+    }
+    // Ein einziger Puffer-Upload statt eines Aufrufs pro Instanz
+    if (multimesh->get_instance_count() != int(count) || multimesh->get_transform_format() != MultiMesh::TRANSFORM_2D) {
+        multimesh->set_instance_count(0);
+        multimesh->set_transform_format(MultiMesh::TRANSFORM_2D);
+        multimesh->set_instance_count(count);
+        multimesh_buffer.clear();
+    }
+    if (count == 0) {
+        return;
+    }
+    const int stride = 8 + (multimesh->is_using_colors() ? 4 : 0) + (multimesh->is_using_custom_data() ? 4 : 0);
+    if (multimesh_buffer.size() != int(count) * stride) {
+        multimesh_buffer.resize(count * stride);
+        float *w = multimesh_buffer.ptrw();
+        for (uint32_t i = 0; i < count * stride; i++) {
+            w[i] = 0.0f;
+        }
+        if (multimesh->is_using_colors()) {
+            for (uint32_t i = 0; i < count; i++) {
+                for (int c = 0; c < 4; c++) {
+                    w[i * stride + 8 + c] = 1.0f;
+                }
+            }
+        }
+    }
+    const Transform2D to_local = (is_inside_tree() ? get_global_transform().affine_inverse() : Transform2D()) * grid_transform;
+    float *w = multimesh_buffer.ptrw();
+    for (uint32_t i = 0; i < count; i++) {
+        const Vector2 origin = to_local.xform(positions[i]);
+        float *instance = w + i * stride;
+        instance[0] = 1.0f;
+        instance[1] = 0.0f;
+        instance[2] = 0.0f;
+        instance[3] = origin.x;
+        instance[4] = 0.0f;
+        instance[5] = 1.0f;
+        instance[6] = 0.0f;
+        instance[7] = origin.y;
+    }
+    RenderingServer::get_singleton()->multimesh_set_buffer(multimesh->get_rid(), multimesh_buffer);
+}
+
+void TroopManager::_on_occupancy_changed(const PackedVector2Array &p_cells) {
+    for (uint32_t i = 0; i < troop_ids.size(); i++) {
+        if (targets[i].is_null()) {
+            continue;
+        }
+        // Ziel verschoben, entfernt oder zerstört: im nächsten Schritt neu suchen
+        const GridManager::BuildingRecord *record = grid_manager->get_building_record(targets[i]);
+        if (!record || record->destroyed || record->top_left != target_origins[i]) {
+            _clear_target(i);
+        } else {
+            // Wände haben sich geändert, die Umweglänge muss neu geprüft werden
+            needs_path_check[i] = 1;
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#ifndef TROOP_MANAGER_H
+#define TROOP_MANAGER_H
+
+#include "scene/2d/grid_manager_2d.h"
+#include "scene/2d/node_2d.h"
+#include "scene/resources/multimesh.h"
+#include "scene/resources/texture.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+
+// RVO2 bleibt aus dem Header heraus, damit Nutzer (z. B. Tests) dessen Include-Pfad nicht brauchen
+namespace RVO2D {
+class Agent2D;
+class RVOSimulator2D;
+} // namespace RVO2D
+
+// Simuliert alle Truppen in einem Struct-of-Arrays-Block statt je eines TroopBrain pro Einheit.
+// Zielsuche und Bewegung laufen als Gruppenaufgaben auf dem WorkerThreadPool, die Wege kommen
+// aus den gemeinsamen Flussfeldern des GridManager. Positionen werden einmal pro Frame
+// gesammelt zurückgeschrieben: entweder in optionale Node2D-Knoten oder in einen MultiMesh.
+// Alle Positionen liegen im lokalen Koordinatensystem des GridManager.
+// Optional weichen sich die Truppen gegenseitig aus (RVO2 wie in NavMap); die Nachbarn
+// werden dabei über die Zellen des GridManager gesucht statt über einen k-d-Baum.
+// Im deterministischen Modus liegen alle Positionen auf einem Festkommaraster und die
+// Bewegung wird ganzzahlig gerechnet, sodass Aufzeichnungen auf jedem Rechner bitgleich
+// nachsimuliert und über get_state_hash verglichen werden können.
+class TroopManager : public Node2D {
+    GDCLASS(TroopManager, Node2D);
+
+public:
+    enum TroopState {
+        TROOP_STATE_IDLE,                  // Kein Ziel in Reichweite
+        TROOP_STATE_MOVING,
+        TROOP_STATE_ATTACKING,             // Ziel im Angriffsbereich
+    };
+
+private:
+    // Truppen pro Gruppenaufgabe; kleinere Blöcke lohnen den Verteilungsaufwand nicht
+    static const uint32_t STEP_CHUNK_SIZE = 256;
+    // Größter Zellabstand, in dem Nachbarn für das Ausweichen gesucht werden
+    static const int MAX_AVOIDANCE_CELL_RANGE = 3;
+    // Festkommaauflösung im deterministischen Modus (1/256 Pixel). Positionen bis 65536 px
+    // bleiben damit als float exakt darstellbar.
+    static const int FIXED_POINT_SCALE = 256;
+
+    GridManager *grid_manager = nullptr;
+
+    // Standardwerte für neue Truppen
+    float speed = 100.0f;
+    float attack_range = 50.0f;
+    float detection_range = 100.0f;
+    int max_building_path_length = 50;
+
+    // Ausweichen zwischen Truppen
+    bool avoidance_enabled = false;
+    float troop_radius = 8.0f;
+    float avoidance_neighbor_distance = 48.0f;
+    float avoidance_time_horizon = 0.5f;
+    int avoidance_max_neighbors = 10;
+
+    bool deterministic = false;
+
+    // Truppenzustand als Struct-of-Arrays (Index = Slot, nicht stabil)
+    LocalVector<int> troop_ids;
+    LocalVector<Vector2> positions;
+    LocalVector<float> speeds;
+    LocalVector<float> attack_ranges;
+    LocalVector<float> detection_ranges;
+    LocalVector<uint8_t> states;           // TroopState
+    LocalVector<ObjectID> targets;         // Angegriffenes Gebäude
+    LocalVector<Vector2> target_points;    // Angriffspunkt auf dem Gebäuderand
+    LocalVector<Vector2i> target_origins;  // Obere linke Zelle des Ziels bei der Auswahl
+    LocalVector<Vector2i> goal_cells;      // Zielzelle im Flussfeld
+    LocalVector<uint8_t> needs_path_check; // Umweglänge für das aktuelle Ziel noch nicht geprüft
+    LocalVector<ObjectID> nodes;           // Optionaler Knoten, der die Position übernimmt
+    LocalVector<Vector2> velocities;       // Tatsächliche Geschwindigkeit im letzten Schritt
+    HashMap<int, uint32_t> id_to_slot;
+    int next_troop_id = 1;
+
+    // Darstellung über einen MultiMesh statt einzelner Knoten
+    Ref<MultiMesh> multimesh;
+    Ref<Texture2D> texture;
+    Vector<float> multimesh_buffer;
+
+    // Zustand des aktuellen Schritts (nur während update gültig)
+    float step_delta = 0.0f;
+    int64_t step_delta_usec = 0;           // Zeitschritt in Mikrosekunden (deterministischer Modus)
+    bool step_avoidance = false;
+    LocalVector<uint32_t> step_order;      // Bewegte Truppen, nach Zielfeld gruppiert
+    LocalVector<const GridFlowField2D *> step_fields;
+    LocalVector<uint32_t> step_field_slots; // Feldindex pro Eintrag in step_order
+
+    // Ausweichschritt: Nachbarraster nach Zellen des GridManager, je ein RVO2-Agent pro Truppe
+    LocalVector<Vector2> preferred_velocities;
+    LocalVector<RVO2D::Agent2D> avoidance_agents;
+    LocalVector<int32_t> avoidance_cells;           // Zellindex pro Truppe (ins Gitter geklemmt)
+    LocalVector<uint32_t> avoidance_order;          // Truppen nach Zellindex sortiert
+    HashMap<int32_t, uint32_t> avoidance_buckets;   // Zellindex -> erste Position in avoidance_order
+    int avoidance_cell_range = 1;
+    RVO2D::RVOSimulator2D *avoidance_simulation = nullptr; // Liefert nur den Zeitschritt für Agent2D
+
+    _FORCE_INLINE_ uint32_t _get_chunk_count(uint32_t p_count) const {
+        return (p_count + STEP_CHUNK_SIZE - 1) / STEP_CHUNK_SIZE;
+    }
+    void _run_chunked(void (TroopManager::*p_method)(uint32_t, uint32_t), uint32_t p_count, const StringName &p_description);
+
+    void _retarget_chunk(uint32_t p_chunk, uint32_t p_count);
+    void _move_chunk(uint32_t p_chunk, uint32_t p_count);
+    void _sync_agents_chunk(uint32_t p_chunk, uint32_t p_count);
+    void _avoid_chunk(uint32_t p_chunk, uint32_t p_count);
+    void _integrate_chunk(uint32_t p_chunk, uint32_t p_count);
+    void _apply_avoidance();
+    Vector2 _snap(const Vector2 &p_position) const;
+    Vector2i _get_fixed_cell_size() const;
+    Vector2i _get_cell(const Vector2 &p_position) const;
+    Vector2 _get_cell_center(const Vector2i &p_cell) const;
+    bool _is_in_range(const Vector2 &p_from, const Vector2 &p_to, float p_range) const;
+    void _step_fixed(uint32_t p_slot, const Vector2 &p_waypoint);
+    void _set_target(uint32_t p_slot, const GridManager::TargetHit &p_hit);
+    void _clear_target(uint32_t p_slot);
+    void _check_path_length(uint32_t p_slot, const GridFlowField2D *p_field);
+    void _write_back();
+    void _on_occupancy_changed(const PackedVector2Array &p_cells);
+
+protected:
+    static void _bind_methods();
+    void _notification(int p_what);
+
+public:
+    TroopManager();
+    ~TroopManager();
+
+    void initialize(GridManager *p_grid_manager);
+    GridManager *get_grid_manager() const { return grid_manager; }
+
+    int add_troop(Vector2 position, Node2D *node = nullptr);
+    void remove_troop(int troop_id);
+    void clear_troops();
+    int get_troop_count() const { return troop_ids.size(); }
+    bool has_troop(int troop_id) const { return id_to_slot.has(troop_id); }
+
+    Vector2 get_troop_position(int troop_id) const;
+    void set_troop_position(int troop_id, Vector2 position);
+    TroopState get_troop_state(int troop_id) const;
+    Node2D *get_troop_target(int troop_id) const;
+    Vector2 get_troop_target_point(int troop_id) const;
+    PackedVector2Array get_troop_positions() const;
+
+    // Simuliert alle Truppen um delta Sekunden
+    void update(float delta);
+    // Prüfsumme über alle Truppen und den Zustand des GridManager (ohne ObjectIDs)
+    uint64_t get_state_hash() const;
+
+    void set_speed(float p_speed) { speed = p_speed; }
+    float get_speed() const { return speed; }
+    void set_attack_range(float p_range) { attack_range = p_range; }
+    float get_attack_range() const { return attack_range; }
+    void set_detection_range(float p_range) { detection_range = p_range; }
+    float get_detection_range() const { return detection_range; }
+    void set_max_building_path_length(int p_length) { max_building_path_length = p_length; }
+    int get_max_building_path_length() const { return max_building_path_length; }
+    void set_avoidance_enabled(bool p_enabled) { avoidance_enabled = p_enabled; }
+    bool is_avoidance_enabled() const { return avoidance_enabled; }
+    void set_troop_radius(float p_radius) { troop_radius = MAX(p_radius, 0.0f); }
+    float get_troop_radius() const { return troop_radius; }
+    void set_avoidance_neighbor_distance(float p_distance) { avoidance_neighbor_distance = MAX(p_distance, 0.0f); }
+    float get_avoidance_neighbor_distance() const { return avoidance_neighbor_distance; }
+    void set_avoidance_time_horizon(float p_time) { avoidance_time_horizon = MAX(p_time, 0.01f); }
+    float get_avoidance_time_horizon() const { return avoidance_time_horizon; }
+    void set_avoidance_max_neighbors(int p_count) { avoidance_max_neighbors = MAX(p_count, 1); }
+    int get_avoidance_max_neighbors() const { return avoidance_max_neighbors; }
+    void set_deterministic(bool p_enabled);
+    bool is_deterministic() const { return deterministic; }
+
+    void set_multimesh(const Ref<MultiMesh> &p_multimesh);
+    Ref<MultiMesh> get_multimesh() const { return multimesh; }
+    void set_texture(const Ref<Texture2D> &p_texture);
+    Ref<Texture2D> get_texture() const { return texture; }
+};
+
+VARIANT_ENUM_CAST(TroopManager::TroopState);
+
+#endif // TROOP_MANAGER_H
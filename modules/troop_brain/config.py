@@ -1,4 +1,6 @@
 def can_build(env, platform):
+    # Nur für die Reihenfolge; ohne Navigationsmodul baut SCsub RVO2 selbst
+    env.module_add_dependencies("troop_brain", ["navigation"], True)
     return True
 
 
@@ -2,10 +2,12 @@
 
 #include "core/object/class_db.h"
 #include "TroopBrain.h"
+#include "TroopManager.h"
 
 void initialize_troop_brain_module(ModuleInitializationLevel p_level) {
     if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
         ClassDB::register_class<TroopBrain>();
+        ClassDB::register_class<TroopManager>();
     }
 }
 
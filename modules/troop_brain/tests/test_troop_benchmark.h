@@ -0,0 +1,144 @@
+/**************************************************************************/
+/*  test_troop_benchmark.h                                                */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_TROOP_BENCHMARK_H
+#define TEST_TROOP_BENCHMARK_H
+
+#include "../TroopBrain.h"
+#include "../TroopManager.h"
+
+#include "tests/scene/test_grid_manager_benchmark.h"
+#include "tests/test_benchmark.h"
+#include "tests/test_macros.h"
+
+namespace TestTroopBenchmark {
+
+using TestGridManagerBenchmark::MapSettings;
+
+static Vector2 random_troop_position(const GridManager *p_grid, RandomPCG &r_random) {
+	const Vector2i cell = TestGridManagerBenchmark::random_free_cell(p_grid, r_random);
+	return p_grid->grid_to_screen(Vector2(cell) + Vector2(0.5, 0.5));
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][TroopBrain] Target selection") {
+	const int building_counts[] = { 100, 1000 };
+	const int troop_count = 1000;
+	for (int building_count : building_counts) {
+		MapSettings settings;
+		settings.grid_size = 256;
+		settings.wall_density = 0.1f;
+		settings.building_count = building_count;
+		RandomPCG random(settings.seed);
+		GridManager *grid = TestGridManagerBenchmark::create_map(settings, random);
+
+		LocalVector<Node2D *> units;
+		LocalVector<Ref<TroopBrain>> brains;
+		for (int i = 0; i < troop_count; i++) {
+			Node2D *unit = memnew(Node2D);
+			unit->set_position(random_troop_position(grid, random));
+			Ref<TroopBrain> brain;
+			brain.instantiate();
+			brain->initialize(unit, grid);
+			brain->set_detection_range(400);
+			units.push_back(unit);
+			brains.push_back(brain);
+		}
+
+		TestBenchmark::Samples samples;
+		for (const Ref<TroopBrain> &brain : brains) {
+			samples.begin();
+			brain->update_target();
+			samples.end();
+		}
+		Dictionary parameters = settings.to_dictionary();
+		parameters["troop_count"] = troop_count;
+		parameters["detection_range"] = 400;
+		TestBenchmark::report("troop_brain.update_target", parameters, samples);
+		CHECK(samples.size() == uint32_t(troop_count));
+
+		brains.clear();
+		for (Node2D *unit : units) {
+			memdelete(unit);
+		}
+		memdelete(grid);
+	}
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][TroopManager] Frame update throughput") {
+	const int troop_counts[] = { 100, 1000, 10000 };
+	const int frame_count = 60;
+	const float frame_delta = 1.0f / 60.0f;
+	for (int troop_count : troop_counts) {
+		for (int avoidance = 0; avoidance < 2; avoidance++) {
+			MapSettings settings;
+			settings.grid_size = 256;
+			settings.wall_density = 0.1f;
+			settings.building_count = 200;
+			RandomPCG random(settings.seed);
+			GridManager *grid = TestGridManagerBenchmark::create_map(settings, random);
+
+			TroopManager *manager = memnew(TroopManager);
+			manager->initialize(grid);
+			manager->set_detection_range(400);
+			manager->set_avoidance_enabled(avoidance);
+			for (int i = 0; i < troop_count; i++) {
+				manager->add_troop(random_troop_position(grid, random));
+			}
+			// Der erste Schritt baut die Flussfelder auf und wird getrennt gemessen
+			TestBenchmark::Samples first_frame;
+			first_frame.begin();
+			manager->update(frame_delta);
+			first_frame.end();
+
+			TestBenchmark::Samples samples;
+			for (int frame = 0; frame < frame_count; frame++) {
+				samples.begin();
+				manager->update(frame_delta);
+				samples.end();
+			}
+
+			Dictionary parameters = settings.to_dictionary();
+			parameters["troop_count"] = troop_count;
+			parameters["avoidance"] = bool(avoidance);
+			Dictionary metrics;
+			metrics["first_frame_usec"] = first_frame.get_total();
+			metrics["troops_per_second"] = double(troop_count) * frame_count * 1000000.0 / MAX(samples.get_total(), uint64_t(1));
+			TestBenchmark::report("troop_manager.update", parameters, samples, metrics);
+			CHECK(manager->get_troop_count() == troop_count);
+
+			memdelete(manager);
+			memdelete(grid);
+		}
+	}
+}
+
+} // namespace TestTroopBenchmark
+
+#endif // TEST_TROOP_BENCHMARK_H
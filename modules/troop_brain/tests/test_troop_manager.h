@@ -0,0 +1,249 @@
+/**************************************************************************/
+/*  test_troop_manager.h                                                  */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_TROOP_MANAGER_H
+#define TEST_TROOP_MANAGER_H
+
+#include "../TroopManager.h"
+
+#include "tests/scene/test_grid_manager.h"
+#include "tests/test_macros.h"
+
+namespace TestTroopManager {
+
+using TestGridManager::create_building_scene;
+
+TEST_CASE("[TroopManager] Troop bookkeeping") {
+	TroopManager *manager = memnew(TroopManager);
+	const int first = manager->add_troop(Vector2(1, 2));
+	const int second = manager->add_troop(Vector2(3, 4));
+	const int third = manager->add_troop(Vector2(5, 6));
+	CHECK(manager->get_troop_count() == 3);
+
+	manager->remove_troop(first);
+	CHECK(manager->get_troop_count() == 2);
+	CHECK_FALSE(manager->has_troop(first));
+	CHECK(manager->get_troop_position(second) == Vector2(3, 4));
+	CHECK(manager->get_troop_position(third) == Vector2(5, 6));
+
+	ERR_PRINT_OFF;
+	manager->remove_troop(first);
+	ERR_PRINT_ON;
+	CHECK(manager->get_troop_count() == 2);
+
+	manager->clear_troops();
+	CHECK(manager->get_troop_count() == 0);
+	memdelete(manager);
+}
+
+TEST_CASE("[TroopManager] Simulation") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(16);
+	Ref<PackedScene> scene = create_building_scene();
+	CHECK(grid->place_building(Vector2(10, 10), scene, 2));
+	Node2D *building = grid->get_occupant(Vector2i(10, 10));
+
+	TroopManager *manager = memnew(TroopManager);
+	manager->initialize(grid);
+	manager->set_detection_range(1000);
+	manager->set_attack_range(20);
+	manager->set_speed(200);
+
+	SUBCASE("Troops walk to the nearest building and attack it") {
+		const int troop = manager->add_troop(grid->grid_to_screen(Vector2(2.5, 2.5)));
+		for (int i = 0; i < 500 && manager->get_troop_state(troop) != TroopManager::TROOP_STATE_ATTACKING; i++) {
+			manager->update(0.1);
+		}
+		CHECK(manager->get_troop_state(troop) == TroopManager::TROOP_STATE_ATTACKING);
+		CHECK(manager->get_troop_target(troop) == building);
+		CHECK(manager->get_troop_position(troop).distance_to(manager->get_troop_target_point(troop)) <= 20);
+	}
+
+	SUBCASE("A closed wall line makes troops attack the wall") {
+		for (int y = 0; y < 16; y++) {
+			CHECK(grid->place_building(Vector2(6, y), scene, 1, true));
+		}
+		const int troop = manager->add_troop(grid->grid_to_screen(Vector2(2.5, 2.5)));
+		manager->update(0.1);
+		Node2D *target = manager->get_troop_target(troop);
+		REQUIRE(target != nullptr);
+		const Vector2i target_cell = Vector2i(grid->screen_to_grid(manager->get_troop_target_point(troop)).floor());
+		CHECK(grid->is_wall_at(target_cell));
+		CHECK(grid->get_occupant(target_cell) == target);
+	}
+
+	SUBCASE("Destroying the target clears it") {
+		const int troop = manager->add_troop(grid->grid_to_screen(Vector2(2.5, 2.5)));
+		manager->update(0.1);
+		CHECK(manager->get_troop_target(troop) == building);
+		CHECK(grid->set_building_destroyed(building));
+		CHECK(manager->get_troop_target(troop) == nullptr);
+		CHECK(manager->get_troop_state(troop) == TroopManager::TROOP_STATE_IDLE);
+		manager->update(0.1);
+		CHECK(manager->get_troop_target(troop) == nullptr);
+	}
+
+	SUBCASE("Large groups are stepped in parallel") {
+		LocalVector<int> troops;
+		for (int i = 0; i < 1000; i++) {
+			troops.push_back(manager->add_troop(grid->grid_to_screen(Vector2(0.5 + (i % 8), 0.5 + (i / 8) % 8))));
+		}
+		PackedVector2Array before = manager->get_troop_positions();
+		manager->update(0.1);
+		for (uint32_t i = 0; i < troops.size(); i++) {
+			CHECK(manager->get_troop_target(troops[i]) == building);
+			const Vector2 target_point = manager->get_troop_target_point(troops[i]);
+			CHECK(manager->get_troop_position(troops[i]).distance_to(target_point) < before[i].distance_to(target_point));
+		}
+	}
+
+	SUBCASE("Avoidance separates overlapping troops") {
+		manager->set_detection_range(1);
+		manager->set_troop_radius(8);
+		const Vector2 start = grid->grid_to_screen(Vector2(3.5, 3.5));
+		const int first = manager->add_troop(start);
+		const int second = manager->add_troop(start + Vector2(1, 0));
+		manager->update(0.1);
+		CHECK(manager->get_troop_position(first) == start);
+		CHECK(manager->get_troop_position(second) == start + Vector2(1, 0));
+
+		manager->set_avoidance_enabled(true);
+		for (int i = 0; i < 10; i++) {
+			manager->update(0.1);
+		}
+		CHECK(manager->get_troop_position(first).distance_to(manager->get_troop_position(second)) >= 15);
+	}
+
+	SUBCASE("Avoidance keeps large groups moving") {
+		manager->set_avoidance_enabled(true);
+		for (int i = 0; i < 1000; i++) {
+			manager->add_troop(grid->grid_to_screen(Vector2(0.5 + (i % 8), 0.5 + (i / 8) % 8)));
+		}
+		const Vector2 target_point = grid->grid_to_screen(Vector2(11, 11));
+		PackedVector2Array before = manager->get_troop_positions();
+		manager->update(0.1);
+		PackedVector2Array after = manager->get_troop_positions();
+		real_t before_distance = 0;
+		real_t after_distance = 0;
+		for (int i = 0; i < after.size(); i++) {
+			REQUIRE(after[i].is_finite());
+			before_distance += before[i].distance_to(target_point);
+			after_distance += after[i].distance_to(target_point);
+		}
+		CHECK(after_distance < before_distance);
+	}
+
+	memdelete(manager);
+	memdelete(grid);
+}
+
+// Spielt denselben Angriff ab und liefert die Prüfsumme nach jedem Schritt
+static LocalVector<uint64_t> simulate_recorded_attack(int p_ticks) {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(16);
+	Ref<PackedScene> scene = create_building_scene();
+	grid->place_building(Vector2(10, 10), scene, 2);
+	grid->place_building(Vector2(4, 12), scene, 1);
+	for (int y = 0; y < 8; y++) {
+		grid->place_building(Vector2(7, y), scene, 1, true);
+	}
+
+	TroopManager *manager = memnew(TroopManager);
+	manager->set_deterministic(true);
+	manager->initialize(grid);
+	manager->set_detection_range(1000);
+	manager->set_attack_range(20);
+	manager->set_speed(130);
+	for (int i = 0; i < 40; i++) {
+		manager->add_troop(grid->grid_to_screen(Vector2(0.3 + (i % 5) * 0.7, 0.7 + (i / 5) * 0.9)));
+	}
+
+	LocalVector<uint64_t> hashes;
+	for (int tick = 0; tick < p_ticks; tick++) {
+		manager->update(1.0 / 60.0);
+		hashes.push_back(manager->get_state_hash());
+	}
+	memdelete(manager);
+	memdelete(grid);
+	return hashes;
+}
+
+TEST_CASE("[TroopManager] Deterministic mode") {
+	SUBCASE("Positions stay on the fixed-point grid") {
+		GridManager *grid = memnew(GridManager);
+		grid->set_grid_size(16);
+		Ref<PackedScene> scene = create_building_scene();
+		CHECK(grid->place_building(Vector2(10, 10), scene, 2));
+		TroopManager *manager = memnew(TroopManager);
+		manager->set_deterministic(true);
+		manager->initialize(grid);
+		manager->set_detection_range(1000);
+		const int troop = manager->add_troop(Vector2(1.0 / 3.0, 7.123));
+		for (int i = 0; i < 10; i++) {
+			manager->update(1.0 / 60.0);
+			const Vector2 scaled = manager->get_troop_position(troop) * 256;
+			CHECK(scaled == scaled.round());
+		}
+		CHECK(manager->get_troop_state(troop) == TroopManager::TROOP_STATE_MOVING);
+		memdelete(manager);
+		memdelete(grid);
+	}
+
+	SUBCASE("Replaying the same input gives the same hashes") {
+		const LocalVector<uint64_t> first = simulate_recorded_attack(300);
+		const LocalVector<uint64_t> second = simulate_recorded_attack(300);
+		REQUIRE(first.size() == second.size());
+		bool identical = true;
+		for (uint32_t i = 0; i < first.size(); i++) {
+			identical = identical && first[i] == second[i];
+		}
+		CHECK(identical);
+		CHECK(first[0] != first[first.size() - 1]);
+	}
+
+	SUBCASE("The grid hash ignores instance IDs but not building state") {
+		GridManager *first = memnew(GridManager);
+		GridManager *second = memnew(GridManager);
+		first->set_grid_size(16);
+		second->set_grid_size(16);
+		Ref<PackedScene> scene = create_building_scene();
+		CHECK(first->place_building(Vector2(3, 3), scene, 2));
+		CHECK(second->place_building(Vector2(3, 3), scene, 2));
+		CHECK(first->get_state_hash() == second->get_state_hash());
+		CHECK(second->set_building_destroyed(second->get_occupant(Vector2i(3, 3))));
+		CHECK(first->get_state_hash() != second->get_state_hash());
+		memdelete(first);
+		memdelete(second);
+	}
+}
+
+} // namespace TestTroopManager
+
+#endif // TEST_TROOP_MANAGER_H
@@ -0,0 +1,247 @@
+#include "grid_astar_2d.h"
+
+#include "core/error/error_macros.h"
+
+// Gleiche Reihenfolge wie die bisherigen Richtungsarrays im GridManager
+const Vector2i GridAStar2D::DIRECTIONS[GridAStar2D::DIRECTION_COUNT] = {
+    Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1),
+    Vector2i(1, 1), Vector2i(1, -1), Vector2i(-1, 1), Vector2i(-1, -1)
+};
+
+const uint32_t GridAStar2D::DIRECTION_COSTS[GridAStar2D::DIRECTION_COUNT] = {
+    COST_STRAIGHT, COST_STRAIGHT, COST_STRAIGHT, COST_STRAIGHT,
+    COST_DIAGONAL, COST_DIAGONAL, COST_DIAGONAL, COST_DIAGONAL
+};
+
+void GridAStar2D::_heap_sift_up(uint32_t p_pos) {
+    const int32_t cell = heap[p_pos];
+    while (p_pos > 0) {
+        const uint32_t up = (p_pos - 1) >> 1;
+        if (!_heap_less(cell, heap[up])) {
+            break;
+        }
+        heap[p_pos] = heap[up];
+        heap_index[heap[p_pos]] = p_pos;
+        p_pos = up;
+    }
+    heap[p_pos] = cell;
+    heap_index[cell] = p_pos;
+}
+
+void GridAStar2D::_heap_sift_down(uint32_t p_pos) {
+    const int32_t cell = heap[p_pos];
+    const uint32_t count = heap.size();
+    while (true) {
+        uint32_t child = (p_pos << 1) + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && _heap_less(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!_heap_less(heap[child], cell)) {
+            break;
+        }
+        heap[p_pos] = heap[child];
+        heap_index[heap[p_pos]] = p_pos;
+        p_pos = child;
+    }
+    heap[p_pos] = cell;
+    heap_index[cell] = p_pos;
+}
+
+void GridAStar2D::_heap_push(int32_t p_cell) {
+    heap.push_back(p_cell);
+    _heap_sift_up(heap.size() - 1);
+}
+
+int32_t GridAStar2D::_heap_pop() {
+    const int32_t top = heap[0];
+    const int32_t last = heap[heap.size() - 1];
+    heap.resize(heap.size() - 1);
+    if (!heap.is_empty()) {
+        heap[0] = last;
+        _heap_sift_down(0);
+    }
+    heap_index[top] = HEAP_CLOSED;
+    return top;
+}
+
+void GridAStar2D::_prepare(int p_size) {
+    if (p_size != size) {
+        // Nur bei geänderter Gittergröße neu allokieren
+        size = p_size;
+        const uint32_t count = uint32_t(size) * uint32_t(size);
+        node_generation.resize(count);
+        g_cost.resize(count);
+        f_cost.resize(count);
+        parent.resize(count);
+        heap_index.resize(count);
+        memset(node_generation.ptr(), 0, count * sizeof(uint32_t));
+        generation = 0;
+    }
+    generation++;
+    if (generation == 0) {
+        // Überlauf des Zählers: alle Knoten einmalig zurücksetzen
+        memset(node_generation.ptr(), 0, node_generation.size() * sizeof(uint32_t));
+        generation = 1;
+    }
+    heap.clear();
+}
+
+bool GridAStar2D::solve(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path) {
+    return solve(p_size, p_from, p_to, p_walls, Rect2i(0, 0, p_size, p_size), r_path);
+}
+
+bool GridAStar2D::solve(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, const Rect2i &p_bounds, LocalVector<Vector2i> &r_path) {
+    r_path.clear();
+    last_expanded_count = 0;
+    ERR_FAIL_COND_V(p_size <= 0, false);
+    const Rect2i bounds = p_bounds.intersection(Rect2i(0, 0, p_size, p_size));
+    if (!bounds.has_point(p_from) || !bounds.has_point(p_to)) {
+        return false;
+    }
+    const int min_x = bounds.position.x;
+    const int min_y = bounds.position.y;
+    const int max_x = bounds.position.x + bounds.size.x;
+    const int max_y = bounds.position.y + bounds.size.y;
+
+    _prepare(p_size);
+
+    const int32_t start = p_from.y * size + p_from.x;
+    const int32_t goal = p_to.y * size + p_to.x;
+
+    node_generation[start] = generation;
+    g_cost[start] = 0;
+    f_cost[start] = octile_distance(p_from, p_to);
+    parent[start] = -1;
+    _heap_push(start);
+
+    bool found = false;
+    while (!heap.is_empty()) {
+        const int32_t current = _heap_pop();
+        last_expanded_count++;
+        if (current == goal) {
+            found = true;
+            break;
+        }
+
+        const int cx = current % size;
+        const int cy = current / size;
+        const uint32_t current_g = g_cost[current];
+
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            const int nx = cx + DIRECTIONS[d].x;
+            const int ny = cy + DIRECTIONS[d].y;
+            if (nx < min_x || ny < min_y || nx >= max_x || ny >= max_y) {
+                continue;
+            }
+            const int32_t next = ny * size + nx;
+            // Wände blockieren, außer es ist das Ziel selbst
+            if (p_walls && next != goal && (p_walls[next >> 6] & (uint64_t(1) << (next & 63)))) {
+                continue;
+            }
+            const uint32_t new_g = current_g + DIRECTION_COSTS[d];
+            if (node_generation[next] != generation) {
+                node_generation[next] = generation;
+                g_cost[next] = new_g;
+                f_cost[next] = new_g + octile_distance(Vector2i(nx, ny), p_to);
+                parent[next] = current;
+                _heap_push(next);
+            } else if (heap_index[next] != HEAP_CLOSED && new_g < g_cost[next]) {
+                // Decrease-Key: Die Heuristik ist konsistent, geschlossene Knoten sind endgültig
+                f_cost[next] -= g_cost[next] - new_g;
+                g_cost[next] = new_g;
+                parent[next] = current;
+                _heap_sift_up(heap_index[next]);
+            }
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    // Pfadlänge bestimmen und dann von hinten befüllen (kein Einfügen am Anfang)
+    uint32_t length = 0;
+    for (int32_t cell = goal; cell != -1; cell = parent[cell]) {
+        length++;
+    }
+    r_path.resize(length);
+    uint32_t pos = length;
+    for (int32_t cell = goal; cell != -1; cell = parent[cell]) {
+        r_path[--pos] = Vector2i(cell % size, cell / size);
+    }
+    return true;
+}
+
+void GridAStar2D::straight_path(const Vector2i &p_from, const Vector2i &p_to, LocalVector<Vector2i> &r_path) {
+    const int dx = p_to.x - p_from.x;
+    const int dy = p_to.y - p_from.y;
+    const int ax = ABS(dx);
+    const int ay = ABS(dy);
+    const int steps = MAX(ax, ay);
+    r_path.resize(steps + 1);
+    r_path[0] = p_from;
+    for (int i = 1; i <= steps; i++) {
+        // Nebenachse gerundet interpolieren: pro Schritt höchstens eine Zelle, also 8-Wege-Nachbarn
+        const int ox = (2 * i * ax + steps) / (2 * steps);
+        const int oy = (2 * i * ay + steps) / (2 * steps);
+        r_path[i] = Vector2i(p_from.x + (dx < 0 ? -ox : ox), p_from.y + (dy < 0 ? -oy : oy));
+    }
+}
+
+bool GridAStar2D::has_line_of_sight(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls) {
+    if (!p_walls) {
+        return true;
+    }
+    const int nx = ABS(p_to.x - p_from.x);
+    const int ny = ABS(p_to.y - p_from.y);
+    const int sx = p_to.x > p_from.x ? 1 : -1;
+    const int sy = p_to.y > p_from.y ? 1 : -1;
+    Vector2i cell = p_from;
+    int ix = 0;
+    int iy = 0;
+    while (ix < nx || iy < ny) {
+        // Welche Zellgrenze wird zuerst gekreuzt? Vergleich von (0.5 + ix) / nx und (0.5 + iy) / ny
+        const int64_t decision = int64_t(1 + 2 * ix) * ny - int64_t(1 + 2 * iy) * nx;
+        if (decision == 0) {
+            cell.x += sx;
+            cell.y += sy;
+            ix++;
+            iy++;
+        } else if (decision < 0) {
+            cell.x += sx;
+            ix++;
+        } else {
+            cell.y += sy;
+            iy++;
+        }
+        if (cell == p_to) {
+            break;
+        }
+        if (cell.x < 0 || cell.y < 0 || cell.x >= p_size || cell.y >= p_size) {
+            return false;
+        }
+        const int32_t index = cell.y * p_size + cell.x;
+        if (p_walls[index >> 6] & (uint64_t(1) << (index & 63))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GridAStar2D::pull_string(int p_size, const uint64_t *p_walls, LocalVector<Vector2i> &r_path) {
+    if (r_path.size() < 3) {
+        return;
+    }
+    // In-place: out ist die Anzahl der bereits behaltenen Ecken, anchor die letzte davon
+    uint32_t out = 1;
+    for (uint32_t i = 2; i < r_path.size(); i++) {
+        if (!has_line_of_sight(p_size, r_path[out - 1], r_path[i], p_walls)) {
+            r_path[out++] = r_path[i - 1];
+        }
+    }
+    r_path[out++] = r_path[r_path.size() - 1];
+    r_path.resize(out);
+}
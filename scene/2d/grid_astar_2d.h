@@ -0,0 +1,82 @@
+#ifndef GRID_ASTAR_2D_H
+#define GRID_ASTAR_2D_H
+
+#include "core/math/rect2i.h"
+#include "core/math/vector2i.h"
+#include "core/templates/local_vector.h"
+#include "core/typedefs.h"
+
+// A*-Löser für das quadratische Gitter des GridManager (8-Wege-Bewegung).
+// Alle Knotendaten liegen in flachen Arrays, die über einen Generationszähler
+// ungültig gemacht werden, statt sie vor jeder Suche zu leeren. Nach der ersten
+// Suche auf einer Gittergröße allokiert eine Abfrage keinen Speicher mehr.
+// Eine Instanz ist nicht threadsicher; parallele Suchen brauchen je einen eigenen Löser.
+class GridAStar2D {
+public:
+    // Ganzzahlige Kosten (1 gerade, ~1.414 diagonal), damit Ergebnisse bitgenau reproduzierbar sind
+    static const uint32_t COST_STRAIGHT = 1000;
+    static const uint32_t COST_DIAGONAL = 1414;
+
+    // 8-Wege-Nachbarschaft: erst die geraden, dann die diagonalen Richtungen
+    static const int DIRECTION_COUNT = 8;
+    static const Vector2i DIRECTIONS[DIRECTION_COUNT];
+    static const uint32_t DIRECTION_COSTS[DIRECTION_COUNT];
+
+private:
+    static const int32_t HEAP_CLOSED = -1;
+
+    int size = 0;
+    uint32_t generation = 0;
+    uint32_t last_expanded_count = 0;
+
+    LocalVector<uint32_t> node_generation; // Suche, in der die Knotendaten zuletzt gesetzt wurden
+    LocalVector<uint32_t> g_cost;          // Bisherige Kosten vom Start
+    LocalVector<uint32_t> f_cost;          // g_cost + Heuristik
+    LocalVector<int32_t> parent;           // Vorgängerzelle auf dem besten Weg
+    LocalVector<int32_t> heap_index;       // Position im Heap oder HEAP_CLOSED
+    LocalVector<int32_t> heap;             // Binärer Min-Heap der offenen Zellen
+
+    _FORCE_INLINE_ bool _heap_less(int32_t p_a, int32_t p_b) const {
+        // Bei gleichem f den Knoten mit größerem g bevorzugen (näher am Ziel)
+        return f_cost[p_a] < f_cost[p_b] || (f_cost[p_a] == f_cost[p_b] && g_cost[p_a] > g_cost[p_b]);
+    }
+    void _heap_push(int32_t p_cell);
+    int32_t _heap_pop();
+    void _heap_sift_up(uint32_t p_pos);
+    void _heap_sift_down(uint32_t p_pos);
+
+    void _prepare(int p_size);
+
+public:
+    static _FORCE_INLINE_ uint32_t octile_distance(const Vector2i &p_a, const Vector2i &p_b) {
+        const uint32_t dx = ABS(p_a.x - p_b.x);
+        const uint32_t dy = ABS(p_a.y - p_b.y);
+        const uint32_t diag = MIN(dx, dy);
+        return COST_DIAGONAL * diag + COST_STRAIGHT * (MAX(dx, dy) - diag);
+    }
+
+    // Sucht einen Pfad von p_from nach p_to auf einem Gitter der Größe p_size x p_size.
+    // p_walls ist ein Bitset (Index = y * p_size + x) der gesperrten Zellen oder nullptr,
+    // um Wände zu ignorieren. Die Zielzelle selbst darf eine Wand sein.
+    // r_path enthält bei Erfolg alle Zellen einschließlich Start und Ziel.
+    bool solve(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path);
+    // Wie oben, die Suche bleibt aber innerhalb von p_bounds (z. B. einem Cluster von GridHierarchy2D)
+    bool solve(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, const Rect2i &p_bounds, LocalVector<Vector2i> &r_path);
+
+    // Kürzester Weg ohne Hindernisse: eine gerasterte Linie mit max(dx, dy) Schritten,
+    // deren Kosten der Octile-Distanz entsprechen. Benötigt keine Suche.
+    static void straight_path(const Vector2i &p_from, const Vector2i &p_to, LocalVector<Vector2i> &r_path);
+
+    uint32_t get_last_expanded_count() const { return last_expanded_count; }
+
+    // Prüft, ob die Strecke zwischen den Mittelpunkten zweier Zellen nur freie Zellen berührt
+    // (Supercover-Rasterung). Die Endzellen selbst werden nicht geprüft. Läuft die Strecke
+    // genau durch eine Zellecke, gilt sie wie ein diagonaler A*-Schritt als frei.
+    static bool has_line_of_sight(int p_size, const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls);
+
+    // Reduziert einen Zellpfad auf seine Eckpunkte: Zwischenzellen, die von der letzten
+    // behaltenen Ecke aus in direkter Sichtlinie liegen, werden entfernt (String Pulling).
+    static void pull_string(int p_size, const uint64_t *p_walls, LocalVector<Vector2i> &r_path);
+};
+
+#endif // GRID_ASTAR_2D_H
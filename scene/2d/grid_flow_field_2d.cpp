@@ -0,0 +1,271 @@
+#include "grid_flow_field_2d.h"
+
+#include "scene/2d/grid_astar_2d.h"
+
+// Gegenrichtung zu jedem Index in GridAStar2D::DIRECTIONS
+static const uint8_t GRID_FLOW_OPPOSITE[GridAStar2D::DIRECTION_COUNT] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+
+void GridFlowField2D::_queue_push(uint32_t p_cost, int32_t p_cell) {
+    uint32_t pos = queue.size();
+    queue.push_back({ p_cost, p_cell });
+    while (pos > 0) {
+        const uint32_t up = (pos - 1) >> 1;
+        if (queue[up].cost <= p_cost) {
+            break;
+        }
+        queue[pos] = queue[up];
+        pos = up;
+    }
+    queue[pos] = { p_cost, p_cell };
+}
+
+GridFlowField2D::QueueEntry GridFlowField2D::_queue_pop() {
+    const QueueEntry top = queue[0];
+    const QueueEntry last = queue[queue.size() - 1];
+    queue.resize(queue.size() - 1);
+    const uint32_t count = queue.size();
+    if (count > 0) {
+        uint32_t pos = 0;
+        while (true) {
+            uint32_t child = (pos << 1) + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && queue[child + 1].cost < queue[child].cost) {
+                child++;
+            }
+            if (queue[child].cost >= last.cost) {
+                break;
+            }
+            queue[pos] = queue[child];
+            pos = child;
+        }
+        queue[pos] = last;
+    }
+    return top;
+}
+
+void GridFlowField2D::build(int p_size, const Vector2i &p_goal, const uint64_t *p_walls, uint32_t p_max_cost) {
+    size = p_size;
+    goal = p_goal;
+    avoid_walls = p_walls != nullptr;
+    max_cost = p_max_cost;
+
+    const uint32_t count = uint32_t(size) * uint32_t(size);
+    distance.resize(count);
+    direction.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        distance[i] = UNREACHABLE;
+    }
+    memset(direction.ptr(), NO_DIRECTION, count * sizeof(uint8_t));
+    queue.clear();
+    open.clear();
+    open_index.resize(count);
+    memset(open_index.ptr(), 0xFF, count * sizeof(int32_t));
+
+    if (!has_cell(goal)) {
+        rhs = distance;
+        return;
+    }
+
+    // Dijkstra vom Ziel aus; die Kanten sind symmetrisch, daher entspricht das der Suche zum Ziel
+    const int32_t goal_index = goal.y * size + goal.x;
+    distance[goal_index] = 0;
+    _queue_push(0, goal_index);
+
+    while (!queue.is_empty()) {
+        const QueueEntry entry = _queue_pop();
+        if (entry.cost != distance[entry.cell]) {
+            continue; // Veralteter Eintrag
+        }
+        const int cx = entry.cell % size;
+        const int cy = entry.cell / size;
+        for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+            const int nx = cx + GridAStar2D::DIRECTIONS[d].x;
+            const int ny = cy + GridAStar2D::DIRECTIONS[d].y;
+            if (nx < 0 || ny < 0 || nx >= size || ny >= size) {
+                continue;
+            }
+            const int32_t next = ny * size + nx;
+            if (p_walls && (p_walls[next >> 6] & (uint64_t(1) << (next & 63)))) {
+                continue;
+            }
+            const uint32_t new_cost = entry.cost + GridAStar2D::DIRECTION_COSTS[d];
+            if (max_cost > 0 && new_cost > max_cost) {
+                continue;
+            }
+            if (new_cost < distance[next]) {
+                distance[next] = new_cost;
+                direction[next] = GRID_FLOW_OPPOSITE[d];
+                _queue_push(new_cost, next);
+            }
+        }
+    }
+
+    // Nach einem vollständigen Aufbau ist jede Zelle lokal konsistent
+    rhs = distance;
+}
+
+void GridFlowField2D::_open_sift_up(uint32_t p_pos) {
+    const int32_t cell = open[p_pos];
+    const uint32_t key = _open_key(cell);
+    while (p_pos > 0) {
+        const uint32_t up = (p_pos - 1) >> 1;
+        if (_open_key(open[up]) <= key) {
+            break;
+        }
+        open[p_pos] = open[up];
+        open_index[open[p_pos]] = p_pos;
+        p_pos = up;
+    }
+    open[p_pos] = cell;
+    open_index[cell] = p_pos;
+}
+
+void GridFlowField2D::_open_sift_down(uint32_t p_pos) {
+    const int32_t cell = open[p_pos];
+    const uint32_t key = _open_key(cell);
+    const uint32_t count = open.size();
+    while (true) {
+        uint32_t child = (p_pos << 1) + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && _open_key(open[child + 1]) < _open_key(open[child])) {
+            child++;
+        }
+        if (_open_key(open[child]) >= key) {
+            break;
+        }
+        open[p_pos] = open[child];
+        open_index[open[p_pos]] = p_pos;
+        p_pos = child;
+    }
+    open[p_pos] = cell;
+    open_index[cell] = p_pos;
+}
+
+void GridFlowField2D::_open_insert(int32_t p_cell) {
+    open.push_back(p_cell);
+    _open_sift_up(open.size() - 1);
+}
+
+void GridFlowField2D::_open_remove(int32_t p_cell) {
+    const int32_t pos = open_index[p_cell];
+    open_index[p_cell] = -1;
+    const int32_t last = open[open.size() - 1];
+    open.resize(open.size() - 1);
+    if (last == p_cell) {
+        return;
+    }
+    open[pos] = last;
+    open_index[last] = pos;
+    _open_sift_up(pos);
+    _open_sift_down(open_index[last]);
+}
+
+void GridFlowField2D::_update_cell(int32_t p_cell, const uint64_t *p_walls) {
+    if (p_cell != goal.y * size + goal.x) {
+        // rhs aus den Nachbarn neu bestimmen und dabei die Richtung des besten Schritts merken
+        uint32_t best = UNREACHABLE;
+        uint8_t best_direction = NO_DIRECTION;
+        if (_is_passable(p_cell, p_walls)) {
+            const int cx = p_cell % size;
+            const int cy = p_cell / size;
+            for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+                const int nx = cx + GridAStar2D::DIRECTIONS[d].x;
+                const int ny = cy + GridAStar2D::DIRECTIONS[d].y;
+                if (nx < 0 || ny < 0 || nx >= size || ny >= size) {
+                    continue;
+                }
+                const int32_t next = ny * size + nx;
+                if (distance[next] == UNREACHABLE || !_is_passable(next, p_walls)) {
+                    continue;
+                }
+                const uint32_t cost = distance[next] + GridAStar2D::DIRECTION_COSTS[d];
+                if (cost < best) {
+                    best = cost;
+                    best_direction = d;
+                }
+            }
+            if (max_cost > 0 && best != UNREACHABLE && best > max_cost) {
+                best = UNREACHABLE;
+                best_direction = NO_DIRECTION;
+            }
+        }
+        rhs[p_cell] = best;
+        direction[p_cell] = best_direction;
+    }
+    if (open_index[p_cell] != -1) {
+        _open_remove(p_cell);
+    }
+    if (distance[p_cell] != rhs[p_cell]) {
+        _open_insert(p_cell);
+    }
+}
+
+void GridFlowField2D::repair(const LocalVector<Vector2i> &p_changed_cells, const uint64_t *p_walls) {
+    last_repair_count = 0;
+    if (!avoid_walls || !has_cell(goal)) {
+        return;
+    }
+
+    // Geänderte Zellen und ihre Nachbarn neu bewerten (die Kanten zu ihnen haben sich geändert)
+    for (const Vector2i &cell : p_changed_cells) {
+        if (!has_cell(cell)) {
+            continue;
+        }
+        _update_cell(cell.y * size + cell.x, p_walls);
+        for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+            const Vector2i neighbor = cell + GridAStar2D::DIRECTIONS[d];
+            if (has_cell(neighbor)) {
+                _update_cell(neighbor.y * size + neighbor.x, p_walls);
+            }
+        }
+    }
+
+    while (!open.is_empty()) {
+        const int32_t cell = open[0];
+        _open_remove(cell);
+        last_repair_count++;
+        if (distance[cell] > rhs[cell]) {
+            // Überkonsistent: Kosten sind gesunken
+            distance[cell] = rhs[cell];
+        } else {
+            // Unterkonsistent: Kosten sind gestiegen, Zelle neu bewerten
+            distance[cell] = UNREACHABLE;
+            _update_cell(cell, p_walls);
+        }
+        const int cx = cell % size;
+        const int cy = cell / size;
+        for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+            const int nx = cx + GridAStar2D::DIRECTIONS[d].x;
+            const int ny = cy + GridAStar2D::DIRECTIONS[d].y;
+            if (nx >= 0 && ny >= 0 && nx < size && ny < size) {
+                _update_cell(ny * size + nx, p_walls);
+            }
+        }
+    }
+}
+
+bool GridFlowField2D::is_affected_by(const Vector2i &p_cell, bool p_is_wall) const {
+    // Ohne Wandvermeidung hängt das Feld nicht von der Belegung ab; das Ziel ist immer begehbar
+    if (!avoid_walls || !has_cell(p_cell) || p_cell == goal) {
+        return false;
+    }
+    const uint32_t cell_distance = distance[p_cell.y * size + p_cell.x];
+    if (p_is_wall) {
+        // Neue Wand auf einer erreichten Zelle
+        return cell_distance != UNREACHABLE;
+    }
+    if (cell_distance != UNREACHABLE) {
+        return false;
+    }
+    // Freigewordene Zelle: nur relevant, wenn sie an den erreichten Bereich grenzt
+    for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+        if (get_distance(p_cell + GridAStar2D::DIRECTIONS[d]) != UNREACHABLE) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+#ifndef GRID_FLOW_FIELD_2D_H
+#define GRID_FLOW_FIELD_2D_H
+
+#include "core/math/vector2i.h"
+#include "core/templates/local_vector.h"
+#include "core/typedefs.h"
+
+// Integrationsfeld (Dijkstra-Karte) zu einer Zielzelle des GridManager.
+// Speichert pro Zelle die Kosten bis zum Ziel und die Richtung des nächsten Schritts,
+// sodass beliebig viele Einheiten ihren Weg zum selben Ziel in O(1) ablesen können.
+// Kosten und Nachbarschaft entsprechen GridAStar2D, die Wege sind also gleich lang.
+// Ändern sich einzelne Zellen, repariert repair() das Feld inkrementell (LPA* ohne
+// Heuristik), sodass der Aufwand nur vom tatsächlich betroffenen Bereich abhängt.
+class GridFlowField2D {
+public:
+    static const uint32_t UNREACHABLE = UINT32_MAX;
+    static const uint8_t NO_DIRECTION = 0xFF;
+
+private:
+    struct QueueEntry {
+        uint32_t cost;
+        int32_t cell;
+    };
+
+    int size = 0;
+    Vector2i goal;
+    bool avoid_walls = true;
+    uint32_t max_cost = 0;              // 0 = unbegrenzte Reichweite
+    uint64_t last_used = 0;             // Für die LRU-Verdrängung im Cache
+
+    LocalVector<uint32_t> distance;     // Kosten bis zum Ziel oder UNREACHABLE
+    LocalVector<uint8_t> direction;     // Index in GridAStar2D::DIRECTIONS zum nächsten Schritt
+    LocalVector<QueueEntry> queue;      // Binärer Min-Heap während des Aufbaus
+
+    // Zustand für die inkrementelle Reparatur
+    LocalVector<uint32_t> rhs;          // Einschrittige Vorausschau auf die Kosten
+    LocalVector<int32_t> open_index;    // Position in open oder -1
+    LocalVector<int32_t> open;          // Indizierter Min-Heap der inkonsistenten Zellen
+    uint32_t last_repair_count = 0;
+
+    void _queue_push(uint32_t p_cost, int32_t p_cell);
+    QueueEntry _queue_pop();
+
+    _FORCE_INLINE_ bool _is_passable(int32_t p_cell, const uint64_t *p_walls) const {
+        return !p_walls || p_cell == goal.y * size + goal.x || !(p_walls[p_cell >> 6] & (uint64_t(1) << (p_cell & 63)));
+    }
+    _FORCE_INLINE_ uint32_t _open_key(int32_t p_cell) const { return MIN(distance[p_cell], rhs[p_cell]); }
+    void _open_sift_up(uint32_t p_pos);
+    void _open_sift_down(uint32_t p_pos);
+    void _open_remove(int32_t p_cell);
+    void _open_insert(int32_t p_cell);
+    void _update_cell(int32_t p_cell, const uint64_t *p_walls);
+
+public:
+    // Baut das Feld neu auf. p_walls wie bei GridAStar2D (nullptr = Wände ignorieren).
+    void build(int p_size, const Vector2i &p_goal, const uint64_t *p_walls, uint32_t p_max_cost);
+
+    // Prüft, ob eine geänderte Zelle das Feld ungültig macht
+    bool is_affected_by(const Vector2i &p_cell, bool p_is_wall) const;
+
+    // Passt das Feld an geänderte Zellen an. p_walls muss den neuen Zustand enthalten.
+    void repair(const LocalVector<Vector2i> &p_changed_cells, const uint64_t *p_walls);
+    uint32_t get_last_repair_count() const { return last_repair_count; }
+
+    _FORCE_INLINE_ bool has_cell(const Vector2i &p_cell) const {
+        return p_cell.x >= 0 && p_cell.y >= 0 && p_cell.x < size && p_cell.y < size;
+    }
+    _FORCE_INLINE_ uint32_t get_distance(const Vector2i &p_cell) const {
+        return has_cell(p_cell) ? distance[p_cell.y * size + p_cell.x] : UNREACHABLE;
+    }
+    _FORCE_INLINE_ uint8_t get_direction(const Vector2i &p_cell) const {
+        return has_cell(p_cell) ? direction[p_cell.y * size + p_cell.x] : NO_DIRECTION;
+    }
+
+    int get_size() const { return size; }
+    const Vector2i &get_goal() const { return goal; }
+    bool is_avoiding_walls() const { return avoid_walls; }
+    uint32_t get_max_cost() const { return max_cost; }
+    void set_last_used(uint64_t p_tick) { last_used = p_tick; }
+    uint64_t get_last_used() const { return last_used; }
+};
+
+#endif // GRID_FLOW_FIELD_2D_H
@@ -0,0 +1,429 @@
+#include "grid_hierarchy_2d.h"
+
+#include "core/error/error_macros.h"
+
+void GridHierarchy2D::reset(int p_size, int p_cluster_size) {
+    size = MAX(p_size, 0);
+    cluster_size = MAX(p_cluster_size, 2);
+    clusters_per_side = (size + cluster_size - 1) / cluster_size;
+
+    clusters.clear();
+    clusters.resize(clusters_per_side * clusters_per_side);
+    dirty_clusters.clear();
+    for (int cy = 0; cy < clusters_per_side; cy++) {
+        for (int cx = 0; cx < clusters_per_side; cx++) {
+            Cluster &cluster = clusters[cy * clusters_per_side + cx];
+            const Vector2i origin = Vector2i(cx, cy) * cluster_size;
+            cluster.rect = Rect2i(origin, Vector2i(MIN(cluster_size, size - origin.x), MIN(cluster_size, size - origin.y)));
+            dirty_clusters.push_back(cy * clusters_per_side + cx);
+        }
+    }
+
+    const uint32_t count = uint32_t(size) * uint32_t(size);
+    node_slot.resize(count);
+    memset(node_slot.ptr(), 0xFF, count * sizeof(int32_t));
+    node_generation.resize(count);
+    g_cost.resize(count);
+    f_cost.resize(count);
+    parent.resize(count);
+    heap_index.resize(count);
+    memset(node_generation.ptr(), 0, count * sizeof(uint32_t));
+    generation = 0;
+    local_distance.resize(cluster_size * cluster_size);
+}
+
+void GridHierarchy2D::_mark_dirty(int p_cluster_x, int p_cluster_y) {
+    if (p_cluster_x < 0 || p_cluster_y < 0 || p_cluster_x >= clusters_per_side || p_cluster_y >= clusters_per_side) {
+        return;
+    }
+    const uint32_t index = p_cluster_y * clusters_per_side + p_cluster_x;
+    if (!clusters[index].dirty) {
+        clusters[index].dirty = true;
+        dirty_clusters.push_back(index);
+    }
+}
+
+void GridHierarchy2D::invalidate_cell(const Vector2i &p_cell) {
+    if (p_cell.x < 0 || p_cell.y < 0 || p_cell.x >= size || p_cell.y >= size) {
+        return;
+    }
+    const int cx = p_cell.x / cluster_size;
+    const int cy = p_cell.y / cluster_size;
+    _mark_dirty(cx, cy);
+    // Randzellen bestimmen auch die Übergänge des Nachbarn
+    const int lx = p_cell.x % cluster_size;
+    const int ly = p_cell.y % cluster_size;
+    if (lx == 0) {
+        _mark_dirty(cx - 1, cy);
+    } else if (lx == cluster_size - 1) {
+        _mark_dirty(cx + 1, cy);
+    }
+    if (ly == 0) {
+        _mark_dirty(cx, cy - 1);
+    } else if (ly == cluster_size - 1) {
+        _mark_dirty(cx, cy + 1);
+    }
+}
+
+void GridHierarchy2D::_add_node(Cluster &r_cluster, int32_t p_cell, int p_direction) {
+    int32_t slot = node_slot[p_cell];
+    if (slot == NO_SLOT) {
+        slot = r_cluster.nodes.size();
+        node_slot[p_cell] = slot;
+        r_cluster.nodes.push_back(p_cell);
+        r_cluster.exits.push_back(0);
+    }
+    r_cluster.exits[slot] |= 1 << p_direction;
+}
+
+void GridHierarchy2D::_add_border_nodes(Cluster &r_cluster, int p_direction, const uint64_t *p_walls) {
+    // p_direction ist einer der geraden Indizes 0..3 in GridAStar2D::DIRECTIONS
+    const Rect2i &rect = r_cluster.rect;
+    const Vector2i across = GridAStar2D::DIRECTIONS[p_direction];
+    Vector2i inner = rect.position;
+    if (across.x > 0) {
+        inner.x += rect.size.x - 1;
+    } else if (across.y > 0) {
+        inner.y += rect.size.y - 1;
+    }
+    const Vector2i outer_check = inner + across;
+    if (outer_check.x < 0 || outer_check.y < 0 || outer_check.x >= size || outer_check.y >= size) {
+        return; // Gitterrand, kein Nachbarcluster
+    }
+    const Vector2i along = across.x != 0 ? Vector2i(0, 1) : Vector2i(1, 0);
+    const int length = across.x != 0 ? rect.size.y : rect.size.x;
+
+    // Zusammenhängende Öffnungen (beide Seiten frei) suchen. Beide Cluster werten dieselben
+    // Zellpaare in derselben Reihenfolge aus und wählen daher dieselben Übergänge.
+    int run_start = -1;
+    for (int t = 0; t <= length; t++) {
+        bool open = false;
+        if (t < length) {
+            const Vector2i cell = inner + along * t;
+            const Vector2i outer = cell + across;
+            open = _is_free(cell.y * size + cell.x, p_walls) && _is_free(outer.y * size + outer.x, p_walls);
+        }
+        if (open && run_start < 0) {
+            run_start = t;
+        } else if (!open && run_start >= 0) {
+            const int run_length = t - run_start;
+            if (run_length >= WIDE_ENTRANCE_LENGTH) {
+                const Vector2i first = inner + along * run_start;
+                const Vector2i last = inner + along * (t - 1);
+                _add_node(r_cluster, first.y * size + first.x, p_direction);
+                _add_node(r_cluster, last.y * size + last.x, p_direction);
+            } else {
+                const Vector2i middle = inner + along * (run_start + (run_length - 1) / 2);
+                _add_node(r_cluster, middle.y * size + middle.x, p_direction);
+            }
+            run_start = -1;
+        }
+    }
+}
+
+void GridHierarchy2D::_local_queue_push(uint32_t p_cost, int32_t p_cell) {
+    uint32_t pos = local_queue.size();
+    local_queue.push_back({ p_cost, p_cell });
+    while (pos > 0) {
+        const uint32_t up = (pos - 1) >> 1;
+        if (local_queue[up].cost <= p_cost) {
+            break;
+        }
+        local_queue[pos] = local_queue[up];
+        pos = up;
+    }
+    local_queue[pos] = { p_cost, p_cell };
+}
+
+GridHierarchy2D::QueueEntry GridHierarchy2D::_local_queue_pop() {
+    const QueueEntry top = local_queue[0];
+    const QueueEntry last = local_queue[local_queue.size() - 1];
+    local_queue.resize(local_queue.size() - 1);
+    const uint32_t count = local_queue.size();
+    if (count > 0) {
+        uint32_t pos = 0;
+        while (true) {
+            uint32_t child = (pos << 1) + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && local_queue[child + 1].cost < local_queue[child].cost) {
+                child++;
+            }
+            if (local_queue[child].cost >= last.cost) {
+                break;
+            }
+            local_queue[pos] = local_queue[child];
+            pos = child;
+        }
+        local_queue[pos] = last;
+    }
+    return top;
+}
+
+uint32_t GridHierarchy2D::_local_dijkstra(const Rect2i &p_rect, const Vector2i &p_from, const uint64_t *p_walls) {
+    // Kosten von p_from zu allen Zellen des Clusters, ohne ihn zu verlassen.
+    // p_from selbst darf eine Wand sein (Zielzelle), alle anderen Zellen müssen frei sein.
+    const int width = p_rect.size.x;
+    const int count = width * p_rect.size.y;
+    for (int i = 0; i < count; i++) {
+        local_distance[i] = UNREACHABLE;
+    }
+    local_queue.clear();
+    const int32_t from = p_from.y * size + p_from.x;
+    local_distance[(p_from.y - p_rect.position.y) * width + (p_from.x - p_rect.position.x)] = 0;
+    _local_queue_push(0, from);
+
+    uint32_t settled = 0;
+    while (!local_queue.is_empty()) {
+        const QueueEntry entry = _local_queue_pop();
+        if (entry.cost != _get_local_distance(p_rect, entry.cell)) {
+            continue; // Veralteter Eintrag
+        }
+        settled++;
+        const int cx = entry.cell % size;
+        const int cy = entry.cell / size;
+        for (int d = 0; d < GridAStar2D::DIRECTION_COUNT; d++) {
+            const Vector2i next_cell = Vector2i(cx, cy) + GridAStar2D::DIRECTIONS[d];
+            if (!p_rect.has_point(next_cell)) {
+                continue;
+            }
+            const int32_t next = next_cell.y * size + next_cell.x;
+            if (!_is_free(next, p_walls)) {
+                continue;
+            }
+            const uint32_t new_cost = entry.cost + GridAStar2D::DIRECTION_COSTS[d];
+            uint32_t &distance = local_distance[(next_cell.y - p_rect.position.y) * width + (next_cell.x - p_rect.position.x)];
+            if (new_cost < distance) {
+                distance = new_cost;
+                _local_queue_push(new_cost, next);
+            }
+        }
+    }
+    return settled;
+}
+
+void GridHierarchy2D::_rebuild_cluster(uint32_t p_cluster, const uint64_t *p_walls) {
+    Cluster &cluster = clusters[p_cluster];
+    for (int32_t cell : cluster.nodes) {
+        node_slot[cell] = NO_SLOT;
+    }
+    cluster.nodes.clear();
+    cluster.exits.clear();
+    for (int d = 0; d < 4; d++) {
+        _add_border_nodes(cluster, d, p_walls);
+    }
+
+    // Kosten zwischen allen Übergängen des Clusters (innerhalb des Clusters)
+    const uint32_t node_count = cluster.nodes.size();
+    cluster.distances.resize(node_count * node_count);
+    for (uint32_t i = 0; i < node_count; i++) {
+        const int32_t cell = cluster.nodes[i];
+        _local_dijkstra(cluster.rect, Vector2i(cell % size, cell / size), p_walls);
+        for (uint32_t j = 0; j < node_count; j++) {
+            cluster.distances[i * node_count + j] = _get_local_distance(cluster.rect, cluster.nodes[j]);
+        }
+    }
+    cluster.dirty = false;
+}
+
+void GridHierarchy2D::_heap_sift_up(uint32_t p_pos) {
+    const int32_t cell = heap[p_pos];
+    while (p_pos > 0) {
+        const uint32_t up = (p_pos - 1) >> 1;
+        if (!_heap_less(cell, heap[up])) {
+            break;
+        }
+        heap[p_pos] = heap[up];
+        heap_index[heap[p_pos]] = p_pos;
+        p_pos = up;
+    }
+    heap[p_pos] = cell;
+    heap_index[cell] = p_pos;
+}
+
+void GridHierarchy2D::_heap_sift_down(uint32_t p_pos) {
+    const int32_t cell = heap[p_pos];
+    const uint32_t count = heap.size();
+    while (true) {
+        uint32_t child = (p_pos << 1) + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && _heap_less(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!_heap_less(heap[child], cell)) {
+            break;
+        }
+        heap[p_pos] = heap[child];
+        heap_index[heap[p_pos]] = p_pos;
+        p_pos = child;
+    }
+    heap[p_pos] = cell;
+    heap_index[cell] = p_pos;
+}
+
+void GridHierarchy2D::_heap_push(int32_t p_cell) {
+    heap.push_back(p_cell);
+    _heap_sift_up(heap.size() - 1);
+}
+
+int32_t GridHierarchy2D::_heap_pop() {
+    const int32_t top = heap[0];
+    const int32_t last = heap[heap.size() - 1];
+    heap.resize(heap.size() - 1);
+    if (!heap.is_empty()) {
+        heap[0] = last;
+        _heap_sift_down(0);
+    }
+    heap_index[top] = HEAP_CLOSED;
+    return top;
+}
+
+void GridHierarchy2D::_open_node(int32_t p_cell, uint32_t p_g, int32_t p_parent, const Vector2i &p_goal) {
+    if (node_generation[p_cell] != generation) {
+        node_generation[p_cell] = generation;
+        g_cost[p_cell] = p_g;
+        f_cost[p_cell] = p_g + GridAStar2D::octile_distance(Vector2i(p_cell % size, p_cell / size), p_goal);
+        parent[p_cell] = p_parent;
+        _heap_push(p_cell);
+    } else if (heap_index[p_cell] != HEAP_CLOSED && p_g < g_cost[p_cell]) {
+        f_cost[p_cell] -= g_cost[p_cell] - p_g;
+        g_cost[p_cell] = p_g;
+        parent[p_cell] = p_parent;
+        _heap_sift_up(heap_index[p_cell]);
+    }
+}
+
+bool GridHierarchy2D::_search_abstract(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls) {
+    abstract_path.clear();
+    const uint32_t start_cluster = _get_cluster_index(p_from);
+    const uint32_t goal_cluster = _get_cluster_index(p_to);
+    const Cluster &start = clusters[start_cluster];
+    const Cluster &goal = clusters[goal_cluster];
+
+    // Start und Ziel über eine Suche innerhalb ihres Clusters an dessen Übergänge anbinden
+    last_expanded_count += _local_dijkstra(goal.rect, p_to, p_walls);
+    goal_costs.resize(goal.nodes.size());
+    for (uint32_t i = 0; i < goal.nodes.size(); i++) {
+        goal_costs[i] = _get_local_distance(goal.rect, goal.nodes[i]);
+    }
+    last_expanded_count += _local_dijkstra(start.rect, p_from, p_walls);
+    start_costs.resize(start.nodes.size());
+    for (uint32_t i = 0; i < start.nodes.size(); i++) {
+        start_costs[i] = _get_local_distance(start.rect, start.nodes[i]);
+    }
+
+    generation++;
+    if (generation == 0) {
+        memset(node_generation.ptr(), 0, node_generation.size() * sizeof(uint32_t));
+        generation = 1;
+    }
+    heap.clear();
+    for (uint32_t i = 0; i < start.nodes.size(); i++) {
+        if (start_costs[i] != UNREACHABLE) {
+            _open_node(start.nodes[i], start_costs[i], -1, p_to);
+        }
+    }
+
+    uint32_t best_cost = UNREACHABLE;
+    int32_t best_node = -1;
+    while (!heap.is_empty() && f_cost[heap[0]] < best_cost) {
+        const int32_t current = _heap_pop();
+        last_expanded_count++;
+        const Cluster &cluster = clusters[_get_cluster_index(Vector2i(current % size, current / size))];
+        const uint32_t slot = node_slot[current];
+        const uint32_t node_count = cluster.nodes.size();
+        const uint32_t current_g = g_cost[current];
+
+        if (&cluster == &goal && goal_costs[slot] != UNREACHABLE && current_g + goal_costs[slot] < best_cost) {
+            best_cost = current_g + goal_costs[slot];
+            best_node = current;
+        }
+        for (uint32_t j = 0; j < node_count; j++) {
+            const uint32_t cost = cluster.distances[slot * node_count + j];
+            if (j != slot && cost != UNREACHABLE) {
+                _open_node(cluster.nodes[j], current_g + cost, current, p_to);
+            }
+        }
+        for (int d = 0; d < 4; d++) {
+            if (!(cluster.exits[slot] & (1 << d))) {
+                continue;
+            }
+            const Vector2i next_cell = Vector2i(current % size, current / size) + GridAStar2D::DIRECTIONS[d];
+            const int32_t next = next_cell.y * size + next_cell.x;
+            ERR_CONTINUE(node_slot[next] == NO_SLOT);
+            _open_node(next, current_g + GridAStar2D::COST_STRAIGHT, current, p_to);
+        }
+    }
+
+    if (best_node == -1) {
+        return false;
+    }
+    for (int32_t node = best_node; node != -1; node = parent[node]) {
+        abstract_path.push_back(node);
+    }
+    abstract_path.invert();
+    return true;
+}
+
+bool GridHierarchy2D::_refine(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path) {
+    // Jeder Abschnitt liegt entweder in einem Cluster oder ist ein gerader Schritt über eine Grenze
+    r_path.push_back(p_from);
+    Vector2i current = p_from;
+    for (uint32_t i = 0; i <= abstract_path.size(); i++) {
+        const Vector2i next = i < abstract_path.size() ? Vector2i(abstract_path[i] % size, abstract_path[i] / size) : p_to;
+        if (next == current) {
+            continue;
+        }
+        const uint32_t cluster = _get_cluster_index(current);
+        if (cluster != (uint32_t)_get_cluster_index(next)) {
+            r_path.push_back(next);
+        } else {
+            const bool found = refine_astar.solve(size, current, next, p_walls, clusters[cluster].rect, refine_cells);
+            last_expanded_count += refine_astar.get_last_expanded_count();
+            ERR_FAIL_COND_V(!found, false);
+            for (uint32_t j = 1; j < refine_cells.size(); j++) {
+                r_path.push_back(refine_cells[j]);
+            }
+        }
+        current = next;
+    }
+    return true;
+}
+
+bool GridHierarchy2D::solve(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path) {
+    r_path.clear();
+    last_expanded_count = 0;
+    ERR_FAIL_NULL_V(p_walls, false);
+    ERR_FAIL_COND_V(size <= 0, false);
+    if (p_from.x < 0 || p_from.y < 0 || p_from.x >= size || p_from.y >= size) {
+        return false;
+    }
+    if (p_to.x < 0 || p_to.y < 0 || p_to.x >= size || p_to.y >= size) {
+        return false;
+    }
+
+    // Ungültige Cluster erst bei Bedarf neu aufbauen
+    for (uint32_t index : dirty_clusters) {
+        if (clusters[index].dirty) {
+            _rebuild_cluster(index, p_walls);
+        }
+    }
+    dirty_clusters.clear();
+
+    const Vector2i cluster_delta = Vector2i(p_from.x / cluster_size - p_to.x / cluster_size, p_from.y / cluster_size - p_to.y / cluster_size);
+    if (MAX(ABS(cluster_delta.x), ABS(cluster_delta.y)) > 1) {
+        if (_search_abstract(p_from, p_to, p_walls) && _refine(p_from, p_to, p_walls, r_path)) {
+            return true;
+        }
+        r_path.clear();
+    }
+
+    // Kurze Wege und Wege, die nur über diagonale Engstellen an Clustergrenzen führen
+    const uint32_t expanded = last_expanded_count;
+    const bool found = refine_astar.solve(size, p_from, p_to, p_walls, r_path);
+    last_expanded_count = expanded + refine_astar.get_last_expanded_count();
+    return found;
+}
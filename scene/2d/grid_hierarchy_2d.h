@@ -0,0 +1,117 @@
+#ifndef GRID_HIERARCHY_2D_H
+#define GRID_HIERARCHY_2D_H
+
+#include "core/math/rect2i.h"
+#include "core/math/vector2i.h"
+#include "core/templates/local_vector.h"
+#include "core/typedefs.h"
+#include "scene/2d/grid_astar_2d.h"
+
+// Hierarchische Wegfindung (HPA*) für große Gitter des GridManager.
+// Das Gitter wird in quadratische Cluster fester Größe zerlegt. Entlang jeder Clustergrenze
+// werden Übergänge zwischen freien Zellpaaren bestimmt; innerhalb eines Clusters sind die
+// Kosten zwischen allen Übergängen vorberechnet. Lange Wege werden zuerst auf diesem kleinen
+// Graphen gesucht und anschließend clusterweise mit GridAStar2D verfeinert.
+// Belegungsänderungen machen nur die betroffenen Cluster ungültig; sie werden vor der
+// nächsten Suche neu aufgebaut. Die Wege sind nahezu, aber nicht garantiert optimal.
+// Eine Instanz ist nicht threadsicher.
+class GridHierarchy2D {
+public:
+    static const uint32_t UNREACHABLE = UINT32_MAX;
+
+private:
+    static const int32_t HEAP_CLOSED = -1;
+    static const int32_t NO_SLOT = -1;
+    // Ab dieser Lauflänge erhält eine Grenzöffnung zwei Übergänge (an beiden Enden)
+    static const int WIDE_ENTRANCE_LENGTH = 6;
+
+    struct Cluster {
+        Rect2i rect;
+        LocalVector<int32_t> nodes;         // Zellindizes der Übergänge in diesem Cluster
+        LocalVector<uint8_t> exits;         // Pro Übergang: Bitmaske der geraden Richtungen nach außen
+        LocalVector<uint32_t> distances;    // nodes.size()^2 Kosten innerhalb des Clusters
+        bool dirty = true;
+    };
+
+    struct QueueEntry {
+        uint32_t cost;
+        int32_t cell;
+    };
+
+    int size = 0;
+    int cluster_size = 16;
+    int clusters_per_side = 0;
+    LocalVector<Cluster> clusters;
+    LocalVector<uint32_t> dirty_clusters;
+    LocalVector<int32_t> node_slot;          // Pro Zelle: Index in Cluster::nodes oder NO_SLOT
+    uint32_t last_expanded_count = 0;
+
+    // Abstrakte Suche (Knoten = Zellindex), ungültig gemacht über einen Generationszähler
+    uint32_t generation = 0;
+    LocalVector<uint32_t> node_generation;
+    LocalVector<uint32_t> g_cost;
+    LocalVector<uint32_t> f_cost;
+    LocalVector<int32_t> parent;             // Vorgänger oder -1 für Knoten, die direkt am Start hängen
+    LocalVector<int32_t> heap_index;
+    LocalVector<int32_t> heap;
+
+    // Dijkstra innerhalb eines Clusters (lokale Indizes)
+    LocalVector<uint32_t> local_distance;
+    LocalVector<QueueEntry> local_queue;
+    LocalVector<uint32_t> start_costs;       // Kosten vom Start zu den Übergängen seines Clusters
+    LocalVector<uint32_t> goal_costs;        // Kosten von den Übergängen des Zielclusters zum Ziel
+
+    // Verfeinerung
+    GridAStar2D refine_astar;
+    LocalVector<Vector2i> refine_cells;
+    LocalVector<int32_t> abstract_path;
+
+    _FORCE_INLINE_ int _get_cluster_index(const Vector2i &p_cell) const {
+        return (p_cell.y / cluster_size) * clusters_per_side + p_cell.x / cluster_size;
+    }
+    _FORCE_INLINE_ bool _is_free(int32_t p_cell, const uint64_t *p_walls) const {
+        return !(p_walls[p_cell >> 6] & (uint64_t(1) << (p_cell & 63)));
+    }
+
+    void _mark_dirty(int p_cluster_x, int p_cluster_y);
+    void _rebuild_cluster(uint32_t p_cluster, const uint64_t *p_walls);
+    void _add_border_nodes(Cluster &r_cluster, int p_direction, const uint64_t *p_walls);
+    void _add_node(Cluster &r_cluster, int32_t p_cell, int p_direction);
+    uint32_t _local_dijkstra(const Rect2i &p_rect, const Vector2i &p_from, const uint64_t *p_walls);
+    _FORCE_INLINE_ uint32_t _get_local_distance(const Rect2i &p_rect, int32_t p_cell) const {
+        return local_distance[(p_cell / size - p_rect.position.y) * p_rect.size.x + (p_cell % size - p_rect.position.x)];
+    }
+    void _local_queue_push(uint32_t p_cost, int32_t p_cell);
+    QueueEntry _local_queue_pop();
+
+    _FORCE_INLINE_ bool _heap_less(int32_t p_a, int32_t p_b) const {
+        return f_cost[p_a] < f_cost[p_b] || (f_cost[p_a] == f_cost[p_b] && g_cost[p_a] > g_cost[p_b]);
+    }
+    void _heap_sift_up(uint32_t p_pos);
+    void _heap_sift_down(uint32_t p_pos);
+    void _heap_push(int32_t p_cell);
+    int32_t _heap_pop();
+    void _open_node(int32_t p_cell, uint32_t p_g, int32_t p_parent, const Vector2i &p_goal);
+
+    bool _search_abstract(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls);
+    bool _refine(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path);
+
+public:
+    // Legt die Cluster für ein Gitter der Größe p_size an; alle Cluster gelten als ungültig
+    void reset(int p_size, int p_cluster_size);
+
+    // Meldet eine geänderte Zelle. Liegt sie auf einem Clusterrand, ändert sich auch der
+    // Übergang zum Nachbarcluster, der daher ebenfalls neu aufgebaut wird.
+    void invalidate_cell(const Vector2i &p_cell);
+
+    // Sucht einen Pfad wie GridAStar2D::solve. p_walls darf nicht nullptr sein.
+    // Kurze Wege (Start und Ziel in benachbarten Clustern) und Wege, die der abstrakte
+    // Graph nicht findet, werden direkt auf dem Gitter gesucht.
+    bool solve(const Vector2i &p_from, const Vector2i &p_to, const uint64_t *p_walls, LocalVector<Vector2i> &r_path);
+
+    uint32_t get_last_expanded_count() const { return last_expanded_count; }
+    int get_size() const { return size; }
+    int get_cluster_size() const { return cluster_size; }
+};
+
+#endif // GRID_HIERARCHY_2D_H
@@ -1,46 +1,50 @@
-#include <queue>
-#include <unordered_map>
 #include <cmath>
-#include <functional>
 
 #include "core/math/vector2.h"
 #include "grid_manager_2d.h"
 #include "core/object/class_db.h"
 #include "core/math/math_funcs.h"
+#include "core/math/geometry_2d.h"
+#include "servers/rendering_server.h"
 
-// Spezialisierung für std::hash<Vector2>
-namespace std {
-    template <>
-    struct hash<Vector2> {
-        std::size_t operator()(const Vector2 &v) const {
-            std::hash<float> float_hash;
-            std::size_t h1 = float_hash(v.x);
-            std::size_t h2 = float_hash(v.y);
-            return h1 ^ (h2 << 1);
-        }
-    };
+// Isometrische Umrechnung mit expliziter Zellengröße (auch für Schnappschüsse in Worker-Threads)
+static _FORCE_INLINE_ Vector2 iso_grid_to_screen(const Vector2 &p_cell_size, const Vector2 &p_grid_pos) {
+    return Vector2((p_grid_pos.x - p_grid_pos.y) * (p_cell_size.x / 2),
+                   (p_grid_pos.x + p_grid_pos.y) * (p_cell_size.y / 2));
 }
 
-struct AStarNode {
-    Vector2 cell;
-    float priority;
-    bool operator<(const AStarNode& other) const {
-        return priority > other.priority; // Min-Heap für die Priority Queue
-    }
-};
+static _FORCE_INLINE_ Vector2 iso_screen_to_grid(const Vector2 &p_cell_size, const Vector2 &p_screen_pos) {
+    float A = p_cell_size.x / 2;
+    float B = p_cell_size.y / 2;
+    float i = (p_screen_pos.y / B + p_screen_pos.x / A) / 2;
+    float j = (p_screen_pos.y / B - p_screen_pos.x / A) / 2;
+    return Vector2(i, j);
+}
 
 GridManager::GridManager() {
     // Standardwerte sind bereits im Header gesetzt
     last_path_init_point = Vector2(0, 0);
+    _resize_occupancy(grid_size);
 }
 
 GridManager::~GridManager() {
-    // Keine dynamischen Ressourcen, die freigegeben werden müssen
+    // Laufende Sammelabfragen abwarten, bevor ihre Puffer freigegeben werden
+    for (KeyValue<int, PathBatch *> &E : path_batches) {
+        if (E.value->group_id != -1) {
+            WorkerThreadPool::get_singleton()->wait_for_group_task_completion(E.value->group_id);
+        }
+        memdelete(E.value);
+    }
+    path_batches.clear();
+    for (PathBatchWorker *worker : path_batch_workers) {
+        memdelete(worker);
+    }
+    clear_flow_fields();
 }
 
 void GridManager::_bind_methods() {
     // API-Methoden binden
-    ClassDB::bind_method(D_METHOD("api_place_building", "top_left_cell", "building_scene", "building_size"), &GridManager::api_place_building);
+    ClassDB::bind_method(D_METHOD("api_place_building", "top_left_cell", "building_scene", "building_size", "is_wall"), &GridManager::api_place_building, DEFVAL(false));
     ClassDB::bind_method(D_METHOD("api_move_building", "building_instance", "new_top_left_cell", "building_size"), &GridManager::api_move_building);
     ClassDB::bind_method(D_METHOD("api_spawn_troop", "screen_pos", "troop_scene"), &GridManager::api_spawn_troop);
     ClassDB::bind_method(D_METHOD("api_enable_build_mode"), &GridManager::api_enable_build_mode);
@@ -53,11 +57,15 @@ void GridManager::_bind_methods() {
 
     // Intern verwendete Funktionen binden
     ClassDB::bind_method(D_METHOD("can_place_building", "top_left_cell", "building_size"), &GridManager::can_place_building);
-    ClassDB::bind_method(D_METHOD("place_building", "top_left_cell", "building_scene", "building_size"), &GridManager::place_building);
+    ClassDB::bind_method(D_METHOD("place_building", "top_left_cell", "building_scene", "building_size", "is_wall"), &GridManager::place_building, DEFVAL(false));
     ClassDB::bind_method(D_METHOD("move_building", "building_instance", "new_top_left_cell", "building_size"), &GridManager::move_building);
+    ClassDB::bind_method(D_METHOD("remove_building", "building_instance"), &GridManager::remove_building);
+    ClassDB::bind_method(D_METHOD("set_building_destroyed", "building_instance", "destroyed"), &GridManager::set_building_destroyed, DEFVAL(true));
     ClassDB::bind_method(D_METHOD("can_spawn_troop", "screen_pos"), &GridManager::can_spawn_troop);
+    ClassDB::bind_method(D_METHOD("can_spawn_troops", "screen_positions"), &GridManager::can_spawn_troops);
     ClassDB::bind_method(D_METHOD("spawn_troop", "screen_pos", "troop_scene"), &GridManager::spawn_troop);
     ClassDB::bind_method(D_METHOD("update_z_index"), &GridManager::update_z_index);
+    ClassDB::bind_method(D_METHOD("update_node_z_index", "node"), &GridManager::update_node_z_index);
     ClassDB::bind_method(D_METHOD("toggle_modes", "p_last_active_state"), &GridManager::toggle_modes);
 
     // Pfadfindungsmethoden binden (ergänzt um get_simple_path_through_wall)
@@ -69,11 +77,49 @@ void GridManager::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_direct_path", "start_pos", "end_pos", "segments"), &GridManager::get_direct_path, DEFVAL(10));
     ClassDB::bind_method(D_METHOD("get_simple_path_through_wall", "start_pos", "end_pos", "max_detour"), &GridManager::get_simple_path_through_wall);
     ClassDB::bind_method(D_METHOD("get_natural_path_through_wall", "start_pos", "end_pos"), &GridManager::get_natural_path_through_wall);
+    ClassDB::bind_method(D_METHOD("get_waypoint_path", "start_pos", "end_pos", "avoid_walls"), &GridManager::get_waypoint_path, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("simplify_path", "path", "avoid_walls"), &GridManager::simplify_path, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("has_line_of_sight", "from_cell", "to_cell"), &GridManager::has_line_of_sight);
+    ClassDB::bind_method(D_METHOD("get_path_cell_length", "path"), &GridManager::get_path_cell_length);
+    ClassDB::bind_static_method("GridManager", D_METHOD("sample_path_curve", "path", "segment", "t"), &GridManager::sample_path_curve);
+
+    // Sammel-Pfadabfragen
+    ClassDB::bind_method(D_METHOD("request_paths_batch", "starts", "goals", "flags", "callback"), &GridManager::request_paths_batch, DEFVAL(PATH_FLAG_AVOID_WALLS), DEFVAL(Callable()));
+    ClassDB::bind_method(D_METHOD("is_paths_batch_completed", "batch_id"), &GridManager::is_paths_batch_completed);
+    ClassDB::bind_method(D_METHOD("get_paths_batch_result", "batch_id"), &GridManager::get_paths_batch_result);
+
+    // Flussfelder
+    ClassDB::bind_method(D_METHOD("get_flow_field_next_cell", "cell", "goal_cell", "avoid_walls"), &GridManager::get_flow_field_next_cell, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("get_flow_field_distance", "cell", "goal_cell", "avoid_walls"), &GridManager::get_flow_field_distance, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("get_flow_field_path", "start_pos", "end_pos", "avoid_walls"), &GridManager::get_flow_field_path, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("clear_flow_fields"), &GridManager::clear_flow_fields);
+
+    BIND_BITFIELD_FLAG(PATH_FLAG_AVOID_WALLS);
+    BIND_BITFIELD_FLAG(PATH_FLAG_SMOOTH);
+    BIND_BITFIELD_FLAG(PATH_FLAG_WAYPOINTS);
+    BIND_BITFIELD_FLAG(TARGET_FILTER_BUILDINGS);
+    BIND_BITFIELD_FLAG(TARGET_FILTER_WALLS);
+    BIND_ENUM_CONSTANT(DEPTH_SORT_ALL_CHILDREN);
+    BIND_ENUM_CONSTANT(DEPTH_SORT_INCREMENTAL);
+    BIND_ENUM_CONSTANT(DEPTH_SORT_Y_SORT);
 
     // Utility-Funktionen binden, damit sie in GDScript verfügbar sind:
     ClassDB::bind_method(D_METHOD("grid_to_screen", "grid_pos"), &GridManager::grid_to_screen);
     ClassDB::bind_method(D_METHOD("screen_to_grid", "screen_pos"), &GridManager::screen_to_grid);
 
+    // Typisierte Belegungsabfragen
+    ClassDB::bind_method(D_METHOD("is_cell_occupied", "cell"), &GridManager::is_cell_occupied);
+    ClassDB::bind_method(D_METHOD("is_wall_at", "cell"), &GridManager::is_wall_at);
+    ClassDB::bind_method(D_METHOD("is_cell_destroyed", "cell"), &GridManager::is_cell_destroyed);
+    ClassDB::bind_method(D_METHOD("get_occupant", "cell"), &GridManager::get_occupant);
+    ClassDB::bind_method(D_METHOD("get_occupant_offset", "cell"), &GridManager::get_occupant_offset);
+    ClassDB::bind_method(D_METHOD("get_occupancy_bitmap"), &GridManager::get_occupancy_bitmap);
+
+    // Räumliche Zielsuche
+    ClassDB::bind_method(D_METHOD("find_nearest_target", "position", "radius", "filter"), &GridManager::find_nearest_target, DEFVAL(TARGET_FILTER_BUILDINGS | TARGET_FILTER_WALLS));
+    ClassDB::bind_method(D_METHOD("get_building_count"), &GridManager::get_building_count);
+    ClassDB::bind_method(D_METHOD("get_state_hash"), &GridManager::get_state_hash);
+
     // Getter und Setter binden
     ClassDB::bind_method(D_METHOD("set_cell_size", "size"), &GridManager::set_cell_size);
     ClassDB::bind_method(D_METHOD("get_cell_size"), &GridManager::get_cell_size);
@@ -83,10 +129,21 @@ void GridManager::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_min_z_index"), &GridManager::get_min_z_index);
     ClassDB::bind_method(D_METHOD("set_max_z_index", "index"), &GridManager::set_max_z_index);
     ClassDB::bind_method(D_METHOD("get_max_z_index"), &GridManager::get_max_z_index);
+    ClassDB::bind_method(D_METHOD("set_depth_sort_mode", "mode"), &GridManager::set_depth_sort_mode);
+    ClassDB::bind_method(D_METHOD("get_depth_sort_mode"), &GridManager::get_depth_sort_mode);
     ClassDB::bind_method(D_METHOD("set_grid_lines", "enable"), &GridManager::set_grid_lines);
     ClassDB::bind_method(D_METHOD("get_grid_lines"), &GridManager::get_grid_lines);
     ClassDB::bind_method(D_METHOD("set_show_occupied", "enable"), &GridManager::set_show_occupied);
     ClassDB::bind_method(D_METHOD("get_show_occupied"), &GridManager::get_show_occupied);
+    ClassDB::bind_method(D_METHOD("set_flow_field_cache_size", "size"), &GridManager::set_flow_field_cache_size);
+    ClassDB::bind_method(D_METHOD("get_flow_field_cache_size"), &GridManager::get_flow_field_cache_size);
+    ClassDB::bind_method(D_METHOD("set_flow_field_max_distance", "distance"), &GridManager::set_flow_field_max_distance);
+    ClassDB::bind_method(D_METHOD("get_flow_field_max_distance"), &GridManager::get_flow_field_max_distance);
+    ClassDB::bind_method(D_METHOD("set_hierarchical_pathfinding", "enable"), &GridManager::set_hierarchical_pathfinding);
+    ClassDB::bind_method(D_METHOD("is_hierarchical_pathfinding"), &GridManager::is_hierarchical_pathfinding);
+    ClassDB::bind_method(D_METHOD("set_path_cluster_size", "size"), &GridManager::set_path_cluster_size);
+    ClassDB::bind_method(D_METHOD("get_path_cluster_size"), &GridManager::get_path_cluster_size);
+    ClassDB::bind_method(D_METHOD("get_last_path_expanded_count"), &GridManager::get_last_path_expanded_count);
     ClassDB::bind_method(D_METHOD("get_grid_occupancy"), &GridManager::get_grid_occupancy);
     ClassDB::add_property("GridManager", PropertyInfo(Variant::DICTIONARY, "grid_occupancy"), "", "get_grid_occupancy");
 
@@ -95,31 +152,146 @@ void GridManager::_bind_methods() {
     ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "grid_size"), "set_grid_size", "get_grid_size");
     ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "min_z_index"), "set_min_z_index", "get_min_z_index");
     ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "max_z_index"), "set_max_z_index", "get_max_z_index");
+    ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "depth_sort_mode", PROPERTY_HINT_ENUM, "All Children,Incremental,Y-Sort"), "set_depth_sort_mode", "get_depth_sort_mode");
     ClassDB::add_property("GridManager", PropertyInfo(Variant::BOOL, "grid_lines"), "set_grid_lines", "get_grid_lines");
     ClassDB::add_property("GridManager", PropertyInfo(Variant::BOOL, "show_occupied"), "set_show_occupied", "get_show_occupied");
+    ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "flow_field_cache_size", PROPERTY_HINT_RANGE, "1,64,1"), "set_flow_field_cache_size", "get_flow_field_cache_size");
+    ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "flow_field_max_distance", PROPERTY_HINT_RANGE, "0,1024,1,or_greater"), "set_flow_field_max_distance", "get_flow_field_max_distance");
+    ClassDB::add_property("GridManager", PropertyInfo(Variant::BOOL, "hierarchical_pathfinding"), "set_hierarchical_pathfinding", "is_hierarchical_pathfinding");
+    ClassDB::add_property("GridManager", PropertyInfo(Variant::INT, "path_cluster_size", PROPERTY_HINT_RANGE, "4,64,1"), "set_path_cluster_size", "get_path_cluster_size");
+
+    // Signale
+    ADD_SIGNAL(MethodInfo("occupancy_changed", PropertyInfo(Variant::PACKED_VECTOR2_ARRAY, "cells")));
 }
 
 // Getter und Setter
-void GridManager::set_cell_size(Vector2 size) { cell_size = size; }
+void GridManager::set_cell_size(Vector2 size) {
+    cell_size = size;
+    _queue_debug_redraw(true);
+    _refresh_depth();
+}
 Vector2 GridManager::get_cell_size() const { return cell_size; }
-void GridManager::set_grid_size(int size) { grid_size = size; }
+void GridManager::set_grid_size(int size) {
+    ERR_FAIL_COND_MSG(size < 0, "grid_size darf nicht negativ sein.");
+    _resize_occupancy(size);
+    clear_flow_fields();
+    // Meldet die Zellen entfernter Gebäude, die noch im Gitter liegen
+    _flush_dirty_cells();
+    _refresh_depth();
+}
 int GridManager::get_grid_size() const { return grid_size; }
-void GridManager::set_min_z_index(int index) { min_z_index = index; }
+void GridManager::set_min_z_index(int index) {
+    min_z_index = index;
+    _refresh_depth();
+}
 int GridManager::get_min_z_index() const { return min_z_index; }
-void GridManager::set_max_z_index(int index) { max_z_index = index; }
+void GridManager::set_max_z_index(int index) {
+    max_z_index = index;
+    _refresh_depth();
+}
 int GridManager::get_max_z_index() const { return max_z_index; }
-void GridManager::set_grid_lines(bool enable) { grid_lines = enable; }
+void GridManager::set_depth_sort_mode(DepthSortMode p_mode) {
+    ERR_FAIL_INDEX(p_mode, DEPTH_SORT_Y_SORT + 1);
+    depth_sort_mode = p_mode;
+    set_y_sort_enabled(depth_sort_mode == DEPTH_SORT_Y_SORT);
+    // Einmaliger Abgleich aller Kinder beim Wechsel
+    if (depth_sort_mode == DEPTH_SORT_Y_SORT) {
+        for (int i = 0; i < get_child_count(); i++) {
+            Node2D *child = Object::cast_to<Node2D>(get_child(i));
+            if (child) {
+                child->set_z_index(0);
+            }
+        }
+    } else {
+        update_z_index();
+    }
+}
+GridManager::DepthSortMode GridManager::get_depth_sort_mode() const { return depth_sort_mode; }
+void GridManager::set_grid_lines(bool enable) {
+    grid_lines = enable;
+    queue_redraw();
+}
 bool GridManager::get_grid_lines() const { return grid_lines; }
-void GridManager::set_show_occupied(bool enable) { show_occupied = enable; }
+void GridManager::set_show_occupied(bool enable) {
+    show_occupied = enable;
+    queue_redraw();
+}
 bool GridManager::get_show_occupied() const { return show_occupied; }
-
-void GridManager::_ready() {
-    set_process(true);
+void GridManager::set_flow_field_cache_size(int size) {
+    flow_field_cache_size = MAX(size, 1);
+    // Überzählige Felder sofort verwerfen (am längsten unbenutzte zuerst)
+    while ((int)flow_fields.size() > flow_field_cache_size) {
+        uint32_t oldest = 0;
+        for (uint32_t i = 1; i < flow_fields.size(); i++) {
+            if (flow_fields[i]->get_last_used() < flow_fields[oldest]->get_last_used()) {
+                oldest = i;
+            }
+        }
+        memdelete(flow_fields[oldest]);
+        flow_fields.remove_at_unordered(oldest);
+    }
+}
+int GridManager::get_flow_field_cache_size() const { return flow_field_cache_size; }
+void GridManager::set_flow_field_max_distance(int distance) {
+    flow_field_max_distance = MAX(distance, 0);
+    clear_flow_fields();
+}
+int GridManager::get_flow_field_max_distance() const { return flow_field_max_distance; }
+void GridManager::set_hierarchical_pathfinding(bool enable) {
+    hierarchical_pathfinding = enable;
+    // Änderungen werden nur bei aktiver Clusterebene verfolgt, daher beim Einschalten neu anlegen
+    if (hierarchical_pathfinding) {
+        hierarchy.reset(grid_size, path_cluster_size);
+    }
+}
+bool GridManager::is_hierarchical_pathfinding() const { return hierarchical_pathfinding; }
+void GridManager::set_path_cluster_size(int size) {
+    path_cluster_size = CLAMP(size, 4, 64);
+    if (hierarchical_pathfinding) {
+        hierarchy.reset(grid_size, path_cluster_size);
+    }
+}
+int GridManager::get_path_cluster_size() const { return path_cluster_size; }
+int GridManager::get_last_path_expanded_count() const { return last_path_expanded_count; }
+
+void GridManager::_notification(int p_what) {
+    switch (p_what) {
+        case NOTIFICATION_DRAW: {
+            _draw_debug();
+        } break;
+        case NOTIFICATION_INTERNAL_PROCESS: {
+            // Abgeschlossene Sammelabfragen mit Callback ausliefern
+            LocalVector<int> finished;
+            for (const KeyValue<int, PathBatch *> &E : path_batches) {
+                if (E.value->callback.is_valid() && is_paths_batch_completed(E.key)) {
+                    finished.push_back(E.key);
+                }
+            }
+            for (int batch_id : finished) {
+                // Ein früherer Callback kann die Abfrage schon abgeholt oder abgebrochen haben
+                PathBatch **batchp = path_batches.getptr(batch_id);
+                if (!batchp) {
+                    continue;
+                }
+                Callable callback = (*batchp)->callback;
+                Array results = _finish_path_batch(batch_id);
+                callback.call(batch_id, results);
+            }
+            // Weiterlaufen, solange noch Abfragen mit Callback ausstehen (auch aus den Callbacks heraus gestellte)
+            bool pending = false;
+            for (const KeyValue<int, PathBatch *> &E : path_batches) {
+                pending = pending || E.value->callback.is_valid();
+            }
+            if (!pending) {
+                set_process_internal(false);
+            }
+        } break;
+    }
 }
 
 // API-Methoden
-bool GridManager::api_place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size) {
-    return place_building(top_left_cell, building_scene, building_size);
+bool GridManager::api_place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size, bool is_wall) {
+    return place_building(top_left_cell, building_scene, building_size, is_wall);
 }
 
 bool GridManager::api_move_building(Node2D* building_instance, Vector2 new_top_left_cell, int building_size) {
@@ -169,16 +341,492 @@ void GridManager::api_set_selection(Node2D* building_instance) {
 
 // Utility-Funktionen
 Vector2 GridManager::grid_to_screen(Vector2 grid_pos) const {
-    return Vector2((grid_pos.x - grid_pos.y) * (cell_size.x / 2),
-                   (grid_pos.x + grid_pos.y) * (cell_size.y / 2));
+    return iso_grid_to_screen(cell_size, grid_pos);
 }
 
 Vector2 GridManager::screen_to_grid(Vector2 screen_pos) const {
-    float A = cell_size.x / 2;
-    float B = cell_size.y / 2;
-    float i = (screen_pos.y / B + screen_pos.x / A) / 2;
-    float j = (screen_pos.y / B - screen_pos.x / A) / 2;
-    return Vector2(i, j);
+    return iso_screen_to_grid(cell_size, screen_pos);
+}
+
+// Flacher Belegungsspeicher
+void GridManager::_resize_occupancy(int p_new_size) {
+    // Gebäude, die nicht mehr vollständig im neuen Gitter liegen, werden wie bei remove_building
+    // entfernt. Ihre Zellen werden vorher freigegeben, damit keine Reste übernommen werden.
+    LocalVector<ObjectID> removed;
+    if (p_new_size < grid_size) {
+        for (const BuildingRecord &record : buildings) {
+            if (record.top_left.x + record.size > p_new_size || record.top_left.y + record.size > p_new_size) {
+                removed.push_back(record.id);
+            }
+        }
+        for (const ObjectID &id : removed) {
+            _release_cells(buildings[building_indices[id]]);
+            _remove_building_record(id);
+        }
+    }
+
+    LocalVector<ObjectID> new_objects;
+    LocalVector<uint8_t> new_flags;
+    LocalVector<Vector2i> new_offsets;
+    LocalVector<uint64_t> new_wall_bits;
+    const uint32_t cell_count = uint32_t(p_new_size) * uint32_t(p_new_size);
+    new_objects.resize(cell_count);
+    new_flags.resize(cell_count);
+    new_offsets.resize(cell_count);
+    new_wall_bits.resize((cell_count + 63) / 64);
+    memset(new_flags.ptr(), 0, cell_count * sizeof(uint8_t));
+    memset(new_wall_bits.ptr(), 0, new_wall_bits.size() * sizeof(uint64_t));
+
+    // Bestehende Belegung übernehmen, soweit sie im neuen Gitter liegt
+    const int keep = MIN(grid_size, p_new_size);
+    if (cell_flags.size() == uint32_t(grid_size) * uint32_t(grid_size)) {
+        for (int y = 0; y < keep; y++) {
+            for (int x = 0; x < keep; x++) {
+                const int from = y * grid_size + x;
+                const int to = y * p_new_size + x;
+                new_objects[to] = cell_objects[from];
+                new_flags[to] = cell_flags[from];
+                new_offsets[to] = cell_offsets[from];
+                if ((new_flags[to] & (CELL_WALL | CELL_DESTROYED)) == CELL_WALL) {
+                    new_wall_bits[to >> 6] |= uint64_t(1) << (to & 63);
+                }
+            }
+        }
+    }
+
+    grid_size = p_new_size;
+    cell_objects = new_objects;
+    cell_flags = new_flags;
+    cell_offsets = new_offsets;
+    wall_bits = new_wall_bits;
+    _rebuild_spatial_index();
+    _rebuild_spawn_block();
+    _queue_debug_redraw(true);
+    if (hierarchical_pathfinding) {
+        hierarchy.reset(grid_size, path_cluster_size);
+    }
+
+    // Geänderte Zellen außerhalb des neuen Gitters gibt es nicht mehr
+    for (uint32_t i = 0; i < dirty_cells.size();) {
+        if (is_cell_in_grid(dirty_cells[i])) {
+            i++;
+        } else {
+            dirty_cells.remove_at_unordered(i);
+        }
+    }
+    for (const ObjectID &id : removed) {
+        Node2D *instance = Object::cast_to<Node2D>(ObjectDB::get_instance(id));
+        if (instance) {
+            _free_building_node(instance);
+        }
+    }
+}
+
+void GridManager::_occupy_cells(const Vector2i &p_top_left, int p_size, ObjectID p_id, bool p_is_wall) {
+    for (int x = 0; x < p_size; x++) {
+        for (int y = 0; y < p_size; y++) {
+            const Vector2i cell = p_top_left + Vector2i(x, y);
+            if (!is_cell_in_grid(cell)) {
+                continue;
+            }
+            const int idx = cell_to_index(cell);
+            if (!(cell_flags[idx] & CELL_OCCUPIED)) {
+                _update_spawn_block(cell, 1);
+            }
+            cell_objects[idx] = p_id;
+            cell_flags[idx] = CELL_OCCUPIED | (p_is_wall ? CELL_WALL : 0);
+            cell_offsets[idx] = Vector2i(x, y);
+            dirty_cells.push_back(cell);
+            if (p_is_wall) {
+                wall_bits[idx >> 6] |= uint64_t(1) << (idx & 63);
+            } else {
+                wall_bits[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+            }
+        }
+    }
+}
+
+void GridManager::_release_cells(const BuildingRecord &p_record) {
+    // Nur die Fläche des Gebäudes besuchen statt des ganzen Gitters
+    for (int x = 0; x < p_record.size; x++) {
+        for (int y = 0; y < p_record.size; y++) {
+            const Vector2i cell = p_record.top_left + Vector2i(x, y);
+            if (!is_cell_in_grid(cell)) {
+                continue;
+            }
+            const int idx = cell_to_index(cell);
+            if (!(cell_flags[idx] & CELL_OCCUPIED) || cell_objects[idx] != p_record.id) {
+                continue;
+            }
+            cell_objects[idx] = ObjectID();
+            cell_flags[idx] = 0;
+            cell_offsets[idx] = Vector2i();
+            wall_bits[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+            _update_spawn_block(cell, -1);
+            dirty_cells.push_back(cell);
+        }
+    }
+}
+
+void GridManager::_set_cells_destroyed(const BuildingRecord &p_record, bool p_destroyed) {
+    for (int x = 0; x < p_record.size; x++) {
+        for (int y = 0; y < p_record.size; y++) {
+            const Vector2i cell = p_record.top_left + Vector2i(x, y);
+            if (!is_cell_in_grid(cell)) {
+                continue;
+            }
+            const int idx = cell_to_index(cell);
+            if (!(cell_flags[idx] & CELL_OCCUPIED) || cell_objects[idx] != p_record.id) {
+                continue;
+            }
+            if (bool(cell_flags[idx] & CELL_DESTROYED) == p_destroyed) {
+                continue;
+            }
+            if (p_destroyed) {
+                cell_flags[idx] |= CELL_DESTROYED;
+                wall_bits[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+            } else {
+                cell_flags[idx] &= ~CELL_DESTROYED;
+                if (cell_flags[idx] & CELL_WALL) {
+                    wall_bits[idx >> 6] |= uint64_t(1) << (idx & 63);
+                }
+            }
+            dirty_cells.push_back(cell);
+        }
+    }
+}
+
+// Gebäudeliste und räumlicher Index
+void GridManager::_add_building_record(ObjectID p_id, const Vector2i &p_top_left, int p_size, bool p_is_wall) {
+    BuildingRecord record;
+    record.id = p_id;
+    record.top_left = p_top_left;
+    record.size = p_size;
+    record.is_wall = p_is_wall;
+    building_indices[p_id] = buildings.size();
+    buildings.push_back(record);
+    max_building_size = MAX(max_building_size, p_size);
+    _spatial_insert(buildings.size() - 1);
+}
+
+void GridManager::_remove_building_record(ObjectID p_id) {
+    HashMap<ObjectID, uint32_t>::Iterator E = building_indices.find(p_id);
+    if (!E) {
+        return;
+    }
+    const uint32_t index = E->value;
+    const uint32_t last = buildings.size() - 1;
+    _spatial_erase(index);
+    building_indices.remove(E);
+    if (index != last) {
+        // Letzten Eintrag in die Lücke verschieben und seine Verweise anpassen
+        _spatial_erase(last);
+        buildings[index] = buildings[last];
+        building_indices[buildings[index].id] = index;
+        _spatial_insert(index);
+    }
+    buildings.resize(last);
+}
+
+int GridManager::_get_spatial_bucket(const Vector2i &p_cell) const {
+    if (!is_cell_in_grid(p_cell)) {
+        return -1;
+    }
+    return (p_cell.y / SPATIAL_BUCKET_CELLS) * spatial_bucket_count + p_cell.x / SPATIAL_BUCKET_CELLS;
+}
+
+void GridManager::_spatial_insert(uint32_t p_record) {
+    const int bucket = _get_spatial_bucket(buildings[p_record].top_left);
+    if (bucket != -1) {
+        spatial_buckets[bucket].push_back(p_record);
+    }
+}
+
+void GridManager::_spatial_erase(uint32_t p_record) {
+    const int bucket = _get_spatial_bucket(buildings[p_record].top_left);
+    if (bucket != -1) {
+        spatial_buckets[bucket].erase(p_record);
+    }
+}
+
+void GridManager::_rebuild_spatial_index() {
+    spatial_bucket_count = (grid_size + SPATIAL_BUCKET_CELLS - 1) / SPATIAL_BUCKET_CELLS;
+    spatial_buckets.clear();
+    spatial_buckets.resize(spatial_bucket_count * spatial_bucket_count);
+    for (uint32_t i = 0; i < buildings.size(); i++) {
+        _spatial_insert(i);
+    }
+}
+
+const GridManager::BuildingRecord *GridManager::get_building_record(ObjectID p_id) const {
+    HashMap<ObjectID, uint32_t>::ConstIterator E = building_indices.find(p_id);
+    return E ? &buildings[E->value] : nullptr;
+}
+
+int GridManager::get_building_count() const {
+    return buildings.size();
+}
+
+uint64_t GridManager::get_state_hash() const {
+    // Die Belegung folgt vollständig aus den Gebäudeeinträgen; ObjectIDs unterscheiden sich
+    // zwischen Läufen und gehen daher nicht ein. Die Reihenfolge der Einträge bestimmt den
+    // Gleichstand bei der Zielsuche und gehört deshalb zum Zustand.
+    uint64_t hash = hash_djb2_one_64(uint64_t(grid_size));
+    hash = hash_djb2_one_64(uint64_t(buildings.size()), hash);
+    for (const BuildingRecord &record : buildings) {
+        hash = hash_djb2_one_64(uint64_t(uint32_t(record.top_left.x)) | (uint64_t(uint32_t(record.top_left.y)) << 32), hash);
+        hash = hash_djb2_one_64(uint64_t(record.size) | (uint64_t(record.is_wall) << 32) | (uint64_t(record.destroyed) << 33), hash);
+    }
+    return hash;
+}
+
+bool GridManager::query_nearest_target(const Vector2 &p_position, float p_radius, BitField<TargetFilter> p_filter, TargetHit &r_hit) const {
+    if (buildings.is_empty() || p_radius < 0.0f) {
+        return false;
+    }
+
+    // Suchkreis als achsenparalleles Rechteck ins Gitter abbilden (die Projektion ist affin)
+    const Vector2 corners[4] = {
+        screen_to_grid(p_position + Vector2(-p_radius, -p_radius)),
+        screen_to_grid(p_position + Vector2(p_radius, -p_radius)),
+        screen_to_grid(p_position + Vector2(p_radius, p_radius)),
+        screen_to_grid(p_position + Vector2(-p_radius, p_radius)),
+    };
+    Vector2 grid_min = corners[0];
+    Vector2 grid_max = corners[0];
+    for (int i = 1; i < 4; i++) {
+        grid_min = grid_min.min(corners[i]);
+        grid_max = grid_max.max(corners[i]);
+    }
+    // Gebäude werden über ihre obere linke Zelle einsortiert
+    const Vector2i cell_min = (Vector2i(grid_min.floor()) - Vector2i(max_building_size - 1, max_building_size - 1)).maxi(0);
+    const Vector2i cell_max = Vector2i(grid_max.floor()).mini(grid_size - 1);
+    if (cell_min.x > cell_max.x || cell_min.y > cell_max.y) {
+        return false;
+    }
+    const Vector2i bucket_min = cell_min / SPATIAL_BUCKET_CELLS;
+    const Vector2i bucket_max = cell_max / SPATIAL_BUCKET_CELLS;
+
+    const Vector2 grid_position = screen_to_grid(p_position);
+    const bool want_buildings = p_filter.has_flag(TARGET_FILTER_BUILDINGS);
+    const bool want_walls = p_filter.has_flag(TARGET_FILTER_WALLS);
+    float best_distance = p_radius;
+    bool found = false;
+
+    for (int by = bucket_min.y; by <= bucket_max.y; by++) {
+        for (int bx = bucket_min.x; bx <= bucket_max.x; bx++) {
+            for (uint32_t index : spatial_buckets[by * spatial_bucket_count + bx]) {
+                const BuildingRecord &record = buildings[index];
+                if (record.destroyed || (record.is_wall ? !want_walls : !want_buildings)) {
+                    continue;
+                }
+                // Nächster Punkt der Grundfläche (im Bild ein Parallelogramm)
+                const Vector2 top_left = record.top_left;
+                const Vector2 bottom_right = top_left + Vector2(record.size, record.size);
+                Vector2 point = p_position;
+                if (grid_position.x < top_left.x || grid_position.y < top_left.y || grid_position.x > bottom_right.x || grid_position.y > bottom_right.y) {
+                    const Vector2 outline[4] = {
+                        grid_to_screen(top_left),
+                        grid_to_screen(Vector2(bottom_right.x, top_left.y)),
+                        grid_to_screen(bottom_right),
+                        grid_to_screen(Vector2(top_left.x, bottom_right.y)),
+                    };
+                    float point_distance = FLT_MAX;
+                    for (int i = 0; i < 4; i++) {
+                        const Vector2 segment[2] = { outline[i], outline[(i + 1) % 4] };
+                        const Vector2 candidate = Geometry2D::get_closest_point_to_segment(p_position, segment);
+                        const float candidate_distance = p_position.distance_squared_to(candidate);
+                        if (candidate_distance < point_distance) {
+                            point_distance = candidate_distance;
+                            point = candidate;
+                        }
+                    }
+                }
+                const float distance = p_position.distance_to(point);
+                if (distance < best_distance && ObjectDB::get_instance(record.id)) {
+                    best_distance = distance;
+                    r_hit.id = record.id;
+                    r_hit.point = point;
+                    r_hit.distance = distance;
+                    r_hit.is_wall = record.is_wall;
+                    found = true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+Dictionary GridManager::find_nearest_target(Vector2 position, float radius, BitField<TargetFilter> filter) const {
+    Dictionary result;
+    TargetHit hit;
+    if (query_nearest_target(position, radius, filter, hit)) {
+        result["target"] = ObjectDB::get_instance(hit.id);
+        result["point"] = hit.point;
+        result["distance"] = hit.distance;
+        result["is_wall"] = hit.is_wall;
+    }
+    return result;
+}
+
+void GridManager::_flush_dirty_cells() {
+    if (dirty_cells.is_empty()) {
+        return;
+    }
+    // Doppelte Einträge (z. B. beim Verschieben auf überlappende Zellen) zusammenfassen
+    HashSet<Vector2i> seen;
+    PackedVector2Array changed;
+    for (uint32_t i = 0; i < dirty_cells.size();) {
+        if (seen.has(dirty_cells[i])) {
+            dirty_cells.remove_at_unordered(i);
+            continue;
+        }
+        seen.insert(dirty_cells[i]);
+        changed.push_back(dirty_cells[i]);
+        i++;
+    }
+
+    // Betroffene Flussfelder inkrementell reparieren statt sie neu aufzubauen
+    for (GridFlowField2D *field : flow_fields) {
+        for (const Vector2i &cell : dirty_cells) {
+            if (field->is_affected_by(cell, is_wall_at(cell))) {
+                field->repair(dirty_cells, wall_bits.ptr());
+                break;
+            }
+        }
+    }
+    if (hierarchical_pathfinding) {
+        for (const Vector2i &cell : dirty_cells) {
+            hierarchy.invalidate_cell(cell);
+        }
+    }
+    dirty_cells.clear();
+    _queue_debug_redraw(false);
+
+    emit_signal(SNAME("occupancy_changed"), changed);
+}
+
+bool GridManager::is_cell_occupied(Vector2i cell) const {
+    return get_cell_flags(cell) & CELL_OCCUPIED;
+}
+
+bool GridManager::is_wall_at(Vector2i cell) const {
+    // Zerstörte Wände blockieren nicht mehr (entspricht wall_bits)
+    return (get_cell_flags(cell) & (CELL_WALL | CELL_DESTROYED)) == CELL_WALL;
+}
+
+bool GridManager::is_cell_destroyed(Vector2i cell) const {
+    return get_cell_flags(cell) & CELL_DESTROYED;
+}
+
+Node2D* GridManager::get_occupant(Vector2i cell) const {
+    if (!is_cell_occupied(cell)) {
+        return nullptr;
+    }
+    return Object::cast_to<Node2D>(ObjectDB::get_instance(cell_objects[cell_to_index(cell)]));
+}
+
+Vector2i GridManager::get_occupant_offset(Vector2i cell) const {
+    if (!is_cell_occupied(cell)) {
+        return Vector2i();
+    }
+    return cell_offsets[cell_to_index(cell)];
+}
+
+const GridFlowField2D *GridManager::get_flow_field(const Vector2i &p_goal_cell, bool p_avoid_walls) {
+    if (!is_cell_in_grid(p_goal_cell)) {
+        return nullptr;
+    }
+    flow_field_tick++;
+    for (GridFlowField2D *field : flow_fields) {
+        if (field->get_goal() == p_goal_cell && field->is_avoiding_walls() == p_avoid_walls) {
+            field->set_last_used(flow_field_tick);
+            return field;
+        }
+    }
+
+    // Neues Feld aufbauen, bei vollem Cache das am längsten unbenutzte wiederverwenden
+    GridFlowField2D *field = nullptr;
+    if ((int)flow_fields.size() >= flow_field_cache_size) {
+        field = flow_fields[0];
+        for (GridFlowField2D *candidate : flow_fields) {
+            if (candidate->get_last_used() < field->get_last_used()) {
+                field = candidate;
+            }
+        }
+    } else {
+        field = memnew(GridFlowField2D);
+        flow_fields.push_back(field);
+    }
+    field->build(grid_size, p_goal_cell, p_avoid_walls ? wall_bits.ptr() : nullptr, uint32_t(flow_field_max_distance) * GridAStar2D::COST_STRAIGHT);
+    field->set_last_used(flow_field_tick);
+    return field;
+}
+
+Vector2i GridManager::get_flow_field_next_cell(Vector2i cell, Vector2i goal_cell, bool avoid_walls) {
+    const GridFlowField2D *field = get_flow_field(goal_cell, avoid_walls);
+    if (!field) {
+        return Vector2i(-1, -1);
+    }
+    if (cell == goal_cell) {
+        return goal_cell;
+    }
+    const uint8_t direction = field->get_direction(cell);
+    if (direction == GridFlowField2D::NO_DIRECTION) {
+        return Vector2i(-1, -1);
+    }
+    return cell + GridAStar2D::DIRECTIONS[direction];
+}
+
+float GridManager::get_flow_field_distance(Vector2i cell, Vector2i goal_cell, bool avoid_walls) {
+    const GridFlowField2D *field = get_flow_field(goal_cell, avoid_walls);
+    if (!field) {
+        return -1.0f;
+    }
+    const uint32_t distance = field->get_distance(cell);
+    if (distance == GridFlowField2D::UNREACHABLE) {
+        return -1.0f;
+    }
+    return distance / float(GridAStar2D::COST_STRAIGHT);
+}
+
+PackedVector2Array GridManager::get_flow_field_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls) {
+    Vector2i cell = Vector2i(screen_to_grid(start_pos).floor());
+    const Vector2i goal_cell = Vector2i(screen_to_grid(end_pos).floor());
+    const GridFlowField2D *field = get_flow_field(goal_cell, avoid_walls);
+    if (!field || cell == goal_cell || field->get_distance(cell) == GridFlowField2D::UNREACHABLE) {
+        return PackedVector2Array();
+    }
+
+    // Den Richtungen bis zum Ziel folgen
+    PackedVector2Array path;
+    path.push_back(grid_to_screen(Vector2(cell) + Vector2(0.5, 0.5)));
+    while (cell != goal_cell) {
+        cell += GridAStar2D::DIRECTIONS[field->get_direction(cell)];
+        path.push_back(grid_to_screen(Vector2(cell) + Vector2(0.5, 0.5)));
+    }
+    return path;
+}
+
+void GridManager::clear_flow_fields() {
+    for (GridFlowField2D *field : flow_fields) {
+        memdelete(field);
+    }
+    flow_fields.clear();
+}
+
+Ref<BitMap> GridManager::get_occupancy_bitmap() const {
+    Ref<BitMap> bitmap;
+    bitmap.instantiate();
+    bitmap->create(Size2i(grid_size, grid_size));
+    for (int y = 0; y < grid_size; y++) {
+        for (int x = 0; x < grid_size; x++) {
+            if (cell_flags[y * grid_size + x] & CELL_OCCUPIED) {
+                bitmap->set_bitv(Point2i(x, y), true);
+            }
+        }
+    }
+    return bitmap;
 }
 
 // Interne Funktionen
@@ -186,10 +834,10 @@ bool GridManager::can_place_building(Vector2 top_left_cell, int building_size) c
     if (top_left_cell.x < 0 || top_left_cell.y < 0 || top_left_cell.x + building_size > grid_size || top_left_cell.y + building_size > grid_size) {
         return false;
     }
+    const Vector2i top_left = Vector2i(top_left_cell.floor());
     for (int x = 0; x < building_size; x++) {
         for (int y = 0; y < building_size; y++) {
-            Vector2 cell = top_left_cell + Vector2(x, y);
-            if (grid_occupancy.has(cell)) {
+            if (is_cell_occupied(top_left + Vector2i(x, y))) {
                 return false;
             }
         }
@@ -197,7 +845,8 @@ bool GridManager::can_place_building(Vector2 top_left_cell, int building_size) c
     return true;
 }
 
-bool GridManager::place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size) {
+bool GridManager::place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size, bool is_wall) {
+    ERR_FAIL_COND_V(building_scene.is_null(), false);
     if (!can_place_building(top_left_cell, building_size)) {
         return false;
     }
@@ -208,19 +857,10 @@ bool GridManager::place_building(Vector2 top_left_cell, Ref<PackedScene> buildin
         building_instance->set_position(building_center);
         building_instance->set_z_index(0);
         add_child(building_instance);
-        // Hier wird für jede Zelle ein Dictionary gespeichert statt nur der Instanz
-        for (int x = 0; x < building_size; x++) {
-            for (int y = 0; y < building_size; y++) {
-                Vector2 cell = top_left_cell + Vector2(x, y);
-                Dictionary cell_info;
-                cell_info["obj"]       = building_instance;
-                cell_info["is_wall"]   = false;
-                cell_info["destroyed"] = false;
-                cell_info["position_in_grid"] = Vector2(x, y);
-                grid_occupancy[cell]   = cell_info;
-            }
-        }
-        update_z_index();
+        _occupy_cells(Vector2i(top_left_cell.floor()), building_size, building_instance->get_instance_id(), is_wall);
+        _add_building_record(building_instance->get_instance_id(), Vector2i(top_left_cell.floor()), building_size, is_wall);
+        _flush_dirty_cells();
+        _update_depth(building_instance);
         return true;
     }
     return false;
@@ -266,57 +906,117 @@ bool GridManager::move_building(Node2D* instance, Vector2 new_top_left_cell, int
     if (!can_place_building(new_top_left_cell, building_size)) {
         return false;
     }
-    Array keys_to_remove;
+    ERR_FAIL_NULL_V(instance, false);
+    // Alte Zellen über den Gebäudeeintrag freigeben; er kennt auch die Wandeigenschaft
+    const ObjectID id = instance->get_instance_id();
     bool is_wall = false;
-    bool found = false;
-    // Get occupancy info and determine if the instance is a wall
-    for (const Variant &key : grid_occupancy.keys()) {
-        Dictionary cell_info = grid_occupancy[key];
-        if (cell_info.has("obj") && Object::cast_to<Node2D>(cell_info["obj"]) == instance) {
-            keys_to_remove.append(key);
-            if (!found && cell_info.has("is_wall")) {
-                is_wall = bool(cell_info["is_wall"]);
-                found = true;
-            }
-        }
-    }
-    for (const Variant& key : keys_to_remove) {
-        grid_occupancy.erase(key);
+    const BuildingRecord *record = get_building_record(id);
+    if (record) {
+        is_wall = record->is_wall;
+        _release_cells(*record);
+        _remove_building_record(id);
     }
     Vector2 center_cell = new_top_left_cell + Vector2(building_size / 2.0, building_size / 2.0);
     Vector2 building_center = grid_to_screen(center_cell);
     instance->set_position(building_center);
     instance->set_z_index(0);
-    for (int x = 0; x < building_size; x++) {
-        for (int y = 0; y < building_size; y++) {
-            Vector2 cell = new_top_left_cell + Vector2(x, y);
-            Dictionary cell_info;
-            cell_info["obj"] = instance;
-            cell_info["is_wall"] = is_wall;
-            cell_info["destroyed"] = false;
-            cell_info["position_in_grid"] = Vector2(x, y);
-            grid_occupancy[cell] = cell_info;
-        }
-    }
-    update_z_index();
+    _occupy_cells(Vector2i(new_top_left_cell.floor()), building_size, id, is_wall);
+    _add_building_record(id, Vector2i(new_top_left_cell.floor()), building_size, is_wall);
+    _flush_dirty_cells();
+    _update_depth(instance);
     if (!is_wall && last_active_state.size() > 0) {
         toggle_modes(last_active_state);
     }
     return true;
 }
 
-bool GridManager::can_spawn_troop(Vector2 screen_pos) const {
-    Vector2 troop_cell = screen_to_grid(screen_pos);
-    troop_cell = Vector2(floor(troop_cell.x), floor(troop_cell.y));
-    for (const Variant& cell : grid_occupancy.keys()) {
-        Vector2 occ_cell = cell;
-        if (abs(troop_cell.x - occ_cell.x) <= 1 && abs(troop_cell.y - occ_cell.y) <= 1) {
-            return false;
-        }
+bool GridManager::remove_building(Node2D* instance) {
+    ERR_FAIL_NULL_V(instance, false);
+    const BuildingRecord *record = get_building_record(instance->get_instance_id());
+    if (!record) {
+        return false;
     }
+    _release_cells(*record);
+    _remove_building_record(instance->get_instance_id());
+    _flush_dirty_cells();
+    _free_building_node(instance);
     return true;
 }
 
+void GridManager::_free_building_node(Node2D *p_instance) {
+    if (p_instance->get_parent() != this) {
+        return;
+    }
+    // Außerhalb des Szenenbaums gibt es keine Löschwarteschlange
+    if (is_inside_tree()) {
+        p_instance->queue_free();
+    } else {
+        remove_child(p_instance);
+        memdelete(p_instance);
+    }
+}
+
+bool GridManager::set_building_destroyed(Node2D* instance, bool destroyed) {
+    ERR_FAIL_NULL_V(instance, false);
+    HashMap<ObjectID, uint32_t>::Iterator E = building_indices.find(instance->get_instance_id());
+    if (!E || buildings[E->value].destroyed == destroyed) {
+        return false;
+    }
+    BuildingRecord &record = buildings[E->value];
+    record.destroyed = destroyed;
+    _set_cells_destroyed(record, destroyed);
+    _flush_dirty_cells();
+    return true;
+}
+
+void GridManager::_update_spawn_block(const Vector2i &p_cell, int p_delta) {
+    // Die Zelle sperrt sich selbst und ihre acht Nachbarn (alle im Randstreifen enthalten)
+    const int stride = grid_size + 2;
+    for (int dy = 0; dy < 3; dy++) {
+        uint8_t *row = spawn_block_counts.ptr() + (p_cell.y + dy) * stride + p_cell.x;
+        row[0] += p_delta;
+        row[1] += p_delta;
+        row[2] += p_delta;
+    }
+}
+
+void GridManager::_rebuild_spawn_block() {
+    const uint32_t stride = grid_size + 2;
+    spawn_block_counts.resize(stride * stride);
+    memset(spawn_block_counts.ptr(), 0, spawn_block_counts.size() * sizeof(uint8_t));
+    for (int y = 0; y < grid_size; y++) {
+        for (int x = 0; x < grid_size; x++) {
+            if (cell_flags[y * grid_size + x] & CELL_OCCUPIED) {
+                _update_spawn_block(Vector2i(x, y), 1);
+            }
+        }
+    }
+}
+
+bool GridManager::_is_spawn_blocked(const Vector2i &p_cell) const {
+    // Außerhalb des Randstreifens liegt keine belegte Zelle in Reichweite
+    if (p_cell.x < -1 || p_cell.y < -1 || p_cell.x > grid_size || p_cell.y > grid_size) {
+        return false;
+    }
+    return spawn_block_counts[(p_cell.y + 1) * (grid_size + 2) + p_cell.x + 1] != 0;
+}
+
+bool GridManager::can_spawn_troop(Vector2 screen_pos) const {
+    // Die 3x3-Nachbarschaft der Zielzelle steckt bereits in der Spawnsperre
+    return !_is_spawn_blocked(Vector2i(screen_to_grid(screen_pos).floor()));
+}
+
+PackedByteArray GridManager::can_spawn_troops(const PackedVector2Array &screen_positions) const {
+    PackedByteArray mask;
+    mask.resize(screen_positions.size());
+    uint8_t *w = mask.ptrw();
+    const Vector2 *r = screen_positions.ptr();
+    for (int i = 0; i < screen_positions.size(); i++) {
+        w[i] = _is_spawn_blocked(Vector2i(iso_screen_to_grid(cell_size, r[i]).floor())) ? 0 : 1;
+    }
+    return mask;
+}
+
 bool GridManager::spawn_troop(Vector2 screen_pos, Ref<PackedScene> troop_scene) {
     if (!troop_scene.is_valid()) {
         ERR_PRINT("Keine troop_scene definiert!");
@@ -329,23 +1029,58 @@ bool GridManager::spawn_troop(Vector2 screen_pos, Ref<PackedScene> troop_scene)
     if (troop_instance) {
         troop_instance->set_position(screen_pos);
         add_child(troop_instance);
+        if (depth_sort_mode == DEPTH_SORT_INCREMENTAL) {
+            update_node_z_index(troop_instance);
+        }
         return true;
     }
     return false;
 }
 
 void GridManager::update_z_index() {
-    float board_height = grid_to_screen(Vector2(grid_size, grid_size)).y;
+    if (depth_sort_mode == DEPTH_SORT_Y_SORT) {
+        return; // Die Reihenfolge bestimmt die Y-Sortierung des Canvas
+    }
     for (int i = 0; i < get_child_count(); i++) {
         Node2D* building = Object::cast_to<Node2D>(get_child(i));
         if (building) {
-            float clamped_y = CLAMP(building->get_position().y, 0.0f, board_height);
-            float t = clamped_y / board_height;
-            building->set_z_index(Math::lerp(min_z_index, max_z_index, t));
+            update_node_z_index(building);
         }
     }
 }
 
+void GridManager::update_node_z_index(Node2D *node) {
+    ERR_FAIL_NULL(node);
+    float board_height = grid_to_screen(Vector2(grid_size, grid_size)).y;
+    if (board_height <= 0.0f) {
+        node->set_z_index(min_z_index);
+        return;
+    }
+    float clamped_y = CLAMP(node->get_position().y, 0.0f, board_height);
+    float t = clamped_y / board_height;
+    node->set_z_index(Math::lerp(min_z_index, max_z_index, t));
+}
+
+void GridManager::_update_depth(Node2D *p_node) {
+    switch (depth_sort_mode) {
+        case DEPTH_SORT_ALL_CHILDREN:
+            update_z_index();
+            break;
+        case DEPTH_SORT_INCREMENTAL:
+            update_node_z_index(p_node);
+            break;
+        case DEPTH_SORT_Y_SORT:
+            break;
+    }
+}
+
+void GridManager::_refresh_depth() {
+    // Brettgröße oder Z-Bereich geändert: alle bereits sortierten Kinder neu abbilden
+    if (depth_sort_mode != DEPTH_SORT_Y_SORT && get_child_count() > 0) {
+        update_z_index();
+    }
+}
+
 void GridManager::toggle_modes(Dictionary p_last_active_state) {
     if (p_last_active_state.size() == 0) {
         ERR_PRINT("toggle_modes aufgerufen ohne gespeicherten Zustand!");
@@ -368,224 +1103,208 @@ void GridManager::toggle_modes(Dictionary p_last_active_state) {
     }
 }
 
-void GridManager::_process(double delta) {
+void GridManager::_queue_debug_redraw(bool p_grid_changed) {
+    grid_lines_dirty = grid_lines_dirty || p_grid_changed;
+    overlay_dirty = true;
     if (grid_lines || show_occupied) {
         queue_redraw();
     }
 }
 
-void GridManager::_draw() {
-    print_line("Draw grid");
-    if (grid_lines) {
-        // Print to console
-        print_line("Draw grid lines");
-        for (int i = 0; i < grid_size; i++) {
-            for (int j = 0; j < grid_size; j++) {
-                Vector2 center = grid_to_screen(Vector2(i + 0.5, j + 0.5));
-                Vector2 top = center + Vector2(0, -cell_size.y / 2);
-                Vector2 right = center + Vector2(cell_size.x / 2, 0);
-                Vector2 bottom = center + Vector2(0, cell_size.y / 2);
-                Vector2 left = center + Vector2(-cell_size.x / 2, 0);
-                draw_line(top, right, Color(1, 0, 0), 1);
-                draw_line(right, bottom, Color(1, 0, 0), 1);
-                draw_line(bottom, left, Color(1, 0, 0), 1);
-                draw_line(left, top, Color(1, 0, 0), 1);
+void GridManager::_rebuild_grid_lines() {
+    // Die Zellränder liegen auf den Geraden x = const und y = const im Gitter,
+    // daher genügen 2 * (grid_size + 1) Linien statt vier Linien pro Zelle.
+    grid_line_points.resize(4 * (grid_size + 1));
+    Vector2 *points_w = grid_line_points.ptrw();
+    for (int i = 0; i <= grid_size; i++) {
+        *points_w++ = grid_to_screen(Vector2(i, 0));
+        *points_w++ = grid_to_screen(Vector2(i, grid_size));
+        *points_w++ = grid_to_screen(Vector2(0, i));
+        *points_w++ = grid_to_screen(Vector2(grid_size, i));
+    }
+    grid_lines_dirty = false;
+}
+
+void GridManager::_rebuild_overlay() {
+    // Belegte Zellen grün, freie Nachbarn belegter Zellen gelb
+    overlay_points.clear();
+    overlay_colors.clear();
+    overlay_indices.clear();
+    const Vector2 half_x = Vector2(cell_size.x / 2, 0);
+    const Vector2 half_y = Vector2(0, cell_size.y / 2);
+    static const int QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int idx = 0; idx < (int)cell_flags.size(); idx++) {
+        Color color;
+        if (cell_flags[idx] & CELL_OCCUPIED) {
+            color = Color(0, 1, 0, 0.5);
+        } else {
+            const Vector2i cell = Vector2i(idx % grid_size, idx / grid_size);
+            bool near_occupied = false;
+            for (int d = 0; d < GridAStar2D::DIRECTION_COUNT && !near_occupied; d++) {
+                near_occupied = is_cell_occupied(cell + GridAStar2D::DIRECTIONS[d]);
             }
+            if (!near_occupied) {
+                continue;
+            }
+            color = Color(1, 1, 0, 0.5);
+        }
+        const Vector2 center = grid_to_screen(Vector2(idx % grid_size, idx / grid_size) + Vector2(0.5, 0.5));
+        const int base = overlay_points.size();
+        overlay_points.push_back(center - half_y);
+        overlay_points.push_back(center + half_x);
+        overlay_points.push_back(center + half_y);
+        overlay_points.push_back(center - half_x);
+        for (int k = 0; k < 4; k++) {
+            overlay_colors.push_back(color);
+        }
+        for (int k = 0; k < 6; k++) {
+            overlay_indices.push_back(base + QUAD_INDICES[k]);
         }
     }
-    if (show_occupied) {
-        // Print to editor console
-        print_line("Draw occupied cells");
-        Dictionary drawn_yellow;
-        for (const Variant& key : grid_occupancy.keys()) {
-            Vector2 cell = key;
-            Vector2 cell_center = grid_to_screen(cell + Vector2(0.5, 0.5));
-            Vector2 points[4] = {
-                cell_center + Vector2(0, -cell_size.y / 2),
-                cell_center + Vector2(cell_size.x / 2, 0),
-                cell_center + Vector2(0, cell_size.y / 2),
-                cell_center + Vector2(-cell_size.x / 2, 0)
-            };
-            {
-                PackedVector2Array poly_array;
-                for (int k = 0; k < 4; k++) {
-                    poly_array.push_back(points[k]);
-                }
-                draw_colored_polygon(poly_array, Color(0, 1, 0, 0.5));
-            }
+    overlay_dirty = false;
+}
 
-            Vector2 neighbor_offsets[8] = {
-                Vector2(1, 0), Vector2(-1, 0), Vector2(0, 1), Vector2(0, -1),
-                Vector2(1, 1), Vector2(1, -1), Vector2(-1, 1), Vector2(-1, -1)
-            };
-            for (int i = 0; i < 8; i++) {
-                Vector2 neighbor = cell + neighbor_offsets[i];
-                if (grid_occupancy.has(neighbor) || drawn_yellow.has(neighbor)) {
-                    continue;
-                }
-                Vector2 neighbor_center = grid_to_screen(neighbor + Vector2(0.5, 0.5));
-                Vector2 neighbor_points[4] = {
-                    neighbor_center + Vector2(0, -cell_size.y / 2),
-                    neighbor_center + Vector2(cell_size.x / 2, 0),
-                    neighbor_center + Vector2(0, cell_size.y / 2),
-                    neighbor_center + Vector2(-cell_size.x / 2, 0)
-                };
-                PackedVector2Array neighbor_poly;
-                for (int k = 0; k < 4; k++) {
-                    neighbor_poly.push_back(neighbor_points[k]);
-                }
-                draw_colored_polygon(neighbor_poly, Color(1, 1, 0, 0.5));
-                drawn_yellow[neighbor] = true;
-            }
+void GridManager::_draw_debug() {
+    if (grid_lines) {
+        if (grid_lines_dirty) {
+            _rebuild_grid_lines();
+        }
+        draw_multiline(grid_line_points, Color(1, 0, 0), 1);
+    }
+    if (show_occupied) {
+        if (overlay_dirty) {
+            _rebuild_overlay();
+        }
+        if (!overlay_indices.is_empty()) {
+            RenderingServer::get_singleton()->canvas_item_add_triangle_array(get_canvas_item(), overlay_indices, overlay_points, overlay_colors);
         }
     }
 }
 
-Array GridManager::get_simple_path(Vector2 start_pos, Vector2 end_pos) {
+PackedVector2Array GridManager::get_simple_path(Vector2 start_pos, Vector2 end_pos) {
     Vector2 start_grid = screen_to_grid(start_pos);
     Vector2 end_grid = screen_to_grid(end_pos);
     start_grid = Vector2(floor(start_grid.x), floor(start_grid.y));
     end_grid = Vector2(floor(end_grid.x), floor(end_grid.y));
-    Array path;
+    PackedVector2Array path;
     Vector2 diff = end_grid - start_grid;
-    int steps = std::max(abs(diff.x), abs(diff.y));
+    int steps = MAX(Math::abs(diff.x), Math::abs(diff.y));
     if (steps == 0) {
-        path.append(grid_to_screen(start_grid + Vector2(0.5, 0.5)));
+        path.push_back(grid_to_screen(start_grid + Vector2(0.5, 0.5)));
         return path;
     }
+    path.resize(steps + 1);
+    Vector2 *path_w = path.ptrw();
     Vector2 step = diff / static_cast<float>(steps);
     Vector2 current = start_grid;
     for (int i = 0; i <= steps; i++) {
         Vector2 cell = Vector2(round(current.x), round(current.y));
-        path.append(grid_to_screen(cell + Vector2(0.5, 0.5)));
+        path_w[i] = grid_to_screen(cell + Vector2(0.5, 0.5));
         current += step;
     }
     return path;
 }
 
-Array GridManager::get_simple_path_iso_avoid_walls(Vector2 start_pos, Vector2 end_pos) {
+PackedVector2Array GridManager::_find_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls, bool waypoints) {
     // Start- und Endposition in Gitterkoordinaten umwandeln
-    Vector2 start_grid = screen_to_grid(start_pos);
-    Vector2 end_grid = screen_to_grid(end_pos);
-    Vector2 start_cell = Vector2(std::floor(start_grid.x), std::floor(start_grid.y));
-    Vector2 goal_cell = Vector2(std::floor(end_grid.x), std::floor(end_grid.y));
+    Vector2i start_cell = Vector2i(screen_to_grid(start_pos).floor());
+    Vector2i goal_cell = Vector2i(screen_to_grid(end_pos).floor());
 
     // Wenn Start und Ziel identisch sind, leeren Pfad zurückgeben
     if (start_cell == goal_cell) {
-        return Array();
+        return PackedVector2Array();
     }
 
-    // A*-Datenstrukturen initialisieren
-    std::priority_queue<AStarNode> frontier;
-    frontier.push({start_cell, 0.0f});
-    std::unordered_map<Vector2, Vector2> came_from;
-    std::unordered_map<Vector2, float> cost_so_far;
-    came_from[start_cell] = start_cell;
-    cost_so_far[start_cell] = 0.0f;
-
-    // Heuristik: Manhattan-Distanz
-    auto heuristic = [](Vector2 a, Vector2 b) {
-        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
-    };
-
-    // Bewegungsrichtungen (8-Wege-Bewegung: horizontal, vertikal, diagonal)
-    Vector2 directions[8] = {
-        Vector2(1, 0), Vector2(-1, 0), Vector2(0, 1), Vector2(0, -1),
-        Vector2(1, 1), Vector2(1, -1), Vector2(-1, 1), Vector2(-1, -1)
-    };
-
-    // A*-Algorithmus
-    while (!frontier.empty()) {
-        Vector2 current = frontier.top().cell;
-        frontier.pop();
-
-        if (current == goal_cell) {
-            break;
+    const uint64_t *walls = avoid_walls ? wall_bits.ptr() : nullptr;
+    if (!is_cell_in_grid(start_cell) || !is_cell_in_grid(goal_cell)) {
+        last_path_expanded_count = 0;
+        return PackedVector2Array();
+    }
+    if (!avoid_walls) {
+        // Ohne Hindernisse ist die gerasterte Linie bereits ein kürzester Weg
+        GridAStar2D::straight_path(start_cell, goal_cell, path_cells);
+        last_path_expanded_count = 0;
+    } else if (hierarchical_pathfinding) {
+        // Lange Wege über die Clusterebene, kurze direkt auf dem Gitter
+        const bool found = hierarchy.solve(start_cell, goal_cell, walls, path_cells);
+        last_path_expanded_count = hierarchy.get_last_expanded_count();
+        if (!found) {
+            return PackedVector2Array();
         }
-
-        for (const auto& offset : directions) {
-            Vector2 next = current + offset;
-            // Prüfen, ob die Position außerhalb des Gitters liegt
-            if (next.x < 0 || next.y < 0 || next.x >= grid_size || next.y >= grid_size) {
-                continue;
-            }
-            // Prüfen, ob eine Wand im Weg ist
-            if (grid_occupancy.has(next)) {
-                Dictionary occ = grid_occupancy[next];
-                bool is_wall = occ.has("is_wall") ? bool(occ["is_wall"]) : false;
-                if (is_wall) {
-                    continue;
-                }
-            }
-            // Kosten berechnen (1 für gerade, 1.414 für diagonal)
-            float new_cost = cost_so_far[current] + (offset.length() == 1 ? 1.0f : 1.414f);
-            if (cost_so_far.find(next) == cost_so_far.end() || new_cost < cost_so_far[next]) {
-                cost_so_far[next] = new_cost;
-                float priority = new_cost + heuristic(next, goal_cell);
-                frontier.push({next, priority});
-                came_from[next] = current;
-            }
+    } else {
+        // A* mit wiederverwendeten Knotenpuffern und Octile-Heuristik
+        const bool found = astar.solve(grid_size, start_cell, goal_cell, walls, path_cells);
+        last_path_expanded_count = astar.get_last_expanded_count();
+        if (!found) {
+            return PackedVector2Array();
         }
     }
-
-    // Wenn kein Pfad gefunden wurde, leeres Array zurückgeben
-    if (came_from.find(goal_cell) == came_from.end()) {
-        return Array();
-    }
-
-    // Pfad rückwärts aufbauen
-    Array grid_path;
-    Vector2 current = goal_cell;
-    while (current != start_cell) {
-        grid_path.insert(0, current);
-        current = came_from[current];
+    if (waypoints) {
+        GridAStar2D::pull_string(grid_size, walls, path_cells);
     }
-    grid_path.insert(0, start_cell);
 
     // Pfad in Bildschirmkoordinaten umwandeln
-    Array screen_path;
-    for (const auto& cell : grid_path) {
-        screen_path.append(grid_to_screen(static_cast<Vector2>(cell) + Vector2(0.5, 0.5)));
+    PackedVector2Array screen_path;
+    screen_path.resize(path_cells.size());
+    Vector2 *screen_path_w = screen_path.ptrw();
+    for (uint32_t i = 0; i < path_cells.size(); i++) {
+        screen_path_w[i] = grid_to_screen(Vector2(path_cells[i]) + Vector2(0.5, 0.5));
     }
     return screen_path;
 }
 
-Array GridManager::smooth_path(Array path, int segments) {
+PackedVector2Array GridManager::get_simple_path_iso_avoid_walls(Vector2 start_pos, Vector2 end_pos) {
+    return _find_path(start_pos, end_pos, true);
+}
+
+Vector2 GridManager::sample_path_curve(const PackedVector2Array &path, int segment, float t) {
+    ERR_FAIL_COND_V(path.is_empty(), Vector2());
+    if (path.size() == 1) {
+        return path[0];
+    }
+    segment = CLAMP(segment, 0, path.size() - 2);
+    const Vector2 *path_r = path.ptr();
+
+    // Kontrollpunkte für die Spline-Berechnung
+    Vector2 p0 = (segment == 0) ? path_r[segment] : path_r[segment - 1];
+    Vector2 p1 = path_r[segment];
+    Vector2 p2 = path_r[segment + 1];
+    Vector2 p3 = (segment + 2 < path.size()) ? path_r[segment + 2] : p2;
+
+    // Punkt auf dem Catmull-Rom-Spline zwischen p1 (t = 0) und p2 (t = 1)
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * (
+        (2 * p1) +
+        (-p0 + p2) * t +
+        (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2 +
+        (-p0 + 3 * p1 - 3 * p2 + p3) * t3
+    );
+}
+
+PackedVector2Array GridManager::smooth_path(const PackedVector2Array &path, int segments) {
     // Wenn der Pfad zu kurz ist, unverändert zurückgeben
-    if (path.size() < 2) {
+    if (path.size() < 2 || segments < 1) {
         return path;
     }
 
-    Array smoothed;
+    PackedVector2Array smoothed;
+    smoothed.resize((path.size() - 1) * segments + 1);
+    Vector2 *smoothed_w = smoothed.ptrw();
+    int out = 0;
     for (int i = 0; i < path.size() - 1; i++) {
-        // Kontrollpunkte für die Spline-Berechnung
-        Vector2 p0 = (i == 0) ? (Vector2)path[i] : (Vector2)path[i - 1];
-        Vector2 p1 = (Vector2)path[i];
-        Vector2 p2 = (Vector2)path[i + 1];
-        Vector2 p3 = (i + 2 < path.size()) ? (Vector2)path[i + 2] : p2;
-
-        // Zwischenpunkte mit Catmull-Rom-Spline berechnen
         for (int j = 0; j < segments; j++) {
-            float t = j / static_cast<float>(segments);
-            float t2 = t * t;
-            float t3 = t2 * t;
-            Vector2 point = 0.5f * (
-                (2 * p1) +
-                (-p0 + p2) * t +
-                (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2 +
-                (-p0 + 3 * p1 - 3 * p2 + p3) * t3
-            );
-            smoothed.append(point);
+            smoothed_w[out++] = sample_path_curve(path, i, j / static_cast<float>(segments));
         }
     }
     // Letzten Punkt hinzufügen
-    smoothed.append(path[path.size() - 1]);
+    smoothed_w[out] = path[path.size() - 1];
     return smoothed;
 }
 
-Array GridManager::get_simple_path_iso_avoid_walls_smoothed(Vector2 start_pos, Vector2 end_pos) {
+PackedVector2Array GridManager::get_simple_path_iso_avoid_walls_smoothed(Vector2 start_pos, Vector2 end_pos) {
     // Einfachen Pfad berechnen
-    Array path = get_simple_path_iso_avoid_walls(start_pos, end_pos);
+    PackedVector2Array path = get_simple_path_iso_avoid_walls(start_pos, end_pos);
     if (path.size() < 2) {
         return path;
     }
@@ -593,7 +1312,47 @@ Array GridManager::get_simple_path_iso_avoid_walls_smoothed(Vector2 start_pos, V
     return smooth_path(path, 10);
 }
 
-Array GridManager::get_simple_path_through_wall(Vector2 start_pos, Vector2 end_pos, float max_detour) {
+PackedVector2Array GridManager::get_waypoint_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls) {
+    return _find_path(start_pos, end_pos, avoid_walls, true);
+}
+
+PackedVector2Array GridManager::simplify_path(const PackedVector2Array &path, bool avoid_walls) const {
+    if (path.size() < 3) {
+        return path;
+    }
+    LocalVector<Vector2i> cells;
+    cells.resize(path.size());
+    for (int i = 0; i < path.size(); i++) {
+        cells[i] = Vector2i(screen_to_grid(path[i]).floor());
+    }
+    GridAStar2D::pull_string(grid_size, avoid_walls ? wall_bits.ptr() : nullptr, cells);
+
+    PackedVector2Array simplified;
+    simplified.resize(cells.size());
+    Vector2 *simplified_w = simplified.ptrw();
+    for (uint32_t i = 0; i < cells.size(); i++) {
+        simplified_w[i] = grid_to_screen(Vector2(cells[i]) + Vector2(0.5, 0.5));
+    }
+    return simplified;
+}
+
+bool GridManager::has_line_of_sight(Vector2i from_cell, Vector2i to_cell) const {
+    if (!is_cell_in_grid(from_cell) || !is_cell_in_grid(to_cell)) {
+        return false;
+    }
+    return GridAStar2D::has_line_of_sight(grid_size, from_cell, to_cell, wall_bits.ptr());
+}
+
+float GridManager::get_path_cell_length(const PackedVector2Array &path) const {
+    // Länge in Zellen statt Punktanzahl, damit Eckpunkt- und abgetastete Pfade vergleichbar sind
+    float length = 0.0f;
+    for (int i = 1; i < path.size(); i++) {
+        length += screen_to_grid(path[i - 1]).distance_to(screen_to_grid(path[i]));
+    }
+    return length;
+}
+
+PackedVector2Array GridManager::get_simple_path_through_wall(Vector2 start_pos, Vector2 end_pos, float max_detour) {
     // Umwandeln in Gitterkoordinaten (Zellenpositionen)
     Vector2 start_grid = screen_to_grid(start_pos);
     Vector2 end_grid = screen_to_grid(end_pos);
@@ -602,19 +1361,19 @@ Array GridManager::get_simple_path_through_wall(Vector2 start_pos, Vector2 end_p
 
     // Falls Start und Ziel in derselben Zelle liegen
     if (start_cell == goal_cell) {
-        Array path;
-        path.append(grid_to_screen(start_cell + Vector2(0.5, 0.5)));
+        PackedVector2Array path;
+        path.push_back(grid_to_screen(start_cell + Vector2(0.5, 0.5)));
         return path;
     }
 
     // Versuche, einen Pfad zu finden, der Hindernisse umgeht.
-    Array path_around = get_simple_path_iso_avoid_walls(start_pos, end_pos);
+    PackedVector2Array path_around = get_simple_path_iso_avoid_walls(start_pos, end_pos);
     float cost_around = 0.0f;
     if (path_around.size() > 1) {
         // Summiere die Distanzen zwischen den aufeinanderfolgenden Punkten
         for (int i = 1; i < path_around.size(); i++) {
-            Vector2 p1 = (Vector2)path_around[i - 1];
-            Vector2 p2 = (Vector2)path_around[i];
+            Vector2 p1 = path_around[i - 1];
+            Vector2 p2 = path_around[i];
             cost_around += p1.distance_to(p2);
         }
     }
@@ -630,112 +1389,126 @@ Array GridManager::get_simple_path_through_wall(Vector2 start_pos, Vector2 end_p
         return path_around;
     } else {
         // Ansonsten: Ermittle den idealen Pfad, der Hindernisse ignoriert.
-        Array path_ignore = get_simple_path_iso_ignore_walls(start_pos, end_pos);
-        Array partial;
+        PackedVector2Array path_ignore = get_simple_path_iso_ignore_walls(start_pos, end_pos);
+        PackedVector2Array partial;
         // Durchlaufe den idealen Pfad, bis zur ersten Zelle, die belegt ist.
         for (int i = 0; i < path_ignore.size(); i++) {
-            Vector2 screen_point = (Vector2)path_ignore[i];
+            Vector2 screen_point = path_ignore[i];
             // Bestimme die zugehörige Gitterzelle (mittels Abschneiden der Nachkommastellen)
             Vector2 grid_pt = screen_to_grid(screen_point);
             grid_pt.x = floor(grid_pt.x);
             grid_pt.y = floor(grid_pt.y);
-            if (grid_occupancy.has(grid_pt)) {
-                Dictionary occ = grid_occupancy[grid_pt];
-                if (occ.has("obj")) { // Hindernis gefunden
-                    break;
-                }
+            if (is_cell_occupied(Vector2i(grid_pt))) { // Hindernis gefunden
+                break;
             }
-            partial.append(screen_point);
+            partial.push_back(screen_point);
         }
         return partial;
     }
 }
 
-Array GridManager::get_simple_path_iso_ignore_walls(Vector2 start_pos, Vector2 end_pos) {
-    // Umwandeln der Bildschirmkoordinaten in Gitterkoordinaten
-    Vector2 start_grid = screen_to_grid(start_pos);
-    Vector2 end_grid = screen_to_grid(end_pos);
-    Vector2 start_cell = Vector2(floor(start_grid.x), floor(start_grid.y));
-    Vector2 goal_cell = Vector2(floor(end_grid.x), floor(end_grid.y));
-
-    // Falls Start und Ziel identisch sind, leeren Pfad zurückgeben
-    if (start_cell == goal_cell) {
-        return Array();
-    }
-
-    // A*-Algorithmus initialisieren
-    std::priority_queue<AStarNode> frontier;
-    frontier.push({start_cell, 0.0f});
-    std::unordered_map<Vector2, Vector2> came_from;
-    std::unordered_map<Vector2, float> cost_so_far;
-    came_from[start_cell] = start_cell;
-    cost_so_far[start_cell] = 0.0f;
-
-    // Heuristik: Manhattan-Distanz
-    auto heuristic = [](Vector2 a, Vector2 b) {
-        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
-    };
-
-    // 8-Wege-Bewegung
-    Vector2 directions[8] = {
-        Vector2(1, 0), Vector2(-1, 0), Vector2(0, 1), Vector2(0, -1),
-        Vector2(1, 1), Vector2(1, -1), Vector2(-1, 1), Vector2(-1, -1)
-    };
+PackedVector2Array GridManager::get_simple_path_iso_ignore_walls(Vector2 start_pos, Vector2 end_pos) {
+    // Gleiche Suche, dabei werden keine Zellen als blockiert betrachtet
+    return _find_path(start_pos, end_pos, false);
+}
 
-    // A*-Algorithmus ausführen, dabei werden keine Zellen als blockiert betrachtet
-    while (!frontier.empty()) {
-        Vector2 current = frontier.top().cell;
-        frontier.pop();
+int GridManager::request_paths_batch(const PackedVector2Array &starts, const PackedVector2Array &goals, BitField<PathFlags> flags, const Callable &callback) {
+    ERR_FAIL_COND_V_MSG(starts.size() != goals.size(), -1, "starts und goals müssen gleich viele Punkte enthalten.");
+    WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
 
-        if (current == goal_cell) {
-            break;
+    if (path_batch_workers.is_empty()) {
+        // Index 0 ist für Aufrufe außerhalb des Pools reserviert (z. B. ohne Worker-Threads)
+        path_batch_workers.resize(pool->get_thread_count() + 1);
+        for (PathBatchWorker *&worker : path_batch_workers) {
+            worker = memnew(PathBatchWorker);
         }
+    }
 
-        for (const auto &offset : directions) {
-            Vector2 next = current + offset;
-            // Gittergrenzen prüfen
-            if (next.x < 0 || next.y < 0 || next.x >= grid_size || next.y >= grid_size) {
-                continue;
-            }
-            // Kosten berechnen (1 für horizontal/vertikal, ~1.414 für diagonal)
-            float new_cost = cost_so_far[current] + ((offset.length() == 1.0f) ? 1.0f : 1.414f);
-            if (cost_so_far.find(next) == cost_so_far.end() || new_cost < cost_so_far[next]) {
-                cost_so_far[next] = new_cost;
-                float priority = new_cost + heuristic(next, goal_cell);
-                frontier.push({next, priority});
-                came_from[next] = current;
-            }
-        }
+    PathBatch *batch = memnew(PathBatch);
+    batch->grid_size = grid_size;
+    batch->cell_size = cell_size;
+    batch->flags = flags;
+    if (flags.has_flag(PATH_FLAG_AVOID_WALLS)) {
+        batch->walls = wall_bits;
     }
+    batch->starts = starts;
+    batch->goals = goals;
+    batch->results.resize(starts.size());
+    batch->callback = callback;
+
+    const int batch_id = next_path_batch_id++;
+    path_batches[batch_id] = batch;
+    if (starts.size() > 0) {
+        batch->group_id = pool->add_template_group_task(this, &GridManager::_solve_path_batch_element, batch, starts.size(), -1, true, SNAME("GridManagerPathBatch"));
+    }
+    if (callback.is_valid()) {
+        set_process_internal(true);
+    }
+    return batch_id;
+}
 
-    // Falls kein Pfad gefunden wurde, leeres Array zurückgeben
-    if (came_from.find(goal_cell) == came_from.end()) {
-        return Array();
+void GridManager::_solve_path_batch_element(uint32_t p_index, PathBatch *p_batch) {
+    // Läuft auf einem Pool-Thread: nur den Schnappschuss im Batch lesen, nie den GridManager-Zustand
+    PathBatchWorker *worker = path_batch_workers[WorkerThreadPool::get_singleton()->get_thread_index() + 1];
+
+    const Vector2i start_cell = Vector2i(iso_screen_to_grid(p_batch->cell_size, p_batch->starts[p_index]).floor());
+    const Vector2i goal_cell = Vector2i(iso_screen_to_grid(p_batch->cell_size, p_batch->goals[p_index]).floor());
+    if (start_cell == goal_cell) {
+        return;
+    }
+    const uint64_t *walls = (p_batch->flags & PATH_FLAG_AVOID_WALLS) ? p_batch->walls.ptr() : nullptr;
+    if (!worker->astar.solve(p_batch->grid_size, start_cell, goal_cell, walls, worker->cells)) {
+        return;
+    }
+    if (p_batch->flags & PATH_FLAG_WAYPOINTS) {
+        GridAStar2D::pull_string(p_batch->grid_size, walls, worker->cells);
     }
 
-    // Pfad rückwärts rekonstruieren
-    Array grid_path;
-    Vector2 current = goal_cell;
-    while (current != start_cell) {
-        grid_path.insert(0, current);
-        current = came_from[current];
+    PackedVector2Array path;
+    path.resize(worker->cells.size());
+    Vector2 *path_w = path.ptrw();
+    for (uint32_t i = 0; i < worker->cells.size(); i++) {
+        path_w[i] = iso_grid_to_screen(p_batch->cell_size, Vector2(worker->cells[i]) + Vector2(0.5, 0.5));
     }
-    grid_path.insert(0, start_cell);
+    if (p_batch->flags & PATH_FLAG_SMOOTH) {
+        path = smooth_path(path, 10);
+    }
+    p_batch->results[p_index] = path;
+}
 
-    // Umwandeln der Gitterkoordinaten in Bildschirmkoordinaten (Zentrierung berücksichtigen)
-    Array screen_path;
-    for (int i = 0; i < grid_path.size(); i++) {
-        Vector2 cell = grid_path[i];
-        screen_path.append(grid_to_screen(cell + Vector2(0.5, 0.5)));
+Array GridManager::_finish_path_batch(int p_batch_id) {
+    PathBatch **batchp = path_batches.getptr(p_batch_id);
+    ERR_FAIL_NULL_V_MSG(batchp, Array(), vformat("Unbekannte Pfad-Sammelabfrage: %d.", p_batch_id));
+    PathBatch *batch = *batchp;
+    if (batch->group_id != -1) {
+        WorkerThreadPool::get_singleton()->wait_for_group_task_completion(batch->group_id);
     }
-    return screen_path;
+    Array results;
+    results.resize(batch->results.size());
+    for (uint32_t i = 0; i < batch->results.size(); i++) {
+        results[i] = batch->results[i];
+    }
+    path_batches.erase(p_batch_id);
+    memdelete(batch);
+    return results;
+}
+
+bool GridManager::is_paths_batch_completed(int batch_id) const {
+    PathBatch *const *batchp = path_batches.getptr(batch_id);
+    ERR_FAIL_NULL_V_MSG(batchp, false, vformat("Unbekannte Pfad-Sammelabfrage: %d.", batch_id));
+    return (*batchp)->group_id == -1 || WorkerThreadPool::get_singleton()->is_group_task_completed((*batchp)->group_id);
 }
 
-Array GridManager::get_direct_path(Vector2 start_pos, Vector2 end_pos, int segments) {
-    return Array(); // Platzhalter-Implementierung
+Array GridManager::get_paths_batch_result(int batch_id) {
+    // Blockiert, bis alle Pfade der Abfrage berechnet sind, und gibt die Abfrage frei
+    return _finish_path_batch(batch_id);
 }
 
-Array GridManager::get_natural_path_through_wall(Vector2 start_pos, Vector2 end_pos) {
+PackedVector2Array GridManager::get_direct_path(Vector2 start_pos, Vector2 end_pos, int segments) {
+    return PackedVector2Array(); // Platzhalter-Implementierung
+}
+
+PackedVector2Array GridManager::get_natural_path_through_wall(Vector2 start_pos, Vector2 end_pos) {
     // Bildschirmkoordinaten in Gitterkoordinaten umwandeln
     Vector2 start_grid = screen_to_grid(start_pos);
     Vector2 end_grid = screen_to_grid(end_pos);
@@ -744,36 +1517,33 @@ Array GridManager::get_natural_path_through_wall(Vector2 start_pos, Vector2 end_
 
     // Falls Start und Ziel in derselben Zelle liegen, direkten Mittelpunkt zurückgeben
     if (start_cell == end_cell) {
-        Array path;
-        path.append(grid_to_screen(start_cell + Vector2(0.5, 0.5)));
+        PackedVector2Array path;
+        path.push_back(grid_to_screen(start_cell + Vector2(0.5, 0.5)));
         return path;
     }
 
     // Zuerst Pfad ermitteln, der Hindernisse umgeht
-    Array avoid_path = get_simple_path_iso_avoid_walls(start_pos, end_pos);
+    PackedVector2Array avoid_path = get_simple_path_iso_avoid_walls(start_pos, end_pos);
     if (avoid_path.size() > 0) {
         // Glätten des Pfades für einen natürlicheren Verlauf
-        Array natural = smooth_path(avoid_path, 10);
+        PackedVector2Array natural = smooth_path(avoid_path, 10);
         return natural;
     } else {
         // Falls kein Umweichpfad gefunden wurde:
         // Ermittle den idealen Pfad, der Hindernisse ignoriert
-        Array ignore_path = get_simple_path_iso_ignore_walls(start_pos, end_pos);
-        Array partial;
+        PackedVector2Array ignore_path = get_simple_path_iso_ignore_walls(start_pos, end_pos);
+        PackedVector2Array partial;
         // Füge Punkte so lange hinzu, bis ein Hindernis erreicht wird
         for (int i = 0; i < ignore_path.size(); i++) {
-            Vector2 screen_point = (Vector2)ignore_path[i];
+            Vector2 screen_point = ignore_path[i];
             // Bestimme die zugehörige Gitterzelle (mittels Abschneiden der Nachkommastellen)
             Vector2 grid_pt = screen_to_grid(screen_point);
             grid_pt.x = floor(grid_pt.x);
             grid_pt.y = floor(grid_pt.y);
-            if (grid_occupancy.has(grid_pt)) {
-                Dictionary occ = grid_occupancy[grid_pt];
-                if (occ.has("obj")) { // Hindernis gefunden – Pfad abbrechen
-                    break;
-                }
+            if (is_cell_occupied(Vector2i(grid_pt))) { // Hindernis gefunden – Pfad abbrechen
+                break;
             }
-            partial.append(screen_point);
+            partial.push_back(screen_point);
         }
         // Glätten, falls ausreichend Punkte vorhanden sind
         if (partial.size() >= 2) {
@@ -784,7 +1554,25 @@ Array GridManager::get_natural_path_through_wall(Vector2 start_pos, Vector2 end_
 }
 
 Dictionary GridManager::get_grid_occupancy() const {
-    return grid_occupancy;
+    // Kompatibilitätsansicht: baut das frühere Dictionary-Format aus dem flachen Speicher auf.
+    // Änderungen an der zurückgegebenen Kopie wirken sich nicht auf die Belegung aus.
+    Dictionary occupancy;
+    for (int y = 0; y < grid_size; y++) {
+        for (int x = 0; x < grid_size; x++) {
+            const int idx = y * grid_size + x;
+            const uint8_t flags = cell_flags[idx];
+            if (!(flags & CELL_OCCUPIED)) {
+                continue;
+            }
+            Dictionary cell_info;
+            cell_info["obj"] = ObjectDB::get_instance(cell_objects[idx]);
+            cell_info["is_wall"] = bool(flags & CELL_WALL);
+            cell_info["destroyed"] = bool(flags & CELL_DESTROYED);
+            cell_info["position_in_grid"] = Vector2(cell_offsets[idx]);
+            occupancy[Vector2(x, y)] = cell_info;
+        }
+    }
+    return occupancy;
 }
 
 // Weitere Pfadfindungsmethoden können ähnlich implementiert werden (z. B. get_simple_path_iso, A*-basiert etc.).
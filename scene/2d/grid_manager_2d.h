@@ -2,9 +2,17 @@
 #define GRID_MANAGER_H
 
 #include "scene/2d/node_2d.h"
+#include "scene/2d/grid_astar_2d.h"
+#include "scene/2d/grid_flow_field_2d.h"
+#include "scene/2d/grid_hierarchy_2d.h"
 #include "core/variant/dictionary.h"
 #include "core/variant/array.h"
 #include "core/typedefs.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
+#include "core/templates/local_vector.h"
+#include "scene/resources/bit_map.h"
 #include "scene/resources/packed_scene.h"
 #include <cmath>
 
@@ -24,12 +32,160 @@ class GridManager : public Node2D {
     bool build_mode = false;              // Baumodus-Flag
     bool move_mode = false;               // Verschiebemodus-Flag
     Dictionary last_active_state;         // Gespeicherter Zustand
-    Dictionary grid_occupancy;            // Zellenbelegung
     Array last_path;                      // Letzter berechneter Pfad
     Vector2 last_path_init_point;         // Startpunkt des letzten Pfades
 
+public:
+    // Zustandsbits einer Zelle im flachen Belegungsspeicher
+    enum CellFlags : uint8_t {
+        CELL_OCCUPIED = 1 << 0,
+        CELL_WALL = 1 << 1,
+        CELL_DESTROYED = 1 << 2,
+    };
+
+    // Optionen für Sammel-Pfadabfragen
+    enum PathFlags {
+        PATH_FLAG_AVOID_WALLS = 1 << 0,
+        PATH_FLAG_SMOOTH = 1 << 1,
+        PATH_FLAG_WAYPOINTS = 1 << 2,     // Auf Eckpunkte in Sichtlinie reduzieren
+    };
+
+    // Auswahl der Kandidaten für find_nearest_target
+    enum TargetFilter {
+        TARGET_FILTER_BUILDINGS = 1 << 0,
+        TARGET_FILTER_WALLS = 1 << 1,
+    };
+
+    // Wie die Zeichenreihenfolge der Kinder nach dem Platzieren/Verschieben bestimmt wird
+    enum DepthSortMode {
+        DEPTH_SORT_ALL_CHILDREN,          // Z-Index aller Kinder neu berechnen (O(Kinder))
+        DEPTH_SORT_INCREMENTAL,           // Nur den Z-Index des geänderten Knotens setzen
+        DEPTH_SORT_Y_SORT,                // Y-Sortierung des Canvas, Z-Index bleibt 0
+    };
+
+    // Ein Eintrag pro platziertem Gebäude (auch Wände)
+    struct BuildingRecord {
+        ObjectID id;
+        Vector2i top_left;
+        int size = 1;
+        bool is_wall = false;
+        bool destroyed = false;
+    };
+
+    // Ergebnis einer Zielsuche für native Aufrufer
+    struct TargetHit {
+        ObjectID id;
+        Vector2 point;                    // Nächster Punkt auf dem Gebäuderand
+        float distance = 0.0f;
+        bool is_wall = false;
+    };
+
+private:
+    // Zellenbelegung als Struct-of-Arrays (grid_size * grid_size, Index = y * grid_size + x)
+    LocalVector<ObjectID> cell_objects;   // Belegendes Objekt pro Zelle
+    LocalVector<uint8_t> cell_flags;      // CellFlags pro Zelle
+    LocalVector<Vector2i> cell_offsets;   // Position der Zelle innerhalb ihres Gebäudes
+    LocalVector<uint64_t> wall_bits;      // Wand-Bitset für die Pfadsuche
+
+    void _resize_occupancy(int p_new_size);
+    void _occupy_cells(const Vector2i &p_top_left, int p_size, ObjectID p_id, bool p_is_wall);
+    void _release_cells(const BuildingRecord &p_record);
+    void _set_cells_destroyed(const BuildingRecord &p_record, bool p_destroyed);
+
+    // Spawnsperre als dilatierte Belegung: pro Zelle die Anzahl belegter Zellen in ihrer
+    // 3x3-Nachbarschaft. Ein Randstreifen von einer Zelle deckt auch Positionen direkt neben
+    // dem Gitter ab. Index = (y + 1) * (grid_size + 2) + (x + 1)
+    LocalVector<uint8_t> spawn_block_counts;
+    void _update_spawn_block(const Vector2i &p_cell, int p_delta);
+    void _rebuild_spawn_block();
+    bool _is_spawn_blocked(const Vector2i &p_cell) const;
+
+    // Gebäudeliste mit Zugriff über die ObjectID
+    LocalVector<BuildingRecord> buildings;
+    HashMap<ObjectID, uint32_t> building_indices;
+    void _add_building_record(ObjectID p_id, const Vector2i &p_top_left, int p_size, bool p_is_wall);
+    void _remove_building_record(ObjectID p_id);
+    void _free_building_node(Node2D *p_instance);
+
+    // Zeichenreihenfolge: der Z-Index eines Knotens hängt nur von seiner eigenen Y-Position ab,
+    // daher genügt es, den geänderten Knoten zu aktualisieren
+    DepthSortMode depth_sort_mode = DEPTH_SORT_INCREMENTAL;
+    void _update_depth(Node2D *p_node);
+    void _refresh_depth();
+
+    // Räumlicher Index: gleichmäßiges Raster aus Eimern mit je SPATIAL_BUCKET_CELLS^2 Zellen.
+    // Ein Gebäude liegt im Eimer seiner oberen linken Zelle, Abfragen erweitern den
+    // Suchbereich dafür um die größte Gebäudegröße nach oben links.
+    static const int SPATIAL_BUCKET_CELLS = 8;
+    int spatial_bucket_count = 0;         // Eimer pro Achse
+    int max_building_size = 1;
+    LocalVector<LocalVector<uint32_t>> spatial_buckets; // Indizes in buildings
+    int _get_spatial_bucket(const Vector2i &p_cell) const;
+    void _spatial_insert(uint32_t p_record);
+    void _spatial_erase(uint32_t p_record);
+    void _rebuild_spatial_index();
+
+    // Seit dem letzten Abgleich geänderte Zellen (von _occupy_cells/_release_cells gesammelt).
+    // _flush_dirty_cells repariert betroffene Flussfelder und sendet occupancy_changed.
+    LocalVector<Vector2i> dirty_cells;
+    void _flush_dirty_cells();
+
+    // Debug-Darstellung: Geometrie wird zwischengespeichert und nur nach Änderungen an Belegung,
+    // Gitter- oder Zellengröße neu aufgebaut. Das CanvasItem behält seine Zeichenbefehle ohnehin
+    // bis zum nächsten queue_redraw, daher wird nur dann neu gezeichnet.
+    PackedVector2Array grid_line_points;  // Endpunktpaare für einen einzigen draw_multiline-Aufruf
+    Vector<Point2> overlay_points;        // Je vier Ecken pro markierter Zelle
+    Vector<Color> overlay_colors;
+    Vector<int> overlay_indices;          // Zwei Dreiecke pro Zelle
+    bool grid_lines_dirty = true;
+    bool overlay_dirty = true;
+    void _rebuild_grid_lines();
+    void _rebuild_overlay();
+    void _queue_debug_redraw(bool p_grid_changed);
+    void _draw_debug();
+
+    // Flussfelder pro Zielzelle (LRU-Cache)
+    int flow_field_cache_size = 8;
+    int flow_field_max_distance = 0;      // Reichweite in Zellen, 0 = unbegrenzt
+    LocalVector<GridFlowField2D *> flow_fields;
+    uint64_t flow_field_tick = 0;
+
+    // Pfadsuche (Puffer werden zwischen Abfragen wiederverwendet)
+    GridAStar2D astar;
+    LocalVector<Vector2i> path_cells;
+    uint32_t last_path_expanded_count = 0;
+
+    // Optionale Clusterebene (HPA*) für wandvermeidende Suchen auf großen Karten
+    bool hierarchical_pathfinding = false;
+    int path_cluster_size = 16;
+    GridHierarchy2D hierarchy;
+    PackedVector2Array _find_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls, bool waypoints = false);
+
+    // Sammel-Pfadabfragen auf dem WorkerThreadPool
+    struct PathBatchWorker {
+        GridAStar2D astar;
+        LocalVector<Vector2i> cells;
+    };
+    struct PathBatch {
+        int grid_size = 0;                // Schnappschuss der Gittergröße
+        Vector2 cell_size;                // Schnappschuss der Zellengröße
+        uint32_t flags = 0;
+        LocalVector<uint64_t> walls;      // Schnappschuss der Wand-Bits (nur lesend)
+        PackedVector2Array starts;
+        PackedVector2Array goals;
+        LocalVector<PackedVector2Array> results;
+        WorkerThreadPool::GroupID group_id = -1;
+        Callable callback;
+    };
+    HashMap<int, PathBatch *> path_batches;
+    int next_path_batch_id = 1;
+    LocalVector<PathBatchWorker *> path_batch_workers; // Ein Löser pro Pool-Thread (+1 für den Aufrufer)
+    void _solve_path_batch_element(uint32_t p_index, PathBatch *p_batch);
+    Array _finish_path_batch(int p_batch_id);
+
 protected:
     static void _bind_methods();          // Methoden- und Eigenschaftsbindung
+    void _notification(int p_what);
 
 public:
     // Konstruktor/Destruktor
@@ -38,15 +194,19 @@ public:
 
     // Interne Hilfsfunktionen
     bool can_place_building(Vector2 top_left_cell, int building_size) const;
-    bool place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size);
+    bool place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size, bool is_wall = false);
     bool move_building(Node2D* building_instance, Vector2 new_top_left_cell, int building_size);
+    bool remove_building(Node2D* building_instance);
+    bool set_building_destroyed(Node2D* building_instance, bool destroyed = true);
     bool can_spawn_troop(Vector2 screen_pos) const;
+    PackedByteArray can_spawn_troops(const PackedVector2Array &screen_positions) const;
     bool spawn_troop(Vector2 screen_pos, Ref<PackedScene> troop_scene);
     void update_z_index();
+    void update_node_z_index(Node2D *node);
     void toggle_modes(Dictionary p_last_active_state);
 
     // API-Methoden
-    bool api_place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size);
+    bool api_place_building(Vector2 top_left_cell, Ref<PackedScene> building_scene, int building_size, bool is_wall = false);
     bool api_move_building(Node2D* building_instance, Vector2 new_top_left_cell, int building_size);
     bool api_spawn_troop(Vector2 screen_pos, Ref<PackedScene> troop_scene);
     void api_enable_build_mode();
@@ -61,15 +221,59 @@ public:
     Vector2 grid_to_screen(Vector2 grid_pos) const;
     Vector2 screen_to_grid(Vector2 screen_pos) const;
 
+    // Typisierter Zugriff auf die Zellenbelegung
+    _FORCE_INLINE_ bool is_cell_in_grid(const Vector2i &p_cell) const {
+        return p_cell.x >= 0 && p_cell.y >= 0 && p_cell.x < grid_size && p_cell.y < grid_size;
+    }
+    _FORCE_INLINE_ int cell_to_index(const Vector2i &p_cell) const { return p_cell.y * grid_size + p_cell.x; }
+    _FORCE_INLINE_ uint8_t get_cell_flags(const Vector2i &p_cell) const {
+        return is_cell_in_grid(p_cell) ? cell_flags[cell_to_index(p_cell)] : 0;
+    }
+    _FORCE_INLINE_ const LocalVector<uint64_t> &get_wall_bits() const { return wall_bits; }
+    bool is_cell_occupied(Vector2i cell) const;
+    bool is_wall_at(Vector2i cell) const;
+    bool is_cell_destroyed(Vector2i cell) const;
+    Node2D* get_occupant(Vector2i cell) const;
+    Vector2i get_occupant_offset(Vector2i cell) const;
+    Ref<BitMap> get_occupancy_bitmap() const;
+
+    // Gebäudeliste und räumliche Zielsuche
+    const BuildingRecord *get_building_record(ObjectID p_id) const;
+    int get_building_count() const;
+    // Prüfsumme über Gittergröße und alle Gebäudeeinträge (ohne ObjectIDs), für Lockstep-Vergleiche
+    uint64_t get_state_hash() const;
+    bool query_nearest_target(const Vector2 &p_position, float p_radius, BitField<TargetFilter> p_filter, TargetHit &r_hit) const;
+    Dictionary find_nearest_target(Vector2 position, float radius, BitField<TargetFilter> filter = TARGET_FILTER_BUILDINGS | TARGET_FILTER_WALLS) const;
+
+    // Flussfelder: gemeinsame Wegfindung vieler Einheiten zum selben Ziel
+    const GridFlowField2D *get_flow_field(const Vector2i &p_goal_cell, bool p_avoid_walls);
+    Vector2i get_flow_field_next_cell(Vector2i cell, Vector2i goal_cell, bool avoid_walls = true);
+    float get_flow_field_distance(Vector2i cell, Vector2i goal_cell, bool avoid_walls = true);
+    PackedVector2Array get_flow_field_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls = true);
+    void clear_flow_fields();
+
     // Pfadfindungsmethoden
-    Array get_simple_path(Vector2 start_pos, Vector2 end_pos);
-    Array get_simple_path_iso_avoid_walls(Vector2 start_pos, Vector2 end_pos);
-    Array get_simple_path_iso_ignore_walls(Vector2 start_pos, Vector2 end_pos);
-    Array smooth_path(Array path, int segments = 10);
-    Array get_simple_path_iso_avoid_walls_smoothed(Vector2 start_pos, Vector2 end_pos);
-    Array get_simple_path_through_wall(Vector2 start_pos, Vector2 end_pos, float max_detour);
-    Array get_direct_path(Vector2 start_pos, Vector2 end_pos, int segments = 10);
-    Array get_natural_path_through_wall(Vector2 start_pos, Vector2 end_pos);
+    PackedVector2Array get_simple_path(Vector2 start_pos, Vector2 end_pos);
+    PackedVector2Array get_simple_path_iso_avoid_walls(Vector2 start_pos, Vector2 end_pos);
+    PackedVector2Array get_simple_path_iso_ignore_walls(Vector2 start_pos, Vector2 end_pos);
+    PackedVector2Array smooth_path(const PackedVector2Array &path, int segments = 10);
+    PackedVector2Array get_simple_path_iso_avoid_walls_smoothed(Vector2 start_pos, Vector2 end_pos);
+    PackedVector2Array get_simple_path_through_wall(Vector2 start_pos, Vector2 end_pos, float max_detour);
+    PackedVector2Array get_direct_path(Vector2 start_pos, Vector2 end_pos, int segments = 10);
+    PackedVector2Array get_natural_path_through_wall(Vector2 start_pos, Vector2 end_pos);
+
+    // Eckpunkt-Pfade: A* mit anschließendem String Pulling über die Sichtlinie im Gitter.
+    // Kurven werden nicht vorab abgetastet, sondern bei Bedarf mit sample_path_curve ausgewertet.
+    PackedVector2Array get_waypoint_path(Vector2 start_pos, Vector2 end_pos, bool avoid_walls = true);
+    PackedVector2Array simplify_path(const PackedVector2Array &path, bool avoid_walls = true) const;
+    bool has_line_of_sight(Vector2i from_cell, Vector2i to_cell) const;
+    float get_path_cell_length(const PackedVector2Array &path) const;
+    static Vector2 sample_path_curve(const PackedVector2Array &path, int segment, float t);
+
+    // Sammel-Pfadabfragen (parallel auf dem WorkerThreadPool)
+    int request_paths_batch(const PackedVector2Array &starts, const PackedVector2Array &goals, BitField<PathFlags> flags = PATH_FLAG_AVOID_WALLS, const Callable &callback = Callable());
+    bool is_paths_batch_completed(int batch_id) const;
+    Array get_paths_batch_result(int batch_id);
 
     // Getter und Setter für Eigenschaften
     void set_cell_size(Vector2 size);
@@ -80,18 +284,27 @@ public:
     int get_min_z_index() const;
     void set_max_z_index(int index);
     int get_max_z_index() const;
+    void set_depth_sort_mode(DepthSortMode p_mode);
+    DepthSortMode get_depth_sort_mode() const;
     void set_grid_lines(bool enable);
     bool get_grid_lines() const;
     void set_show_occupied(bool enable);
     bool get_show_occupied() const;
+    void set_flow_field_cache_size(int size);
+    int get_flow_field_cache_size() const;
+    void set_flow_field_max_distance(int distance);
+    int get_flow_field_max_distance() const;
+    void set_hierarchical_pathfinding(bool enable);
+    bool is_hierarchical_pathfinding() const;
+    void set_path_cluster_size(int size);
+    int get_path_cluster_size() const;
+    int get_last_path_expanded_count() const;
     Dictionary get_grid_occupancy() const;
 
-    // Godot-Methoden
-    void _ready();
-
-    // Überladene Godot-Methoden
-    void _process(double delta);
-    void _draw();
 };
 
+VARIANT_BITFIELD_CAST(GridManager::PathFlags);
+VARIANT_BITFIELD_CAST(GridManager::TargetFilter);
+VARIANT_ENUM_CAST(GridManager::DepthSortMode);
+
 #endif // GRID_MANAGER_H
\ No newline at end of file
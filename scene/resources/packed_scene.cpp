@@ -164,6 +164,14 @@ Node *SceneState::instantiate(GenEditState p_edit_state) const {
 
 	LocalVector<DeferredNodePathProperties> deferred_node_paths;
 
+	const InstantiationPlan *plan = nullptr;
+	if (p_edit_state == GEN_EDIT_STATE_DISABLED && !Engine::get_singleton()->is_editor_hint()) {
+		plan = _get_instantiation_plan();
+		if (plan->types.size() != uint32_t(nc)) {
+			plan = nullptr;
+		}
+	}
+
 	for (int i = 0; i < nc; i++) {
 		const NodeData &n = nd[i];
 
@@ -307,11 +315,34 @@ Node *SceneState::instantiate(GenEditState p_edit_state) const {
 				Dictionary missing_resource_properties;
 				HashMap<Ref<Resource>, Ref<Resource>> resources_local_to_sub_scene; // Record the mappings in the sub-scene.
 
+				// Only valid if the node really is of the class the setters were resolved for.
+				const InstantiationPlan::Setter *setters = nullptr;
+				if (plan && !missing_node && node->get_class_name() == plan->types[i]) {
+					setters = &plan->setters[plan->first_setters[i]];
+				}
+
 				for (int j = 0; j < nprop_count; j++) {
 					bool valid;
 
 					ERR_FAIL_INDEX_V(nprops[j].value, prop_count, nullptr);
 
+					if (setters && setters[j].method && !node->get_script_instance()) {
+						// What Object::set() ends up doing through ClassDB::set_property().
+						Callable::CallError ce;
+						if (setters[j].index >= 0) {
+							const Variant index = setters[j].index;
+							const Variant *args[2] = { &index, &props[nprops[j].value] };
+							setters[j].method->call(node, args, 2, ce);
+						} else {
+							const Variant *args[1] = { &props[nprops[j].value] };
+							setters[j].method->call(node, args, 1, ce);
+						}
+						if (ce.error == Callable::CallError::CALL_OK) {
+							continue;
+						}
+						// Let Object::set() deal with values the setter rejected, e.g. ones that need a conversion.
+					}
+
 					if (nprops[j].name & FLAG_PATH_PROPERTY_IS_NODE) {
 						if (!Engine::get_singleton()->is_editor_hint() && node->get_scene_instance_load_placeholder()) {
 							// We cannot know if the referenced nodes exist yet, so instead of deferring, we write the NodePaths directly.
@@ -628,6 +659,69 @@ Node *SceneState::instantiate(GenEditState p_edit_state) const {
 	return ret_nodes[0];
 }
 
+const SceneState::InstantiationPlan *SceneState::_get_instantiation_plan() const {
+	if (instantiation_plan_ready.is_set()) {
+		return &instantiation_plan;
+	}
+
+	MutexLock lock(instantiation_plan_mutex);
+	if (instantiation_plan_ready.is_set()) {
+		return &instantiation_plan;
+	}
+
+	const int node_count = nodes.size();
+	instantiation_plan.types.resize(node_count);
+	instantiation_plan.first_setters.resize(node_count);
+	instantiation_plan.setters.clear();
+
+	for (int i = 0; i < node_count; i++) {
+		const NodeData &n = nodes[i];
+		instantiation_plan.first_setters[i] = instantiation_plan.setters.size();
+		instantiation_plan.setters.resize(instantiation_plan.setters.size() + n.properties.size());
+		instantiation_plan.types[i] = StringName();
+
+		// The class of instances is up to their scenes, and the root of an inherited scene gets its values duplicated.
+		if (n.instance >= 0 || n.type == TYPE_INSTANTIATED || (i == 0 && base_scene_idx >= 0) || n.type < 0 || n.type >= names.size()) {
+			continue;
+		}
+		// Extensions may take over setting properties before ClassDB gets to it.
+		const StringName &type = names[n.type];
+		const ClassDB::APIType api = ClassDB::get_api_type(type);
+		if (api != ClassDB::API_CORE && api != ClassDB::API_EDITOR) {
+			continue;
+		}
+		instantiation_plan.types[i] = type;
+
+		InstantiationPlan::Setter *setters = &instantiation_plan.setters[instantiation_plan.first_setters[i]];
+		for (int j = 0; j < n.properties.size(); j++) {
+			const NodeData::Property &property = n.properties[j];
+			if ((property.name & FLAG_PATH_PROPERTY_IS_NODE) || property.name < 0 || property.name >= names.size() || property.value < 0 || property.value >= variants.size()) {
+				continue;
+			}
+			// Objects, arrays and dictionaries may need to be made local to the scene or retyped first.
+			const Variant::Type value_type = variants[property.value].get_type();
+			if (value_type == Variant::OBJECT || value_type == Variant::ARRAY || value_type == Variant::DICTIONARY) {
+				continue;
+			}
+			if (names[property.name] == CoreStringName(script)) {
+				continue;
+			}
+			setters[j].method = ClassDB::get_property_setter_method(type, names[property.name], &setters[j].index);
+		}
+	}
+
+	instantiation_plan_ready.set();
+	return &instantiation_plan;
+}
+
+void SceneState::_clear_instantiation_plan() {
+	MutexLock lock(instantiation_plan_mutex);
+	instantiation_plan_ready.clear();
+	instantiation_plan.types.clear();
+	instantiation_plan.first_setters.clear();
+	instantiation_plan.setters.clear();
+}
+
 Variant SceneState::make_local_resource(Variant &p_value, const SceneState::NodeData &p_node_data, HashMap<Ref<Resource>, Ref<Resource>> &p_resources_local_to_sub_scene, Node *p_node, const StringName p_sname, HashMap<Ref<Resource>, Ref<Resource>> &p_resources_local_to_scene, int p_i, Node **p_ret_nodes, SceneState::GenEditState p_edit_state) const {
 	Ref<Resource> res = p_value;
 	if (res.is_null() || !res->is_local_to_scene()) {
@@ -1306,6 +1400,7 @@ String SceneState::get_path() const {
 }
 
 void SceneState::clear() {
+	_clear_instantiation_plan();
 	names.clear();
 	variants.clear();
 	nodes.clear();
@@ -1504,6 +1599,8 @@ void SceneState::set_bundled_scene(const Dictionary &p_dictionary) {
 
 	ERR_FAIL_COND_MSG(version > PACKED_SCENE_VERSION, "Save format version too new.");
 
+	_clear_instantiation_plan();
+
 	const int node_count = p_dictionary["node_count"];
 	const Vector<int> snodes = p_dictionary["nodes"];
 	ERR_FAIL_COND(snodes.size() < node_count);
@@ -1988,6 +2085,7 @@ int SceneState::add_node(int p_parent, int p_owner, int p_type, int p_name, int
 	nd.instance = p_instance;
 	nd.index = p_index;
 
+	_clear_instantiation_plan();
 	nodes.push_back(nd);
 
 	return nodes.size() - 1;
@@ -2004,6 +2102,7 @@ void SceneState::add_node_property(int p_node, int p_name, int p_value, bool p_d
 		prop.name |= FLAG_PATH_PROPERTY_IS_NODE;
 	}
 	prop.value = p_value;
+	_clear_instantiation_plan();
 	nodes.write[p_node].properties.push_back(prop);
 }
 
@@ -2015,6 +2114,7 @@ void SceneState::add_node_group(int p_node, int p_group) {
 
 void SceneState::set_base_scene(int p_idx) {
 	ERR_FAIL_INDEX(p_idx, variants.size());
+	_clear_instantiation_plan();
 	base_scene_idx = p_idx;
 }
 
@@ -89,6 +89,28 @@ class SceneState : public RefCounted {
 
 	Vector<ConnectionData> connections;
 
+	// What instantiating at runtime resolves the same way every time, resolved once: the bound
+	// setter of each plain (not object, array, dictionary nor node path) property of the nodes
+	// created from a class, so setting it skips Object::set() and the ClassDB lookups.
+	// Built on first use, dropped whenever the nodes change.
+	struct InstantiationPlan {
+		struct Setter {
+			MethodBind *method = nullptr; // nullptr if the property goes through Object::set().
+			int index = -1;
+		};
+
+		LocalVector<StringName> types; // Per node, the class the setters are for (empty if not created from a class).
+		LocalVector<uint32_t> first_setters; // Per node, its first entry in setters.
+		LocalVector<Setter> setters; // One per node property, in order.
+	};
+
+	mutable InstantiationPlan instantiation_plan;
+	mutable SafeFlag instantiation_plan_ready;
+	mutable BinaryMutex instantiation_plan_mutex;
+
+	const InstantiationPlan *_get_instantiation_plan() const;
+	void _clear_instantiation_plan();
+
 	Error _parse_node(Node *p_owner, Node *p_node, int p_parent_idx, HashMap<StringName, int> &name_map, HashMap<Variant, int, VariantHasher, VariantComparator> &variant_map, HashMap<Node *, int> &node_map, HashMap<Node *, int> &nodepath_map);
 	Error _parse_connections(Node *p_owner, Node *p_node, HashMap<StringName, int> &name_map, HashMap<Variant, int, VariantHasher, VariantComparator> &variant_map, HashMap<Node *, int> &node_map, HashMap<Node *, int> &nodepath_map);
 
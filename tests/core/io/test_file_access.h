@@ -199,6 +199,97 @@ TEST_CASE("[FileAccess] Get/Store floating point half precision values") {
 	}
 }
 
+TEST_CASE("[FileAccess] Memory-mapped reads") {
+	const String file_path = TestUtils::get_temp_path("file_access_mapped.bin");
+	Vector<uint8_t> data;
+	data.resize(10000);
+	for (int i = 0; i < data.size(); i++) {
+		data.write[i] = i % 251;
+	}
+	{
+		Ref<FileAccess> fw = FileAccess::open(file_path, FileAccess::WRITE);
+		REQUIRE(fw.is_valid());
+		fw->store_buffer(data);
+	}
+
+	Ref<FileAccess> f = FileAccess::open_mapped(file_path);
+	REQUIRE(f.is_valid());
+	CHECK(f->get_length() == uint64_t(data.size()));
+
+	// Regular reads work whether or not the platform maps the file.
+	f->seek(100);
+	CHECK(f->get_8() == 100);
+	CHECK(f->get_position() == 101);
+	CHECK_FALSE(f->eof_reached());
+	CHECK(f->get_buffer(data.size() - 101) == data.slice(101));
+	CHECK_FALSE(f->eof_reached());
+	CHECK(f->get_buffer(1).is_empty());
+	CHECK(f->eof_reached());
+
+	if (f->get_mapped_data()) {
+		CHECK(memcmp(f->get_mapped_data(), data.ptr(), data.size()) == 0);
+
+		f->seek(500);
+		const uint8_t *span = f->get_buffer_span(1000);
+		REQUIRE(span != nullptr);
+		CHECK(span == f->get_mapped_data() + 500);
+		CHECK(f->get_position() == 1500);
+		f->advise(FileAccess::MAP_ADVICE_SEQUENTIAL, 500, 1000);
+
+		// Spans past the end fail without moving.
+		CHECK(f->get_buffer_span(data.size()) == nullptr);
+		CHECK(f->get_position() == 1500);
+		f->seek_end();
+		CHECK(f->get_buffer_span(0) != nullptr);
+		CHECK(f->get_buffer_span(1) == nullptr);
+	} else {
+		CHECK(f->get_buffer_span(1) == nullptr);
+	}
+	// Only pinned mappings outlive the file.
+	f->seek(0);
+	CHECK(f->get_pinned_span(1) == nullptr);
+	CHECK_FALSE(f->make_mapping_writable(0, 1));
+
+	f->close();
+	DirAccess::remove_file_or_error(file_path);
+}
+
+TEST_CASE("[FileAccess] Pinned mappings") {
+	const String file_path = TestUtils::get_temp_path("file_access_pinned.bin");
+	{
+		Ref<FileAccess> fw = FileAccess::open(file_path, FileAccess::WRITE);
+		REQUIRE(fw.is_valid());
+		fw->store_buffer(Vector<uint8_t>({ 1, 2, 3, 4 }));
+	}
+
+	Ref<FileAccess> f = FileAccess::open_mapped(file_path);
+	REQUIRE(f.is_valid());
+	CHECK(f->get_pinned_span(1) == nullptr);
+	if (!f->pin_mapping()) {
+		CHECK_FALSE(f->is_mapping_pinned());
+		f->close();
+		DirAccess::remove_file_or_error(file_path);
+		return;
+	}
+	CHECK(f->is_mapping_pinned());
+	CHECK_FALSE(f->make_mapping_writable(2, 3));
+
+	f->seek(1);
+	uint8_t *span = f->get_pinned_span(2);
+	REQUIRE(span != nullptr);
+	CHECK(f->get_position() == 3);
+	CHECK(span[0] == 2);
+
+	// Writes stay in memory and outlive the file.
+	REQUIRE(f->make_mapping_writable(1, 1));
+	span[0] = 20;
+	f->close();
+	CHECK(span[0] == 20);
+	CHECK(FileAccess::get_file_as_bytes(file_path) == Vector<uint8_t>({ 1, 2, 3, 4 }));
+
+	DirAccess::remove_file_or_error(file_path);
+}
+
 } // namespace TestFileAccess
 
 #endif // TEST_FILE_ACCESS_H
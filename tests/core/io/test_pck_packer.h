@@ -33,6 +33,9 @@
 
 #include "core/io/file_access_pack.h"
 #include "core/io/pck_packer.h"
+#include "core/io/resource_loader.h"
+#include "core/io/resource_saver.h"
+#include "core/math/random_pcg.h"
 #include "core/os/os.h"
 
 #include "tests/test_utils.h"
@@ -62,6 +65,10 @@ TEST_CASE("[PCKPacker] Pack an empty PCK file") {
 	CHECK_MESSAGE(
 			f->get_length() <= 500,
 			"The generated empty PCK file shouldn't be too large.");
+	f->seek(4);
+	CHECK_MESSAGE(
+			f->get_32() == PACK_FORMAT_VERSION_MIN,
+			"A PCK file without compressed files should keep the older format version.");
 }
 
 TEST_CASE("[PCKPacker] Pack empty with zero alignment invalid") {
@@ -117,6 +124,107 @@ TEST_CASE("[PCKPacker] Pack a PCK file with some files and directories") {
 			f->get_length() <= 27000,
 			"The generated non-empty PCK file shouldn't be too large.");
 }
+
+TEST_CASE("[PCKPacker] Pack and read compressed files") {
+	// Several similar files spanning a few compression blocks, so they share a dictionary.
+	Vector<Vector<uint8_t>> contents;
+	for (int i = 0; i < 10; i++) {
+		String text;
+		for (int j = 0; j < 4000; j++) {
+			text += vformat("[node name=\"Node%d\" type=\"Node2D\" parent=\"Root%d\"]\n", j, i);
+		}
+		contents.push_back(text.to_utf8_buffer());
+	}
+	// And one that doesn't compress at all.
+	Vector<uint8_t> noise;
+	noise.resize(100000);
+	RandomPCG rng(1234);
+	for (int i = 0; i < noise.size(); i++) {
+		noise.write[i] = rng.rand() & 0xff;
+	}
+	contents.push_back(noise);
+
+	PCKPacker pck_packer;
+	const String output_pck_path = TestUtils::get_temp_path("output_compressed.pck");
+	REQUIRE(pck_packer.pck_start(output_pck_path) == OK);
+	pck_packer.set_compression_enabled(true);
+	pck_packer.set_compression_dictionaries_enabled(true);
+
+	uint64_t total_size = 0;
+	for (int i = 0; i < contents.size(); i++) {
+		const String source_path = TestUtils::get_temp_path(vformat("compressed_source_%d.tscn", i));
+		Ref<FileAccess> fw = FileAccess::open(source_path, FileAccess::WRITE);
+		REQUIRE(fw.is_valid());
+		fw->store_buffer(contents[i]);
+		fw.unref();
+		total_size += contents[i].size();
+		CHECK(pck_packer.add_file(vformat("pck_packer_compressed/file_%d.tscn", i), source_path) == OK);
+	}
+	REQUIRE(pck_packer.flush() == OK);
+
+	Ref<FileAccess> pck = FileAccess::open(output_pck_path, FileAccess::READ);
+	CHECK_MESSAGE(
+			pck->get_length() < total_size / 2,
+			"The compressed PCK file should be much smaller than its contents.");
+	pck->seek(4);
+	CHECK(pck->get_32() == PACK_FORMAT_VERSION);
+	pck.unref();
+
+	REQUIRE(PackedData::get_singleton()->add_pack(output_pck_path, true, 0) == OK);
+	for (int i = 0; i < contents.size(); i++) {
+		Ref<FileAccess> f = FileAccess::open(vformat("res://pck_packer_compressed/file_%d.tscn", i), FileAccess::READ);
+		REQUIRE(f.is_valid());
+		CHECK(f->get_length() == uint64_t(contents[i].size()));
+		CHECK_MESSAGE(f->get_buffer(contents[i].size()) == contents[i], "Compressed files should read back unchanged.");
+		CHECK_FALSE(f->eof_reached());
+		CHECK(f->get_buffer(1).is_empty());
+		CHECK(f->eof_reached());
+
+		// Seeking across blocks, both ways.
+		f->seek(70000);
+		CHECK(f->get_8() == contents[i][70000]);
+		f->seek(10);
+		CHECK(f->get_buffer(100) == contents[i].slice(10, 110));
+	}
+}
+
+TEST_CASE("[PCKPacker] Load packed arrays of binary resources from a pack") {
+	Ref<Resource> resource = memnew(Resource);
+	PackedFloat32Array floats;
+	// Large enough to be loaded as a view into the pack.
+	for (int i = 0; i < 8192; i++) {
+		floats.push_back(i * 0.5);
+	}
+	resource->set_meta("floats", floats);
+	resource->set_meta("bytes", PackedByteArray({ 1, 2, 3 }));
+	const String source_path = TestUtils::get_temp_path("pck_packer_arrays.res");
+	REQUIRE(ResourceSaver::save(resource, source_path) == OK);
+
+	PCKPacker pck_packer;
+	const String output_pck_path = TestUtils::get_temp_path("output_arrays.pck");
+	REQUIRE(pck_packer.pck_start(output_pck_path) == OK);
+	CHECK(pck_packer.add_file("pck_packer_arrays/arrays.res", source_path) == OK);
+	REQUIRE(pck_packer.flush() == OK);
+	REQUIRE(PackedData::get_singleton()->add_pack(output_pck_path, true, 0) == OK);
+
+	// The floats may point into the mapping of the pack, whose data stays read-only; writing copies
+	// them first.
+	Ref<Resource> loaded = ResourceLoader::load("res://pck_packer_arrays/arrays.res", "", ResourceFormatLoader::CACHE_MODE_IGNORE);
+	REQUIRE(loaded.is_valid());
+	PackedFloat32Array loaded_floats = loaded->get_meta("floats");
+	CHECK(loaded_floats == floats);
+	CHECK(PackedByteArray(loaded->get_meta("bytes")) == PackedByteArray({ 1, 2, 3 }));
+	PackedFloat32Array copy = loaded_floats;
+	copy.set(1, 42);
+	copy.push_back(1);
+	loaded_floats.clear();
+	CHECK(copy[1] == 42);
+
+	Ref<Resource> reloaded = ResourceLoader::load("res://pck_packer_arrays/arrays.res", "", ResourceFormatLoader::CACHE_MODE_IGNORE);
+	REQUIRE(reloaded.is_valid());
+	CHECK(PackedFloat32Array(reloaded->get_meta("floats")) == floats);
+}
+
 } // namespace TestPCKPacker
 
 #endif // TEST_PCK_PACKER_H
@@ -34,6 +34,7 @@
 #include "core/io/resource.h"
 #include "core/io/resource_loader.h"
 #include "core/io/resource_saver.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/os/os.h"
 
 #include "thirdparty/doctest/doctest.h"
@@ -112,6 +113,63 @@ TEST_CASE("[Resource] Saving and loading") {
 			"The loaded child resource name should be equal to the expected value.");
 }
 
+TEST_CASE("[Resource] Saving and loading packed arrays in binary resources") {
+	Ref<Resource> resource = memnew(Resource);
+	// Odd sizes, so the blobs following each array start unaligned.
+	resource->set_meta("bytes", PackedByteArray({ 1, 2, 3 }));
+	resource->set_meta("int32s", PackedInt32Array({ -1, 2, INT32_MAX }));
+	resource->set_meta("int64s", PackedInt64Array({ INT64_MIN, 0, 5 }));
+	resource->set_meta("float32s", PackedFloat32Array({ 0.5, -1.25, 3 }));
+	resource->set_meta("float64s", PackedFloat64Array({ 1e300, -0.125 }));
+	resource->set_meta("vector2s", PackedVector2Array({ Vector2(1, 2), Vector2(-3, 4) }));
+	resource->set_meta("vector3s", PackedVector3Array({ Vector3(1, 2, 3) }));
+	resource->set_meta("vector4s", PackedVector4Array({ Vector4(1, 2, 3, 4), Vector4() }));
+	resource->set_meta("colors", PackedColorArray({ Color(0.1, 0.2, 0.3, 0.4) }));
+	resource->set_meta("empty", PackedFloat32Array());
+	resource->set_meta("after", "still readable");
+	const String save_path = TestUtils::get_temp_path("packed_arrays.res");
+	REQUIRE(ResourceSaver::save(resource, save_path) == OK);
+
+	Ref<Resource> loaded = ResourceLoader::load(save_path, "", ResourceFormatLoader::CACHE_MODE_IGNORE);
+	REQUIRE(loaded.is_valid());
+	List<StringName> names;
+	resource->get_meta_list(&names);
+	for (const StringName &name : names) {
+		CHECK_MESSAGE(loaded->get_meta(name) == resource->get_meta(name), vformat("Metadata '%s' should survive the round trip.", name));
+	}
+
+	// Loaded arrays behave like any other; writing to one doesn't affect other loads.
+	PackedFloat32Array floats = loaded->get_meta("float32s");
+	floats.set(0, 42);
+	Ref<Resource> reloaded = ResourceLoader::load(save_path, "", ResourceFormatLoader::CACHE_MODE_IGNORE);
+	CHECK(PackedFloat32Array(reloaded->get_meta("float32s"))[0] == 0.5);
+
+	// Big-endian files store the elements one by one after the blob header.
+	const String big_endian_path = TestUtils::get_temp_path("packed_arrays_big_endian.res");
+	REQUIRE(ResourceSaver::save(resource, big_endian_path, ResourceSaver::FLAG_SAVE_BIG_ENDIAN) == OK);
+	Ref<Resource> big_endian = ResourceLoader::load(big_endian_path, "", ResourceFormatLoader::CACHE_MODE_IGNORE);
+	REQUIRE(big_endian.is_valid());
+	for (const StringName &name : names) {
+		CHECK_MESSAGE(big_endian->get_meta(name) == resource->get_meta(name), vformat("Metadata '%s' should survive the big-endian round trip.", name));
+	}
+
+	// Only files with packed arrays need the newer format version; the others still load in older
+	// versions.
+	Ref<FileAccess> f = FileAccess::open(save_path, FileAccess::READ);
+	REQUIRE(f.is_valid());
+	f->seek(20);
+	CHECK(f->get_32() == 7);
+
+	Ref<Resource> plain = memnew(Resource);
+	plain->set_meta("after", "still readable");
+	const String plain_path = TestUtils::get_temp_path("no_packed_arrays.res");
+	REQUIRE(ResourceSaver::save(plain, plain_path) == OK);
+	f = FileAccess::open(plain_path, FileAccess::READ);
+	REQUIRE(f.is_valid());
+	f->seek(20);
+	CHECK(f->get_32() == 6);
+}
+
 TEST_CASE("[Resource] Breaking circular references on save") {
 	Ref<Resource> resource_a = memnew(Resource);
 	resource_a->set_name("A");
@@ -166,6 +224,124 @@ TEST_CASE("[Resource] Breaking circular references on save") {
 	// Break circular reference to avoid memory leak
 	resource_c->remove_meta("next");
 }
+
+TEST_CASE("[Resource] Threaded loading of a dependency graph") {
+	// A diamond over a chain: root -> (left, right) -> middle -> leaf, in both formats.
+	const String leaf_path = TestUtils::get_temp_path("threaded_leaf.res");
+	const String middle_path = TestUtils::get_temp_path("threaded_middle.tres");
+	const String left_path = TestUtils::get_temp_path("threaded_left.res");
+	const String right_path = TestUtils::get_temp_path("threaded_right.tres");
+	const String root_path = TestUtils::get_temp_path("threaded_root.tres");
+	{
+		Ref<Resource> leaf = memnew(Resource);
+		leaf->set_name("Leaf");
+		REQUIRE(ResourceSaver::save(leaf, leaf_path, ResourceSaver::FLAG_CHANGE_PATH) == OK);
+		Ref<Resource> middle = memnew(Resource);
+		middle->set_name("Middle");
+		middle->set_meta("next", leaf);
+		REQUIRE(ResourceSaver::save(middle, middle_path, ResourceSaver::FLAG_CHANGE_PATH) == OK);
+		Ref<Resource> left = memnew(Resource);
+		left->set_name("Left");
+		left->set_meta("next", middle);
+		REQUIRE(ResourceSaver::save(left, left_path, ResourceSaver::FLAG_CHANGE_PATH) == OK);
+		Ref<Resource> right = memnew(Resource);
+		right->set_name("Right");
+		right->set_meta("next", middle);
+		REQUIRE(ResourceSaver::save(right, right_path, ResourceSaver::FLAG_CHANGE_PATH) == OK);
+		Ref<Resource> root = memnew(Resource);
+		root->set_name("Root");
+		root->set_meta("left", left);
+		root->set_meta("right", right);
+		REQUIRE(ResourceSaver::save(root, root_path) == OK);
+	}
+	REQUIRE_FALSE(ResourceCache::has(leaf_path));
+
+	REQUIRE(ResourceLoader::load_threaded_request(root_path, "", true) == OK);
+	Error error = FAILED;
+	const Ref<Resource> root = ResourceLoader::load_threaded_get(root_path, &error);
+	CHECK(error == OK);
+	REQUIRE(root.is_valid());
+	CHECK(root->get_name() == "Root");
+
+	const Ref<Resource> left = root->get_meta("left");
+	const Ref<Resource> right = root->get_meta("right");
+	REQUIRE(left.is_valid());
+	REQUIRE(right.is_valid());
+	CHECK(left->get_path() == left_path);
+	CHECK(right->get_path() == right_path);
+	const Ref<Resource> middle = left->get_meta("next");
+	REQUIRE(middle.is_valid());
+	CHECK_MESSAGE(
+			Ref<Resource>(right->get_meta("next")) == middle,
+			"Dependencies shared in the graph should be loaded once.");
+	const Ref<Resource> leaf = middle->get_meta("next");
+	REQUIRE(leaf.is_valid());
+	CHECK(leaf->get_name() == "Leaf");
+	CHECK(ResourceCache::get_ref(leaf_path) == leaf);
+}
+
+// The root depends on the leaf, but only loads it once the leaf started loading by itself.
+class PrefetchTestLoader : public ResourceFormatLoader {
+public:
+	String root_path;
+	String leaf_path;
+	SafeFlag leaf_started;
+	bool leaf_started_before_root = false;
+
+	virtual Ref<Resource> load(const String &p_path, const String &p_original_path, Error *r_error, bool p_use_sub_threads, float *r_progress, CacheMode p_cache_mode) override {
+		Ref<Resource> resource = memnew(Resource);
+		if (p_path == leaf_path) {
+			leaf_started.set();
+		} else {
+			for (int i = 0; i < 5000 && !leaf_started.is_set(); i++) {
+				OS::get_singleton()->delay_usec(1000);
+			}
+			leaf_started_before_root = leaf_started.is_set();
+			resource->set_meta("next", ResourceLoader::load(leaf_path));
+		}
+		if (r_error) {
+			*r_error = OK;
+		}
+		return resource;
+	}
+	virtual void get_recognized_extensions(List<String> *p_extensions) const override {
+		p_extensions->push_back("prefetchtest");
+	}
+	virtual bool handles_type(const String &p_type) const override {
+		return p_type == "Resource";
+	}
+	virtual String get_resource_type(const String &p_path) const override {
+		return p_path.get_extension() == "prefetchtest" ? "Resource" : "";
+	}
+	virtual void get_dependencies(const String &p_path, List<String> *p_dependencies, bool p_add_types) override {
+		if (p_path == root_path) {
+			p_dependencies->push_back(leaf_path + "::Resource");
+		}
+	}
+};
+
+TEST_CASE("[Resource] Threaded loading starts dependencies ahead of their dependents") {
+	if (WorkerThreadPool::get_singleton()->get_thread_count() < 2) {
+		return; // The root would keep the only thread busy.
+	}
+
+	Ref<PrefetchTestLoader> loader = memnew(PrefetchTestLoader);
+	loader->root_path = TestUtils::get_temp_path("prefetch_root.prefetchtest");
+	loader->leaf_path = TestUtils::get_temp_path("prefetch_leaf.prefetchtest");
+	for (const String &path : { loader->root_path, loader->leaf_path }) {
+		Ref<FileAccess> f = FileAccess::open(path, FileAccess::WRITE);
+		REQUIRE(f.is_valid());
+	}
+	ResourceLoader::add_resource_format_loader(loader, true);
+
+	REQUIRE(ResourceLoader::load_threaded_request(loader->root_path, "", true) == OK);
+	const Ref<Resource> root = ResourceLoader::load_threaded_get(loader->root_path);
+	ResourceLoader::remove_resource_format_loader(loader);
+
+	REQUIRE(root.is_valid());
+	CHECK(Ref<Resource>(root->get_meta("next")).is_valid());
+	CHECK_MESSAGE(loader->leaf_started_before_root, "The leaf should have been started before the root got to it.");
+}
 } // namespace TestResource
 
 #endif // TEST_RESOURCE_H
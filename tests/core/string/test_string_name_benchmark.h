@@ -0,0 +1,150 @@
+/**************************************************************************/
+/*  test_string_name_benchmark.h                                          */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_STRING_NAME_BENCHMARK_H
+#define TEST_STRING_NAME_BENCHMARK_H
+
+#include "core/io/dir_access.h"
+#include "core/io/resource.h"
+#include "core/io/resource_loader.h"
+#include "core/io/resource_saver.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/string/string_name.h"
+
+#include "tests/test_benchmark.h"
+#include "tests/test_macros.h"
+#include "tests/test_utils.h"
+
+namespace TestStringNameBenchmark {
+
+// Each thread repeatedly turns the same set of Strings into StringNames and drops them again.
+// With p_shared_names, all threads intern the same names (lookups of existing entries, like
+// property names while loading); otherwise every thread has its own (inserts and removals).
+struct InternBenchmark {
+	static const uint32_t NAME_COUNT = 512;
+	static const uint32_t ROUNDS = 100;
+
+	LocalVector<LocalVector<String>> names; // Per thread.
+	StringName keep_alive[NAME_COUNT]; // Holds the shared names, so only lookups are measured.
+	SafeNumeric<uint32_t> failures;
+
+	InternBenchmark(uint32_t p_thread_count, bool p_shared_names) {
+		names.resize(p_thread_count);
+		for (uint32_t i = 0; i < p_thread_count; i++) {
+			for (uint32_t j = 0; j < NAME_COUNT; j++) {
+				names[i].push_back(p_shared_names ? vformat("benchmark_shared_%d", j) : vformat("benchmark_thread_%d_%d", i, j));
+			}
+		}
+		if (p_shared_names) {
+			for (uint32_t j = 0; j < NAME_COUNT; j++) {
+				keep_alive[j] = names[0][j];
+			}
+		}
+	}
+
+	void run_thread(uint32_t p_thread_index) {
+		for (uint32_t round = 0; round < ROUNDS; round++) {
+			for (const String &name : names[p_thread_index]) {
+				StringName string_name = name;
+				if (string_name != name) {
+					failures.increment();
+				}
+			}
+		}
+	}
+
+	uint32_t get_failures() const { return failures.get(); }
+};
+
+static void run_intern_benchmark(bool p_shared_names) {
+	Dictionary parameters;
+	parameters["names"] = p_shared_names ? "shared" : "per_thread";
+	parameters["name_count"] = InternBenchmark::NAME_COUNT;
+	parameters["rounds"] = InternBenchmark::ROUNDS;
+	const double operations = double(InternBenchmark::NAME_COUNT) * InternBenchmark::ROUNDS;
+	TestBenchmark::run_threaded<InternBenchmark>("string_name.intern", parameters, operations, p_shared_names);
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][StringName] Multithreaded interning") {
+	run_intern_benchmark(true);
+	run_intern_benchmark(false);
+}
+
+// Text resources whose metadata keys become StringNames while parsing, loaded in parallel
+// through ResourceLoader's threaded requests. Run on two builds to compare them.
+TEST_CASE_BENCHMARK("[Benchmark][StringName] Threaded resource loading") {
+	const int resource_count = 64;
+	const int keys_per_resource = 256;
+	const int repetitions = 5;
+
+	LocalVector<String> paths;
+	for (int i = 0; i < resource_count; i++) {
+		Ref<Resource> resource = memnew(Resource);
+		for (int j = 0; j < keys_per_resource; j++) {
+			// Half of the keys are shared between resources, half are unique.
+			resource->set_meta(j % 2 ? vformat("shared_key_%d", j) : vformat("resource_%d_key_%d", i, j), j);
+		}
+		paths.push_back(TestUtils::get_temp_path(vformat("string_name_benchmark_%d.tres", i)));
+		REQUIRE(ResourceSaver::save(resource, paths[i]) == OK);
+	}
+
+	TestBenchmark::Samples samples;
+	int failures = 0;
+	for (int i = 0; i < repetitions; i++) {
+		samples.begin();
+		for (const String &path : paths) {
+			ResourceLoader::load_threaded_request(path, "", false, ResourceFormatLoader::CACHE_MODE_IGNORE);
+		}
+		for (const String &path : paths) {
+			Ref<Resource> resource = ResourceLoader::load_threaded_get(path);
+			if (resource.is_null() || int(resource->get_meta("shared_key_1", -1)) != 1) {
+				failures++;
+			}
+		}
+		samples.end();
+	}
+
+	Dictionary parameters;
+	parameters["resources"] = resource_count;
+	parameters["keys_per_resource"] = keys_per_resource;
+	parameters["threads"] = WorkerThreadPool::get_singleton()->get_thread_count();
+	Dictionary metrics;
+	metrics["resources_per_second"] = double(resource_count) * repetitions * 1000000.0 / MAX(samples.get_total(), uint64_t(1));
+	TestBenchmark::report("string_name.threaded_resource_load", parameters, samples, metrics);
+	CHECK(failures == 0);
+
+	for (const String &path : paths) {
+		DirAccess::remove_file_or_error(path);
+	}
+}
+
+} // namespace TestStringNameBenchmark
+
+#endif // TEST_STRING_NAME_BENCHMARK_H
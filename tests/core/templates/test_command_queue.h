@@ -485,6 +485,78 @@ TEST_CASE("[Stress][CommandQueue] Stress test command queue") {
 			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
 }
 
+class MultiProducerState {
+public:
+	static const int PRODUCER_COUNT = 4;
+	static const int COMMANDS_PER_PRODUCER = 20000;
+
+	CommandQueueMT command_queue;
+	Thread producers[PRODUCER_COUNT];
+	int next_sequence[PRODUCER_COUNT] = {};
+	int order_errors = 0;
+	int sync_count = 0;
+	SafeNumeric<int> finished_producers;
+
+	void consume(int p_producer, int p_sequence, Transform3D p_payload) {
+		if (p_sequence != next_sequence[p_producer]) {
+			order_errors++;
+		}
+		next_sequence[p_producer] = p_sequence + 1;
+	}
+	void consume_sync(int p_producer, int p_sequence) {
+		consume(p_producer, p_sequence, Transform3D());
+		sync_count++;
+	}
+
+	static void producer_loop(void *p_userdata) {
+		MultiProducerState *state = static_cast<MultiProducerState *>(p_userdata);
+		const int producer = state->finished_producers.postincrement() % PRODUCER_COUNT;
+		for (int i = 0; i < COMMANDS_PER_PRODUCER; i++) {
+			if (i % 1000 == 999) {
+				state->command_queue.push_and_sync(state, &MultiProducerState::consume_sync, producer, i);
+			} else {
+				state->command_queue.push(state, &MultiProducerState::consume, producer, i, Transform3D());
+			}
+		}
+	}
+};
+
+TEST_CASE("[CommandQueue] Multiple producers keep per-producer order") {
+	MultiProducerState *state = memnew(MultiProducerState);
+	for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+		state->producers[i].start(&MultiProducerState::producer_loop, state);
+	}
+
+	// Consume concurrently with the producers until every command has run.
+	const int total = MultiProducerState::PRODUCER_COUNT * MultiProducerState::COMMANDS_PER_PRODUCER;
+	int consumed = 0;
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+	while (consumed < total && OS::get_singleton()->get_ticks_usec() - start_usec < 30000000) {
+		state->command_queue.flush_if_pending();
+		consumed = 0;
+		for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+			consumed += state->next_sequence[i];
+		}
+	}
+	for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+		state->producers[i].wait_to_finish();
+	}
+	state->command_queue.flush_all();
+	consumed = 0;
+	for (int i = 0; i < MultiProducerState::PRODUCER_COUNT; i++) {
+		consumed += state->next_sequence[i];
+	}
+
+	CHECK_MESSAGE(consumed == total, "All pushed commands should have been executed.");
+	CHECK_MESSAGE(state->order_errors == 0, "Commands of one producer should run in push order.");
+	CHECK(state->sync_count == MultiProducerState::PRODUCER_COUNT * (MultiProducerState::COMMANDS_PER_PRODUCER / 1000));
+
+	const CommandQueueMT::Stats stats = state->command_queue.get_stats();
+	CHECK_MESSAGE(stats.block_overflows > 0, "Pushing more than one block of commands should link new blocks.");
+	CHECK(stats.sync_waits == uint64_t(state->sync_count));
+	memdelete(state);
+}
+
 TEST_CASE("[CommandQueue] Test Parameter Passing Semantics") {
 	SharedThreadState sts;
 	sts.init_threads();
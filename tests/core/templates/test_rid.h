@@ -249,6 +249,81 @@ TEST_CASE("[RID_Owner] Thread safety") {
 		tester.test();
 	}
 }
+
+TEST_CASE("[RID_Owner] Sharded allocation") {
+	struct ShardedTester {
+		const uint32_t rids_per_thread = 1000;
+
+		// Small chunks, so that threads grow the allocator concurrently.
+		RID_Owner<uint64_t, true, true> rid_owner = RID_Owner<uint64_t, true, true>(sizeof(uint64_t) * 16);
+		TightLocalVector<Thread> threads;
+		TightLocalVector<TightLocalVector<RID>> kept;
+		SafeNumeric<uint32_t> next_thread_idx;
+		std::atomic<uint32_t> errors = 0;
+
+		void test() {
+			threads.resize(MAX(OS::get_singleton()->get_processor_count(), 4));
+			kept.resize(threads.size());
+			for (uint32_t i = 0; i < threads.size(); i++) {
+				threads[i].start(
+						[](void *p_data) {
+							ShardedTester *st = (ShardedTester *)p_data;
+							uint32_t self_th_idx = st->next_thread_idx.postincrement();
+							TightLocalVector<RID> rids;
+							for (uint32_t j = 0; j < st->rids_per_thread; j++) {
+								uint64_t value = (uint64_t(self_th_idx) << 32) | j;
+								rids.push_back(st->rid_owner.make_rid(value));
+							}
+							// Free every other RID to move indices through the shard caches and the pool.
+							for (uint32_t j = 0; j < st->rids_per_thread; j++) {
+								uint64_t *value = st->rid_owner.get_or_null(rids[j]);
+								if (!value || *value != ((uint64_t(self_th_idx) << 32) | j)) {
+									st->errors.fetch_add(1);
+								}
+								if (j % 2) {
+									st->rid_owner.free(rids[j]);
+								} else {
+									st->kept[self_th_idx].push_back(rids[j]);
+								}
+							}
+						},
+						this);
+			}
+			for (uint32_t i = 0; i < threads.size(); i++) {
+				threads[i].wait_to_finish();
+			}
+
+			CHECK_EQ(errors.load(), 0u);
+			const uint32_t kept_count = threads.size() * rids_per_thread / 2;
+			CHECK_EQ(rid_owner.get_rid_count(), kept_count);
+
+			List<RID> owned;
+			rid_owner.get_owned_list(&owned);
+			CHECK_EQ(uint32_t(owned.size()), kept_count);
+
+			for (const TightLocalVector<RID> &rids : kept) {
+				for (const RID &rid : rids) {
+					CHECK(rid_owner.owns(rid));
+					rid_owner.free(rid);
+					CHECK_FALSE(rid_owner.owns(rid));
+				}
+			}
+
+			// Freed RIDs stay invalid once their slot has been reused.
+			RID reused = rid_owner.make_rid(0);
+			CHECK(rid_owner.owns(reused));
+			for (const RID &rid : kept[0]) {
+				CHECK(rid_owner.get_or_null(rid) == nullptr);
+			}
+			rid_owner.free(reused);
+			CHECK_EQ(rid_owner.get_rid_count(), 0u);
+		}
+	};
+
+	ShardedTester *tester = memnew(ShardedTester);
+	tester->test();
+	memdelete(tester);
+}
 } // namespace TestRID
 
 #endif // TEST_RID_H
@@ -0,0 +1,93 @@
+/**************************************************************************/
+/*  test_rid_benchmark.h                                                  */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_RID_BENCHMARK_H
+#define TEST_RID_BENCHMARK_H
+
+#include "core/templates/rid_owner.h"
+
+#include "tests/test_benchmark.h"
+#include "tests/test_macros.h"
+
+namespace TestRIDBenchmark {
+
+// Each thread repeatedly allocates a batch of RIDs, looks every one up and frees them again,
+// which is the pattern of servers creating and destroying objects from worker threads.
+template <bool SHARDED>
+struct ChurnBenchmark {
+	static const uint32_t BATCH_SIZE = 256;
+	static const uint32_t ROUNDS = 200;
+
+	RID_Owner<uint64_t, true, SHARDED> rid_owner;
+	SafeNumeric<uint32_t> failures;
+
+	ChurnBenchmark(uint32_t p_thread_count) {}
+
+	void run_thread(uint32_t p_thread_index) {
+		RID rids[BATCH_SIZE];
+		for (uint32_t round = 0; round < ROUNDS; round++) {
+			for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+				rids[i] = rid_owner.make_rid(i);
+			}
+			for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+				const uint64_t *value = rid_owner.get_or_null(rids[i]);
+				if (!value || *value != i) {
+					failures.increment();
+				}
+			}
+			for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+				rid_owner.free(rids[i]);
+			}
+		}
+	}
+
+	// RIDs still allocated were lost along the way.
+	uint32_t get_failures() const { return failures.get() + rid_owner.get_rid_count(); }
+};
+
+template <bool SHARDED>
+static void run_churn_benchmark(const char *p_allocator) {
+	Dictionary parameters;
+	parameters["allocator"] = p_allocator;
+	parameters["batch_size"] = ChurnBenchmark<SHARDED>::BATCH_SIZE;
+	parameters["rounds"] = ChurnBenchmark<SHARDED>::ROUNDS;
+	// make_rid, get_or_null and free per RID.
+	const double operations = 3.0 * ChurnBenchmark<SHARDED>::BATCH_SIZE * ChurnBenchmark<SHARDED>::ROUNDS;
+	TestBenchmark::run_threaded<ChurnBenchmark<SHARDED>>("rid_alloc.churn", parameters, operations);
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][RID_Owner] Multithreaded allocation churn") {
+	run_churn_benchmark<false>("mutex");
+	run_churn_benchmark<true>("sharded");
+}
+
+} // namespace TestRIDBenchmark
+
+#endif // TEST_RID_BENCHMARK_H
@@ -107,6 +107,124 @@ TEST_CASE("[WorkerThreadPool] Process elements using group tasks") {
 	}
 }
 
+static void static_nested_test(void *p_arg) {
+	// Tasks posted from a pool thread go to its own deque, where idle threads steal them.
+	LocalVector<WorkerThreadPool::TaskID> nested;
+	for (int i = 0; i < 8; i++) {
+		nested.push_back(WorkerThreadPool::get_singleton()->add_native_task(static_test, (void *)(uintptr_t)((uint64_t)p_arg * 8 + i), true));
+	}
+	for (WorkerThreadPool::TaskID id : nested) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(id);
+	}
+}
+
+TEST_CASE("[WorkerThreadPool] Nested tasks and group tasks with affinity") {
+	const int outer_count = 16;
+	counter.clear();
+	counter.resize(outer_count * 8);
+	LocalVector<WorkerThreadPool::TaskID> outer;
+	for (int i = 0; i < outer_count; i++) {
+		outer.push_back(WorkerThreadPool::get_singleton()->add_native_task(static_nested_test, (void *)(uintptr_t)i, true));
+	}
+	for (WorkerThreadPool::TaskID id : outer) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(id);
+	}
+	bool all_run_once = true;
+	for (int i = 1; i < outer_count * 8; i++) {
+		all_run_once &= counter[i].get() == 1;
+	}
+	CHECK(all_run_once);
+
+	for (int iterations = 0; iterations < 100; iterations++) {
+		const int count = 64;
+		counter.clear();
+		counter.resize(count);
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_native_group_task(static_group_test, (void *)0, count, -1, true, String(), iterations);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+		bool all_processed = true;
+		for (int i = 0; i < count; i++) {
+			all_processed &= counter[i].get() == 1;
+		}
+		CHECK(all_processed);
+	}
+
+	CHECK(WorkerThreadPool::get_singleton()->get_queued_task_count() == 0);
+	for (int i = 0; i < WorkerThreadPool::get_singleton()->get_thread_count(); i++) {
+		CHECK(WorkerThreadPool::get_singleton()->get_thread_stats(i).queue_depth == 0);
+	}
+}
+
+static void static_nested_parallel_for_test(void *p_arg, uint32_t p_index) {
+	// Every pool thread is busy with the outer group, so the caller must be able to do all the work.
+	const uint32_t inner_count = (uint32_t)(uintptr_t)p_arg;
+	WorkerThreadPool::get_singleton()->parallel_for(inner_count, [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+		for (uint32_t i = p_from; i < p_to; i++) {
+			counter[p_index * inner_count + i].increment();
+		}
+	});
+}
+
+TEST_CASE("[WorkerThreadPool] Parallel for, reduce and nesting") {
+	const uint32_t count = 10000;
+	const uint32_t max_participants = WorkerThreadPool::get_singleton()->get_max_parallel_participants();
+	counter.clear();
+	counter.resize(count);
+	SafeNumeric<uint32_t> bad_ranges; // Assertions aren't thread-safe, so count and check afterwards.
+	WorkerThreadPool::get_singleton()->parallel_for(count, [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+		if (p_from >= p_to || p_participant >= max_participants) {
+			bad_ranges.increment();
+			return;
+		}
+		for (uint32_t i = p_from; i < p_to; i++) {
+			counter[i].increment();
+		}
+	});
+	bool all_run_once = true;
+	for (uint32_t i = 0; i < count; i++) {
+		all_run_once &= counter[i].get() == 1;
+	}
+	CHECK(all_run_once);
+	CHECK(bad_ranges.get() == 0);
+
+	bad_ranges.set(0);
+	WorkerThreadPool::get_singleton()->parallel_for(
+			count, [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+				// Only the very last range may be shorter than the grain.
+				if (p_to - p_from < 100 && p_to != count) {
+					bad_ranges.increment();
+				}
+			},
+			100);
+	CHECK(bad_ranges.get() == 0);
+
+	const uint64_t sum = WorkerThreadPool::get_singleton()->parallel_reduce(
+			count, uint64_t(0), [](uint32_t p_from, uint32_t p_to, uint64_t &r_partial) {
+				for (uint32_t i = p_from; i < p_to; i++) {
+					r_partial += i;
+				}
+			},
+			[](uint64_t p_a, uint64_t p_b) { return p_a + p_b; });
+	CHECK(sum == uint64_t(count) * (count - 1) / 2);
+
+	bool zero_called = false;
+	WorkerThreadPool::get_singleton()->parallel_for(0, [&](uint32_t p_from, uint32_t p_to, uint32_t p_participant) {
+		zero_called = true;
+	});
+	CHECK_FALSE(zero_called);
+
+	const uint32_t outer_count = 64;
+	const uint32_t inner_count = 256;
+	counter.clear();
+	counter.resize(outer_count * inner_count);
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_native_group_task(static_nested_parallel_for_test, (void *)(uintptr_t)inner_count, outer_count, -1, true);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	all_run_once = true;
+	for (uint32_t i = 0; i < outer_count * inner_count; i++) {
+		all_run_once &= counter[i].get() == 1;
+	}
+	CHECK(all_run_once);
+}
+
 static void static_test_daemon(void *p_arg) {
 	while (!exit.is_set()) {
 		counter[0].add(1);
@@ -0,0 +1,616 @@
+/**************************************************************************/
+/*  test_grid_manager.h                                                   */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_GRID_MANAGER_H
+#define TEST_GRID_MANAGER_H
+
+#include "core/os/os.h"
+#include "scene/2d/grid_manager_2d.h"
+#include "scene/resources/packed_scene.h"
+
+#include "tests/test_macros.h"
+
+namespace TestGridManager {
+
+// Gebäudeszene für alle GridManager- und Truppentests (auch Benchmarks)
+static Ref<PackedScene> create_building_scene() {
+	Node2D *building = memnew(Node2D);
+	building->set_name("Building");
+	Ref<PackedScene> scene;
+	scene.instantiate();
+	scene->pack(building);
+	memdelete(building);
+	return scene;
+}
+
+// Erwartete Argumente für genau eine Emission von occupancy_changed
+static Array occupancy_changed_args(const PackedVector2Array &p_cells) {
+	Array args;
+	args.push_back(p_cells);
+	Array emissions;
+	emissions.push_back(args);
+	return emissions;
+}
+
+TEST_CASE("[GridManager] Occupancy store") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(16);
+	Ref<PackedScene> scene = create_building_scene();
+
+	SUBCASE("Placing a building occupies its cells") {
+		CHECK(grid->place_building(Vector2(2, 3), scene, 2));
+		CHECK(grid->is_cell_occupied(Vector2i(2, 3)));
+		CHECK(grid->is_cell_occupied(Vector2i(3, 4)));
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(4, 3)));
+		CHECK_FALSE(grid->is_wall_at(Vector2i(2, 3)));
+		CHECK(grid->get_occupant(Vector2i(2, 3)) != nullptr);
+		CHECK(grid->get_occupant(Vector2i(2, 3)) == grid->get_occupant(Vector2i(3, 4)));
+		CHECK(grid->get_occupant_offset(Vector2i(3, 4)) == Vector2i(1, 1));
+		CHECK_FALSE(grid->can_place_building(Vector2(3, 4), 1));
+	}
+
+	SUBCASE("Walls are tracked separately") {
+		CHECK(grid->place_building(Vector2(5, 5), scene, 1, true));
+		CHECK(grid->is_wall_at(Vector2i(5, 5)));
+		CHECK_FALSE(grid->is_wall_at(Vector2i(5, 6)));
+	}
+
+	SUBCASE("Cells outside the grid are never occupied") {
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(-1, 0)));
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(16, 16)));
+		CHECK(grid->get_occupant(Vector2i(100, 100)) == nullptr);
+		CHECK_FALSE(grid->can_place_building(Vector2(15, 15), 2));
+	}
+
+	SUBCASE("Moving a building releases its old cells and keeps the wall state") {
+		CHECK(grid->place_building(Vector2(1, 1), scene, 1, true));
+		Node2D *wall = grid->get_occupant(Vector2i(1, 1));
+		REQUIRE(wall != nullptr);
+		CHECK(grid->move_building(wall, Vector2(8, 8), 1));
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(1, 1)));
+		CHECK(grid->is_wall_at(Vector2i(8, 8)));
+		CHECK(grid->get_occupant(Vector2i(8, 8)) == wall);
+	}
+
+	SUBCASE("Dictionary view and bitmap mirror the occupancy store") {
+		CHECK(grid->place_building(Vector2(0, 0), scene, 2));
+		Dictionary occupancy = grid->get_grid_occupancy();
+		CHECK(occupancy.size() == 4);
+		Dictionary cell_info = occupancy[Vector2(1, 0)];
+		CHECK(Vector2(cell_info["position_in_grid"]) == Vector2(1, 0));
+		CHECK_FALSE(bool(cell_info["is_wall"]));
+
+		Ref<BitMap> bitmap = grid->get_occupancy_bitmap();
+		CHECK(bitmap->get_size() == Size2i(16, 16));
+		CHECK(bitmap->get_true_bit_count() == 4);
+		CHECK(bitmap->get_bitv(Point2i(1, 1)));
+	}
+
+	SUBCASE("Resizing the grid keeps occupancy inside the new bounds") {
+		CHECK(grid->place_building(Vector2(1, 1), scene, 1));
+		CHECK(grid->place_building(Vector2(12, 12), scene, 1));
+		// Partly outside after resizing, so it goes away entirely.
+		CHECK(grid->place_building(Vector2(6, 6), scene, 3));
+		const int child_count = grid->get_child_count();
+		grid->set_grid_size(8);
+		CHECK(grid->is_cell_occupied(Vector2i(1, 1)));
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(6, 6)));
+		CHECK(grid->get_grid_occupancy().size() == 1);
+		CHECK(grid->get_building_count() == 1);
+		CHECK(grid->get_child_count() == child_count - 2);
+
+		// Removed buildings leave nothing behind in the state.
+		GridManager *fresh = memnew(GridManager);
+		fresh->set_grid_size(8);
+		CHECK(fresh->place_building(Vector2(1, 1), scene, 1));
+		CHECK(fresh->get_state_hash() == grid->get_state_hash());
+		memdelete(fresh);
+	}
+
+	SUBCASE("Troops cannot spawn next to occupied cells") {
+		CHECK(grid->place_building(Vector2(4, 4), scene, 1));
+		CHECK_FALSE(grid->can_spawn_troop(grid->grid_to_screen(Vector2(5.5, 5.5))));
+		CHECK(grid->can_spawn_troop(grid->grid_to_screen(Vector2(6.5, 6.5))));
+	}
+
+	SUBCASE("Batched spawn checks match single checks") {
+		CHECK(grid->place_building(Vector2(0, 0), scene, 1));
+		CHECK(grid->place_building(Vector2(10, 10), scene, 2));
+		Node2D *moved = grid->get_occupant(Vector2i(10, 10));
+		CHECK(grid->move_building(moved, Vector2(14, 14), 2));
+
+		PackedVector2Array positions;
+		for (int y = -3; y < 19; y++) {
+			for (int x = -3; x < 19; x++) {
+				positions.push_back(grid->grid_to_screen(Vector2(x + 0.5, y + 0.5)));
+			}
+		}
+		PackedByteArray mask = grid->can_spawn_troops(positions);
+		REQUIRE(mask.size() == positions.size());
+		for (int i = 0; i < positions.size(); i++) {
+			CHECK(bool(mask[i]) == grid->can_spawn_troop(positions[i]));
+		}
+		CHECK_FALSE(grid->can_spawn_troop(grid->grid_to_screen(Vector2(-0.5, -0.5))));
+		CHECK_FALSE(grid->can_spawn_troop(grid->grid_to_screen(Vector2(16.5, 16.5))));
+		CHECK(grid->can_spawn_troop(grid->grid_to_screen(Vector2(-1.5, -1.5))));
+		CHECK(grid->can_spawn_troop(grid->grid_to_screen(Vector2(11.5, 11.5))));
+
+		CHECK(grid->remove_building(moved));
+		CHECK(grid->can_spawn_troop(grid->grid_to_screen(Vector2(16.5, 16.5))));
+		grid->set_grid_size(4);
+		CHECK_FALSE(grid->can_spawn_troop(grid->grid_to_screen(Vector2(1.5, 1.5))));
+		CHECK(grid->can_spawn_troop(grid->grid_to_screen(Vector2(2.5, 2.5))));
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Depth sorting") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(16);
+	Ref<PackedScene> scene = create_building_scene();
+	Node2D *troop = memnew(Node2D);
+	troop->set_position(grid->grid_to_screen(Vector2(16, 16)));
+	troop->set_z_index(7);
+	grid->add_child(troop);
+
+	SUBCASE("Incremental mode only updates the placed building") {
+		CHECK(grid->get_depth_sort_mode() == GridManager::DEPTH_SORT_INCREMENTAL);
+		CHECK(grid->place_building(Vector2(0, 0), scene, 2));
+		CHECK(grid->place_building(Vector2(8, 8), scene, 2));
+		Node2D *near = grid->get_occupant(Vector2i(0, 0));
+		Node2D *far = grid->get_occupant(Vector2i(8, 8));
+		CHECK(near->get_z_index() < far->get_z_index());
+		CHECK(troop->get_z_index() == 7);
+
+		const int near_z = near->get_z_index();
+		const int far_z = far->get_z_index();
+		grid->update_z_index();
+		CHECK(near->get_z_index() == near_z);
+		CHECK(far->get_z_index() == far_z);
+		CHECK(troop->get_z_index() == grid->get_max_z_index());
+	}
+
+	SUBCASE("Moving a building updates its depth") {
+		CHECK(grid->place_building(Vector2(0, 0), scene, 1));
+		Node2D *building = grid->get_occupant(Vector2i(0, 0));
+		const int before = building->get_z_index();
+		CHECK(grid->move_building(building, Vector2(12, 12), 1));
+		CHECK(building->get_z_index() > before);
+	}
+
+	SUBCASE("All-children mode sweeps every child") {
+		grid->set_depth_sort_mode(GridManager::DEPTH_SORT_ALL_CHILDREN);
+		troop->set_z_index(7);
+		CHECK(grid->place_building(Vector2(2, 2), scene, 1));
+		CHECK(troop->get_z_index() == grid->get_max_z_index());
+	}
+
+	SUBCASE("Y-sort mode hands ordering to the canvas") {
+		CHECK(grid->place_building(Vector2(4, 4), scene, 1));
+		grid->set_depth_sort_mode(GridManager::DEPTH_SORT_Y_SORT);
+		CHECK(grid->is_y_sort_enabled());
+		CHECK(grid->get_occupant(Vector2i(4, 4))->get_z_index() == 0);
+		CHECK(troop->get_z_index() == 0);
+		CHECK(grid->place_building(Vector2(9, 9), scene, 1));
+		CHECK(grid->get_occupant(Vector2i(9, 9))->get_z_index() == 0);
+
+		grid->set_depth_sort_mode(GridManager::DEPTH_SORT_INCREMENTAL);
+		CHECK_FALSE(grid->is_y_sort_enabled());
+		CHECK(grid->get_occupant(Vector2i(9, 9))->get_z_index() > 0);
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Nearest target queries") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(40);
+	Ref<PackedScene> scene = create_building_scene();
+	CHECK(grid->place_building(Vector2(4, 4), scene, 3));
+	CHECK(grid->place_building(Vector2(12, 4), scene, 1, true));
+	CHECK(grid->place_building(Vector2(30, 30), scene, 4));
+	CHECK(grid->get_building_count() == 3);
+	Node2D *building = grid->get_occupant(Vector2i(4, 4));
+	Node2D *wall = grid->get_occupant(Vector2i(12, 4));
+
+	SUBCASE("Positions inside a footprint hit it at distance zero") {
+		Dictionary hit = grid->find_nearest_target(grid->grid_to_screen(Vector2(6.5, 5.5)), 100);
+		CHECK(Object::cast_to<Node2D>(hit["target"]) == building);
+		CHECK(float(hit["distance"]) == doctest::Approx(0.0));
+	}
+
+	SUBCASE("The hit point lies on the border facing the position") {
+		Dictionary hit = grid->find_nearest_target(grid->grid_to_screen(Vector2(9.5, 5.5)), 200, GridManager::TARGET_FILTER_BUILDINGS);
+		CHECK(Object::cast_to<Node2D>(hit["target"]) == building);
+		CHECK(grid->screen_to_grid(hit["point"]).x == doctest::Approx(7.0));
+		CHECK_FALSE(bool(hit["is_wall"]));
+	}
+
+	SUBCASE("Filters and radius") {
+		Dictionary hit = grid->find_nearest_target(grid->grid_to_screen(Vector2(9.5, 5.5)), 200, GridManager::TARGET_FILTER_WALLS);
+		CHECK(Object::cast_to<Node2D>(hit["target"]) == wall);
+		CHECK(bool(hit["is_wall"]));
+		CHECK(grid->find_nearest_target(grid->grid_to_screen(Vector2(20, 20)), 10).is_empty());
+	}
+
+	SUBCASE("Destroyed, moved and removed buildings update the index") {
+		CHECK(grid->set_building_destroyed(wall));
+		CHECK(grid->find_nearest_target(grid->grid_to_screen(Vector2(12.5, 4.5)), 200, GridManager::TARGET_FILTER_WALLS).is_empty());
+		CHECK(grid->move_building(building, Vector2(20, 20), 3));
+		Dictionary hit = grid->find_nearest_target(grid->grid_to_screen(Vector2(21.5, 21.5)), 10);
+		CHECK(Object::cast_to<Node2D>(hit["target"]) == building);
+		CHECK(grid->remove_building(building));
+		CHECK(grid->get_building_count() == 2);
+		CHECK(grid->find_nearest_target(grid->grid_to_screen(Vector2(21.5, 21.5)), 10).is_empty());
+	}
+
+	SUBCASE("Limited radius agrees with a search covering the whole grid") {
+		for (int i = 0; i < 64; i++) {
+			const Vector2 position = grid->grid_to_screen(Vector2((i * 7) % 40 + 0.25, (i * 13) % 40 + 0.75));
+			const float radius = 40.0f + (i % 5) * 60.0f;
+			Dictionary all = grid->find_nearest_target(position, 100000);
+			Dictionary limited = grid->find_nearest_target(position, radius);
+			REQUIRE_FALSE(all.is_empty());
+			if (float(all["distance"]) < radius) {
+				CHECK(limited["target"] == all["target"]);
+				CHECK(float(limited["distance"]) == doctest::Approx(float(all["distance"])));
+			} else {
+				CHECK(limited.is_empty());
+			}
+		}
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Pathfinding") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(10);
+	Ref<PackedScene> scene = create_building_scene();
+	const Vector2 start = grid->grid_to_screen(Vector2(0.5, 5.5));
+	const Vector2 goal = grid->grid_to_screen(Vector2(9.5, 5.5));
+
+	SUBCASE("Straight path without obstacles") {
+		PackedVector2Array path = grid->get_simple_path_iso_avoid_walls(start, goal);
+		CHECK(path.size() == 10);
+		CHECK(path[0].is_equal_approx(start));
+		CHECK(path[path.size() - 1].is_equal_approx(goal));
+	}
+
+	SUBCASE("Identical start and goal cell returns an empty path") {
+		CHECK(grid->get_simple_path_iso_avoid_walls(start, start).is_empty());
+	}
+
+	SUBCASE("Walls are avoided unless ignored") {
+		for (int y = 0; y < 9; y++) {
+			CHECK(grid->place_building(Vector2(5, y), scene, 1, true));
+		}
+		PackedVector2Array avoid_path = grid->get_simple_path_iso_avoid_walls(start, goal);
+		REQUIRE(avoid_path.size() > 10);
+		for (int i = 0; i < avoid_path.size(); i++) {
+			CHECK_FALSE(grid->is_wall_at(Vector2i(grid->screen_to_grid(avoid_path[i]).floor())));
+		}
+		CHECK(grid->get_simple_path_iso_ignore_walls(start, goal).size() == 10);
+	}
+
+	SUBCASE("Fully blocked goal yields no path") {
+		for (int y = 0; y < 10; y++) {
+			CHECK(grid->place_building(Vector2(5, y), scene, 1, true));
+		}
+		CHECK(grid->get_simple_path_iso_avoid_walls(start, goal).is_empty());
+	}
+
+	SUBCASE("Waypoint paths keep only corners in line of sight") {
+		PackedVector2Array straight = grid->get_waypoint_path(start, goal);
+		REQUIRE(straight.size() == 2);
+		CHECK(straight[0].is_equal_approx(start));
+		CHECK(straight[1].is_equal_approx(goal));
+		CHECK(grid->get_path_cell_length(straight) == doctest::Approx(9.0));
+
+		for (int y = 0; y < 9; y++) {
+			CHECK(grid->place_building(Vector2(5, y), scene, 1, true));
+		}
+		PackedVector2Array cell_path = grid->get_simple_path_iso_avoid_walls(start, goal);
+		PackedVector2Array waypoints = grid->get_waypoint_path(start, goal);
+		REQUIRE(waypoints.size() >= 3);
+		CHECK(waypoints.size() < cell_path.size());
+		CHECK(waypoints[0].is_equal_approx(start));
+		CHECK(waypoints[waypoints.size() - 1].is_equal_approx(goal));
+		CHECK(grid->get_path_cell_length(waypoints) <= grid->get_path_cell_length(cell_path));
+		for (int i = 1; i < waypoints.size(); i++) {
+			const Vector2i from = Vector2i(grid->screen_to_grid(waypoints[i - 1]).floor());
+			const Vector2i to = Vector2i(grid->screen_to_grid(waypoints[i]).floor());
+			CHECK(grid->has_line_of_sight(from, to));
+		}
+		CHECK_FALSE(grid->has_line_of_sight(Vector2i(0, 5), Vector2i(9, 5)));
+		CHECK(grid->simplify_path(cell_path).size() == waypoints.size());
+	}
+
+	SUBCASE("Path curves are evaluated per segment") {
+		PackedVector2Array waypoints;
+		waypoints.push_back(Vector2(0, 0));
+		waypoints.push_back(Vector2(100, 0));
+		waypoints.push_back(Vector2(100, 100));
+		CHECK(GridManager::sample_path_curve(waypoints, 0, 0.0).is_equal_approx(waypoints[0]));
+		CHECK(GridManager::sample_path_curve(waypoints, 0, 1.0).is_equal_approx(waypoints[1]));
+		CHECK(GridManager::sample_path_curve(waypoints, 1, 1.0).is_equal_approx(waypoints[2]));
+		PackedVector2Array smoothed = grid->smooth_path(waypoints, 4);
+		REQUIRE(smoothed.size() == 9);
+		CHECK(smoothed[5].is_equal_approx(GridManager::sample_path_curve(waypoints, 1, 0.25)));
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Hierarchical pathfinding") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(64);
+	Ref<PackedScene> scene = create_building_scene();
+	for (int y = 0; y < 63; y++) {
+		CHECK(grid->place_building(Vector2(32, y), scene, 1, true));
+	}
+	const Vector2 start = grid->grid_to_screen(Vector2(2.5, 2.5));
+	const Vector2 goal = grid->grid_to_screen(Vector2(60.5, 2.5));
+
+	PackedVector2Array flat_path = grid->get_simple_path_iso_avoid_walls(start, goal);
+	const int flat_expanded = grid->get_last_path_expanded_count();
+	REQUIRE_FALSE(flat_path.is_empty());
+
+	grid->set_path_cluster_size(8);
+	grid->set_hierarchical_pathfinding(true);
+
+	SUBCASE("Long routes use the cluster graph") {
+		PackedVector2Array path = grid->get_simple_path_iso_avoid_walls(start, goal);
+		REQUIRE_FALSE(path.is_empty());
+		CHECK(grid->get_last_path_expanded_count() < flat_expanded);
+		CHECK(path[0].is_equal_approx(start));
+		CHECK(path[path.size() - 1].is_equal_approx(goal));
+		CHECK(grid->get_path_cell_length(path) <= grid->get_path_cell_length(flat_path) * 1.1);
+		for (int i = 1; i < path.size(); i++) {
+			const Vector2i from = Vector2i(grid->screen_to_grid(path[i - 1]).floor());
+			const Vector2i to = Vector2i(grid->screen_to_grid(path[i]).floor());
+			CHECK(MAX(ABS(to.x - from.x), ABS(to.y - from.y)) == 1);
+			CHECK_FALSE(grid->is_wall_at(to));
+		}
+	}
+
+	SUBCASE("Occupancy changes invalidate the affected clusters") {
+		REQUIRE_FALSE(grid->get_simple_path_iso_avoid_walls(start, goal).is_empty());
+		CHECK(grid->place_building(Vector2(32, 63), scene, 1, true));
+		CHECK(grid->get_simple_path_iso_avoid_walls(start, goal).is_empty());
+
+		grid->remove_building(grid->get_occupant(Vector2i(32, 10)));
+		PackedVector2Array path = grid->get_simple_path_iso_avoid_walls(start, goal);
+		REQUIRE_FALSE(path.is_empty());
+		bool through_gap = false;
+		for (int i = 0; i < path.size(); i++) {
+			through_gap = through_gap || Vector2i(grid->screen_to_grid(path[i]).floor()) == Vector2i(32, 10);
+		}
+		CHECK(through_gap);
+	}
+
+	SUBCASE("Paths ignoring walls need no search") {
+		PackedVector2Array path = grid->get_simple_path_iso_ignore_walls(start, goal);
+		CHECK(path.size() == 59);
+		CHECK(grid->get_last_path_expanded_count() == 0);
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Flow fields") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(12);
+	Ref<PackedScene> scene = create_building_scene();
+	for (int y = 0; y < 11; y++) {
+		CHECK(grid->place_building(Vector2(6, y), scene, 1, true));
+	}
+	const Vector2i goal_cell = Vector2i(10, 2);
+	const Vector2 goal = grid->grid_to_screen(Vector2(goal_cell) + Vector2(0.5, 0.5));
+
+	SUBCASE("Flow field paths are as long as A* paths") {
+		for (int y = 0; y < 12; y += 3) {
+			const Vector2 start = grid->grid_to_screen(Vector2(1.5, y + 0.5));
+			PackedVector2Array astar_path = grid->get_simple_path_iso_avoid_walls(start, goal);
+			PackedVector2Array flow_path = grid->get_flow_field_path(start, goal);
+			CHECK(flow_path.size() == astar_path.size());
+			CHECK(flow_path[flow_path.size() - 1].is_equal_approx(goal));
+		}
+	}
+
+	SUBCASE("Next cell and distance") {
+		CHECK(grid->get_flow_field_next_cell(Vector2i(10, 3), goal_cell) == goal_cell);
+		CHECK(grid->get_flow_field_distance(Vector2i(10, 4), goal_cell) == doctest::Approx(2.0));
+		CHECK(grid->get_flow_field_distance(goal_cell, goal_cell) == doctest::Approx(0.0));
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell, false) == doctest::Approx(9.0));
+	}
+
+	SUBCASE("Closing the last gap updates the field") {
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell) > 0.0);
+		CHECK(grid->place_building(Vector2(6, 11), scene, 1, true));
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell) == doctest::Approx(-1.0));
+		CHECK(grid->get_flow_field_next_cell(Vector2i(1, 2), goal_cell) == Vector2i(-1, -1));
+	}
+
+	SUBCASE("Destroyed and removed walls are repaired into the field") {
+		CHECK(grid->place_building(Vector2(6, 11), scene, 1, true));
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell) == doctest::Approx(-1.0));
+
+		Node2D *wall = grid->get_occupant(Vector2i(6, 2));
+		REQUIRE(wall != nullptr);
+		CHECK(grid->set_building_destroyed(wall));
+		CHECK_FALSE(grid->is_wall_at(Vector2i(6, 2)));
+		CHECK(grid->is_cell_destroyed(Vector2i(6, 2)));
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell) == doctest::Approx(9.0));
+		CHECK(grid->get_flow_field_next_cell(Vector2i(5, 2), goal_cell) == Vector2i(6, 2));
+
+		CHECK(grid->set_building_destroyed(wall, false));
+		CHECK(grid->get_flow_field_distance(Vector2i(1, 2), goal_cell) == doctest::Approx(-1.0));
+
+		CHECK(grid->remove_building(grid->get_occupant(Vector2i(6, 11))));
+		PackedVector2Array astar_path = grid->get_simple_path_iso_avoid_walls(grid->grid_to_screen(Vector2(1.5, 2.5)), goal);
+		PackedVector2Array flow_path = grid->get_flow_field_path(grid->grid_to_screen(Vector2(1.5, 2.5)), goal);
+		CHECK(flow_path.size() == astar_path.size());
+	}
+
+	SUBCASE("Limited reach") {
+		grid->set_flow_field_max_distance(3);
+		CHECK(grid->get_flow_field_distance(Vector2i(10, 5), goal_cell) == doctest::Approx(3.0));
+		CHECK(grid->get_flow_field_distance(Vector2i(10, 6), goal_cell) == doctest::Approx(-1.0));
+	}
+
+	memdelete(grid);
+}
+
+TEST_CASE("[GridManager] Occupancy change events") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(8);
+	Ref<PackedScene> scene = create_building_scene();
+	SIGNAL_WATCH(grid, "occupancy_changed");
+
+	SUBCASE("Placing reports every covered cell once") {
+		CHECK(grid->place_building(Vector2(1, 1), scene, 2));
+		PackedVector2Array cells = { Vector2(1, 1), Vector2(1, 2), Vector2(2, 1), Vector2(2, 2) };
+		SIGNAL_CHECK("occupancy_changed", occupancy_changed_args(cells));
+	}
+
+	SUBCASE("Moving onto overlapping cells reports the union") {
+		CHECK(grid->place_building(Vector2(1, 1), scene, 1));
+		SIGNAL_DISCARD("occupancy_changed");
+		CHECK(grid->move_building(grid->get_occupant(Vector2i(1, 1)), Vector2(2, 1), 1));
+		PackedVector2Array cells = { Vector2(1, 1), Vector2(2, 1) };
+		SIGNAL_CHECK("occupancy_changed", occupancy_changed_args(cells));
+	}
+
+	SUBCASE("Unchanged state emits nothing") {
+		CHECK(grid->place_building(Vector2(3, 3), scene, 1, true));
+		SIGNAL_DISCARD("occupancy_changed");
+		Node2D *wall = grid->get_occupant(Vector2i(3, 3));
+		CHECK_FALSE(grid->set_building_destroyed(wall, false));
+		SIGNAL_CHECK_FALSE("occupancy_changed");
+		CHECK(grid->set_building_destroyed(wall));
+		SIGNAL_CHECK("occupancy_changed", occupancy_changed_args({ Vector2(3, 3) }));
+		CHECK(grid->remove_building(wall));
+		CHECK_FALSE(grid->is_cell_occupied(Vector2i(3, 3)));
+		SIGNAL_CHECK("occupancy_changed", occupancy_changed_args({ Vector2(3, 3) }));
+	}
+
+	SIGNAL_UNWATCH(grid, "occupancy_changed");
+	memdelete(grid);
+}
+
+// Holt beim ersten Callback eine andere Sammelabfrage selbst ab
+class PathBatchReceiver : public Object {
+public:
+	GridManager *grid = nullptr;
+	int batch_to_take = -1;
+	int calls = 0;
+
+	void on_batch(int p_batch_id, const Array &p_results) {
+		calls++;
+		if (batch_to_take != -1) {
+			grid->get_paths_batch_result(batch_to_take);
+			batch_to_take = -1;
+		}
+	}
+};
+
+TEST_CASE("[GridManager] Batched path queries") {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(12);
+	Ref<PackedScene> scene = create_building_scene();
+	for (int y = 0; y < 11; y++) {
+		CHECK(grid->place_building(Vector2(6, y), scene, 1, true));
+	}
+
+	PackedVector2Array starts;
+	PackedVector2Array goals;
+	for (int i = 0; i < 8; i++) {
+		starts.push_back(grid->grid_to_screen(Vector2(0.5, i + 0.5)));
+		goals.push_back(grid->grid_to_screen(Vector2(11.5, 11.5 - i)));
+	}
+
+	SUBCASE("Batch results match single queries") {
+		int batch_id = grid->request_paths_batch(starts, goals);
+		Array results = grid->get_paths_batch_result(batch_id);
+		REQUIRE(results.size() == starts.size());
+		for (int i = 0; i < starts.size(); i++) {
+			PackedVector2Array single = grid->get_simple_path_iso_avoid_walls(starts[i], goals[i]);
+			CHECK(PackedVector2Array(results[i]).size() == single.size());
+		}
+	}
+
+	SUBCASE("Waypoint batches match single waypoint queries") {
+		int batch_id = grid->request_paths_batch(starts, goals, GridManager::PATH_FLAG_AVOID_WALLS | GridManager::PATH_FLAG_WAYPOINTS);
+		Array results = grid->get_paths_batch_result(batch_id);
+		REQUIRE(results.size() == starts.size());
+		for (int i = 0; i < starts.size(); i++) {
+			PackedVector2Array single = grid->get_waypoint_path(starts[i], goals[i]);
+			CHECK(PackedVector2Array(results[i]) == single);
+		}
+	}
+
+	SUBCASE("Batches use the occupancy snapshot taken at request time") {
+		int batch_id = grid->request_paths_batch(starts, goals, GridManager::PATH_FLAG_AVOID_WALLS);
+		CHECK(grid->place_building(Vector2(6, 11), scene, 1, true));
+		Array results = grid->get_paths_batch_result(batch_id);
+		CHECK_FALSE(PackedVector2Array(results[0]).is_empty());
+		CHECK(grid->get_simple_path_iso_avoid_walls(starts[0], goals[0]).is_empty());
+	}
+
+	SUBCASE("Callbacks skip batches an earlier callback already took") {
+		PathBatchReceiver receiver;
+		receiver.grid = grid;
+		const Callable callback = callable_mp(&receiver, &PathBatchReceiver::on_batch);
+		int first_id = grid->request_paths_batch(starts, goals, GridManager::PATH_FLAG_AVOID_WALLS, callback);
+		int second_id = grid->request_paths_batch(starts, goals, GridManager::PATH_FLAG_AVOID_WALLS, callback);
+		receiver.batch_to_take = second_id;
+		while (!grid->is_paths_batch_completed(first_id) || !grid->is_paths_batch_completed(second_id)) {
+			OS::get_singleton()->delay_usec(100);
+		}
+		grid->notification(Node::NOTIFICATION_INTERNAL_PROCESS);
+		CHECK(receiver.calls == 1);
+		CHECK(receiver.batch_to_take == -1);
+	}
+
+	SUBCASE("Mismatched input sizes are rejected") {
+		goals.resize(1);
+		ERR_PRINT_OFF;
+		CHECK(grid->request_paths_batch(starts, goals) == -1);
+		ERR_PRINT_ON;
+	}
+
+	memdelete(grid);
+}
+
+} // namespace TestGridManager
+
+#endif // TEST_GRID_MANAGER_H
@@ -0,0 +1,187 @@
+/**************************************************************************/
+/*  test_grid_manager_benchmark.h                                         */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_GRID_MANAGER_BENCHMARK_H
+#define TEST_GRID_MANAGER_BENCHMARK_H
+
+#include "core/math/random_pcg.h"
+#include "scene/2d/grid_manager_2d.h"
+#include "scene/resources/packed_scene.h"
+
+#include "tests/scene/test_grid_manager.h"
+#include "tests/test_benchmark.h"
+#include "tests/test_macros.h"
+
+namespace TestGridManagerBenchmark {
+
+static const int GRID_SIZES[] = { 64, 256, 1024 };
+static const float WALL_DENSITIES[] = { 0.0f, 0.1f, 0.2f };
+
+// Parameter einer synthetischen Karte; gleicher Seed ergibt dieselbe Karte
+struct MapSettings {
+	int grid_size = 64;
+	float wall_density = 0.0f;
+	int building_count = 0;
+	int building_size = 2;
+	uint64_t seed = 12345;
+
+	Dictionary to_dictionary() const {
+		Dictionary parameters;
+		parameters["grid_size"] = grid_size;
+		parameters["wall_density"] = wall_density;
+		parameters["building_count"] = building_count;
+		return parameters;
+	}
+};
+
+static Vector2i random_cell(RandomPCG &r_random, int p_limit) {
+	return Vector2i(r_random.random(0, p_limit - 1), r_random.random(0, p_limit - 1));
+}
+
+// Erzeugt ein Gitter mit zufällig verteilten Wänden und Gebäuden. Belegte Zellen werden
+// übersprungen, die tatsächliche Anzahl kann daher leicht unter den Vorgaben liegen.
+static GridManager *create_map(const MapSettings &p_settings, RandomPCG &r_random) {
+	GridManager *grid = memnew(GridManager);
+	grid->set_grid_size(p_settings.grid_size);
+	Ref<PackedScene> scene = TestGridManager::create_building_scene();
+	for (int i = 0; i < p_settings.building_count; i++) {
+		const Vector2i cell = random_cell(r_random, p_settings.grid_size - p_settings.building_size + 1);
+		if (grid->can_place_building(cell, p_settings.building_size)) {
+			grid->place_building(cell, scene, p_settings.building_size);
+		}
+	}
+	const int wall_count = int(p_settings.wall_density * p_settings.grid_size * p_settings.grid_size);
+	for (int i = 0; i < wall_count; i++) {
+		const Vector2i cell = random_cell(r_random, p_settings.grid_size);
+		if (!grid->is_cell_occupied(cell)) {
+			grid->place_building(cell, scene, 1, true);
+		}
+	}
+	return grid;
+}
+
+// Zufällige freie Zelle; nach einigen Fehlversuchen auch eine belegte
+static Vector2i random_free_cell(const GridManager *p_grid, RandomPCG &r_random) {
+	Vector2i cell = random_cell(r_random, p_grid->get_grid_size());
+	for (int attempt = 0; attempt < 64 && p_grid->is_cell_occupied(cell); attempt++) {
+		cell = random_cell(r_random, p_grid->get_grid_size());
+	}
+	return cell;
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][GridManager] Path query latency") {
+	const int query_count = 200;
+	for (int grid_size : GRID_SIZES) {
+		for (float wall_density : WALL_DENSITIES) {
+			MapSettings settings;
+			settings.grid_size = grid_size;
+			settings.wall_density = wall_density;
+			RandomPCG random(settings.seed);
+			GridManager *grid = create_map(settings, random);
+
+			for (int hierarchical = 0; hierarchical < 2; hierarchical++) {
+				grid->set_hierarchical_pathfinding(hierarchical);
+				RandomPCG query_random(settings.seed + 1);
+				TestBenchmark::Samples samples;
+				uint64_t expanded = 0;
+				int found = 0;
+				for (int i = 0; i < query_count; i++) {
+					const Vector2 start = grid->grid_to_screen(Vector2(random_free_cell(grid, query_random)) + Vector2(0.5, 0.5));
+					const Vector2 goal = grid->grid_to_screen(Vector2(random_free_cell(grid, query_random)) + Vector2(0.5, 0.5));
+					samples.begin();
+					const PackedVector2Array path = grid->get_simple_path_iso_avoid_walls(start, goal);
+					samples.end();
+					expanded += grid->get_last_path_expanded_count();
+					found += path.is_empty() ? 0 : 1;
+				}
+				Dictionary parameters = settings.to_dictionary();
+				parameters["hierarchical"] = bool(hierarchical);
+				Dictionary metrics;
+				metrics["mean_expanded_cells"] = double(expanded) / query_count;
+				metrics["found_ratio"] = double(found) / query_count;
+				TestBenchmark::report("grid_manager.path_query", parameters, samples, metrics);
+				CHECK(samples.size() == query_count);
+			}
+			memdelete(grid);
+		}
+	}
+}
+
+TEST_CASE_BENCHMARK("[Benchmark][GridManager] Building placement and moves") {
+	const int building_counts[] = { 100, 1000 };
+	for (int grid_size : GRID_SIZES) {
+		for (int building_count : building_counts) {
+			MapSettings settings;
+			settings.grid_size = grid_size;
+			settings.wall_density = 0.1f;
+			RandomPCG random(settings.seed);
+			GridManager *grid = create_map(settings, random);
+			Ref<PackedScene> scene = TestGridManager::create_building_scene();
+
+			TestBenchmark::Samples place_samples;
+			LocalVector<Node2D *> placed;
+			for (int i = 0; i < building_count; i++) {
+				const Vector2i cell = random_cell(random, grid_size - 1);
+				if (!grid->can_place_building(cell, settings.building_size)) {
+					continue;
+				}
+				place_samples.begin();
+				grid->place_building(cell, scene, settings.building_size);
+				place_samples.end();
+				placed.push_back(grid->get_occupant(cell));
+			}
+
+			TestBenchmark::Samples move_samples;
+			for (Node2D *building : placed) {
+				const Vector2i cell = random_cell(random, grid_size - 1);
+				if (!grid->can_place_building(cell, settings.building_size)) {
+					continue;
+				}
+				move_samples.begin();
+				grid->move_building(building, cell, settings.building_size);
+				move_samples.end();
+			}
+
+			// Die Karte selbst hat keine Gebäude; gezählt werden die Versuche und die tatsächlich gesetzten
+			Dictionary parameters = settings.to_dictionary();
+			parameters.erase("building_count");
+			parameters["attempted_buildings"] = building_count;
+			parameters["placed_buildings"] = place_samples.size();
+			TestBenchmark::report("grid_manager.place_building", parameters, place_samples);
+			TestBenchmark::report("grid_manager.move_building", parameters, move_samples);
+			CHECK(place_samples.size() > 0);
+			memdelete(grid);
+		}
+	}
+}
+
+} // namespace TestGridManagerBenchmark
+
+#endif // TEST_GRID_MANAGER_BENCHMARK_H
@@ -31,6 +31,8 @@
 #ifndef TEST_PACKED_SCENE_H
 #define TEST_PACKED_SCENE_H
 
+#include "scene/2d/node_2d.h"
+#include "scene/gui/control.h"
 #include "scene/resources/packed_scene.h"
 
 #include "tests/test_macros.h"
@@ -216,6 +218,65 @@ TEST_CASE("[PackedScene] Instantiate Packed Scene With Children") {
 	memdelete(instance);
 }
 
+TEST_CASE("[PackedScene] Instantiate Packed Scene With Properties") {
+	// Plain, indexed and metadata properties, set on nodes created from their classes.
+	Node2D *scene = memnew(Node2D);
+	scene->set_name("TestScene");
+	scene->set_position(Vector2(10, 20));
+	scene->set_rotation(0.5);
+
+	Control *control = memnew(Control);
+	control->set_name("Control");
+	control->set_offset(SIDE_LEFT, 4);
+	control->set_offset(SIDE_BOTTOM, 32);
+	control->set_mouse_filter(Control::MOUSE_FILTER_IGNORE);
+	scene->add_child(control);
+	control->set_owner(scene);
+
+	Node *child = memnew(Node);
+	child->set_name("Child");
+	child->set_meta("value", 42);
+	child->set_process_priority(3);
+	scene->add_child(child);
+	child->set_owner(scene);
+
+	Ref<PackedScene> packed_scene;
+	packed_scene.instantiate();
+	REQUIRE(packed_scene->pack(scene) == OK);
+
+	// The first instantiation resolves the setters, the second one reuses them.
+	for (int i = 0; i < 2; i++) {
+		Node2D *instance = Object::cast_to<Node2D>(packed_scene->instantiate());
+		REQUIRE(instance != nullptr);
+		CHECK(instance->get_position() == Vector2(10, 20));
+		CHECK(instance->get_rotation() == doctest::Approx(0.5));
+
+		Control *instance_control = Object::cast_to<Control>(instance->get_node(NodePath("Control")));
+		REQUIRE(instance_control != nullptr);
+		CHECK(instance_control->get_offset(SIDE_LEFT) == 4);
+		CHECK(instance_control->get_offset(SIDE_BOTTOM) == 32);
+		CHECK(instance_control->get_mouse_filter() == Control::MOUSE_FILTER_IGNORE);
+
+		Node *instance_child = instance->get_node(NodePath("Child"));
+		CHECK(int(instance_child->get_meta("value")) == 42);
+		CHECK(instance_child->get_process_priority() == 3);
+		memdelete(instance);
+	}
+
+	// Packing again must not reuse what was resolved for the old state.
+	memdelete(child);
+	scene->set_position(Vector2(-5, 5));
+	REQUIRE(packed_scene->pack(scene) == OK);
+	Node2D *instance = Object::cast_to<Node2D>(packed_scene->instantiate());
+	REQUIRE(instance != nullptr);
+	CHECK(instance->get_position() == Vector2(-5, 5));
+	CHECK(instance->get_child_count() == 1);
+	CHECK(Object::cast_to<Control>(instance->get_child(0))->get_offset(SIDE_BOTTOM) == 32);
+	memdelete(instance);
+
+	memdelete(scene);
+}
+
 TEST_CASE("[PackedScene] Set Path") {
 	// Create a scene to pack.
 	Node *scene = memnew(Node);
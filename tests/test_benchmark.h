@@ -0,0 +1,170 @@
+/**************************************************************************/
+/*  test_benchmark.h                                                      */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/dictionary.h"
+
+#include "tests/test_macros.h"
+
+// Benchmarks are skipped in normal runs. Run them with:
+//   godot --test --no-skip --test-case="[Benchmark]*"
+// Every result is one JSON object per line. With the environment variable
+// GODOT_BENCHMARK_OUTPUT set, lines are appended to that file, otherwise they are
+// printed to stdout prefixed with "BENCHMARK ".
+#define TEST_CASE_BENCHMARK(name) TEST_CASE(name *doctest::skip())
+
+namespace TestBenchmark {
+
+// Collects one duration per measured operation.
+class Samples {
+	LocalVector<uint64_t> usec;
+	uint64_t start = 0;
+
+public:
+	void begin() { start = OS::get_singleton()->get_ticks_usec(); }
+	void end() { usec.push_back(OS::get_singleton()->get_ticks_usec() - start); }
+	void add(uint64_t p_usec) { usec.push_back(p_usec); }
+
+	uint32_t size() const { return usec.size(); }
+
+	uint64_t get_total() const {
+		uint64_t total = 0;
+		for (uint64_t value : usec) {
+			total += value;
+		}
+		return total;
+	}
+
+	// Adds count, total, mean, min, max and the 50th, 90th and 99th percentile (nearest rank).
+	void write_statistics(Dictionary &r_result) const {
+		r_result["count"] = usec.size();
+		if (usec.is_empty()) {
+			return;
+		}
+		LocalVector<uint64_t> sorted = usec;
+		sorted.sort();
+		const uint64_t total = get_total();
+		r_result["total_usec"] = total;
+		r_result["mean_usec"] = double(total) / sorted.size();
+		r_result["min_usec"] = sorted[0];
+		r_result["max_usec"] = sorted[sorted.size() - 1];
+		const double percentiles[3] = { 50.0, 90.0, 99.0 };
+		const char *keys[3] = { "p50_usec", "p90_usec", "p99_usec" };
+		for (int i = 0; i < 3; i++) {
+			const uint32_t rank = uint32_t(Math::ceil(percentiles[i] / 100.0 * sorted.size()));
+			r_result[keys[i]] = sorted[CLAMP(rank, 1u, sorted.size()) - 1];
+		}
+	}
+};
+
+// Emits one result line. p_metrics holds additional values (e.g. throughput).
+inline void report(const String &p_benchmark, const Dictionary &p_parameters, const Samples &p_samples, const Dictionary &p_metrics = Dictionary()) {
+	Dictionary result;
+	result["benchmark"] = p_benchmark;
+	result["parameters"] = p_parameters;
+	p_samples.write_statistics(result);
+	result.merge(p_metrics);
+	const String line = JSON::stringify(result, "", false);
+
+	const String path = OS::get_singleton()->get_environment("GODOT_BENCHMARK_OUTPUT");
+	if (path.is_empty()) {
+		print_line("BENCHMARK " + line);
+		return;
+	}
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ_WRITE);
+	if (file.is_null()) {
+		file = FileAccess::open(path, FileAccess::WRITE);
+	}
+	REQUIRE_MESSAGE(file.is_valid(), vformat("Cannot open benchmark output file: %s", path));
+	file->seek_end();
+	file->store_line(line);
+}
+
+// Runs T on 1 to 32 threads at once, 5 times per thread count, and reports one line per thread
+// count. Each run gets a fresh T(thread_count, p_args...), whose run_thread(thread_index) is what
+// every thread does; get_failures() must be zero once they are done. A run is timed from the
+// first thread started to the last one finished. operations_per_second is computed from
+// p_operations_per_thread, the operations one thread does per run.
+template <typename T, typename... P>
+void run_threaded(const String &p_benchmark, const Dictionary &p_parameters, double p_operations_per_thread, const P &...p_args) {
+	struct ThreadData {
+		T *benchmark = nullptr;
+		uint32_t index = 0;
+
+		static void thread_func(void *p_userdata) {
+			ThreadData *thread_data = static_cast<ThreadData *>(p_userdata);
+			thread_data->benchmark->run_thread(thread_data->index);
+		}
+	};
+
+	const uint32_t thread_counts[] = { 1, 2, 4, 8, 16, 32 };
+	const int repetitions = 5;
+	for (uint32_t thread_count : thread_counts) {
+		Samples samples;
+		uint32_t failures = 0;
+		for (int i = 0; i < repetitions; i++) {
+			T *benchmark = memnew(T(thread_count, p_args...));
+			LocalVector<ThreadData> thread_data;
+			thread_data.resize(thread_count);
+			LocalVector<Thread> threads;
+			threads.resize(thread_count);
+			samples.begin();
+			for (uint32_t j = 0; j < thread_count; j++) {
+				thread_data[j].benchmark = benchmark;
+				thread_data[j].index = j;
+				threads[j].start(&ThreadData::thread_func, &thread_data[j]);
+			}
+			for (Thread &thread : threads) {
+				thread.wait_to_finish();
+			}
+			samples.end();
+			failures += benchmark->get_failures();
+			memdelete(benchmark);
+		}
+
+		Dictionary parameters = p_parameters.duplicate();
+		parameters["threads"] = thread_count;
+		Dictionary metrics;
+		metrics["operations_per_second"] = p_operations_per_thread * thread_count * repetitions * 1000000.0 / MAX(samples.get_total(), uint64_t(1));
+		report(p_benchmark, parameters, samples, metrics);
+		CHECK_MESSAGE(failures == 0, vformat("%s failed on %d threads.", p_benchmark, thread_count));
+	}
+}
+
+} // namespace TestBenchmark
+
+#endif // TEST_BENCHMARK_H